@@ -32,6 +32,7 @@
 #include "binder/expressions/bound_constant.h"
 #include "binder/expressions/bound_star.h"
 #include "binder/expressions/bound_unary_op.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/index_statement.h"
 #include "binder/statement/select_statement.h"
@@ -132,4 +133,25 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
   return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
 }
 
+auto Binder::BindAnalyze(duckdb_libpgquery::PGVacuumStmt *stmt) -> std::unique_ptr<AnalyzeStatement> {
+  if ((stmt->options & duckdb_libpgquery::PG_VACOPT_VACUUM) != 0) {
+    throw NotImplementedException("vacuum is not supported");
+  }
+  bool verbose = (stmt->options & duckdb_libpgquery::PG_VACOPT_VERBOSE) != 0;
+  if (stmt->relation == nullptr) {
+    return std::make_unique<AnalyzeStatement>(nullptr, std::vector<std::unique_ptr<BoundColumnRef>>{}, verbose);
+  }
+
+  std::vector<std::unique_ptr<BoundColumnRef>> cols;
+  auto table = BindBaseTableRef(stmt->relation->relname, std::nullopt);
+  if (stmt->va_cols != nullptr) {
+    for (auto cell = stmt->va_cols->head; cell != nullptr; cell = cell->next) {
+      auto col_name = reinterpret_cast<duckdb_libpgquery::PGValue *>(cell->data.ptr_value)->val.str;
+      auto column_ref = ResolveColumn(*table, std::vector{std::string(col_name)});
+      cols.emplace_back(std::make_unique<BoundColumnRef>(dynamic_cast<const BoundColumnRef &>(*column_ref)));
+    }
+  }
+  return std::make_unique<AnalyzeStatement>(std::move(table), std::move(cols), verbose);
+}
+
 }  // namespace bustub
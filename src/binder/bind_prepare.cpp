@@ -0,0 +1,96 @@
+#include <cctype>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "binder/binder.h"
+#include "binder/bound_expression.h"
+#include "binder/expressions/bound_constant.h"
+#include "binder/expressions/bound_parameter.h"
+#include "binder/statement/prepare_statement.h"
+#include "common/exception.h"
+#include "common/util/string_util.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+auto Binder::BindParameter(duckdb_libpgquery::PGParamRef *node) -> std::unique_ptr<BoundExpression> {
+  BUSTUB_ASSERT(node, "nullptr");
+  if (node->number < 1 || static_cast<size_t>(node->number) > parameter_types_.size()) {
+    throw bustub::Exception(fmt::format("could not determine the type of parameter ${}", node->number));
+  }
+  return std::make_unique<BoundParameter>(node->number - 1, parameter_types_[node->number - 1]);
+}
+
+auto Binder::BindPrepare(duckdb_libpgquery::PGPrepareStmt *stmt) -> std::unique_ptr<PrepareStatement> {
+  std::vector<TypeId> types;
+  if (stmt->argtypes != nullptr) {
+    for (auto cell = stmt->argtypes->head; cell != nullptr; cell = cell->next) {
+      auto *type_name = reinterpret_cast<duckdb_libpgquery::PGTypeName *>(cell->data.ptr_value);
+      auto name =
+          std::string(reinterpret_cast<duckdb_libpgquery::PGValue *>(type_name->names->tail->data.ptr_value)->val.str);
+      if (name == "int4") {
+        types.push_back(TypeId::INTEGER);
+      } else if (name == "varchar") {
+        types.push_back(TypeId::VARCHAR);
+      } else if (name == "bool") {
+        types.push_back(TypeId::BOOLEAN);
+      } else {
+        throw NotImplementedException(fmt::format("unsupported type: {}", name));
+      }
+    }
+  }
+  switch (stmt->query->type) {
+    case duckdb_libpgquery::T_PGSelectStmt:
+    case duckdb_libpgquery::T_PGInsertStmt:
+    case duckdb_libpgquery::T_PGUpdateStmt:
+    case duckdb_libpgquery::T_PGDeleteStmt:
+      break;
+    default:
+      throw NotImplementedException("only SELECT, INSERT, UPDATE and DELETE can be prepared");
+  }
+
+  // The query is kept as text after the AS of the statement, it is planned when it is executed. The text is scanned
+  // by hand, as tokenizing it would release the parse tree the statement is bound from.
+  auto text = stmt_len_ == 0 ? sql_.substr(stmt_location_) : sql_.substr(stmt_location_, stmt_len_);
+  auto is_word = [](char c) { return std::isalnum(c) != 0 || c == '_'; };
+  bool quoted = false;
+  for (size_t i = 0; i + 2 <= text.size(); i++) {
+    if (text[i] == '"') {
+      quoted = !quoted;
+    }
+    if (quoted || StringUtil::Lower(text.substr(i, 2)) != "as" || (i > 0 && is_word(text[i - 1])) ||
+        (i + 2 < text.size() && is_word(text[i + 2]))) {
+      continue;
+    }
+    auto end = i + 2;
+    while (end < text.size() && std::isspace(text[end]) != 0) {
+      end++;
+    }
+    auto query = text.substr(end);
+    while (!query.empty() && (std::isspace(query.back()) != 0 || query.back() == ';')) {
+      query.pop_back();
+    }
+    return std::make_unique<PrepareStatement>(stmt->name, std::move(types), std::move(query));
+  }
+  throw bustub::Exception("PREPARE should have an AS clause");
+}
+
+auto Binder::BindExecute(duckdb_libpgquery::PGExecuteStmt *stmt) -> std::unique_ptr<ExecuteStatement> {
+  std::vector<Value> params;
+  if (stmt->params != nullptr) {
+    for (auto &expr : BindExpressionList(stmt->params)) {
+      if (expr->type_ != ExpressionType::CONSTANT) {
+        throw NotImplementedException("parameters of EXECUTE must be constants");
+      }
+      params.push_back(dynamic_cast<const BoundConstant &>(*expr).val_);
+    }
+  }
+  return std::make_unique<ExecuteStatement>(stmt->name, std::move(params));
+}
+
+auto Binder::BindDeallocate(duckdb_libpgquery::PGDeallocateStmt *stmt) -> std::unique_ptr<DeallocateStatement> {
+  return std::make_unique<DeallocateStatement>(stmt->name == nullptr ? "" : stmt->name);
+}
+
+}  // namespace bustub
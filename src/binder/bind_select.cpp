@@ -2,6 +2,7 @@
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
@@ -14,6 +15,7 @@
 #include "binder/expressions/bound_column_ref.h"
 #include "binder/expressions/bound_constant.h"
 #include "binder/expressions/bound_star.h"
+#include "binder/expressions/bound_subquery_expr.h"
 #include "binder/expressions/bound_unary_op.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/select_statement.h"
@@ -66,8 +68,11 @@ auto Binder::BindValuesList(duckdb_libpgquery::PGList *list) -> std::unique_ptr<
 
 auto Binder::BindSubquery(duckdb_libpgquery::PGSelectStmt *node, const std::string &alias)
     -> std::unique_ptr<BoundSubqueryRef> {
+  // Subqueries in FROM are not LATERAL, they cannot read the columns of the queries around them.
+  auto outer_scopes = std::exchange(outer_scopes_, {});
   std::vector<std::vector<std::string>> select_list_name;
   auto subquery = BindSelect(node);
+  outer_scopes_ = std::move(outer_scopes);
   for (const auto &col : subquery->select_list_) {
     switch (col->type_) {
       case ExpressionType::COLUMN_REF: {
@@ -522,7 +527,7 @@ auto Binder::BindFuncCall(duckdb_libpgquery::PGFuncCall *root) -> std::unique_pt
   }
 
   if (function_name == "min" || function_name == "max" || function_name == "first" || function_name == "last" ||
-      function_name == "sum" || function_name == "count") {
+      function_name == "sum" || function_name == "count" || function_name == "approx_count_distinct") {
     // Rewrite count(*) to count_star().
     if (function_name == "count" && children.empty()) {
       function_name = "count_star";
@@ -697,6 +702,17 @@ auto Binder::ResolveColumn(const BoundTableRef &scope, const std::vector<std::st
     -> std::unique_ptr<BoundExpression> {
   BUSTUB_ASSERT(!scope.IsInvalid(), "invalid scope");
   auto expr = ResolveColumnInternal(scope, col_name);
+  // A column of none of the tables of a subquery is looked up in the queries around it, innermost first.
+  for (size_t depth = 1; !expr && depth <= outer_scopes_.size(); depth++) {
+    const auto *outer_scope = outer_scopes_[outer_scopes_.size() - depth];
+    if (outer_scope == nullptr || outer_scope->type_ == TableReferenceType::EMPTY) {
+      continue;
+    }
+    expr = ResolveColumnInternal(*outer_scope, col_name);
+    if (expr) {
+      dynamic_cast<BoundColumnRef &>(*expr).depth_ = depth;
+    }
+  }
   if (!expr) {
     throw bustub::Exception(fmt::format("column {} not found", fmt::join(col_name, ".")));
   }
@@ -780,6 +796,40 @@ auto Binder::BindBoolExpr(duckdb_libpgquery::PGBoolExpr *root) -> std::unique_pt
   UNREACHABLE("We should have handled all cases!");
 }
 
+auto Binder::BindSubLink(duckdb_libpgquery::PGSubLink *root) -> std::unique_ptr<BoundExpression> {
+  BUSTUB_ASSERT(root, "nullptr");
+  SubqueryType subquery_type;
+  std::unique_ptr<BoundExpression> test_expr = nullptr;
+  switch (root->subLinkType) {
+    case duckdb_libpgquery::PG_EXISTS_SUBLINK: {
+      subquery_type = SubqueryType::EXISTS;
+      break;
+    }
+    case duckdb_libpgquery::PG_ANY_SUBLINK: {
+      // `x IN (SELECT ...)` has no operator name, `x = ANY (SELECT ...)` is the same.
+      if (root->operName != nullptr &&
+          std::string(reinterpret_cast<duckdb_libpgquery::PGValue *>(root->operName->head->data.ptr_value)->val.str) !=
+              "=") {
+        throw NotImplementedException("only = ANY is supported");
+      }
+      subquery_type = SubqueryType::IN;
+      test_expr = BindExpression(root->testexpr);
+      break;
+    }
+    default:
+      throw NotImplementedException(fmt::format("subquery type {} not supported", static_cast<int>(root->subLinkType)));
+  }
+
+  // The subquery can read the columns of this query, see `ResolveColumn`.
+  outer_scopes_.push_back(scope_);
+  auto subquery = BindSelect(reinterpret_cast<duckdb_libpgquery::PGSelectStmt *>(root->subselect));
+  outer_scopes_.pop_back();
+  if (subquery_type == SubqueryType::IN && subquery->select_list_.size() != 1) {
+    throw bustub::Exception("subquery of IN should return exactly one column");
+  }
+  return std::make_unique<BoundSubqueryExpr>(subquery_type, std::move(subquery), std::move(test_expr));
+}
+
 auto Binder::BindExpression(duckdb_libpgquery::PGNode *node) -> std::unique_ptr<BoundExpression> {
   BUSTUB_ASSERT(node, "nullptr");
   switch (node->type) {
@@ -787,6 +837,8 @@ auto Binder::BindExpression(duckdb_libpgquery::PGNode *node) -> std::unique_ptr<
       return BindColumnRef(reinterpret_cast<duckdb_libpgquery::PGColumnRef *>(node));
     case duckdb_libpgquery::T_PGAConst:
       return BindConstant(reinterpret_cast<duckdb_libpgquery::PGAConst *>(node));
+    case duckdb_libpgquery::T_PGParamRef:
+      return BindParameter(reinterpret_cast<duckdb_libpgquery::PGParamRef *>(node));
     case duckdb_libpgquery::T_PGResTarget:
       return BindResTarget(reinterpret_cast<duckdb_libpgquery::PGResTarget *>(node));
     case duckdb_libpgquery::T_PGAStar:
@@ -797,6 +849,8 @@ auto Binder::BindExpression(duckdb_libpgquery::PGNode *node) -> std::unique_ptr<
       return BindAExpr(reinterpret_cast<duckdb_libpgquery::PGAExpr *>(node));
     case duckdb_libpgquery::T_PGBoolExpr:
       return BindBoolExpr(reinterpret_cast<duckdb_libpgquery::PGBoolExpr *>(node));
+    case duckdb_libpgquery::T_PGSubLink:
+      return BindSubLink(reinterpret_cast<duckdb_libpgquery::PGSubLink *>(node));
     default:
       break;
   }
@@ -830,6 +884,9 @@ auto Binder::BindExplain(duckdb_libpgquery::PGExplainStmt *stmt) -> std::unique_
       if (strcmp(temp->defname, "schema") == 0 || strcmp(temp->defname, "s") == 0) {
         explain_options |= ExplainOptions::SCHEMA;
       }
+      if (strcmp(temp->defname, "analyze") == 0 || strcmp(temp->defname, "a") == 0) {
+        explain_options |= ExplainOptions::ANALYZE;
+      }
     }
   }
   return std::make_unique<ExplainStatement>(BindStatement(stmt->query), explain_options);
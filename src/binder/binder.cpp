@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <unordered_set>
 
@@ -43,6 +44,7 @@ namespace bustub {
 Binder::Binder(const Catalog &catalog) : catalog_(catalog) {}
 
 void Binder::ParseAndSave(const std::string &query) {
+  sql_ = query;
   parser_.Parse(query);
   if (!parser_.success) {
     LOG_INFO("Query failed to parse!");
@@ -58,6 +60,17 @@ void Binder::ParseAndSave(const std::string &query) {
   SaveParseTree(parser_.parse_tree);
 }
 
+auto Binder::GetStatementTexts() const -> std::vector<std::string> {
+  std::vector<std::string> texts;
+  for (auto *stmt : statement_nodes_) {
+    auto *raw_stmt = reinterpret_cast<duckdb_libpgquery::PGRawStmt *>(stmt);
+    auto location = static_cast<size_t>(std::max(raw_stmt->stmt_location, 0));
+    // The length of the last statement is 0, it spans the rest of the query.
+    texts.push_back(raw_stmt->stmt_len == 0 ? sql_.substr(location) : sql_.substr(location, raw_stmt->stmt_len));
+  }
+  return texts;
+}
+
 auto Binder::IsKeyword(const std::string &text) -> bool { return duckdb::PostgresParser::IsKeyword(text); }
 
 auto Binder::KeywordList() -> std::vector<ParserKeyword> {
@@ -0,0 +1,23 @@
+#include "binder/statement/analyze_statement.h"
+#include "binder/bound_expression.h"
+#include "binder/expressions/bound_column_ref.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+
+namespace bustub {
+
+AnalyzeStatement::AnalyzeStatement(std::unique_ptr<BoundBaseTableRef> table,
+                                   std::vector<std::unique_ptr<BoundColumnRef>> cols, bool verbose)
+    : BoundStatement(StatementType::ANALYZE_STATEMENT),
+      table_(std::move(table)),
+      cols_(std::move(cols)),
+      verbose_(verbose) {}
+
+auto AnalyzeStatement::ToString() const -> std::string {
+  if (table_ == nullptr) {
+    return fmt::format("BoundAnalyze {{ table=<all>, verbose={} }}", verbose_);
+  }
+  return fmt::format("BoundAnalyze {{ table={}, cols={}, verbose={} }}", *table_, cols_, verbose_);
+}
+
+}  // namespace bustub
@@ -20,16 +20,19 @@
 // THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <memory>
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_order_by.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/delete_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
 #include "binder/statement/insert_statement.h"
+#include "binder/statement/prepare_statement.h"
 #include "binder/statement/select_statement.h"
 #include "binder/statement/update_statement.h"
 #include "binder/table_ref/bound_base_table_ref.h"
@@ -51,8 +54,12 @@ void Binder::SaveParseTree(duckdb_libpgquery::PGList *tree) {
 
 auto Binder::BindStatement(duckdb_libpgquery::PGNode *stmt) -> std::unique_ptr<BoundStatement> {
   switch (stmt->type) {
-    case duckdb_libpgquery::T_PGRawStmt:
-      return BindStatement(reinterpret_cast<duckdb_libpgquery::PGRawStmt *>(stmt)->stmt);
+    case duckdb_libpgquery::T_PGRawStmt: {
+      auto *raw_stmt = reinterpret_cast<duckdb_libpgquery::PGRawStmt *>(stmt);
+      stmt_location_ = std::max(raw_stmt->stmt_location, 0);
+      stmt_len_ = raw_stmt->stmt_len;
+      return BindStatement(raw_stmt->stmt);
+    }
     case duckdb_libpgquery::T_PGCreateStmt:
       return BindCreate(reinterpret_cast<duckdb_libpgquery::PGCreateStmt *>(stmt));
     case duckdb_libpgquery::T_PGInsertStmt:
@@ -67,10 +74,18 @@ auto Binder::BindStatement(duckdb_libpgquery::PGNode *stmt) -> std::unique_ptr<B
       return BindUpdate(reinterpret_cast<duckdb_libpgquery::PGUpdateStmt *>(stmt));
     case duckdb_libpgquery::T_PGIndexStmt:
       return BindIndex(reinterpret_cast<duckdb_libpgquery::PGIndexStmt *>(stmt));
+    case duckdb_libpgquery::T_PGVacuumStmt:
+      return BindAnalyze(reinterpret_cast<duckdb_libpgquery::PGVacuumStmt *>(stmt));
     case duckdb_libpgquery::T_PGVariableSetStmt:
       return BindVariableSet(reinterpret_cast<duckdb_libpgquery::PGVariableSetStmt *>(stmt));
     case duckdb_libpgquery::T_PGVariableShowStmt:
       return BindVariableShow(reinterpret_cast<duckdb_libpgquery::PGVariableShowStmt *>(stmt));
+    case duckdb_libpgquery::T_PGPrepareStmt:
+      return BindPrepare(reinterpret_cast<duckdb_libpgquery::PGPrepareStmt *>(stmt));
+    case duckdb_libpgquery::T_PGExecuteStmt:
+      return BindExecute(reinterpret_cast<duckdb_libpgquery::PGExecuteStmt *>(stmt));
+    case duckdb_libpgquery::T_PGDeallocateStmt:
+      return BindDeallocate(reinterpret_cast<duckdb_libpgquery::PGDeallocateStmt *>(stmt));
     default:
       throw NotImplementedException(NodeTagToString(stmt->type));
   }
@@ -71,6 +71,7 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
     // ֡ҳ
     if (pages_[frame_id].IsDirty()) {
       disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());// <----ҳд
+      ThreadStats().flushed_++;
       pages_[frame_id].is_dirty_ = false;
     }
     //֡Ӧҳڴ
@@ -92,6 +93,7 @@ auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
 //new ,fetchnewpageڻ´һҳûСfetchҳѾڻ
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   std::scoped_lock<std::mutex> lock(latch_);
+  ThreadStats().fetched_++;
   //page_table_չϣpage_id---frame_id
   frame_id_t frame_id;
   if (page_table_->Find(page_id, frame_id)) {
@@ -124,6 +126,7 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
 
     if (pages_[frame_id].IsDirty()) {
       disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());
+      ThreadStats().flushed_++;
       pages_[frame_id].is_dirty_ = false;
     }
     pages_[frame_id].ResetMemory();
@@ -139,6 +142,7 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   //Ҫĳҳʱҳδڻ
   //õһ֡ţضӦҳţ滹ûݣӴ̶ȡ
   disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());//Ӵ̶
+  ThreadStats().missed_++;
 
   replacer_->RecordAccess(frame_id);
   replacer_->SetEvictable(frame_id, false);
@@ -188,6 +192,7 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   }
   //ҳҳţҳдϣȥҳ
   disk_manager_->WritePage(page_id, pages_[frame_id].data_);//<---
+  ThreadStats().flushed_++;
   return true;
 }
 
@@ -0,0 +1,249 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_stats.cpp
+//
+// Identification: src/catalog/table_stats.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "catalog/table_stats.h"
+
+#include <algorithm>
+#include <random>
+
+#include "common/util/hyperloglog.h"
+#include "concurrency/transaction.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+#include "storage/table/table_cursor.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+namespace {
+
+auto Less(const Value &a, const Value &b) -> bool { return a.CompareLessThan(b) == CmpBool::CmpTrue; }
+
+auto Equal(const Value &a, const Value &b) -> bool { return a.CompareEquals(b) == CmpBool::CmpTrue; }
+
+/** @return false if the value is not a number and cannot be interpolated between two others */
+auto ToDouble(const Value &value, double *number) -> bool {
+  switch (value.GetTypeId()) {
+    case TypeId::TINYINT:
+      *number = value.GetAs<int8_t>();
+      return true;
+    case TypeId::SMALLINT:
+      *number = value.GetAs<int16_t>();
+      return true;
+    case TypeId::INTEGER:
+      *number = value.GetAs<int32_t>();
+      return true;
+    case TypeId::BIGINT:
+      *number = static_cast<double>(value.GetAs<int64_t>());
+      return true;
+    case TypeId::DECIMAL:
+      *number = value.GetAs<double>();
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** @return the fraction of the values summarized by a histogram that are less than a value */
+auto HistogramPosition(const std::vector<Value> &bounds, const Value &value) -> double {
+  if (bounds.empty() || !Less(bounds.front(), value)) {
+    return 0;
+  }
+  if (Less(bounds.back(), value)) {
+    return 1;
+  }
+  // The value lies in the bucket (bounds[i - 1], bounds[i]].
+  auto upper = std::lower_bound(bounds.begin(), bounds.end(), value, Less);
+  auto i = static_cast<size_t>(upper - bounds.begin());
+  double within = 0.5;
+  double low;
+  double high;
+  double number;
+  if (ToDouble(bounds[i - 1], &low) && ToDouble(bounds[i], &high) && ToDouble(value, &number) && high > low) {
+    within = (number - low) / (high - low);
+  }
+  return (static_cast<double>(i - 1) + within) / static_cast<double>(bounds.size() - 1);
+}
+
+}  // namespace
+
+auto ColumnStats::HistogramFraction() const -> double {
+  double fraction = 1 - null_fraction_;
+  for (const auto &[value, frequency] : most_common_) {
+    fraction -= frequency;
+  }
+  return std::max(0.0, fraction);
+}
+
+auto ColumnStats::EqualSelectivity(const Value &value) const -> double {
+  if (value.IsNull()) {
+    return 0;
+  }
+  for (const auto &[common, frequency] : most_common_) {
+    if (Equal(common, value)) {
+      return frequency;
+    }
+  }
+  // Assume the values that are not among the most common ones are equally frequent.
+  uint64_t others = distinct_ > most_common_.size() ? distinct_ - most_common_.size() : 1;
+  return HistogramFraction() / static_cast<double>(others);
+}
+
+auto ColumnStats::LessSelectivity(const Value &value, bool inclusive) const -> double {
+  double selectivity = 0;
+  bool is_common = false;
+  for (const auto &[common, frequency] : most_common_) {
+    if (Less(common, value)) {
+      selectivity += frequency;
+    } else if (Equal(common, value)) {
+      is_common = true;
+      selectivity += inclusive ? frequency : 0;
+    }
+  }
+  selectivity += HistogramFraction() * HistogramPosition(histogram_bounds_, value);
+  if (inclusive && !is_common) {
+    selectivity += EqualSelectivity(value);
+  }
+  return std::clamp(selectivity, 0.0, 1 - null_fraction_);
+}
+
+auto ColumnStats::RangeSelectivity(const Value *low, bool low_inclusive, const Value *high, bool high_inclusive) const
+    -> double {
+  double below_high = high != nullptr ? LessSelectivity(*high, high_inclusive) : 1 - null_fraction_;
+  double below_low = low != nullptr ? LessSelectivity(*low, !low_inclusive) : 0;
+  return std::clamp(below_high - below_low, 0.0, 1.0);
+}
+
+auto TableStats::Collect(TableHeap *table, const Schema &schema, const std::vector<uint32_t> &col_ids,
+                         Transaction *txn) -> TableStats {
+  TableStats stats;
+  stats.columns_.resize(schema.GetColumnCount());
+  stats.page_count_ = table->GetPageCount();
+
+  // Count the NULLs and distinct values of every row, and keep a uniform sample of the rows (reservoir sampling).
+  std::vector<HyperLogLog> sketches(col_ids.size());
+  std::vector<uint64_t> nulls(col_ids.size());
+  std::vector<std::vector<Value>> sample;
+  std::mt19937_64 gen(0);
+  {
+    TableCursor cursor(table, txn != nullptr && txn->ReadsSnapshot() ? txn : nullptr);
+    Tuple tuple;
+    while (cursor.Next(&tuple)) {
+      std::vector<Value> row;
+      row.reserve(col_ids.size());
+      for (size_t i = 0; i < col_ids.size(); i++) {
+        row.push_back(tuple.GetValue(&schema, col_ids[i]));
+        if (row.back().IsNull()) {
+          nulls[i]++;
+        } else {
+          sketches[i].Add(row.back());
+        }
+      }
+      stats.row_count_++;
+      if (sample.size() < SAMPLE_ROWS) {
+        sample.push_back(std::move(row));
+      } else if (auto slot = std::uniform_int_distribution<uint64_t>(0, stats.row_count_ - 1)(gen);
+                 slot < SAMPLE_ROWS) {
+        sample[slot] = std::move(row);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < col_ids.size(); i++) {
+    ColumnStats column;
+    column.null_fraction_ =
+        stats.row_count_ == 0 ? 0 : static_cast<double>(nulls[i]) / static_cast<double>(stats.row_count_);
+
+    std::vector<Value> values;
+    for (const auto &row : sample) {
+      if (!row[i].IsNull()) {
+        values.push_back(row[i]);
+      }
+    }
+    std::sort(values.begin(), values.end(), Less);
+    // Runs of equal values as (first index, length).
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (size_t begin = 0; begin < values.size();) {
+      size_t end = begin + 1;
+      while (end < values.size() && Equal(values[begin], values[end])) {
+        end++;
+      }
+      runs.emplace_back(begin, end - begin);
+      begin = end;
+    }
+    // A sample of the whole table counts the distinct values exactly.
+    column.distinct_ =
+        sample.size() == stats.row_count_ ? runs.size() : std::max<uint64_t>(sketches[i].Estimate(), runs.size());
+
+    // A value is common if it is more frequent than the average one, and every value is if there are only a few.
+    std::vector<size_t> by_frequency(runs.size());
+    for (size_t run = 0; run < runs.size(); run++) {
+      by_frequency[run] = run;
+    }
+    std::stable_sort(by_frequency.begin(), by_frequency.end(),
+                     [&runs](size_t a, size_t b) { return runs[a].second > runs[b].second; });
+    bool all_common = runs.size() <= MAX_MOST_COMMON;
+    double average = runs.empty() ? 0 : static_cast<double>(values.size()) / static_cast<double>(runs.size());
+    double frequency_per_value = values.empty() ? 0 : (1 - column.null_fraction_) / static_cast<double>(values.size());
+    std::vector<bool> is_common(runs.size(), false);
+    for (size_t j = 0; j < by_frequency.size() && j < MAX_MOST_COMMON; j++) {
+      auto [begin, count] = runs[by_frequency[j]];
+      if (!all_common && (count < 2 || static_cast<double>(count) <= 1.25 * average)) {
+        break;
+      }
+      is_common[by_frequency[j]] = true;
+      column.most_common_.emplace_back(values[begin], static_cast<double>(count) * frequency_per_value);
+    }
+
+    // The bounds of the histogram split the other values into buckets of the same size.
+    std::vector<Value> others;
+    for (size_t run = 0; run < runs.size(); run++) {
+      if (!is_common[run]) {
+        others.insert(others.end(), values.begin() + runs[run].first,
+                      values.begin() + runs[run].first + runs[run].second);
+      }
+    }
+    if (!others.empty()) {
+      size_t buckets = std::max<size_t>(1, std::min(HISTOGRAM_BUCKETS, others.size() - 1));
+      for (size_t bucket = 0; bucket <= buckets; bucket++) {
+        column.histogram_bounds_.push_back(others[bucket * (others.size() - 1) / buckets]);
+      }
+    }
+    stats.columns_[col_ids[i]] = std::move(column);
+  }
+  return stats;
+}
+
+auto TableStats::ToString(const Schema &schema) const -> std::string {
+  std::vector<std::string> columns;
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    if (!columns_[i].has_value()) {
+      continue;
+    }
+    const auto &column = *columns_[i];
+    std::vector<std::string> most_common;
+    for (const auto &[value, frequency] : column.most_common_) {
+      most_common.push_back(fmt::format("{}:{:.3f}", value.ToString(), frequency));
+    }
+    std::string histogram = column.histogram_bounds_.empty()
+                                ? "[]"
+                                : fmt::format("[{}..{}]/{}", column.histogram_bounds_.front().ToString(),
+                                              column.histogram_bounds_.back().ToString(),
+                                              column.histogram_bounds_.size() - 1);
+    columns.push_back(fmt::format("{} {{ null_fraction={:.3f}, distinct={}, most_common=[{}], histogram={} }}",
+                                  schema.GetColumn(i).GetName(), column.null_fraction_, column.distinct_,
+                                  fmt::join(most_common, ", "), histogram));
+  }
+  return fmt::format("rows={}, pages={}\n{}", row_count_, page_count_, fmt::join(columns, "\n"));
+}
+
+}  // namespace bustub
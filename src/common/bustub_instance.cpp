@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <optional>
 #include <shared_mutex>
 #include <string>
@@ -6,14 +8,17 @@
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
 #include "binder/bound_statement.h"
+#include "binder/statement/analyze_statement.h"
 #include "binder/statement/create_statement.h"
 #include "binder/statement/explain_statement.h"
 #include "binder/statement/index_statement.h"
+#include "binder/statement/prepare_statement.h"
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
+#include "catalog/table_stats.h"
 #include "common/bustub_instance.h"
 #include "common/enums/statement_type.h"
 #include "common/exception.h"
@@ -21,13 +26,16 @@
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "execution/execution_engine.h"
+#include "execution/execution_profile.h"
 #include "execution/executor_context.h"
 #include "execution/executors/mock_scan_executor.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "fmt/ranges.h"
 #include "optimizer/optimizer.h"
+#include "planner/plan_cache.h"
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
@@ -71,6 +79,9 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Old tuple versions of snapshot isolation.
+  txn_manager_->StartGarbageCollection();
 }
 
 BustubInstance::BustubInstance() {
@@ -103,6 +114,9 @@ BustubInstance::BustubInstance() {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Old tuple versions of snapshot isolation.
+  txn_manager_->StartGarbageCollection();
 }
 
 void BustubInstance::CmdDisplayTables(ResultWriter &writer) {
@@ -146,6 +160,119 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+/** Tables and rows with the most lock waits `\\locks` shows */
+static constexpr size_t TOP_CONTENDED = 10;
+
+/** @return a latency in the largest unit that keeps it above one */
+static auto FormatNanos(uint64_t nanos) -> std::string {
+  if (nanos < 1000) {
+    return fmt::format("{}ns", nanos);
+  }
+  if (nanos < 1000 * 1000) {
+    return fmt::format("{:.1f}us", nanos / 1e3);
+  }
+  return fmt::format("{:.1f}ms", nanos / 1e6);
+}
+
+void BustubInstance::CmdDisplayLocks(const std::string &option, ResultWriter &writer) {
+  auto &metrics = lock_manager_->GetMetrics();
+  if (option == "json") {
+    WriteOneCell(metrics.ToJson(), writer);
+    return;
+  }
+  if (option == "reset") {
+    metrics.Reset();
+    WriteOneCell("Lock metrics reset", writer);
+    return;
+  }
+  if (!option.empty()) {
+    throw Exception(fmt::format("unsupported option of \\locks: {}", option));
+  }
+
+  // Latencies are the upper bounds of power-of-two histogram buckets.
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  for (const auto *header : {"resource", "mode", "acquired", "waited", "failed", "upgrades", "acquire_p50",
+                             "acquire_p99", "wait_p50", "wait_p99", "wait_total", "hold_p50", "hold_p99"}) {
+    writer.WriteHeaderCell(header);
+  }
+  writer.EndHeader();
+  for (size_t resource = 0; resource < LockMetrics::RESOURCES; resource++) {
+    for (size_t mode = 0; mode < LockMetrics::MODES; mode++) {
+      const auto &mode_metrics = metrics.Mode(static_cast<LockMetrics::Resource>(resource), mode);
+      if (mode_metrics.acquired_ == 0 && mode_metrics.failed_ == 0) {
+        continue;
+      }
+      writer.BeginRow();
+      writer.WriteCell(LockMetrics::RESOURCE_NAMES[resource]);
+      writer.WriteCell(LockMetrics::MODE_NAMES[mode]);
+      for (const auto &counter :
+           {&mode_metrics.acquired_, &mode_metrics.waited_, &mode_metrics.failed_, &mode_metrics.upgrades_}) {
+        writer.WriteCell(fmt::format("{}", counter->load()));
+      }
+      writer.WriteCell(FormatNanos(mode_metrics.acquire_.Percentile(0.5)));
+      writer.WriteCell(FormatNanos(mode_metrics.acquire_.Percentile(0.99)));
+      writer.WriteCell(FormatNanos(mode_metrics.wait_.Percentile(0.5)));
+      writer.WriteCell(FormatNanos(mode_metrics.wait_.Percentile(0.99)));
+      writer.WriteCell(FormatNanos(mode_metrics.wait_.TotalNanos()));
+      writer.WriteCell(FormatNanos(mode_metrics.hold_.Percentile(0.5)));
+      writer.WriteCell(FormatNanos(mode_metrics.hold_.Percentile(0.99)));
+      writer.EndRow();
+    }
+  }
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("event");
+  writer.WriteHeaderCell("count");
+  writer.EndHeader();
+  auto waits = metrics.waits_.load();
+  for (const auto &[name, count] : std::vector<std::pair<std::string, uint64_t>>{
+           {"committed_txns", metrics.committed_txns_},
+           {"aborted_txns", metrics.aborted_txns_},
+           {"validation_failures", metrics.validation_failures_},
+           {"waits", waits},
+           {"avg_waiting_queue_length", waits == 0 ? 0 : metrics.waiting_queue_length_ / waits},
+           {"max_queue_length", metrics.max_queue_length_},
+           {"upgrade_conflicts", metrics.upgrade_conflicts_},
+           {"escalations", metrics.escalations_},
+           {"deadlocks", metrics.deadlocks_},
+           {"wait_die_aborts", metrics.wait_die_aborts_},
+           {"wounds", metrics.wounds_},
+           {"no_wait_aborts", metrics.no_wait_aborts_}}) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(fmt::format("{}", count));
+    writer.EndRow();
+  }
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("contended");
+  writer.WriteHeaderCell("waits");
+  writer.WriteHeaderCell("wait_total");
+  writer.EndHeader();
+  for (const auto &[oid, contention] : metrics.TopTables(TOP_CONTENDED)) {
+    const auto *table_info = catalog_->GetTable(oid);
+    writer.BeginRow();
+    writer.WriteCell(fmt::format("table {}", table_info == Catalog::NULL_TABLE_INFO ? std::to_string(oid)
+                                                                                      : table_info->name_));
+    writer.WriteCell(fmt::format("{}", contention.waits_));
+    writer.WriteCell(FormatNanos(contention.wait_nanos_));
+    writer.EndRow();
+  }
+  for (const auto &[rid, contention] : metrics.TopRows(TOP_CONTENDED)) {
+    writer.BeginRow();
+    writer.WriteCell(fmt::format("row {}:{}", rid.GetPageId(), rid.GetSlotNum()));
+    writer.WriteCell(fmt::format("{}", contention.waits_));
+    writer.WriteCell(FormatNanos(contention.wait_nanos_));
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -159,6 +286,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\locks: show lock manager and transaction metrics; `\locks json` dumps them as JSON, `\locks reset` clears them
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -167,7 +295,10 @@ of the query, so it's normal that you'll get a wrong result when executing
 unsupported SQL queries. This shell will be able to run `create table` only
 after you have completed the buffer pool manager. It will be able to execute SQL
 queries after you have implemented necessary query executors. Use `explain` to
-see the execution plan of your query.
+see the execution plan of your query, and `analyze <table>` to collect the
+statistics the optimizer estimates row counts from. `prepare <name> as <query>`
+and `execute <name>(<values>)` run a query with parameters `$1`, `$2`, ...
+without planning it again.
 )";
   WriteOneCell(help, writer);
 }
@@ -195,159 +326,362 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayHelp(writer);
       return true;
     }
+    if (StringUtil::StartsWith(sql, "\\locks")) {
+      CmdDisplayLocks(StringUtil::Strip(sql.substr(6), ' '), writer);
+      return true;
+    }
     throw Exception(fmt::format("unsupported internal command: {}", sql));
   }
 
-  bool is_successful = true;
+  // A statement executed again with other constants reuses the plan made the first time.
+  if (auto parameterized = PlanCache::Parameterize(sql); parameterized.has_value()) {
+    auto cached = GetCachedPlan(parameterized->query_, parameterized->params_, false);
+    if (cached->plan_ != nullptr) {
+      return ExecutePlan(PlanCache::BindParameters(cached->plan_, parameterized->params_), *cached->output_schema_,
+                         writer, txn);
+    }
+  }
 
   std::shared_lock<std::shared_mutex> l(catalog_lock_);
-  bustub::Binder binder(*catalog_);
-  binder.ParseAndSave(sql);
+  auto binder = std::make_unique<bustub::Binder>(*catalog_);
+  binder->ParseAndSave(sql);
   l.unlock();
 
-  for (auto *stmt : binder.statement_nodes_) {
-    auto statement = binder.BindStatement(stmt);
-    switch (statement->type_) {
-      case StatementType::CREATE_STATEMENT: {
-        const auto &create_stmt = dynamic_cast<const CreateStatement &>(*statement);
+  // The parser keeps one parse tree per thread, which planning a prepared statement replaces. Each statement is
+  // therefore parsed on its own, and its parse tree is released once it is bound.
+  if (binder->statement_nodes_.size() > 1) {
+    auto statements = binder->GetStatementTexts();
+    binder.reset();
+    bool is_successful = true;
+    for (const auto &statement : statements) {
+      is_successful &= ExecuteSqlTxn(statement, writer, txn);
+    }
+    return is_successful;
+  }
+  if (binder->statement_nodes_.empty()) {
+    return true;
+  }
+  auto statement = binder->BindStatement(binder->statement_nodes_[0]);
+  binder.reset();
+
+  switch (statement->type_) {
+    case StatementType::CREATE_STATEMENT: {
+      const auto &create_stmt = dynamic_cast<const CreateStatement &>(*statement);
 
-        std::unique_lock<std::shared_mutex> l(catalog_lock_);
-        auto info = catalog_->CreateTable(txn, create_stmt.table_, Schema(create_stmt.columns_));
-        l.unlock();
+      std::unique_lock<std::shared_mutex> l(catalog_lock_);
+      auto info = catalog_->CreateTable(txn, create_stmt.table_, Schema(create_stmt.columns_));
+      l.unlock();
 
-        if (info == nullptr) {
-          throw bustub::Exception("Failed to create table");
+      if (info == nullptr) {
+        throw bustub::Exception("Failed to create table");
+      }
+      WriteOneCell(fmt::format("Table created with id = {}", info->oid_), writer);
+      return true;
+    }
+    case StatementType::INDEX_STATEMENT: {
+      const auto &index_stmt = dynamic_cast<const IndexStatement &>(*statement);
+
+      std::vector<uint32_t> col_ids;
+      for (const auto &col : index_stmt.cols_) {
+        auto idx = index_stmt.table_->schema_.GetColIdx(col->col_name_.back());
+        col_ids.push_back(idx);
+        if (index_stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
+          throw NotImplementedException("only support creating index on integer column");
         }
-        WriteOneCell(fmt::format("Table created with id = {}", info->oid_), writer);
-        continue;
       }
-      case StatementType::INDEX_STATEMENT: {
-        const auto &index_stmt = dynamic_cast<const IndexStatement &>(*statement);
+      if (col_ids.size() != 1) {
+        throw NotImplementedException("only support creating index with exactly one column");
+      }
+      auto key_schema = Schema::CopySchema(&index_stmt.table_->schema_, col_ids);
+
+      std::unique_lock<std::shared_mutex> l(catalog_lock_);
+      auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
+          txn, index_stmt.index_name_, index_stmt.table_->table_, index_stmt.table_->schema_, key_schema, col_ids,
+          INTEGER_SIZE, IntegerHashFunctionType{});
+      l.unlock();
+
+      if (info == nullptr) {
+        throw bustub::Exception("Failed to create index");
+      }
+      WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
+      return true;
+    }
+    case StatementType::ANALYZE_STATEMENT: {
+      const auto &analyze_stmt = dynamic_cast<const AnalyzeStatement &>(*statement);
+      std::vector<std::string> table_names;
+      if (analyze_stmt.table_ != nullptr) {
+        table_names.push_back(analyze_stmt.table_->table_);
+      } else {
+        std::shared_lock<std::shared_mutex> l(catalog_lock_);
+        table_names = catalog_->GetTableNames();
+        l.unlock();
+        std::sort(table_names.begin(), table_names.end());
+      }
+
+      std::vector<std::string> output;
+      for (const auto &table_name : table_names) {
+        std::shared_lock<std::shared_mutex> l(catalog_lock_);
+        auto *table_info = catalog_->GetTable(table_name);
+        auto previous = catalog_->GetTableStats(table_info->oid_);
+        l.unlock();
+        if (table_info->table_ == nullptr) {
+          // Mock tables are generated by their scans, there is nothing to analyze.
+          if (analyze_stmt.table_ != nullptr) {
+            throw NotImplementedException(fmt::format("cannot analyze {}, it has no table heap", table_name));
+          }
+          continue;
+        }
 
         std::vector<uint32_t> col_ids;
-        for (const auto &col : index_stmt.cols_) {
-          auto idx = index_stmt.table_->schema_.GetColIdx(col->col_name_.back());
-          col_ids.push_back(idx);
-          if (index_stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
-            throw NotImplementedException("only support creating index on integer column");
+        for (const auto &col : analyze_stmt.cols_) {
+          col_ids.push_back(table_info->schema_.GetColIdx(col->col_name_.back()));
+        }
+        if (col_ids.empty()) {
+          for (uint32_t i = 0; i < table_info->schema_.GetColumnCount(); i++) {
+            col_ids.push_back(i);
           }
         }
-        if (col_ids.size() != 1) {
-          throw NotImplementedException("only support creating index with exactly one column");
+        // Scan the table without holding the catalog lock, the statistics are published once complete.
+        auto stats = std::make_shared<TableStats>(
+            TableStats::Collect(table_info->table_.get(), table_info->schema_, col_ids, txn));
+        if (previous != nullptr) {
+          // Keep the statistics of the columns that were not analyzed this time.
+          for (size_t i = 0; i < stats->columns_.size(); i++) {
+            if (!stats->columns_[i].has_value()) {
+              stats->columns_[i] = previous->columns_[i];
+            }
+          }
         }
-        auto key_schema = Schema::CopySchema(&index_stmt.table_->schema_, col_ids);
 
-        std::unique_lock<std::shared_mutex> l(catalog_lock_);
-        auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
-            txn, index_stmt.index_name_, index_stmt.table_->table_, index_stmt.table_->schema_, key_schema, col_ids,
-            INTEGER_SIZE, IntegerHashFunctionType{});
-        l.unlock();
+        std::unique_lock<std::shared_mutex> ul(catalog_lock_);
+        catalog_->SetTableStats(table_info->oid_, stats);
+        ul.unlock();
 
-        if (info == nullptr) {
-          throw bustub::Exception("Failed to create index");
+        output.push_back(fmt::format("Table {} analyzed: {} rows, {} pages", table_name, stats->row_count_,
+                                     stats->page_count_));
+        if (analyze_stmt.verbose_) {
+          output.push_back(stats->ToString(table_info->schema_));
         }
-        WriteOneCell(fmt::format("Index created with id = {}", info->index_oid_), writer);
-        continue;
       }
-      case StatementType::VARIABLE_SHOW_STATEMENT: {
-        const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
-        auto content = GetSessionVariable(show_stmt.variable_);
-        WriteOneCell(fmt::format("{}={}", show_stmt.variable_, content), writer);
-        continue;
+      WriteOneCell(fmt::format("{}", fmt::join(output, "\n")), writer);
+      return true;
+    }
+    case StatementType::VARIABLE_SHOW_STATEMENT: {
+      const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
+      auto content = GetSessionVariable(show_stmt.variable_);
+      WriteOneCell(fmt::format("{}={}", show_stmt.variable_, content), writer);
+      return true;
+    }
+    case StatementType::VARIABLE_SET_STATEMENT: {
+      const auto &set_stmt = dynamic_cast<const VariableSetStatement &>(*statement);
+      session_variables_[set_stmt.variable_] = set_stmt.value_;
+      // The cached plans were optimized with the previous session variables.
+      plan_cache_.Clear();
+      return true;
+    }
+    case StatementType::PREPARE_STATEMENT: {
+      const auto &prepare_stmt = dynamic_cast<const PrepareStatement &>(*statement);
+      if (!prepare_stmt.types_.empty()) {
+        // Report the errors of the query now, the values of the parameters are given when it is executed.
+        std::vector<Value> params;
+        for (auto type : prepare_stmt.types_) {
+          params.push_back(ValueFactory::GetNullValueByType(type));
+        }
+        GetCachedPlan(prepare_stmt.query_, params, true);
       }
-      case StatementType::VARIABLE_SET_STATEMENT: {
-        const auto &set_stmt = dynamic_cast<const VariableSetStatement &>(*statement);
-        session_variables_[set_stmt.variable_] = set_stmt.value_;
-        continue;
+      auto prepared =
+          std::make_shared<const PrepareStatement>(prepare_stmt.name_, prepare_stmt.types_, prepare_stmt.query_);
+      std::scoped_lock lock(prepared_statements_latch_);
+      prepared_statements_[prepare_stmt.name_] = std::move(prepared);
+      return true;
+    }
+    case StatementType::EXECUTE_STATEMENT: {
+      const auto &execute_stmt = dynamic_cast<const ExecuteStatement &>(*statement);
+      std::shared_ptr<const PrepareStatement> prepared;
+      {
+        std::scoped_lock lock(prepared_statements_latch_);
+        auto iter = prepared_statements_.find(execute_stmt.name_);
+        if (iter == prepared_statements_.end()) {
+          throw Exception(fmt::format("prepared statement {} does not exist", execute_stmt.name_));
+        }
+        prepared = iter->second;
       }
-      case StatementType::EXPLAIN_STATEMENT: {
-        const auto &explain_stmt = dynamic_cast<const ExplainStatement &>(*statement);
-        std::string output;
-
-        // Print binder result.
-        if ((explain_stmt.options_ & ExplainOptions::BINDER) != 0) {
-          output += "=== BINDER ===";
-          output += "\n";
-          output += explain_stmt.statement_->ToString();
-          output += "\n";
+      const auto &types = prepared->types_;
+      auto params = execute_stmt.params_;
+      if (!types.empty() && params.size() != types.size()) {
+        throw Exception(fmt::format("prepared statement {} expects {} parameters, got {}", execute_stmt.name_,
+                                    types.size(), params.size()));
+      }
+      for (size_t i = 0; i < types.size(); i++) {
+        if (params[i].GetTypeId() != types[i]) {
+          params[i] = params[i].CastAs(types[i]);
         }
+      }
+      auto cached = GetCachedPlan(prepared->query_, params, true);
+      return ExecutePlan(PlanCache::BindParameters(cached->plan_, params), *cached->output_schema_, writer, txn);
+    }
+    case StatementType::DEALLOCATE_STATEMENT: {
+      const auto &deallocate_stmt = dynamic_cast<const DeallocateStatement &>(*statement);
+      std::scoped_lock lock(prepared_statements_latch_);
+      if (deallocate_stmt.name_.empty()) {
+        prepared_statements_.clear();
+      } else if (prepared_statements_.erase(deallocate_stmt.name_) == 0) {
+        throw Exception(fmt::format("prepared statement {} does not exist", deallocate_stmt.name_));
+      }
+      return true;
+    }
+    case StatementType::EXPLAIN_STATEMENT: {
+      const auto &explain_stmt = dynamic_cast<const ExplainStatement &>(*statement);
+      std::string output;
+
+      // Print binder result.
+      if ((explain_stmt.options_ & ExplainOptions::BINDER) != 0) {
+        output += "=== BINDER ===";
+        output += "\n";
+        output += explain_stmt.statement_->ToString();
+        output += "\n";
+      }
 
-        std::shared_lock<std::shared_mutex> l(catalog_lock_);
-
-        bustub::Planner planner(*catalog_);
-        planner.PlanQuery(*explain_stmt.statement_);
+      std::shared_lock<std::shared_mutex> l(catalog_lock_);
 
-        bool show_schema = (explain_stmt.options_ & ExplainOptions::SCHEMA) != 0;
+      bustub::Planner planner(*catalog_);
+      planner.PlanQuery(*explain_stmt.statement_);
 
-        // Print planner result.
-        if ((explain_stmt.options_ & ExplainOptions::PLANNER) != 0) {
-          output += "=== PLANNER ===";
-          output += "\n";
-          output += planner.plan_->ToString(show_schema);
-          output += "\n";
-        }
+      bool show_schema = (explain_stmt.options_ & ExplainOptions::SCHEMA) != 0;
 
-        // Print optimizer result.
-        bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
-        auto optimized_plan = optimizer.Optimize(planner.plan_);
+      // Print planner result.
+      if ((explain_stmt.options_ & ExplainOptions::PLANNER) != 0) {
+        output += "=== PLANNER ===";
+        output += "\n";
+        output += planner.plan_->ToString(show_schema);
+        output += "\n";
+      }
 
-        l.unlock();
+      // Print optimizer result.
+      bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
+      auto optimized_plan = optimizer.Optimize(planner.plan_);
 
-        if ((explain_stmt.options_ & ExplainOptions::OPTIMIZER) != 0) {
-          output += "=== OPTIMIZER ===";
-          output += "\n";
-          output += optimized_plan->ToString(show_schema);
-          output += "\n";
-        }
+      l.unlock();
 
-        WriteOneCell(output, writer);
+      if ((explain_stmt.options_ & ExplainOptions::OPTIMIZER) != 0) {
+        output += "=== OPTIMIZER ===";
+        output += "\n";
+        output += optimized_plan->ToString(show_schema);
+        output += "\n";
+      }
 
-        continue;
+      // Execute the optimized plan with every executor instrumented, and print what each plan node did.
+      if ((explain_stmt.options_ & ExplainOptions::ANALYZE) != 0) {
+        ExecutionProfile profile;
+        auto exec_ctx = MakeExecutorContext(txn);
+        exec_ctx->SetProfile(&profile);
+        auto start = std::chrono::steady_clock::now();
+        auto is_successful = execution_engine_->Execute(optimized_plan, nullptr, txn, exec_ctx.get());
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        l.lock();
+        output += "=== ANALYZE ===";
+        output += "\n";
+        output += profile.ToString(*optimized_plan, [&](const AbstractPlanNode &plan) {
+          return optimizer.EstimateRows(plan);
+        });
+        output += "\n";
+        l.unlock();
+        output += fmt::format("Execution time: {:.3f}ms{}", elapsed, is_successful ? "" : " (failed)");
+        output += "\n";
       }
-      default:
-        break;
+
+      WriteOneCell(output, writer);
+
+      return true;
     }
+    default:
+      break;
+  }
 
-    std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  l.lock();
 
-    // Plan the query.
-    bustub::Planner planner(*catalog_);
-    planner.PlanQuery(*statement);
+  // Plan the query.
+  bustub::Planner planner(*catalog_);
+  planner.PlanQuery(*statement);
 
-    // Optimize the query.
-    bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
-    auto optimized_plan = optimizer.Optimize(planner.plan_);
+  // Optimize the query.
+  bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
+  auto optimized_plan = optimizer.Optimize(planner.plan_);
 
-    l.unlock();
+  l.unlock();
 
-    // Execute the query.
-    //ִй
-    auto exec_ctx = MakeExecutorContext(txn);
-    std::vector<Tuple> result_set{};
-    //Żִмƻ
-    is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get());
+  return ExecutePlan(optimized_plan, planner.plan_->OutputSchema(), writer, txn);
+}
 
-    // Return the result set as a vector of string.
-    auto schema = planner.plan_->OutputSchema();
+auto BustubInstance::GetCachedPlan(const std::string &query, const std::vector<Value> &params, bool prepared)
+    -> std::shared_ptr<const CachedPlan> {
+  auto key = PlanCache::Key(query, params);
+  std::shared_lock<std::shared_mutex> l(catalog_lock_);
+  auto catalog_version = catalog_->GetVersion();
+  // A prepared statement cached as uncacheable is planned again for its error.
+  auto cached = plan_cache_.Get(key, catalog_version);
+  if (cached != nullptr && (cached->plan_ != nullptr || !prepared)) {
+    return cached;
+  }
 
-    // Generate header for the result set.
-    writer.BeginTable(false);
-    writer.BeginHeader();
-    for (const auto &column : schema.GetColumns()) {
-      writer.WriteHeaderCell(column.GetName());
+  auto plan = std::make_shared<CachedPlan>();
+  plan->catalog_version_ = catalog_version;
+  try {
+    bustub::Binder binder(*catalog_);
+    for (const auto &param : params) {
+      binder.parameter_types_.push_back(param.GetTypeId());
+    }
+    binder.ParseAndSave(query);
+    // Multiple statements and the statements without a plan, e.g. CREATE TABLE, are left uncached. A prepared query
+    // is always a single SELECT, INSERT, UPDATE or DELETE.
+    auto statement = binder.statement_nodes_.size() == 1 ? binder.BindStatement(binder.statement_nodes_[0]) : nullptr;
+    if (statement != nullptr &&
+        (statement->type_ == StatementType::SELECT_STATEMENT || statement->type_ == StatementType::INSERT_STATEMENT ||
+         statement->type_ == StatementType::UPDATE_STATEMENT || statement->type_ == StatementType::DELETE_STATEMENT)) {
+      bustub::Planner planner(*catalog_);
+      planner.PlanQuery(*statement);
+      bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
+      plan->plan_ = optimizer.Optimize(planner.plan_);
+      plan->output_schema_ = planner.plan_->output_schema_;
     }
-    writer.EndHeader();
+  } catch (const std::exception &) {
+    if (prepared) {
+      throw;
+    }
+    // Remember that the statement is executed without the plan cache.
+    plan->plan_ = nullptr;
+  }
+  plan_cache_.Put(key, plan);
+  return plan;
+}
 
-    // Transforming result set into strings.
-    for (const auto &tuple : result_set) {
-      writer.BeginRow();
-      for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
-        writer.WriteCell(tuple.GetValue(&schema, i).ToString());
-      }
-      writer.EndRow();
+auto BustubInstance::ExecutePlan(const AbstractPlanNodeRef &plan, const Schema &schema, ResultWriter &writer,
+                                 Transaction *txn) -> bool {
+  // Execute the query.
+  //ִй
+  auto exec_ctx = MakeExecutorContext(txn);
+  std::vector<Tuple> result_set{};
+  //Żִмƻ
+  auto is_successful = execution_engine_->Execute(plan, &result_set, txn, exec_ctx.get());
+
+  // Generate header for the result set.
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  for (const auto &column : schema.GetColumns()) {
+    writer.WriteHeaderCell(column.GetName());
+  }
+  writer.EndHeader();
+
+  // Transforming result set into strings.
+  for (const auto &tuple : result_set) {
+    writer.BeginRow();
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      writer.WriteCell(tuple.GetValue(&schema, i).ToString());
     }
-    writer.EndTable();
+    writer.EndRow();
   }
+  writer.EndTable();
 
   return is_successful;
 }
@@ -393,6 +727,7 @@ BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  txn_manager_->StopGarbageCollection();
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
@@ -12,12 +12,41 @@
 
 #include "common/config.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT
+
 namespace bustub {
 
 std::atomic<bool> enable_logging(false);
 
 std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
-std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
+std::atomic<DeadlockPolicy> deadlock_policy(DeadlockPolicy::DETECTION);
+
+std::atomic<size_t> lock_escalation_threshold(1000);
+
+std::atomic<bool> enable_batched_row_locks(true);
+
+std::atomic<bool> enable_lock_metrics(true);
+
+std::atomic<bool> enable_parallel_aggregation(true);
+
+std::atomic<size_t> aggregation_parallelism(std::max<size_t>(1, std::thread::hardware_concurrency()));
+
+std::atomic<size_t> aggregation_spill_threshold(64 << 20);
+
+std::atomic<bool> enable_adaptive_join(false);
+
+std::atomic<size_t> adaptive_join_buffer_rows(1024);
+
+std::atomic<size_t> hash_join_spill_threshold(64 << 20);
+
+std::atomic<size_t> nested_loop_join_block_size(1 << 20);
+
+std::atomic<bool> enable_zero_copy_scan(true);
+
+std::atomic<size_t> topn_parallelism(std::max<size_t>(1, std::thread::hardware_concurrency()));
+
+std::chrono::milliseconds version_gc_interval = std::chrono::milliseconds(50);
 
 }  // namespace bustub
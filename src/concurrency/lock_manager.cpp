@@ -18,6 +18,24 @@
 
 namespace bustub {
 
+/** Partition and queue latches the thread has taken to lock rows, see RowLatchCount() */
+thread_local uint64_t row_latch_count = 0;
+
+template <typename K, typename Hash>
+auto LockManager::GetOrCreateQueue(LockTablePartition<K, Hash> *partition, const K &key) -> LockRequestQueue * {
+  auto iter = partition->lock_map_.find(key);
+  if (iter != partition->lock_map_.end()) {
+    return iter->second.get();
+  }
+  if (partition->free_queues_.empty()) {
+    return partition->lock_map_.emplace(key, std::make_unique<LockRequestQueue>()).first->second.get();
+  }
+  auto node = std::move(partition->free_queues_.back());
+  partition->free_queues_.pop_back();
+  node.key() = key;
+  return partition->lock_map_.insert(std::move(node)).position->second.get();
+}
+
 auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
   //뼶𣺶δύ  
   //ǰģʽ ԶSISSIX
@@ -51,31 +69,38 @@ auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oi
   }
   //ȡһmap:table_oid --> request
   //  ϱ
-  table_lock_map_latch_.lock();
+  auto requested_at = LockMetrics::Now();
+  auto &partition = TablePartition(oid);
+  partition.latch_.lock();
   //oid ûжУԼһ
-  if (table_lock_map_.find(oid) == table_lock_map_.end()) {
-    table_lock_map_.emplace(oid, std::make_shared<LockRequestQueue>());
-  }
   //ҵoid Ӧ
-  auto lock_request_queue = table_lock_map_.find(oid)->second;
+  auto *lock_request_queue = GetOrCreateQueue(&partition, oid);
   lock_request_queue->latch_.lock();//Ȱ
-  table_lock_map_latch_.unlock();
+  partition.latch_.unlock();
   
   //
-  for (auto request : lock_request_queue->request_queue_) {  // NOLINT
+  for (auto iter = lock_request_queue->request_queue_.begin(); iter != lock_request_queue->request_queue_.end();
+       ++iter) {
+    auto *request = &*iter;
   //ȥѭУûidǰid
   //ж¾
     if (request->txn_id_ == txn->GetTransactionId()) {
       //grantedһΪtrue,Ϊ֮ǰûбͨᱻlockmanagerУȥȡһ
       //ģʽֱͬӷ
-      if (request->lock_mode_ == lock_mode) {//ģʽ͵ǰģʽͬ ظ
+      if (CoversLock(request->lock_mode_, lock_mode)) {//ģʽ͵ǰģʽͬ ظ
         lock_request_queue->latch_.unlock();//ֱӷأѾ
         return true;
       }
+      // S and IX together are SIX.
+      if ((request->lock_mode_ == LockMode::SHARED && lock_mode == LockMode::INTENTION_EXCLUSIVE) ||
+          (request->lock_mode_ == LockMode::INTENTION_EXCLUSIVE && lock_mode == LockMode::SHARED)) {
+        lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+      }
       //ıԭжͻ
       if (lock_request_queue->upgrading_ != INVALID_TXN_ID) {//Դֻһ
         lock_request_queue->latch_.unlock();
         txn->SetState(TransactionState::ABORTED);//ǰж
+        metrics_.upgrade_conflicts_.fetch_add(1, LockMetrics::Relaxed());
         throw TransactionAbortException(txn->GetTransactionId(), AbortReason::UPGRADE_CONFLICT);
       }
       //ʷrequestT1ǰT2lock_mode   
@@ -95,37 +120,43 @@ auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oi
         throw TransactionAbortException(txn->GetTransactionId(), AbortReason::INCOMPATIBLE_UPGRADE);
       }
       //㣬Ȱʷrequest ӶƳ
-      lock_request_queue->request_queue_.remove(request);
+      lock_request_queue->Release(iter);
       //ȨrequestҪ     ɾfalseʾɾ
-      InsertOrDeleteTableLockSet(txn, request, false);
+      InsertOrDeleteTableLockSet(txn, *request, false);
       //һ¼  ڵ¼
-      auto upgrade_lock_request = std::make_shared<LockRequest>(txn->GetTransactionId(), lock_mode, oid);
+      LockRequest upgrade_request(txn->GetTransactionId(), lock_mode, oid);
       //ҵһ δλãȼǰ
-      std::list<std::shared_ptr<LockRequest>>::iterator lr_iter;
+      std::list<LockRequest>::iterator lr_iter;
       for (lr_iter = lock_request_queue->request_queue_.begin(); lr_iter != lock_request_queue->request_queue_.end();
            lr_iter++) {
-        if (!(*lr_iter)->granted_) {
+        if (!lr_iter->granted_) {
           break;
         }
       }
       // µڵ¼   ² һδλãʹģ͵ȴ  Ȩ
       //  ¼  뵽λ
-      lock_request_queue->request_queue_.insert(lr_iter, upgrade_lock_request);
+      auto *upgrade_lock_request = lock_request_queue->Insert(lr_iter, upgrade_request);
       //ԴΪ 
       lock_request_queue->upgrading_ = txn->GetTransactionId();
+      metrics_.Upgrading(LockMetrics::Resource::TABLE, static_cast<size_t>(lock_mode));
       
 
       //
       std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
       //ȴģ  ¼ûеĻһwait()ȴ
       //ڵȴ״̬
+      uint64_t wait_start = 0;
       while (!GrantLock(upgrade_lock_request, lock_request_queue)) {
-        lock_request_queue->cv_.wait(lock);//  cv_
+        if (wait_start == 0) {
+          wait_start = metrics_.Waiting(lock_request_queue->request_queue_.size());
+        }
+        WaitForGrant(txn, upgrade_lock_request, lock_request_queue, &lock);//  cv_
         
         //״̬ǷΪֹ ΪĳЩԭʱȣֹôȡĳӦֹͣ
         if (txn->GetState() == TransactionState::ABORTED) {
+          MarkFailed(LockMetrics::Resource::TABLE, upgrade_lock_request, wait_start);
           lock_request_queue->upgrading_ = INVALID_TXN_ID;//ֹʧ
-          lock_request_queue->request_queue_.remove(upgrade_lock_request);//ӶƳ¼
+          lock_request_queue->Release(upgrade_lock_request);//ӶƳ¼
           lock_request_queue->cv_.notify_all();//֪ͨ߳
           //еȴָʾạ֪̃߳ǰѾֹԳԻȡ
           return false;
@@ -135,8 +166,8 @@ auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oi
       }
 
       lock_request_queue->upgrading_ = INVALID_TXN_ID;// ֵΪЧֵ ζ ǰ¼ ɹ
-      upgrade_lock_request->granted_ = true;//־
-      InsertOrDeleteTableLockSet(txn, upgrade_lock_request, true);//ϣ
+      MarkGranted(LockMetrics::Resource::TABLE, upgrade_lock_request, requested_at, wait_start);//־
+      InsertOrDeleteTableLockSet(txn, *upgrade_lock_request, true);//ϣ
 
       if (lock_mode != LockMode::EXCLUSIVE) {//ֻҪǰT2ģʽ ꣬Ϳ֪̳ͨ߳Իȡǰˣ
         lock_request_queue->cv_.notify_all();
@@ -147,22 +178,27 @@ auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oi
   //lock table ûظtxn_id ֱӼӵĩβȴȨ
   //
   //µڵ㣬ȴ
-  auto lock_request = std::make_shared<LockRequest>(txn->GetTransactionId(), lock_mode, oid);//µ ¼
-  lock_request_queue->request_queue_.push_back(lock_request);
+  auto *lock_request = lock_request_queue->Insert(lock_request_queue->request_queue_.end(),
+                                                  LockRequest(txn->GetTransactionId(), lock_mode, oid));//µ ¼
 
   std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
+  uint64_t wait_start = 0;
   while (!GrantLock(lock_request, lock_request_queue)) {
-    lock_request_queue->cv_.wait(lock);
+    if (wait_start == 0) {
+      wait_start = metrics_.Waiting(lock_request_queue->request_queue_.size());
+    }
+    WaitForGrant(txn, lock_request, lock_request_queue, &lock);
     if (txn->GetState() == TransactionState::ABORTED) {
-      lock_request_queue->request_queue_.remove(lock_request);
+      MarkFailed(LockMetrics::Resource::TABLE, lock_request, wait_start);
+      lock_request_queue->Release(lock_request);
       lock_request_queue->cv_.notify_all();
       return false;
     }
   }
 
-  lock_request->granted_ = true;//ɹȨ
+  MarkGranted(LockMetrics::Resource::TABLE, lock_request, requested_at, wait_start);//ɹȨ
   //ֻע   ı
-  InsertOrDeleteTableLockSet(txn, lock_request, true);
+  InsertOrDeleteTableLockSet(txn, *lock_request, true);
 
   if (lock_mode != LockMode::EXCLUSIVE) {
     lock_request_queue->cv_.notify_all();
@@ -172,10 +208,12 @@ auto LockManager::LockTable(Transaction *txn, LockMode lock_mode, const table_oi
 }
 
 auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool {
-  table_lock_map_latch_.lock();
+  auto &partition = TablePartition(oid);
+  partition.latch_.lock();
   //1mapвڶӦıid
-  if (table_lock_map_.find(oid) == table_lock_map_.end()) {
-    table_lock_map_latch_.unlock();
+  auto iter = partition.lock_map_.find(oid);
+  if (iter == partition.lock_map_.end()) {
+    partition.latch_.unlock();
     txn->SetState(TransactionState::ABORTED);
     throw bustub::TransactionAbortException(txn->GetTransactionId(), AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
   }
@@ -187,21 +225,25 @@ auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool
 
   if (!(s_row_lock_set->find(oid) == s_row_lock_set->end() || s_row_lock_set->at(oid).empty()) ||
       !(x_row_lock_set->find(oid) == x_row_lock_set->end() || x_row_lock_set->at(oid).empty())) {
-    table_lock_map_latch_.unlock();
+    partition.latch_.unlock();
     txn->SetState(TransactionState::ABORTED);
     throw bustub::TransactionAbortException(txn->GetTransactionId(), AbortReason::TABLE_UNLOCKED_BEFORE_UNLOCKING_ROWS);
   }
 
-  auto lock_request_queue = table_lock_map_[oid];
+  auto *lock_request_queue = iter->second.get();
 
   lock_request_queue->latch_.lock();
-  table_lock_map_latch_.unlock();
+  partition.latch_.unlock();
   //3ҵqueueڵ㳢Խ
-  for (auto lock_request : lock_request_queue->request_queue_) {  // NOLINT
+  for (auto lr_iter = lock_request_queue->request_queue_.begin(); lr_iter != lock_request_queue->request_queue_.end();
+       ++lr_iter) {
   //ʷеid ͵ǰid
-    if (lock_request->txn_id_ == txn->GetTransactionId() && lock_request->granted_) {
+    if (lr_iter->txn_id_ == txn->GetTransactionId() && lr_iter->granted_) {
+      LockRequest lock_request = *lr_iter;
+      metrics_.Released(LockMetrics::Resource::TABLE, static_cast<size_t>(lock_request.lock_mode_),
+                        lock_request.granted_at_);
       //н
-      lock_request_queue->request_queue_.remove(lock_request);
+      lock_request_queue->Release(lr_iter);
 
       lock_request_queue->cv_.notify_all();//֪̼ͨ߳ӽ
       lock_request_queue->latch_.unlock();
@@ -210,11 +252,11 @@ auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool
       //ύͶδύͷXshrinking״̬
       //ͬĸ뼶ȥ״̬
       if ((txn->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ &&
-           (lock_request->lock_mode_ == LockMode::SHARED || lock_request->lock_mode_ == LockMode::EXCLUSIVE)) ||
+           (lock_request.lock_mode_ == LockMode::SHARED || lock_request.lock_mode_ == LockMode::EXCLUSIVE)) ||
           (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED &&
-           lock_request->lock_mode_ == LockMode::EXCLUSIVE) ||
+           lock_request.lock_mode_ == LockMode::EXCLUSIVE) ||
           (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED &&
-           lock_request->lock_mode_ == LockMode::EXCLUSIVE)) {
+           lock_request.lock_mode_ == LockMode::EXCLUSIVE)) {
             //ĵǰ״̬ύֹ״̬
         if (txn->GetState() != TransactionState::COMMITTED && txn->GetState() != TransactionState::ABORTED) {
           txn->SetState(TransactionState::SHRINKING);//״̬
@@ -231,7 +273,7 @@ auto LockManager::UnlockTable(Transaction *txn, const table_oid_t &oid) -> bool
   throw bustub::TransactionAbortException(txn->GetTransactionId(), AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
 }
 
-auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
+auto LockManager::CheckRowLock(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> void {
   //ǰģʽ ֻS|Xͳͳ
   if (lock_mode == LockMode::INTENTION_EXCLUSIVE || lock_mode == LockMode::INTENTION_SHARED ||
       lock_mode == LockMode::SHARED_INTENTION_EXCLUSIVE) {
@@ -274,17 +316,24 @@ auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_
       throw TransactionAbortException(txn->GetTransactionId(), AbortReason::TABLE_LOCK_NOT_PRESENT);
     }
   }
+}
+
+auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool {
+  CheckRowLock(txn, lock_mode, oid);
+  auto requested_at = LockMetrics::Now();
   // rid
-  row_lock_map_latch_.lock();
-  if (row_lock_map_.find(rid) == row_lock_map_.end()) {
-    row_lock_map_.emplace(rid, std::make_shared<LockRequestQueue>());
-  }
+  auto &partition = RowPartition(rid);
+  partition.latch_.lock();
+  row_latch_count++;
   //ҵ
-  auto lock_request_queue = row_lock_map_.find(rid)->second;
+  auto *lock_request_queue = GetOrCreateQueue(&partition, rid);
   lock_request_queue->latch_.lock();
-  row_lock_map_latch_.unlock();
+  row_latch_count++;
+  partition.latch_.unlock();
 
-  for (auto request : lock_request_queue->request_queue_) {  // NOLINT
+  for (auto iter = lock_request_queue->request_queue_.begin(); iter != lock_request_queue->request_queue_.end();
+       ++iter) {
+    auto *request = &*iter;
   //
   //Ӧм
     if (request->txn_id_ == txn->GetTransactionId()) {
@@ -296,6 +345,7 @@ auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_
       if (lock_request_queue->upgrading_ != INVALID_TXN_ID) {
         lock_request_queue->latch_.unlock();
         txn->SetState(TransactionState::ABORTED);
+        metrics_.upgrade_conflicts_.fetch_add(1, LockMetrics::Relaxed());
         throw TransactionAbortException(txn->GetTransactionId(), AbortReason::UPGRADE_CONFLICT);
       }
 
@@ -313,36 +363,42 @@ auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_
         throw TransactionAbortException(txn->GetTransactionId(), AbortReason::INCOMPATIBLE_UPGRADE);
       }
       //ǰ   
-      lock_request_queue->request_queue_.remove(request);
-      InsertOrDeleteRowLockSet(txn, request, false);//ɾ
-      auto upgrade_lock_request = std::make_shared<LockRequest>(txn->GetTransactionId(), lock_mode, oid, rid);
+      lock_request_queue->Release(iter);
+      InsertOrDeleteRowLockSet(txn, *request, false);//ɾ
+      LockRequest upgrade_request(txn->GetTransactionId(), lock_mode, oid, rid);
       
       //ҵһûλ
-      std::list<std::shared_ptr<LockRequest>>::iterator lr_iter;
+      std::list<LockRequest>::iterator lr_iter;
       for (lr_iter = lock_request_queue->request_queue_.begin(); lr_iter != lock_request_queue->request_queue_.end();
            lr_iter++) {
-        if (!(*lr_iter)->granted_) {
+        if (!lr_iter->granted_) {
           break;
         }
       }
-      lock_request_queue->request_queue_.insert(lr_iter, upgrade_lock_request);
+      auto *upgrade_lock_request = lock_request_queue->Insert(lr_iter, upgrade_request);
       lock_request_queue->upgrading_ = txn->GetTransactionId();
+      metrics_.Upgrading(LockMetrics::Resource::ROW, static_cast<size_t>(lock_mode));
 
       std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
+      uint64_t wait_start = 0;
       while (!GrantLock(upgrade_lock_request, lock_request_queue)) {
-        lock_request_queue->cv_.wait(lock);
+        if (wait_start == 0) {
+          wait_start = metrics_.Waiting(lock_request_queue->request_queue_.size());
+        }
+        WaitForGrant(txn, upgrade_lock_request, lock_request_queue, &lock);
         if (txn->GetState() == TransactionState::ABORTED) {
+          MarkFailed(LockMetrics::Resource::ROW, upgrade_lock_request, wait_start);
           lock_request_queue->upgrading_ = INVALID_TXN_ID;
-          lock_request_queue->request_queue_.remove(upgrade_lock_request);
+          lock_request_queue->Release(upgrade_lock_request);
           lock_request_queue->cv_.notify_all();
           return false;
         }
       }
 
       lock_request_queue->upgrading_ = INVALID_TXN_ID;
-      upgrade_lock_request->granted_ = true;
+      MarkGranted(LockMetrics::Resource::ROW, upgrade_lock_request, requested_at, wait_start);
       //е 
-      InsertOrDeleteRowLockSet(txn, upgrade_lock_request, true);
+      InsertOrDeleteRowLockSet(txn, *upgrade_lock_request, true);
 
       if (lock_mode != LockMode::EXCLUSIVE) {
         lock_request_queue->cv_.notify_all();
@@ -352,121 +408,435 @@ auto LockManager::LockRow(Transaction *txn, LockMode lock_mode, const table_oid_
   }
 
   //
-  auto lock_request = std::make_shared<LockRequest>(txn->GetTransactionId(), lock_mode, oid, rid);
-  lock_request_queue->request_queue_.push_back(lock_request);
+  auto *lock_request = lock_request_queue->Insert(lock_request_queue->request_queue_.end(),
+                                                  LockRequest(txn->GetTransactionId(), lock_mode, oid, rid));
 
   std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
   //ȴģ жǰԺ󣬵ǰ¼ 赽
+  uint64_t wait_start = 0;
   while (!GrantLock(lock_request, lock_request_queue)) {
-    lock_request_queue->cv_.wait(lock);
+    if (wait_start == 0) {
+      wait_start = metrics_.Waiting(lock_request_queue->request_queue_.size());
+    }
+    WaitForGrant(txn, lock_request, lock_request_queue, &lock);
     if (txn->GetState() == TransactionState::ABORTED) {
-      lock_request_queue->request_queue_.remove(lock_request);
+      MarkFailed(LockMetrics::Resource::ROW, lock_request, wait_start);
+      lock_request_queue->Release(lock_request);
       lock_request_queue->cv_.notify_all();
       return false;
     }
   }
 
-  lock_request->granted_ = true;
-  InsertOrDeleteRowLockSet(txn, lock_request, true);//뵽
+  MarkGranted(LockMetrics::Resource::ROW, lock_request, requested_at, wait_start);
+  InsertOrDeleteRowLockSet(txn, *lock_request, true);//뵽
 
   if (lock_mode != LockMode::EXCLUSIVE) {
     lock_request_queue->cv_.notify_all();
   }
+  lock.unlock();
+
+  auto threshold = lock_escalation_threshold.load();
+  if (threshold != 0) {
+    size_t row_locks = (*txn->GetSharedRowLockSet())[oid].size() + (*txn->GetExclusiveRowLockSet())[oid].size();
+    // A failed escalation is retried every `threshold` rows rather than on every row.
+    if (row_locks >= threshold && row_locks % threshold == 0) {
+      TryEscalate(txn, lock_mode, oid);
+    }
+  }
+  return true;
+}
+
+auto LockManager::LockRows(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, std::vector<RID> rids)
+    -> bool {
+  CheckRowLock(txn, lock_mode, oid);
+  // Every batch locks its rows in the same order, partition by partition, so two batches never wait for each other.
+  auto row_order = [](const RID &a, const RID &b) {
+    auto a_partition = PartitionIndex(std::hash<RID>()(a));
+    auto b_partition = PartitionIndex(std::hash<RID>()(b));
+    return a_partition != b_partition ? a_partition < b_partition : a.Get() < b.Get();
+  };
+  std::sort(rids.begin(), rids.end(), row_order);
+  rids.erase(std::unique(rids.begin(), rids.end()), rids.end());
+
+  auto requested_at = LockMetrics::Now();
+  size_t next = 0;
+  bool must_wait = !enable_batched_row_locks;
+  while (!must_wait && next < rids.size()) {
+    size_t partition_index = PartitionIndex(std::hash<RID>()(rids[next]));
+    auto &partition = row_lock_partitions_[partition_index];
+    std::scoped_lock partition_lock(partition.latch_);
+    row_latch_count++;
+    for (; next < rids.size() && PartitionIndex(std::hash<RID>()(rids[next])) == partition_index; next++) {
+      if (!TryGrantRowLock(txn, lock_mode, oid, rids[next], &partition, requested_at)) {
+        must_wait = true;
+        break;
+      }
+    }
+  }
+
+  // The first row that has to wait, and every row after it, go through LockRow() in the same order.
+  for (; next < rids.size(); next++) {
+    if (IsRowLockCovered(txn, lock_mode, oid)) {
+      return true;
+    }
+    if (!LockRow(txn, lock_mode, oid, rids[next])) {
+      return false;
+    }
+  }
+
+  auto threshold = lock_escalation_threshold.load();
+  if (threshold != 0 && !IsRowLockCovered(txn, lock_mode, oid)) {
+    size_t row_locks = (*txn->GetSharedRowLockSet())[oid].size() + (*txn->GetExclusiveRowLockSet())[oid].size();
+    if (row_locks >= threshold) {
+      TryEscalate(txn, lock_mode, oid);
+    }
+  }
+  return true;
+}
+
+auto LockManager::TryGrantRowLock(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid,
+                                  LockTablePartition<RID, std::hash<RID>> *partition, uint64_t requested_at) -> bool {
+  auto iter = partition->lock_map_.find(rid);
+  if (iter == partition->lock_map_.end()) {
+    // Nobody can reach a new queue before the partition latch is released, so it is filled without its own latch.
+    auto *lock_request_queue = GetOrCreateQueue(partition, rid);
+    auto *lock_request = lock_request_queue->Insert(lock_request_queue->request_queue_.end(),
+                                                    LockRequest(txn->GetTransactionId(), lock_mode, oid, rid));
+    MarkGranted(LockMetrics::Resource::ROW, lock_request, requested_at, 0);
+    InsertOrDeleteRowLockSet(txn, *lock_request, true);
+    return true;
+  }
+
+  auto *lock_request_queue = iter->second.get();
+  std::scoped_lock queue_lock(lock_request_queue->latch_);
+  row_latch_count++;
+  auto &requests = lock_request_queue->request_queue_;
+  for (auto &request : requests) {
+    if (request.txn_id_ == txn->GetTransactionId()) {
+      if (request.lock_mode_ == lock_mode || request.lock_mode_ == LockMode::EXCLUSIVE) {
+        return true;
+      }
+      // S is upgraded to X in place if nobody else holds or waits for the row, otherwise the upgrade has to queue.
+      if (requests.size() != 1) {
+        return false;
+      }
+      metrics_.Upgrading(LockMetrics::Resource::ROW, static_cast<size_t>(lock_mode));
+      InsertOrDeleteRowLockSet(txn, request, false);
+      request.lock_mode_ = lock_mode;
+      MarkGranted(LockMetrics::Resource::ROW, &request, requested_at, 0);
+      InsertOrDeleteRowLockSet(txn, request, true);
+      return true;
+    }
+  }
+  for (const auto &request : requests) {
+    if (!request.granted_ || !AreLocksCompatible(request.lock_mode_, lock_mode)) {
+      return false;
+    }
+  }
+  auto *lock_request =
+      lock_request_queue->Insert(requests.end(), LockRequest(txn->GetTransactionId(), lock_mode, oid, rid));
+  MarkGranted(LockMetrics::Resource::ROW, lock_request, requested_at, 0);
+  InsertOrDeleteRowLockSet(txn, *lock_request, true);
   return true;
 }
 
+auto LockManager::RowLatchCount() -> uint64_t { return row_latch_count; }
+
 auto LockManager::UnlockRow(Transaction *txn, const table_oid_t &oid, const RID &rid) -> bool {
-  row_lock_map_latch_.lock();
-  //ϣڹϣ棬ЧĽ
-  if (row_lock_map_.find(rid) == row_lock_map_.end()) {
-    row_lock_map_latch_.unlock();
+  LockMode lock_mode;
+  if (!ReleaseRowLock(txn, rid, &lock_mode)) {
+    //ûи׳쳣
     txn->SetState(TransactionState::ABORTED);
     throw bustub::TransactionAbortException(txn->GetTransactionId(), AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
   }
-  auto lock_request_queue = row_lock_map_[rid];
+  //״̬
+  if ((txn->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ &&
+       (lock_mode == LockMode::SHARED || lock_mode == LockMode::EXCLUSIVE)) ||
+      (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED && lock_mode == LockMode::EXCLUSIVE) ||
+      (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED && lock_mode == LockMode::EXCLUSIVE)) {
+    if (txn->GetState() != TransactionState::COMMITTED && txn->GetState() != TransactionState::ABORTED) {
+      txn->SetState(TransactionState::SHRINKING);
+    }
+  }
+
+  InsertOrDeleteRowLockSet(txn, LockRequest(txn->GetTransactionId(), lock_mode, oid, rid), false);
+  return true;
+}
+
+auto LockManager::LockKey(Transaction *txn, LockMode lock_mode, const index_oid_t &index_oid, int64_t key) -> bool {
+  if (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED && lock_mode == LockMode::SHARED) {
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn->GetTransactionId(), AbortReason::LOCK_SHARED_ON_READ_UNCOMMITTED);
+  }
+  if (txn->GetState() == TransactionState::SHRINKING) {
+    txn->SetState(TransactionState::ABORTED);
+    throw TransactionAbortException(txn->GetTransactionId(), AbortReason::LOCK_ON_SHRINKING);
+  }
 
+  auto requested_at = LockMetrics::Now();
+  IndexKey index_key{index_oid, key};
+  auto &partition = KeyPartition(index_key);
+  partition.latch_.lock();
+  auto *lock_request_queue = GetOrCreateQueue(&partition, index_key);
   lock_request_queue->latch_.lock();
-  row_lock_map_latch_.unlock();
-  
-  
-  for (auto lock_request : lock_request_queue->request_queue_) {  // NOLINT
-    if (lock_request->txn_id_ == txn->GetTransactionId() && lock_request->granted_) {
-      lock_request_queue->request_queue_.remove(lock_request);
+  partition.latch_.unlock();
+  std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
+
+  LockRequest request(txn->GetTransactionId(), lock_mode, index_oid, key);
+  auto pos = lock_request_queue->request_queue_.end();
+  bool upgrade = false;
+  for (auto iter = lock_request_queue->request_queue_.begin(); iter != lock_request_queue->request_queue_.end();
+       ++iter) {
+    if (iter->txn_id_ != txn->GetTransactionId()) {
+      continue;
+    }
+    if (CoversLock(iter->lock_mode_, lock_mode)) {
+      return true;
+    }
+    if (lock_request_queue->upgrading_ != INVALID_TXN_ID) {
+      txn->SetState(TransactionState::ABORTED);
+      metrics_.upgrade_conflicts_.fetch_add(1, LockMetrics::Relaxed());
+      throw TransactionAbortException(txn->GetTransactionId(), AbortReason::UPGRADE_CONFLICT);
+    }
+    if ((iter->lock_mode_ == LockMode::SHARED && lock_mode == LockMode::INTENTION_EXCLUSIVE) ||
+        (iter->lock_mode_ == LockMode::INTENTION_EXCLUSIVE && lock_mode == LockMode::SHARED)) {
+      request.lock_mode_ = LockMode::SHARED_INTENTION_EXCLUSIVE;
+    }
+    // The upgraded request goes ahead of every waiting one.
+    lock_request_queue->Release(iter);
+    pos = std::find_if(lock_request_queue->request_queue_.begin(), lock_request_queue->request_queue_.end(),
+                       [](const LockRequest &lr) { return !lr.granted_; });
+    lock_request_queue->upgrading_ = txn->GetTransactionId();
+    metrics_.Upgrading(LockMetrics::Resource::KEY, static_cast<size_t>(request.lock_mode_));
+    upgrade = true;
+    break;
+  }
 
+  auto *lock_request = lock_request_queue->Insert(pos, request);
+  uint64_t wait_start = 0;
+  while (!GrantLock(lock_request, lock_request_queue)) {
+    if (wait_start == 0) {
+      wait_start = metrics_.Waiting(lock_request_queue->request_queue_.size());
+    }
+    WaitForGrant(txn, lock_request, lock_request_queue, &lock);
+    if (txn->GetState() == TransactionState::ABORTED) {
+      MarkFailed(LockMetrics::Resource::KEY, lock_request, wait_start);
+      if (upgrade) {
+        // The lock held before the upgrade is gone as well.
+        lock_request_queue->upgrading_ = INVALID_TXN_ID;
+        (*txn->GetKeyLockSet())[index_oid].erase(key);
+      }
+      lock_request_queue->Release(lock_request);
       lock_request_queue->cv_.notify_all();
-      lock_request_queue->latch_.unlock();
-      //״̬
-      if ((txn->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ &&
-           (lock_request->lock_mode_ == LockMode::SHARED || lock_request->lock_mode_ == LockMode::EXCLUSIVE)) ||
-          (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED &&
-           lock_request->lock_mode_ == LockMode::EXCLUSIVE) ||
-          (txn->GetIsolationLevel() == IsolationLevel::READ_UNCOMMITTED &&
-           lock_request->lock_mode_ == LockMode::EXCLUSIVE)) {
-        if (txn->GetState() != TransactionState::COMMITTED && txn->GetState() != TransactionState::ABORTED) {
-          txn->SetState(TransactionState::SHRINKING);
-        }
+      return false;
+    }
+  }
+
+  if (upgrade) {
+    lock_request_queue->upgrading_ = INVALID_TXN_ID;
+  }
+  MarkGranted(LockMetrics::Resource::KEY, lock_request, requested_at, wait_start);
+  (*txn->GetKeyLockSet())[index_oid].insert(key);
+  if (lock_request->lock_mode_ != LockMode::EXCLUSIVE) {
+    lock_request_queue->cv_.notify_all();
+  }
+  return true;
+}
+
+auto LockManager::UnlockKey(Transaction *txn, const index_oid_t &index_oid, int64_t key) -> bool {
+  LockMode lock_mode;
+  if (!ReleaseLock(txn, &KeyPartition(IndexKey{index_oid, key}), IndexKey{index_oid, key}, &lock_mode)) {
+    return false;
+  }
+  auto keys = txn->GetKeyLockSet()->find(index_oid);
+  if (keys != txn->GetKeyLockSet()->end()) {
+    keys->second.erase(key);
+  }
+  return true;
+}
+
+auto LockManager::LockNextKey(Transaction *txn, LockMode lock_mode, const index_oid_t &index_oid,
+                              const std::function<int64_t()> &next_key) -> bool {
+  int64_t key = next_key();
+  while (true) {
+    if (!LockKey(txn, lock_mode, index_oid, key)) {
+      return false;
+    }
+    int64_t current = next_key();
+    if (current == key) {
+      return true;
+    }
+    // A key was inserted into the gap, or the locked one deleted, before the lock was granted.
+    key = current;
+  }
+}
+
+auto LockManager::ReleaseRowLock(Transaction *txn, const RID &rid, LockMode *lock_mode) -> bool {
+  return ReleaseLock(txn, &RowPartition(rid), rid, lock_mode);
+}
+
+template <typename K, typename Hash>
+auto LockManager::ReleaseLock(Transaction *txn, LockTablePartition<K, Hash> *partition, const K &key,
+                              LockMode *lock_mode) -> bool {
+  std::scoped_lock partition_lock(partition->latch_);
+  //ϣڹϣ棬ЧĽ
+  auto iter = partition->lock_map_.find(key);
+  if (iter == partition->lock_map_.end()) {
+    return false;
+  }
+  auto *lock_request_queue = iter->second.get();
+
+  std::unique_lock queue_lock(lock_request_queue->latch_);
+  for (auto lr_iter = lock_request_queue->request_queue_.begin(); lr_iter != lock_request_queue->request_queue_.end();
+       ++lr_iter) {
+    if (lr_iter->txn_id_ == txn->GetTransactionId() && lr_iter->granted_) {
+      *lock_mode = lr_iter->lock_mode_;
+      metrics_.Released(std::is_same_v<K, RID> ? LockMetrics::Resource::ROW : LockMetrics::Resource::KEY,
+                        static_cast<size_t>(*lock_mode), lr_iter->granted_at_);
+      lock_request_queue->Release(lr_iter);
+
+      lock_request_queue->cv_.notify_all();
+      bool unused = lock_request_queue->request_queue_.empty();
+      queue_lock.unlock();
+      if (unused) {
+        // Nobody holds or waits for the resource, and nobody can reach its queue without the partition latch, so the
+        // map node and the queue can be recycled for another resource.
+        partition->free_queues_.push_back(partition->lock_map_.extract(iter));
       }
+      return true;
+    }
+  }
+  return false;
+}
 
-      InsertOrDeleteRowLockSet(txn, lock_request, false);
+auto LockManager::TryLockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
+  if (txn->GetState() != TransactionState::GROWING) {
+    return false;
+  }
+  LockMode held;
+  if (GetTableLockMode(txn, oid, &held)) {
+    if (CoversLock(held, lock_mode)) {
       return true;
     }
+    // Apart from S and IX, which make SIX, any mode the held one does not cover is an upgrade LockTable() allows.
+    if ((held == LockMode::SHARED && lock_mode == LockMode::INTENTION_EXCLUSIVE) ||
+        (held == LockMode::INTENTION_EXCLUSIVE && lock_mode == LockMode::SHARED)) {
+      lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+    }
   }
-  //ûи׳쳣
-  lock_request_queue->latch_.unlock();
-  txn->SetState(TransactionState::ABORTED);
-  throw bustub::TransactionAbortException(txn->GetTransactionId(), AbortReason::ATTEMPTED_UNLOCK_BUT_NO_LOCK_HELD);
+
+  auto requested_at = LockMetrics::Now();
+  auto &partition = TablePartition(oid);
+  partition.latch_.lock();
+  auto *lock_request_queue = GetOrCreateQueue(&partition, oid);
+  lock_request_queue->latch_.lock();
+  partition.latch_.unlock();
+  std::unique_lock<std::mutex> lock(lock_request_queue->latch_, std::adopt_lock);
+  // Changing a granted mode while someone waits would change what the waiter waits for behind the back of the
+  // waits-for graph, so only lock when every request in the queue is granted.
+  LockRequest *own_request = nullptr;
+  for (auto &lr : lock_request_queue->request_queue_) {
+    if (!lr.granted_) {
+      return false;
+    }
+    if (lr.txn_id_ == txn->GetTransactionId()) {
+      own_request = &lr;
+    } else if (!AreLocksCompatible(lr.lock_mode_, lock_mode)) {
+      return false;
+    }
+  }
+  if (own_request == nullptr) {
+    own_request = lock_request_queue->Insert(lock_request_queue->request_queue_.end(),
+                                             LockRequest(txn->GetTransactionId(), lock_mode, oid));
+  } else {
+    metrics_.Upgrading(LockMetrics::Resource::TABLE, static_cast<size_t>(lock_mode));
+    InsertOrDeleteTableLockSet(txn, *own_request, false);
+    own_request->lock_mode_ = lock_mode;
+  }
+  MarkGranted(LockMetrics::Resource::TABLE, own_request, requested_at, 0);
+  InsertOrDeleteTableLockSet(txn, *own_request, true);
+  return true;
+}
+
+auto LockManager::TryEscalate(Transaction *txn, LockMode row_mode, const table_oid_t &oid) -> bool {
+  LockMode held;
+  if (!GetTableLockMode(txn, oid, &held)) {
+    return false;
+  }
+  LockMode escalated = LockMode::EXCLUSIVE;
+  if (row_mode == LockMode::SHARED) {
+    escalated = held == LockMode::INTENTION_EXCLUSIVE ? LockMode::SHARED_INTENTION_EXCLUSIVE : LockMode::SHARED;
+  }
+  if (CoversLock(held, escalated) || !TryLockTable(txn, escalated, oid)) {
+    return false;
+  }
+
+  // Any escalated mode covers the S rows, only X covers the X rows.
+  std::vector<std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>>> row_lock_sets{
+      txn->GetSharedRowLockSet()};
+  if (escalated == LockMode::EXCLUSIVE) {
+    row_lock_sets.push_back(txn->GetExclusiveRowLockSet());
+  }
+  for (const auto &row_lock_set : row_lock_sets) {
+    auto rows = row_lock_set->find(oid);
+    if (rows == row_lock_set->end()) {
+      continue;
+    }
+    for (const auto &rid : rows->second) {
+      LockMode lock_mode;
+      ReleaseRowLock(txn, rid, &lock_mode);
+    }
+    rows->second.clear();
+  }
+  metrics_.escalations_.fetch_add(1, LockMetrics::Relaxed());
+  return true;
 }
 
 void LockManager::AddEdge(txn_id_t t1, txn_id_t t2) {
-  //ͼе񼯺
-  txn_set_.insert(t1);
-  txn_set_.insert(t2);
+  std::scoped_lock graph_lock(waits_for_latch_);
   //ִбĶt1t2
   //ȴͼ
   waits_for_[t1].push_back(t2);
 }
 
 void LockManager::RemoveEdge(txn_id_t t1, txn_id_t t2) {
-    //ҵt1 t2λõ
-  auto iter = std::find(waits_for_[t1].begin(), waits_for_[t1].end(), t2);
-  if (iter != waits_for_[t1].end()) {
-    waits_for_[t1].erase(iter);
+  std::scoped_lock graph_lock(waits_for_latch_);
+  auto edges = waits_for_.find(t1);
+  if (edges == waits_for_.end()) {
+    return;
+  }
+  auto iter = std::find(edges->second.begin(), edges->second.end(), t2);
+  if (iter != edges->second.end()) {
+    edges->second.erase(iter);
+  }
+  if (edges->second.empty()) {
+    waits_for_.erase(edges);
   }
 }
 
 auto LockManager::HasCycle(txn_id_t *txn_id) -> bool {
-    //Ƿл
-  for (auto const &start_txn_id : txn_set_) {//мϣͼееĶ
-    if (Dfs(start_txn_id)) {//ѵĻ
-      *txn_id = *active_set_.begin();//Ծϵid   
-      for (auto const &active_txn_id : active_set_) {
-        *txn_id = std::max(*txn_id, active_txn_id);//лʱֹҲǱIDΪIDǵġ
-      }
-      active_set_.clear();
+  std::scoped_lock graph_lock(waits_for_latch_);
+  std::vector<txn_id_t> sources;
+  sources.reserve(waits_for_.size());
+  for (const auto &[source, edges] : waits_for_) {
+    sources.push_back(source);
+  }
+  std::sort(sources.begin(), sources.end());
+  for (auto source : sources) {
+    std::unordered_set<txn_id_t> visited{source};
+    std::vector<txn_id_t> cycle;
+    if (FindCycle(source, source, &visited, &cycle)) {
+      // Abort the newest transaction on the cycle, as WaitForGrant() does.
+      *txn_id = *std::max_element(cycle.begin(), cycle.end());
       return true;
     }
-
-    active_set_.clear();
   }
-  //мͼе֮󣬲ܶ϶ûл
   return false;
 }
 
-auto LockManager::DeleteNode(txn_id_t txn_id) -> void {
-    //ǰѳɾˣtxn_id = 2
-    //2 ---> 3,9
-  waits_for_.erase(txn_id);//ͨͼɾ 
-
-  for (auto a_txn_id : txn_set_) {
-    //ɾ
-    //1 --->2,3,5,9   2ɵ  1 --->,3,5,9 
-    if (a_txn_id != txn_id) {
-      RemoveEdge(a_txn_id, txn_id);
-    }
-  }
-}
 //õ ļ
 auto LockManager::GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
+  std::scoped_lock graph_lock(waits_for_latch_);
   std::vector<std::pair<txn_id_t, txn_id_t>> result;
   //һͼϣ key-value   ȴͼ
   for (auto const &pair : waits_for_) {
@@ -478,133 +848,208 @@ auto LockManager::GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>> {
   return result;
 }
 
-void LockManager::RunCycleDetection() {
-  while (enable_cycle_detection_) {//true һ̨
-    std::this_thread::sleep_for(cycle_detection_interval);//ʱ
-    //ÿsleep֮󣬶̬һͼ
-    {  // TODO(students): detect deadlock
-      table_lock_map_latch_.lock();
-      row_lock_map_latch_.lock();
-      //кͱmapҪ˶Ҫ
-      //1̬ͼ
-      //1.1 Աϵ
-      for (auto &pair : table_lock_map_) {//Ĺϣ keyǱID,value
-        std::unordered_set<txn_id_t> granted_set;
-        pair.second->latch_.lock();//м
-        //һͬһʱֻһ
-        //table001 -- T100 T200 T300
-        //table002 -- T110 T300 T310
-        //е
-        for (auto const &lock_request : pair.second->request_queue_) {
-        //ڹelse
-          if (lock_request->granted_) {
-            granted_set.emplace(lock_request->txn_id_);
-          } else {//ûȨģҪȴ
-          //ñǣȴֹʱҪҵӦ֪ͨ
-            for (auto txn_id : granted_set) {
-                //ϣûбȨ񼯺
-              map_txn_oid_.emplace(lock_request->txn_id_, lock_request->oid_);
-              //ûбȨĹУлĹбֹҪmap_txn_oid_¼һ
-              //һ񣬶ӦһԴ
-              //ǰûбȨӶȨ
-              AddEdge(lock_request->txn_id_, txn_id);
-              //ǰڵȴǰѾȨ
-            }
-          }
-        }
-        pair.second->latch_.unlock();
-      }
-      //1.2 ϵ
-      for (auto &pair : row_lock_map_) {
-        std::unordered_set<txn_id_t> granted_set;
-        pair.second->latch_.lock();
-        for (auto const &lock_request : pair.second->request_queue_) {
-          if (lock_request->granted_) {
-            granted_set.emplace(lock_request->txn_id_);
-          } else {
-            for (auto txn_id : granted_set) {
-                //ûȨģйϣ¼IDӦԴ
-              map_txn_rid_.emplace(lock_request->txn_id_, lock_request->rid_);
-              AddEdge(lock_request->txn_id_, txn_id);
-            }
-          }
+void LockManager::WaitForGrant(Transaction *txn, const LockRequest *lock_request,
+                               LockRequestQueue *lock_request_queue, std::unique_lock<std::mutex> *lock) {
+  if (txn->GetState() == TransactionState::ABORTED) {
+    return;
+  }
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC) {
+    // An optimistic transaction bets on conflicts being rare, so it gives up rather than wait for anyone.
+    txn->SetState(TransactionState::ABORTED);
+    metrics_.no_wait_aborts_.fetch_add(1, LockMetrics::Relaxed());
+    return;
+  }
+  txn_id_t txn_id = txn->GetTransactionId();
+  auto blockers = Blockers(lock_request, lock_request_queue);
+  auto policy = deadlock_policy.load();
+  if (policy == DeadlockPolicy::WAIT_DIE) {
+    // Die rather than wait for an older transaction.
+    if (std::any_of(blockers.begin(), blockers.end(), [txn_id](txn_id_t blocker) { return blocker < txn_id; })) {
+      txn->SetState(TransactionState::ABORTED);
+      metrics_.wait_die_aborts_.fetch_add(1, LockMetrics::Relaxed());
+      return;
+    }
+  }
+
+  std::vector<txn_id_t> victims;
+  std::vector<LockRequestQueue *> victim_queues;
+  {
+    std::scoped_lock graph_lock(waits_for_latch_);
+    if (policy == DeadlockPolicy::WOUND_WAIT) {
+      // Wound the newer transactions instead of waiting for them. A wounded transaction that is not blocked notices
+      // the next time it has to wait; it still releases its locks when it finishes.
+      for (auto blocker : blockers) {
+        if (blocker > txn_id) {
+          victims.push_back(blocker);
         }
-        pair.second->latch_.unlock();
-      }
-     
-      row_lock_map_latch_.unlock();
-      table_lock_map_latch_.unlock();
-      //ÿsleep֮󣬶̬һͼ
-      txn_id_t txn_id;
-      //2. лעtxn_idǸΣлʱӦֹ
-      while (HasCycle(&txn_id)) {
-        //лҪһֱûлΪֹ
-        Transaction *txn = TransactionManager::GetTransaction(txn_id);//صл 
-        txn->SetState(TransactionState::ABORTED);//״̬Ϊֹ
-        DeleteNode(txn_id);//ߴͼɾˣҰΪֹ  ͼɾߺ
-        
-        //ֹIDģ߳
-        //ȨֹӰ߳
-        if (map_txn_oid_.count(txn_id) > 0) {//ûȨ񼯺  == ȴ֪̣ͨ߳
-          table_lock_map_[map_txn_oid_[txn_id]]->latch_.lock();
-          table_lock_map_[map_txn_oid_[txn_id]]->cv_.notify_all();
-          table_lock_map_[map_txn_oid_[txn_id]]->latch_.unlock();
+      }
+    } else if (policy == DeadlockPolicy::DETECTION) {
+      // The graph had no cycle before this transaction blocked, so a new cycle has to go through it.
+      waits_for_[txn_id] = blockers;
+      std::unordered_set<txn_id_t> visited{txn_id};
+      std::vector<txn_id_t> cycle;
+      if (FindCycle(txn_id, txn_id, &visited, &cycle)) {
+        metrics_.deadlocks_.fetch_add(1, LockMetrics::Relaxed());
+        // Abort the newest transaction on the cycle, i.e. the one with the largest id.
+        txn_id_t victim = *std::max_element(cycle.begin(), cycle.end());
+        if (victim == txn_id) {
+          waits_for_.erase(txn_id);
+          txn->SetState(TransactionState::ABORTED);
+          return;
         }
+        victims.push_back(victim);
+      }
+    }
 
-        if (map_txn_rid_.count(txn_id) > 0) {
-          row_lock_map_[map_txn_rid_[txn_id]]->latch_.lock();
-          row_lock_map_[map_txn_rid_[txn_id]]->cv_.notify_all();
-          row_lock_map_[map_txn_rid_[txn_id]]->latch_.unlock();
-        }
+    for (auto victim : victims) {
+      Transaction *victim_txn = TransactionManager::GetTransaction(victim);
+      if (victim_txn == nullptr || victim_txn->GetState() == TransactionState::COMMITTED ||
+          victim_txn->GetState() == TransactionState::ABORTED) {
+        continue;
+      }
+      victim_txn->SetState(TransactionState::ABORTED);
+      if (policy == DeadlockPolicy::WOUND_WAIT) {
+        metrics_.wounds_.fetch_add(1, LockMetrics::Relaxed());
+      }
+      // The victim no longer waits for anyone, so it cannot close another cycle.
+      waits_for_.erase(victim);
+      auto iter = waiting_queue_.find(victim);
+      if (iter != waiting_queue_.end()) {
+        victim_queues.push_back(iter->second);
+        waiting_queue_.erase(iter);
+      }
+    }
+
+    if (victim_queues.empty()) {
+      waits_for_[txn_id] = std::move(blockers);
+      waiting_queue_[txn_id] = lock_request_queue;
+    } else {
+      waits_for_.erase(txn_id);
+    }
+  }
+
+  if (!victim_queues.empty()) {
+    // Wake the victims up without holding the latch of our own queue, which could deadlock with a victim doing the
+    // same. Queues are never freed while the lock manager lives, so a stale queue only gets a spurious wakeup.
+    lock->unlock();
+    for (auto *queue : victim_queues) {
+      std::scoped_lock queue_lock(queue->latch_);
+      queue->cv_.notify_all();
+    }
+    lock->lock();
+    // The request may have become grantable in the meantime, let the caller check again before sleeping.
+    return;
+  }
+
+  lock_request_queue->cv_.wait(*lock);
+
+  std::scoped_lock graph_lock(waits_for_latch_);
+  waits_for_.erase(txn_id);
+  waiting_queue_.erase(txn_id);
+}
+
+auto LockManager::Blockers(const LockRequest *lock_request, const LockRequestQueue *lock_request_queue)
+    -> std::vector<txn_id_t> {
+  std::vector<txn_id_t> blockers;
+  for (const auto &lr : lock_request_queue->request_queue_) {
+    if (&lr == lock_request) {
+      break;
+    }
+    if (lr.txn_id_ == lock_request->txn_id_) {
+      continue;
+    }
+    // Ungranted requests ahead are served first, granted ones only block if they conflict.
+    if (!lr.granted_ || !AreLocksCompatible(lr.lock_mode_, lock_request->lock_mode_)) {
+      blockers.push_back(lr.txn_id_);
+    }
+  }
+  return blockers;
+}
+
+auto LockManager::FindCycle(txn_id_t source, txn_id_t txn_id, std::unordered_set<txn_id_t> *visited,
+                            std::vector<txn_id_t> *cycle) -> bool {
+  cycle->push_back(txn_id);
+  auto iter = waits_for_.find(txn_id);
+  if (iter != waits_for_.end()) {
+    for (auto next : iter->second) {
+      if (next == source) {
+        return true;
+      }
+      if (visited->insert(next).second && FindCycle(source, next, visited, cycle)) {
+        return true;
       }
-      //л
-      waits_for_.clear();
-      safe_set_.clear();
-      txn_set_.clear();
-      map_txn_oid_.clear();
-      map_txn_rid_.clear();
     }
   }
+  cycle->pop_back();
+  return false;
+}
+
+auto LockManager::AreLocksCompatible(LockMode held, LockMode requested) -> bool {
+  switch (requested) {
+    case LockMode::SHARED:
+      return held == LockMode::INTENTION_SHARED || held == LockMode::SHARED;
+    case LockMode::EXCLUSIVE:
+      return false;
+    case LockMode::INTENTION_SHARED:
+      return held != LockMode::EXCLUSIVE;
+    case LockMode::INTENTION_EXCLUSIVE:
+      return held == LockMode::INTENTION_SHARED || held == LockMode::INTENTION_EXCLUSIVE;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return held == LockMode::INTENTION_SHARED;
+  }
+  return false;
+}
+
+auto LockManager::CoversLock(LockMode held, LockMode requested) -> bool {
+  switch (held) {
+    case LockMode::EXCLUSIVE:
+      return true;
+    case LockMode::SHARED_INTENTION_EXCLUSIVE:
+      return requested != LockMode::EXCLUSIVE;
+    case LockMode::SHARED:
+    case LockMode::INTENTION_EXCLUSIVE:
+      return requested == held || requested == LockMode::INTENTION_SHARED;
+    case LockMode::INTENTION_SHARED:
+      return requested == LockMode::INTENTION_SHARED;
+  }
+  return false;
+}
+
+auto LockManager::IsRowLockCovered(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool {
+  LockMode table_lock_mode;
+  return GetTableLockMode(txn, oid, &table_lock_mode) && CoversLock(table_lock_mode, lock_mode);
+}
+
+auto LockManager::GetTableLockMode(Transaction *txn, const table_oid_t &oid, LockMode *lock_mode) -> bool {
+  if (txn->IsTableExclusiveLocked(oid)) {
+    *lock_mode = LockMode::EXCLUSIVE;
+  } else if (txn->IsTableSharedIntentionExclusiveLocked(oid)) {
+    *lock_mode = LockMode::SHARED_INTENTION_EXCLUSIVE;
+  } else if (txn->IsTableSharedLocked(oid)) {
+    *lock_mode = LockMode::SHARED;
+  } else if (txn->IsTableIntentionExclusiveLocked(oid)) {
+    *lock_mode = LockMode::INTENTION_EXCLUSIVE;
+  } else if (txn->IsTableIntentionSharedLocked(oid)) {
+    *lock_mode = LockMode::INTENTION_SHARED;
+  } else {
+    return false;
+  }
+  return true;
 }
 
 //µ¼ ûеĻһwait()ȴ
 //
 //1ǰ񶼼  2ǰ񶼼
-auto LockManager::GrantLock(const std::shared_ptr<LockRequest> &lock_request,
-                            const std::shared_ptr<LockRequestQueue> &lock_request_queue) -> bool {
+auto LockManager::GrantLock(const LockRequest *lock_request, const LockRequestQueue *lock_request_queue) -> bool {
   //lr ǰ
-  for (auto &lr : lock_request_queue->request_queue_) {
+  for (const auto &lr : lock_request_queue->request_queue_) {
     //ݾ  lrΪT1е   T2治
-    //lr->granted_ ǰ鶼
-    if (lr->granted_) {
-      switch (lock_request->lock_mode_) {//T2 want
-        case LockMode::SHARED:
-          if (lr->lock_mode_ == LockMode::INTENTION_EXCLUSIVE ||
-              lr->lock_mode_ == LockMode::SHARED_INTENTION_EXCLUSIVE || lr->lock_mode_ == LockMode::EXCLUSIVE) {
-            return false;
-          }
-          break;
-        case LockMode::EXCLUSIVE:
-          return false;
-          break;
-        case LockMode::INTENTION_SHARED:
-          if (lr->lock_mode_ == LockMode::EXCLUSIVE) {
-            return false;
-          }
-          break;
-        case LockMode::INTENTION_EXCLUSIVE:
-          if (lr->lock_mode_ == LockMode::SHARED || lr->lock_mode_ == LockMode::SHARED_INTENTION_EXCLUSIVE ||
-              lr->lock_mode_ == LockMode::EXCLUSIVE) {
-            return false;
-          }
-          break;
-        case LockMode::SHARED_INTENTION_EXCLUSIVE:
-          if (lr->lock_mode_ != LockMode::INTENTION_SHARED) {
-            return false;
-          }
-          break;
+    //lr.granted_ ǰ鶼
+    if (lr.granted_) {
+      if (!AreLocksCompatible(lr.lock_mode_, lock_request->lock_mode_)) {
+        return false;
       }
-    } else if (lock_request.get() != lr.get()) {
+    } else if (lock_request != &lr) {
       return false;
     } else {
       return true;
@@ -613,65 +1058,63 @@ auto LockManager::GrantLock(const std::shared_ptr<LockRequest> &lock_request,
   return false;
 }
 //ͺͲͣҵӦļϽвɾ
-void LockManager::InsertOrDeleteTableLockSet(Transaction *txn, const std::shared_ptr<LockRequest> &lock_request,
-                                             bool insert) {
-  switch (lock_request->lock_mode_) {
+void LockManager::InsertOrDeleteTableLockSet(Transaction *txn, const LockRequest &lock_request, bool insert) {
+  switch (lock_request.lock_mode_) {
     case LockMode::SHARED:
       if (insert) {
-        txn->GetSharedTableLockSet()->insert(lock_request->oid_);
+        txn->GetSharedTableLockSet()->insert(lock_request.oid_);
       } else {
-        txn->GetSharedTableLockSet()->erase(lock_request->oid_);
+        txn->GetSharedTableLockSet()->erase(lock_request.oid_);
       }
       break;
     case LockMode::EXCLUSIVE:
       if (insert) {
-        txn->GetExclusiveTableLockSet()->insert(lock_request->oid_);
+        txn->GetExclusiveTableLockSet()->insert(lock_request.oid_);
       } else {
-        txn->GetExclusiveTableLockSet()->erase(lock_request->oid_);
+        txn->GetExclusiveTableLockSet()->erase(lock_request.oid_);
       }
       break;
     case LockMode::INTENTION_SHARED:
       if (insert) {
-        txn->GetIntentionSharedTableLockSet()->insert(lock_request->oid_);
+        txn->GetIntentionSharedTableLockSet()->insert(lock_request.oid_);
       } else {
-        txn->GetIntentionSharedTableLockSet()->erase(lock_request->oid_);
+        txn->GetIntentionSharedTableLockSet()->erase(lock_request.oid_);
       }
       break;
     case LockMode::INTENTION_EXCLUSIVE:
       if (insert) {
-        txn->GetIntentionExclusiveTableLockSet()->insert(lock_request->oid_);
+        txn->GetIntentionExclusiveTableLockSet()->insert(lock_request.oid_);
       } else {
-        txn->GetIntentionExclusiveTableLockSet()->erase(lock_request->oid_);
+        txn->GetIntentionExclusiveTableLockSet()->erase(lock_request.oid_);
       }
       break;
     case LockMode::SHARED_INTENTION_EXCLUSIVE:
       if (insert) {
-        txn->GetSharedIntentionExclusiveTableLockSet()->insert(lock_request->oid_);
+        txn->GetSharedIntentionExclusiveTableLockSet()->insert(lock_request.oid_);
       } else {
-        txn->GetSharedIntentionExclusiveTableLockSet()->erase(lock_request->oid_);
+        txn->GetSharedIntentionExclusiveTableLockSet()->erase(lock_request.oid_);
       }
       break;
   }
 }
 
-void LockManager::InsertOrDeleteRowLockSet(Transaction *txn, const std::shared_ptr<LockRequest> &lock_request,
-                                           bool insert) {
+void LockManager::InsertOrDeleteRowLockSet(Transaction *txn, const LockRequest &lock_request, bool insert) {
   // ֻSX
   auto s_row_lock_set = txn->GetSharedRowLockSet();
   auto x_row_lock_set = txn->GetExclusiveRowLockSet();
-  switch (lock_request->lock_mode_) {
+  switch (lock_request.lock_mode_) {
     case LockMode::SHARED:
       if (insert) {
-        InsertRowLockSet(s_row_lock_set, lock_request->oid_, lock_request->rid_);
+        InsertRowLockSet(s_row_lock_set, lock_request.oid_, lock_request.rid_);
       } else {
-        DeleteRowLockSet(s_row_lock_set, lock_request->oid_, lock_request->rid_);
+        DeleteRowLockSet(s_row_lock_set, lock_request.oid_, lock_request.rid_);
       }
       break;
     case LockMode::EXCLUSIVE:
       if (insert) {
-        InsertRowLockSet(x_row_lock_set, lock_request->oid_, lock_request->rid_);
+        InsertRowLockSet(x_row_lock_set, lock_request.oid_, lock_request.rid_);
       } else {
-        DeleteRowLockSet(x_row_lock_set, lock_request->oid_, lock_request->rid_);
+        DeleteRowLockSet(x_row_lock_set, lock_request.oid_, lock_request.rid_);
       }
       break;
     case LockMode::INTENTION_SHARED:
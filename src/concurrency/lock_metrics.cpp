@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_metrics.cpp
+//
+// Identification: src/concurrency/lock_metrics.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/lock_metrics.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+void LockMetrics::Histogram::Record(uint64_t nanos) {
+  // Bucket i holds the latencies in [2^(i-1), 2^i) nanoseconds.
+  size_t bucket = std::min<size_t>(BUCKETS - 1, 64 - __builtin_clzll(nanos | 1));
+  buckets_[bucket].fetch_add(1, Relaxed());
+  total_nanos_.fetch_add(nanos, Relaxed());
+}
+
+auto LockMetrics::Histogram::Count() const -> uint64_t {
+  uint64_t count = 0;
+  for (const auto &bucket : buckets_) {
+    count += bucket.load(Relaxed());
+  }
+  return count;
+}
+
+auto LockMetrics::Histogram::Percentile(double fraction) const -> uint64_t {
+  auto count = Count();
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * count)));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+    seen += buckets_[bucket].load(Relaxed());
+    if (seen >= rank) {
+      return uint64_t{1} << bucket;
+    }
+  }
+  return uint64_t{1} << (BUCKETS - 1);
+}
+
+void LockMetrics::Histogram::Reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, Relaxed());
+  }
+  total_nanos_.store(0, Relaxed());
+}
+
+auto LockMetrics::Now() -> uint64_t {
+  if (!enable_lock_metrics.load(Relaxed())) {
+    return 0;
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+auto LockMetrics::Waiting(size_t queue_length) -> uint64_t {
+  auto now = Now();
+  if (now == 0) {
+    return 0;
+  }
+  waits_.fetch_add(1, Relaxed());
+  waiting_queue_length_.fetch_add(queue_length, Relaxed());
+  auto max = max_queue_length_.load(Relaxed());
+  while (queue_length > max && !max_queue_length_.compare_exchange_weak(max, queue_length, Relaxed())) {
+  }
+  return now;
+}
+
+auto LockMetrics::Granted(Resource resource, size_t mode, table_oid_t oid, const RID &rid, uint64_t requested_at,
+                          uint64_t wait_start) -> uint64_t {
+  if (requested_at == 0) {
+    return 0;
+  }
+  auto now = Now();
+  if (now == 0) {
+    return 0;
+  }
+  auto &metrics = Mode(resource, mode);
+  metrics.acquired_.fetch_add(1, Relaxed());
+  metrics.acquire_.Record(now - requested_at);
+  if (wait_start != 0) {
+    metrics.waited_.fetch_add(1, Relaxed());
+    metrics.wait_.Record(now - requested_at);
+    Contended(resource, oid, rid, now - wait_start);
+  }
+  return now;
+}
+
+void LockMetrics::Failed(Resource resource, size_t mode, table_oid_t oid, const RID &rid, uint64_t wait_start) {
+  auto now = Now();
+  if (now == 0) {
+    return;
+  }
+  Mode(resource, mode).failed_.fetch_add(1, Relaxed());
+  if (wait_start != 0) {
+    Contended(resource, oid, rid, now - wait_start);
+  }
+}
+
+void LockMetrics::Released(Resource resource, size_t mode, uint64_t granted_at) {
+  if (granted_at == 0) {
+    return;
+  }
+  auto now = Now();
+  if (now != 0) {
+    Mode(resource, mode).hold_.Record(now - granted_at);
+  }
+}
+
+void LockMetrics::Contended(Resource resource, table_oid_t oid, const RID &rid, uint64_t wait_nanos) {
+  if (resource == Resource::KEY) {
+    return;
+  }
+  std::scoped_lock latch(contention_latch_);
+  auto &table = contended_tables_[oid];
+  table.waits_++;
+  table.wait_nanos_ += wait_nanos;
+  if (resource == Resource::ROW) {
+    auto iter = contended_rows_.find(rid);
+    if (iter == contended_rows_.end()) {
+      if (contended_rows_.size() >= MAX_CONTENDED_ROWS) {
+        return;
+      }
+      iter = contended_rows_.emplace(rid, Contention{}).first;
+    }
+    iter->second.waits_++;
+    iter->second.wait_nanos_ += wait_nanos;
+  }
+}
+
+template <typename K>
+static auto Top(const std::unordered_map<K, LockMetrics::Contention> &contention, size_t n)
+    -> std::vector<std::pair<K, LockMetrics::Contention>> {
+  std::vector<std::pair<K, LockMetrics::Contention>> top(contention.begin(), contention.end());
+  auto more_waits = [](const auto &a, const auto &b) {
+    return a.second.waits_ != b.second.waits_ ? a.second.waits_ > b.second.waits_
+                                              : a.second.wait_nanos_ > b.second.wait_nanos_;
+  };
+  n = std::min(n, top.size());
+  std::partial_sort(top.begin(), top.begin() + n, top.end(), more_waits);
+  top.resize(n);
+  return top;
+}
+
+auto LockMetrics::TopTables(size_t n) -> std::vector<std::pair<table_oid_t, Contention>> {
+  std::scoped_lock latch(contention_latch_);
+  return Top(contended_tables_, n);
+}
+
+auto LockMetrics::TopRows(size_t n) -> std::vector<std::pair<RID, Contention>> {
+  std::scoped_lock latch(contention_latch_);
+  return Top(contended_rows_, n);
+}
+
+auto LockMetrics::ToJson(size_t top) -> std::string {
+  std::vector<std::string> modes;
+  for (size_t resource = 0; resource < RESOURCES; resource++) {
+    for (size_t mode = 0; mode < MODES; mode++) {
+      const auto &metrics = Mode(static_cast<Resource>(resource), mode);
+      auto acquired = metrics.acquired_.load(Relaxed());
+      auto failed = metrics.failed_.load(Relaxed());
+      if (acquired == 0 && failed == 0) {
+        continue;
+      }
+      modes.push_back(fmt::format(
+          R"({{"resource":"{}","mode":"{}","acquired":{},"waited":{},"failed":{},"upgrades":{},)"
+          R"("acquire_p50_ns":{},"acquire_p99_ns":{},"wait_p50_ns":{},"wait_p99_ns":{},"wait_total_ns":{},)"
+          R"("hold_p50_ns":{},"hold_p99_ns":{}}})",
+          RESOURCE_NAMES[resource], MODE_NAMES[mode], acquired, metrics.waited_.load(Relaxed()), failed,
+          metrics.upgrades_.load(Relaxed()), metrics.acquire_.Percentile(0.5), metrics.acquire_.Percentile(0.99),
+          metrics.wait_.Percentile(0.5), metrics.wait_.Percentile(0.99), metrics.wait_.TotalNanos(),
+          metrics.hold_.Percentile(0.5), metrics.hold_.Percentile(0.99)));
+    }
+  }
+  std::vector<std::string> tables;
+  for (const auto &[oid, contention] : TopTables(top)) {
+    tables.push_back(
+        fmt::format(R"({{"oid":{},"waits":{},"wait_ns":{}}})", oid, contention.waits_, contention.wait_nanos_));
+  }
+  std::vector<std::string> rows;
+  for (const auto &[rid, contention] : TopRows(top)) {
+    rows.push_back(fmt::format(R"({{"page_id":{},"slot":{},"waits":{},"wait_ns":{}}})", rid.GetPageId(),
+                               rid.GetSlotNum(), contention.waits_, contention.wait_nanos_));
+  }
+  return fmt::format(
+      R"({{"modes":[{}],"waits":{},"waiting_queue_length_total":{},"max_queue_length":{},"upgrade_conflicts":{},)"
+      R"("escalations":{},"deadlocks":{},"wait_die_aborts":{},"wounds":{},"no_wait_aborts":{},"committed_txns":{},)"
+      R"("aborted_txns":{},"validation_failures":{},"top_tables":[{}],"top_rows":[{}]}})",
+      fmt::join(modes, ","), waits_.load(Relaxed()), waiting_queue_length_.load(Relaxed()),
+      max_queue_length_.load(Relaxed()), upgrade_conflicts_.load(Relaxed()), escalations_.load(Relaxed()),
+      deadlocks_.load(Relaxed()), wait_die_aborts_.load(Relaxed()), wounds_.load(Relaxed()),
+      no_wait_aborts_.load(Relaxed()), committed_txns_.load(Relaxed()), aborted_txns_.load(Relaxed()),
+      validation_failures_.load(Relaxed()), fmt::join(tables, ","), fmt::join(rows, ","));
+}
+
+void LockMetrics::Reset() {
+  for (auto &metrics : modes_) {
+    metrics.acquired_.store(0, Relaxed());
+    metrics.waited_.store(0, Relaxed());
+    metrics.failed_.store(0, Relaxed());
+    metrics.upgrades_.store(0, Relaxed());
+    metrics.acquire_.Reset();
+    metrics.wait_.Reset();
+    metrics.hold_.Reset();
+  }
+  for (auto *counter : {&waits_, &waiting_queue_length_, &max_queue_length_, &upgrade_conflicts_, &escalations_,
+                        &deadlocks_, &wait_die_aborts_, &wounds_, &no_wait_aborts_, &committed_txns_, &aborted_txns_,
+                        &validation_failures_}) {
+    counter->store(0, Relaxed());
+  }
+  std::scoped_lock latch(contention_latch_);
+  contended_tables_.clear();
+  contended_rows_.clear();
+}
+
+}  // namespace bustub
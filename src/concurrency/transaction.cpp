@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// transaction.cpp
+//
+// Identification: src/concurrency/transaction.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/transaction.h"
+
+#include <vector>
+
+namespace bustub {
+
+namespace {
+
+/** The memory of transactions freed on a thread, handed out again by the next ones allocated on it */
+struct TransactionPool {
+  std::vector<void *> free_;
+
+  ~TransactionPool() {
+    for (auto *ptr : free_) {
+      ::operator delete(ptr);
+    }
+  }
+};
+
+thread_local TransactionPool transaction_pool;
+
+}  // namespace
+
+auto Transaction::operator new(size_t size) -> void * {
+  auto &free = transaction_pool.free_;
+  if (size == sizeof(Transaction) && !free.empty()) {
+    void *ptr = free.back();
+    free.pop_back();
+    return ptr;
+  }
+  return ::operator new(size);
+}
+
+void Transaction::operator delete(void *ptr, size_t size) {
+  auto &free = transaction_pool.free_;
+  if (size == sizeof(Transaction) && free.size() < TXN_POOL_SIZE) {
+    free.push_back(ptr);
+    return;
+  }
+  ::operator delete(ptr);
+}
+
+}  // namespace bustub
@@ -12,17 +12,18 @@
 
 #include "concurrency/transaction_manager.h"
 
+#include <algorithm>
 #include <mutex>  // NOLINT
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "catalog/catalog.h"
 #include "storage/table/table_heap.h"
 namespace bustub {
 
-std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
-std::shared_mutex TransactionManager::txn_map_mutex = {};
+std::array<TransactionManager::TxnMapShard, 1 << TXN_MAP_SHARD_BITS> TransactionManager::txn_map = {};
 
 auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level) -> Transaction * {
   // Acquire the global transaction latch in shared mode.
@@ -32,87 +33,255 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
 
+  if (txn->ReadsSnapshot()) {
+    // Registered under the same latch the watermark is read under, so no version the snapshot reads is collected.
+    std::scoped_lock<std::mutex> l(snapshot_latch_);
+    txn->SetReadTs(last_commit_ts_);
+    active_snapshots_[txn->GetReadTs()]++;
+  }
+
   if (enable_logging) {
     LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
     lsn_t lsn = log_manager_->AppendLogRecord(&record);
     txn->SetPrevLSN(lsn);
   }
 
-  std::unique_lock<std::shared_mutex> l(txn_map_mutex);
-  txn_map[txn->GetTransactionId()] = txn;
+  RegisterTransaction(txn);
   return txn;
 }
 
-void TransactionManager::Commit(Transaction *txn) {
-  txn->SetState(TransactionState::COMMITTED);
+void TransactionManager::RegisterTransaction(Transaction *txn) {
+  auto &shard = TxnMapShardOf(txn->GetTransactionId());
+  std::unique_lock<std::shared_mutex> l(shard.latch_);
+  shard.txns_[txn->GetTransactionId()] = txn;
+}
 
-  // Perform all deletes before we commit.
-  auto write_set = txn->GetWriteSet();
-  while (!write_set->empty()) {
-    auto &item = write_set->back();
-    auto *table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
-      // Note that this also releases the lock when holding the page latch.
-      table->ApplyDelete(item.rid_, txn);
-    }
-    write_set->pop_back();
+void TransactionManager::UnregisterTransaction(Transaction *txn) {
+  auto &shard = TxnMapShardOf(txn->GetTransactionId());
+  std::unique_lock<std::shared_mutex> l(shard.latch_);
+  shard.txns_.erase(txn->GetTransactionId());
+}
+
+auto TransactionManager::Commit(Transaction *txn) -> bool {
+  // An optimistic transaction that wrote something has yet to pass validation.
+  if (txn->GetIsolationLevel() != IsolationLevel::OPTIMISTIC || txn->IsReadOnly()) {
+    txn->SetState(TransactionState::COMMITTED);
+  }
+
+  // A read-only transaction has no versions to stamp or collect and never allocated its write sets. An optimistic one
+  // read a consistent snapshot, so there is nothing to validate either.
+  if (txn->IsReadOnly()) {
+    EndSnapshot(txn);
+  } else if (!CommitWrites(txn)) {
+    lock_manager_->GetMetrics().validation_failures_.fetch_add(1, LockMetrics::Relaxed());
+    Abort(txn);
+    return false;
   }
-  write_set->clear();
 
   // Release all the locks.
   ReleaseLocks(txn);
+  UnregisterTransaction(txn);
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
+  lock_manager_->GetMetrics().committed_txns_.fetch_add(1, LockMetrics::Relaxed());
+  return true;
+}
+
+auto TransactionManager::CommitWrites(Transaction *txn) -> bool {
+  // Stamp the versions of all changes and only then publish the commit to new snapshots.
+  auto write_set = txn->GetWriteSet();
+  {
+    std::scoped_lock<std::mutex> l(commit_latch_);
+    // Commits are numbered under the latch, so no commit can slip in between the validation and this one.
+    if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && !Validate(txn)) {
+      return false;
+    }
+    txn->SetState(TransactionState::COMMITTED);
+    if (!write_set->empty()) {
+      timestamp_t commit_ts = last_commit_ts_ + 1;
+      for (const auto &item : *write_set) {
+        item.table_->GetVersionStore()->Commit(item.rid_, txn->GetTransactionId(), commit_ts);
+      }
+      last_commit_ts_ = commit_ts;
+    }
+  }
+  EndSnapshot(txn);
+
+  // Drop the versions no snapshot reads, which also removes deleted tuples. Without older snapshots running that is
+  // all of them; the garbage collector takes care of the rest. The rows of a table are handed over together, so that
+  // the deleted tuples of a page are removed under one latch.
+  timestamp_t watermark = GetWatermark();
+  std::vector<RID> rids;
+  for (auto item = write_set->begin(); item != write_set->end();) {
+    auto *table = item->table_;
+    rids.clear();
+    for (; item != write_set->end() && item->table_ == table; ++item) {
+      rids.push_back(item->rid_);
+    }
+    table->CollectVersions(rids, watermark);
+    if (table->GetVersionStore()->Size() > 0) {
+      std::scoped_lock<std::mutex> l(gc_latch_);
+      versioned_tables_.insert(table);
+    }
+  }
+  write_set->clear();
+  txn->GetIndexWriteSet()->clear();
+  return true;
+}
+
+auto TransactionManager::Validate(Transaction *txn) -> bool {
+  // The snapshot of the transaction keeps every version committed after it from being collected.
+  timestamp_t read_ts = txn->GetReadTs();
+  for (auto *table : *txn->GetReadTableSet()) {
+    if (table->GetVersionStore()->GetLastCommitTs() > read_ts) {
+      return false;
+    }
+  }
+  for (const auto &[table, rid] : *txn->GetReadSet()) {
+    if (table->GetVersionStore()->IsChangedSince(rid, read_ts)) {
+      return false;
+    }
+  }
+  return true;
 }
 
 void TransactionManager::Abort(Transaction *txn) {
   txn->SetState(TransactionState::ABORTED);
   // Rollback before releasing the lock.
+  RollbackTableWrites(txn);
+  // Snapshots keep reading the versions from before the transaction until every row is rolled back.
   auto table_write_set = txn->GetWriteSet();
-  while (!table_write_set->empty()) {
-    auto &item = table_write_set->back();
-    auto *table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
-      table->RollbackDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::INSERT) {
-      // Note that this also releases the lock when holding the page latch.
-      table->ApplyDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::UPDATE) {
-      table->UpdateTuple(item.tuple_, item.rid_, txn);
-    }
-    table_write_set->pop_back();
+  for (const auto &item : *table_write_set) {
+    item.table_->GetVersionStore()->Abort(item.rid_, txn->GetTransactionId());
   }
   table_write_set->clear();
-  // Rollback index updates
+  EndSnapshot(txn);
+  RollbackIndexWrites(txn);
+
+  // Release all the locks.
+  ReleaseLocks(txn);
+  UnregisterTransaction(txn);
+  // Release the global transaction latch.
+  global_txn_latch_.RUnlock();
+  lock_manager_->GetMetrics().aborted_txns_.fetch_add(1, LockMetrics::Relaxed());
+}
+
+void TransactionManager::RollbackTableWrites(Transaction *txn) {
+  auto table_write_set = txn->GetWriteSet();
+  std::vector<const TableWriteRecord *> records;
+  records.reserve(table_write_set->size());
+  for (auto item = table_write_set->rbegin(); item != table_write_set->rend(); ++item) {
+    records.push_back(&*item);
+  }
+  // The sort is stable, so the records of a table are still undone newest first.
+  std::stable_sort(records.begin(), records.end(),
+                   [](const TableWriteRecord *a, const TableWriteRecord *b) { return a->table_ < b->table_; });
+  for (size_t begin = 0; begin < records.size();) {
+    auto *table = records[begin]->table_;
+    size_t end = begin;
+    while (end < records.size() && records[end]->table_ == table) {
+      end++;
+    }
+    table->Rollback({records.begin() + begin, records.begin() + end}, txn);
+    begin = end;
+  }
+}
+
+void TransactionManager::RollbackIndexWrites(Transaction *txn) {
   auto index_write_set = txn->GetIndexWriteSet();
-  while (!index_write_set->empty()) {
-    auto &item = index_write_set->back();
-    auto *catalog = item.catalog_;
+  std::vector<const IndexWriteRecord *> records;
+  records.reserve(index_write_set->size());
+  for (auto item = index_write_set->rbegin(); item != index_write_set->rend(); ++item) {
+    records.push_back(&*item);
+  }
+  std::stable_sort(records.begin(), records.end(), [](const IndexWriteRecord *a, const IndexWriteRecord *b) {
+    return a->index_oid_ < b->index_oid_;
+  });
+  for (size_t begin = 0; begin < records.size();) {
+    auto *catalog = records[begin]->catalog_;
     // Metadata identifying the table that should be deleted from.
-    TableInfo *table_info = catalog->GetTable(item.table_oid_);
-    IndexInfo *index_info = catalog->GetIndex(item.index_oid_);
-    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                            index_info->index_->GetKeyAttrs());
-    if (item.wtype_ == WType::DELETE) {
-      index_info->index_->InsertEntry(new_key, item.rid_, txn);
-    } else if (item.wtype_ == WType::INSERT) {
-      index_info->index_->DeleteEntry(new_key, item.rid_, txn);
-    } else if (item.wtype_ == WType::UPDATE) {
-      // Delete the new key and insert the old key
-      index_info->index_->DeleteEntry(new_key, item.rid_, txn);
-      auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                                  index_info->index_->GetKeyAttrs());
-      index_info->index_->InsertEntry(old_key, item.rid_, txn);
+    TableInfo *table_info = catalog->GetTable(records[begin]->table_oid_);
+    IndexInfo *index_info = catalog->GetIndex(records[begin]->index_oid_);
+    auto *index = index_info->index_.get();
+    size_t end = begin;
+    for (; end < records.size() && records[end]->index_oid_ == index_info->index_oid_; end++) {
+      const auto &item = *records[end];
+      // Keys written by the executors are kept in their serialized form, only the others are built again.
+      Tuple built_key;
+      if (item.key_.GetLength() == 0) {
+        built_key = item.tuple_.KeyFromTuple(table_info->schema_, *index->GetKeySchema(), index->GetKeyAttrs());
+      }
+      const Tuple &new_key = item.key_.GetLength() == 0 ? built_key : item.key_;
+      if (item.wtype_ == WType::DELETE) {
+        index->InsertEntry(new_key, item.rid_, txn);
+      } else if (item.wtype_ == WType::INSERT) {
+        index->DeleteEntry(new_key, item.rid_, txn);
+      } else if (item.wtype_ == WType::UPDATE) {
+        // Delete the new key and insert the old key
+        index->DeleteEntry(new_key, item.rid_, txn);
+        auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *index->GetKeySchema(), index->GetKeyAttrs());
+        index->InsertEntry(old_key, item.rid_, txn);
+      }
     }
-    index_write_set->pop_back();
+    begin = end;
   }
-  table_write_set->clear();
   index_write_set->clear();
+}
 
-  // Release all the locks.
-  ReleaseLocks(txn);
-  // Release the global transaction latch.
-  global_txn_latch_.RUnlock();
+void TransactionManager::EndSnapshot(Transaction *txn) {
+  if (!txn->ReadsSnapshot()) {
+    return;
+  }
+  std::scoped_lock<std::mutex> l(snapshot_latch_);
+  auto iter = active_snapshots_.find(txn->GetReadTs());
+  if (iter != active_snapshots_.end() && --iter->second == 0) {
+    active_snapshots_.erase(iter);
+  }
+}
+
+auto TransactionManager::GetWatermark() -> timestamp_t {
+  std::scoped_lock<std::mutex> l(snapshot_latch_);
+  return active_snapshots_.empty() ? last_commit_ts_.load() : active_snapshots_.begin()->first;
+}
+
+void TransactionManager::GarbageCollect() {
+  timestamp_t watermark = GetWatermark();
+  std::vector<TableHeap *> tables;
+  {
+    std::scoped_lock<std::mutex> l(gc_latch_);
+    tables.assign(versioned_tables_.begin(), versioned_tables_.end());
+  }
+  for (auto *table : tables) {
+    table->CollectVersions(watermark);
+  }
+}
+
+void TransactionManager::StartGarbageCollection() {
+  enable_gc_ = true;
+  gc_thread_ = std::thread([this] {
+    std::unique_lock<std::mutex> l(gc_latch_);
+    while (enable_gc_) {
+      gc_cv_.wait_for(l, version_gc_interval, [this] { return !enable_gc_; });
+      if (!enable_gc_) {
+        break;
+      }
+      l.unlock();
+      GarbageCollect();
+      l.lock();
+    }
+  });
+}
+
+void TransactionManager::StopGarbageCollection() {
+  if (!gc_thread_.joinable()) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> l(gc_latch_);
+    enable_gc_ = false;
+  }
+  gc_cv_.notify_all();
+  gc_thread_.join();
 }
 
 void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
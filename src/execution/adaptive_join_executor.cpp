@@ -0,0 +1,421 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_join_executor.cpp
+//
+// Identification: src/execution/adaptive_join_executor.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/adaptive_join_executor.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "fmt/format.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** A spilled page starts with the number of bytes of it in use, followed by serialized tuples */
+constexpr uint32_t SPILL_PAGE_HEADER_SIZE = sizeof(uint32_t);
+
+auto NullTuple(const Schema &schema) -> Tuple {
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (const auto &column : schema.GetColumns()) {
+    values.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+  }
+  return Tuple{values, &schema};
+}
+
+auto BufferRows() -> size_t { return std::max<size_t>(1, adaptive_join_buffer_rows); }
+
+}  // namespace
+
+AdaptiveJoinExecutor::AdaptiveJoinExecutor(ExecutorContext *exec_ctx, const AdaptiveJoinPlanNode *plan,
+                                           std::unique_ptr<AbstractExecutor> &&left_child,
+                                           std::unique_ptr<AbstractExecutor> &&right_child)
+    : AbstractExecutor(exec_ctx),
+      plan_{plan},
+      left_executor_{std::move(left_child)},
+      right_executor_(std::move(right_child)) {
+  if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
+    throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
+  }
+  // The index can only stand in for the right input if the latter is a full scan of the indexed table.
+  const auto *seq_scan = dynamic_cast<const SeqScanPlanNode *>(plan->GetRightPlan().get());
+  if (plan->index_oid_.has_value() && seq_scan != nullptr) {
+    index_info_ = exec_ctx->GetCatalog()->GetIndex(*plan->index_oid_);
+    table_info_ = exec_ctx->GetCatalog()->GetTable(seq_scan->GetTableOid());
+    right_column_ids_ = &seq_scan->column_ids_;
+  }
+}
+
+AdaptiveJoinExecutor::~AdaptiveJoinExecutor() { DropPartitions(); }
+
+void AdaptiveJoinExecutor::Init() {
+  DropPartitions();
+  decisions_.clear();
+  build_.clear();
+  table_.clear();
+  probe_executor_ = nullptr;
+  probe_exhausted_ = false;
+  probe_batch_.clear();
+  probe_pos_ = 0;
+  partition_ = 0;
+  probe_page_ = 0;
+  probe_resident_read_ = false;
+  matches_.clear();
+  rids_.clear();
+  next_match_ = 0;
+  pending_null_ = false;
+  next_unmatched_ = 0;
+
+  const auto &left_schema = plan_->GetLeftPlan()->OutputSchema();
+  const auto &right_schema = plan_->GetRightPlan()->OutputSchema();
+  left_key_.emplace(&plan_->LeftJoinKeyExpression(), left_schema);
+  right_key_.emplace(&plan_->RightJoinKeyExpression(), right_schema);
+  if (plan_->GetJoinType() == JoinType::LEFT) {
+    null_right_tuple_ = NullTuple(right_schema);
+  }
+
+  const auto limit = BufferRows();
+  std::vector<Tuple> left_tuples;
+  left_executor_->Init();
+  const bool left_exhausted = Fill(left_executor_.get(), &left_tuples, limit);
+  if (left_exhausted && index_info_ != nullptr) {
+    // Few outer tuples: probing the index is cheaper than reading the right table at all.
+    strategy_ = Strategy::IndexNestedLoop;
+    decisions_.push_back(fmt::format("index nested loop join over {}: left input has {} rows", index_info_->name_,
+                                     left_tuples.size()));
+    probe_batch_ = std::move(left_tuples);
+    probe_executor_ = left_executor_.get();
+    probe_exhausted_ = true;
+    return;
+  }
+
+  std::vector<Tuple> right_tuples;
+  right_executor_->Init();
+  const bool right_exhausted = Fill(right_executor_.get(), &right_tuples, limit);
+  if (right_exhausted) {
+    strategy_ = Strategy::HashBuildRight;
+    decisions_.push_back(fmt::format("hash join built on the right input: {} rows", right_tuples.size()));
+    Build(&right_tuples, false);
+    probe_batch_ = std::move(left_tuples);
+    probe_executor_ = left_executor_.get();
+    probe_exhausted_ = left_exhausted;
+  } else if (left_exhausted) {
+    // The right input was expected to be the small one, but it is the left one that fits in the buffer.
+    strategy_ = Strategy::HashBuildLeft;
+    decisions_.push_back(fmt::format("hash join built on the left input: {} rows, right input has more than {} rows",
+                                     left_tuples.size(), limit));
+    Build(&left_tuples, true);
+    probe_batch_ = std::move(right_tuples);
+    probe_executor_ = right_executor_.get();
+  } else {
+    // Neither input fits in the buffer: read the right one until it is exhausted or too large to be held in memory.
+    const size_t threshold = hash_join_spill_threshold;
+    size_t bytes = 0;
+    for (const auto &tuple : right_tuples) {
+      bytes += tuple.GetLength();
+    }
+    Tuple tuple;
+    RID rid;
+    while (bytes <= threshold && right_executor_->Next(&tuple, &rid)) {
+      bytes += tuple.GetLength();
+      right_tuples.push_back(tuple);
+    }
+    if (bytes <= threshold) {
+      strategy_ = Strategy::HashBuildRight;
+      decisions_.push_back(fmt::format("hash join built on the right input: {} rows", right_tuples.size()));
+      Build(&right_tuples, false);
+      probe_batch_ = std::move(left_tuples);
+      probe_executor_ = left_executor_.get();
+    } else {
+      strategy_ = Strategy::PartitionedHash;
+      left_partitions_.resize(HASH_JOIN_PARTITIONS);
+      right_partitions_.resize(HASH_JOIN_PARTITIONS);
+      auto right_rows = right_tuples.size();
+      for (const auto &right_tuple : right_tuples) {
+        Spill(right_tuple, false, &right_partitions_);
+      }
+      right_tuples.clear();
+      while (right_executor_->Next(&tuple, &rid)) {
+        Spill(tuple, false, &right_partitions_);
+        right_rows++;
+      }
+      FinishSpill(&right_partitions_);
+      for (const auto &left_tuple : left_tuples) {
+        Spill(left_tuple, true, &left_partitions_);
+      }
+      left_tuples.clear();
+      while (left_executor_->Next(&tuple, &rid)) {
+        Spill(tuple, true, &left_partitions_);
+      }
+      FinishSpill(&left_partitions_);
+
+      size_t pages = 0;
+      for (size_t i = 0; i < left_partitions_.size(); i++) {
+        pages += left_partitions_[i].pages_.size() + right_partitions_[i].pages_.size();
+      }
+      decisions_.push_back(
+          fmt::format("partitioned hash join: right input has {} rows, more than {} bytes, {} partitions, {} pages",
+                      right_rows, threshold, HASH_JOIN_PARTITIONS, pages));
+      LoadPartition(0);
+      probe_exhausted_ = true;
+    }
+  }
+}
+
+auto AdaptiveJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    if (EmitMatch(tuple)) {
+      return true;
+    }
+    if (!NextProbeTuple(&probe_tuple_)) {
+      break;
+    }
+    FindMatches();
+  }
+  // A left join built on the left input emits the left tuples nothing matched once the right input is exhausted.
+  if (strategy_ == Strategy::HashBuildLeft && plan_->GetJoinType() == JoinType::LEFT) {
+    while (next_unmatched_ < build_.size()) {
+      const auto &entry = build_[next_unmatched_++];
+      if (!entry.matched_) {
+        *tuple = Tuple(entry.tuple_, &plan_->GetLeftPlan()->OutputSchema(), null_right_tuple_,
+                       &plan_->GetRightPlan()->OutputSchema());
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto AdaptiveJoinExecutor::Fill(AbstractExecutor *executor, std::vector<Tuple> *buffer, size_t limit) -> bool {
+  Tuple tuple;
+  RID rid;
+  while (buffer->size() < limit) {
+    if (!executor->Next(&tuple, &rid)) {
+      return true;
+    }
+    buffer->push_back(tuple);
+  }
+  return false;
+}
+
+void AdaptiveJoinExecutor::Build(std::vector<Tuple> *tuples, bool build_left) {
+  build_.reserve(build_.size() + tuples->size());
+  for (auto &tuple : *tuples) {
+    Insert(std::move(tuple), build_left);
+  }
+  tuples->clear();
+}
+
+void AdaptiveJoinExecutor::Insert(Tuple tuple, bool build_left) {
+  auto key = (build_left ? left_key_ : right_key_)->Evaluate(&tuple);
+  table_[HashUtil::HashValue(&key)].push_back(build_.size());
+  build_.push_back(BuildEntry{std::move(key), std::move(tuple), false});
+}
+
+void AdaptiveJoinExecutor::Spill(const Tuple &tuple, bool left, std::vector<Partition> *partitions) {
+  auto key = (left ? left_key_ : right_key_)->Evaluate(&tuple);
+  auto &partition = (*partitions)[HashUtil::HashValue(&key) % partitions->size()];
+  const uint32_t size = sizeof(uint32_t) + tuple.GetLength();
+  if (size > static_cast<uint32_t>(BUSTUB_PAGE_SIZE) - SPILL_PAGE_HEADER_SIZE) {
+    partition.resident_.push_back(tuple);
+    return;
+  }
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  uint32_t used = 0;
+  if (partition.write_page_ != nullptr) {
+    std::memcpy(&used, partition.write_page_->GetData(), sizeof(uint32_t));
+    if (used + size > static_cast<uint32_t>(BUSTUB_PAGE_SIZE)) {
+      bpm->UnpinPage(partition.pages_.back(), true);
+      partition.write_page_ = nullptr;
+    }
+  }
+  if (partition.write_page_ == nullptr) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      partition.resident_.push_back(tuple);
+      return;
+    }
+    partition.pages_.push_back(page_id);
+    partition.write_page_ = page;
+    used = SPILL_PAGE_HEADER_SIZE;
+  }
+  auto *data = partition.write_page_->GetData();
+  tuple.SerializeTo(data + used);
+  used += size;
+  std::memcpy(data, &used, sizeof(uint32_t));
+}
+
+void AdaptiveJoinExecutor::FinishSpill(std::vector<Partition> *partitions) {
+  for (auto &partition : *partitions) {
+    if (partition.write_page_ != nullptr) {
+      exec_ctx_->GetBufferPoolManager()->UnpinPage(partition.pages_.back(), true);
+      partition.write_page_ = nullptr;
+    }
+  }
+}
+
+auto AdaptiveJoinExecutor::ReadPage(page_id_t page_id) -> std::vector<Tuple> {
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  auto *page = bpm->FetchPage(page_id);
+  if (page == nullptr) {
+    throw ExecutionException("no free frame to read a partition of a join back");
+  }
+  std::vector<Tuple> tuples;
+  const auto *data = page->GetData();
+  uint32_t used;
+  std::memcpy(&used, data, sizeof(uint32_t));
+  for (uint32_t offset = SPILL_PAGE_HEADER_SIZE; offset < used;) {
+    tuples.emplace_back();
+    tuples.back().DeserializeFrom(data + offset);
+    offset += sizeof(uint32_t) + tuples.back().GetLength();
+  }
+  bpm->UnpinPage(page_id, false);
+  bpm->DeletePage(page_id);
+  return tuples;
+}
+
+void AdaptiveJoinExecutor::LoadPartition(size_t partition) {
+  build_.clear();
+  table_.clear();
+  auto &build = right_partitions_[partition];
+  for (auto &page_id : build.pages_) {
+    auto tuples = ReadPage(page_id);
+    page_id = INVALID_PAGE_ID;
+    Build(&tuples, false);
+  }
+  Build(&build.resident_, false);
+  partition_ = partition;
+  probe_page_ = 0;
+  probe_resident_read_ = false;
+}
+
+void AdaptiveJoinExecutor::DropPartitions() {
+  auto *bpm = exec_ctx_->GetBufferPoolManager();
+  for (auto *partitions : {&left_partitions_, &right_partitions_}) {
+    for (auto &partition : *partitions) {
+      if (partition.write_page_ != nullptr) {
+        bpm->UnpinPage(partition.pages_.back(), false);
+      }
+      for (auto page_id : partition.pages_) {
+        if (page_id != INVALID_PAGE_ID) {
+          bpm->DeletePage(page_id);
+        }
+      }
+    }
+    partitions->clear();
+  }
+}
+
+auto AdaptiveJoinExecutor::NextProbeTuple(Tuple *tuple) -> bool {
+  while (probe_pos_ >= probe_batch_.size()) {
+    if (!RefillProbe()) {
+      return false;
+    }
+  }
+  *tuple = probe_batch_[probe_pos_++];
+  return true;
+}
+
+auto AdaptiveJoinExecutor::RefillProbe() -> bool {
+  probe_batch_.clear();
+  probe_pos_ = 0;
+  if (strategy_ != Strategy::PartitionedHash) {
+    if (probe_exhausted_ || probe_executor_ == nullptr) {
+      return false;
+    }
+    probe_exhausted_ = Fill(probe_executor_, &probe_batch_, BufferRows());
+    return true;
+  }
+  // The left tuples of the current partition are read back a page at a time, then the next partition is built.
+  while (partition_ < left_partitions_.size()) {
+    auto &probe = left_partitions_[partition_];
+    if (probe_page_ < probe.pages_.size()) {
+      probe_batch_ = ReadPage(probe.pages_[probe_page_]);
+      probe.pages_[probe_page_++] = INVALID_PAGE_ID;
+      return true;
+    }
+    if (!probe_resident_read_) {
+      probe_resident_read_ = true;
+      probe_batch_ = std::move(probe.resident_);
+      return true;
+    }
+    if (partition_ + 1 == left_partitions_.size()) {
+      break;
+    }
+    LoadPartition(partition_ + 1);
+  }
+  return false;
+}
+
+void AdaptiveJoinExecutor::FindMatches() {
+  matches_.clear();
+  rids_.clear();
+  next_match_ = 0;
+  const bool is_left_join = plan_->GetJoinType() == JoinType::LEFT;
+  if (strategy_ == Strategy::IndexNestedLoop) {
+    auto key = left_key_->Evaluate(&probe_tuple_);
+    index_info_->index_->ScanKey(Tuple{{key}, index_info_->index_->GetKeySchema()}, &rids_,
+                                 exec_ctx_->GetTransaction());
+    pending_null_ = rids_.empty() && is_left_join;
+    return;
+  }
+  const bool probe_left = strategy_ != Strategy::HashBuildLeft;
+  auto key = (probe_left ? left_key_ : right_key_)->Evaluate(&probe_tuple_);
+  if (auto bucket = table_.find(HashUtil::HashValue(&key)); bucket != table_.end()) {
+    for (auto idx : bucket->second) {
+      if (build_[idx].key_.CompareEquals(key) == CmpBool::CmpTrue) {
+        matches_.push_back(idx);
+        build_[idx].matched_ = true;
+      }
+    }
+  }
+  pending_null_ = matches_.empty() && probe_left && is_left_join;
+}
+
+auto AdaptiveJoinExecutor::EmitMatch(Tuple *tuple) -> bool {
+  const auto &left_schema = plan_->GetLeftPlan()->OutputSchema();
+  const auto &right_schema = plan_->GetRightPlan()->OutputSchema();
+  if (strategy_ == Strategy::IndexNestedLoop) {
+    while (next_match_ < rids_.size()) {
+      Tuple right_tuple;
+      if (table_info_->table_->GetTuple(rids_[next_match_++], &right_tuple, exec_ctx_->GetTransaction())) {
+        if (!right_column_ids_->empty()) {
+          right_tuple = right_tuple.ProjectColumns(table_info_->schema_, right_schema, *right_column_ids_);
+        }
+        *tuple = Tuple(probe_tuple_, &left_schema, right_tuple, &right_schema);
+        return true;
+      }
+    }
+  } else if (next_match_ < matches_.size()) {
+    const auto &build_tuple = build_[matches_[next_match_++]].tuple_;
+    if (strategy_ == Strategy::HashBuildLeft) {
+      *tuple = Tuple(build_tuple, &left_schema, probe_tuple_, &right_schema);
+    } else {
+      *tuple = Tuple(probe_tuple_, &left_schema, build_tuple, &right_schema);
+    }
+    return true;
+  }
+  if (pending_null_) {
+    pending_null_ = false;
+    *tuple = Tuple(probe_tuple_, &left_schema, null_right_tuple_, &right_schema);
+    return true;
+  }
+  return false;
+}
+
+}  // namespace bustub
@@ -25,6 +25,7 @@
 #include <memory>
 #include <vector>
 
+#include "common/config.h"
 #include "execution/executors/aggregation_executor.h"
 
 namespace bustub {
@@ -35,10 +36,34 @@ AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const Aggreg
       plan_(plan),
       child_(std::move(child)),
       aht_(plan_->aggregates_, plan_->agg_types_),//ϣ
-      aht_iterator_(aht_.Begin()) {}//ϣ
+      aht_iterator_(aht_.Begin()),//ϣ
+      is_distinct_(plan_->GetAggregates().empty() && !plan_->GetGroupBys().empty()) {}
 
 void AggregationExecutor::Init() {
   child_->Init();
+  if (is_distinct_) {
+    // Duplicates are dropped while the child is read, so nothing is built up front.
+    distinct_keys_.clear();
+    return;
+  }
+  aht_.Clear();
+  results_.clear();
+  result_idx_ = 0;
+  use_results_ = false;
+  if (enable_parallel_aggregation && ParallelAggregationHashTable::IsSupported(plan_)) {
+    if (parallel_aht_ == nullptr) {
+      parallel_aht_ = std::make_unique<ParallelAggregationHashTable>(plan_, &child_->GetOutputSchema(),
+                                                                     exec_ctx_->GetBufferPoolManager());
+    }
+    parallel_aht_->Build(child_.get());
+    if (parallel_aht_->Merge(&GetOutputSchema(), &results_) > 0 || GetOutputSchema().GetColumnCount() != 1) {
+      use_results_ = true;
+    } else {
+      aht_.InsertIntialCombine();
+      aht_iterator_ = aht_.Begin();
+    }
+    return;
+  }
   Tuple tuple{};
   RID rid{};
   //ӽڵȡtuplerid
@@ -47,6 +72,7 @@ void AggregationExecutor::Init() {
     //õһµtuple,tupleеݣӳϵ
     aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
   }
+  aht_.Finalize();
   //⴦չϣΪձͳϢʱֻcountstar0Чnull*/
   if (aht_.Size() == 0 && GetOutputSchema().GetColumnCount() == 1) {
     aht_.InsertIntialCombine();
@@ -55,7 +81,24 @@ void AggregationExecutor::Init() {
 }
 
 auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (is_distinct_) {
+    while (child_->Next(tuple, rid)) {
+      auto key = MakeAggregateKey(tuple);
+      if (distinct_keys_.insert(key).second) {
+        *tuple = Tuple{key.group_bys_, &GetOutputSchema()};
+        return true;
+      }
+    }
+    return false;
+  }
     //ָʱϣÿһ
+  if (use_results_) {
+    if (result_idx_ == results_.size()) {
+      return false;
+    }
+    *tuple = results_[result_idx_++];
+    return true;
+  }
   if (aht_iterator_ == aht_.End()) {
     return false;
   }
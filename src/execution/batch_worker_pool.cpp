@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// batch_worker_pool.cpp
+//
+// Identification: src/execution/batch_worker_pool.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/batch_worker_pool.h"
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+
+namespace bustub {
+
+auto BatchWorkerPool::ReadBatch(AbstractExecutor *child, size_t batch_size) -> std::vector<Tuple> {
+  std::vector<Tuple> batch(batch_size);
+  RID rid;
+  size_t size = 0;
+  while (size < batch.size() && child->Next(&batch[size], &rid)) {
+    size++;
+  }
+  batch.resize(size);
+  return batch;
+}
+
+void BatchWorkerPool::Run(AbstractExecutor *child, std::vector<Tuple> batch, const ProcessFn &process,
+                          const FinishFn &finish) {
+  std::mutex latch;
+  std::condition_variable cv;
+  std::deque<std::vector<Tuple>> queue;
+  bool done = false;
+  std::exception_ptr error = nullptr;
+  const size_t max_queued = 2 * num_workers_;
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers_);
+  for (size_t i = 0; i < num_workers_; i++) {
+    threads.emplace_back([&, worker = i]() {
+      try {
+        while (true) {
+          std::vector<Tuple> tuples;
+          {
+            std::unique_lock<std::mutex> l(latch);
+            cv.wait(l, [&] { return !queue.empty() || done; });
+            if (queue.empty()) {
+              break;
+            }
+            tuples = std::move(queue.front());
+            queue.pop_front();
+          }
+          cv.notify_all();
+          process(worker, tuples);
+        }
+        if (finish) {
+          finish(worker);
+        }
+      } catch (...) {
+        std::unique_lock<std::mutex> l(latch);
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+        done = true;
+        queue.clear();
+        cv.notify_all();
+      }
+    });
+  }
+
+  auto join = [&]() {
+    {
+      std::unique_lock<std::mutex> l(latch);
+      done = true;
+    }
+    cv.notify_all();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+
+  try {
+    while (!batch.empty()) {
+      {
+        std::unique_lock<std::mutex> l(latch);
+        cv.wait(l, [&] { return queue.size() < max_queued || done; });
+        if (done) {
+          break;
+        }
+        queue.emplace_back(std::move(batch));
+      }
+      cv.notify_all();
+      batch = ReadBatch(child, batch_size_);
+    }
+  } catch (...) {
+    join();
+    throw;
+  }
+  join();
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace bustub
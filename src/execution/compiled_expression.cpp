@@ -0,0 +1,360 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_expression.cpp
+//
+// Identification: src/execution/compiled_expression.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/compiled_expression.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+#include "execution/expressions/arithmetic_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+CompiledExpression::CompiledExpression(const AbstractExpression *expr, const Schema &schema)
+    : expr_(expr), left_schema_(&schema), right_schema_(nullptr), is_join_(false) {
+  if (Emit(expr) == 0) {
+    program_.clear();
+  }
+}
+
+CompiledExpression::CompiledExpression(const AbstractExpression *expr, const Schema &left_schema,
+                                       const Schema &right_schema)
+    : expr_(expr), left_schema_(&left_schema), right_schema_(&right_schema), is_join_(true) {
+  if (Emit(expr) == 0) {
+    program_.clear();
+  }
+}
+
+auto CompiledExpression::IsRawType(TypeId type) -> bool {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto CompiledExpression::Emit(const AbstractExpression *expr) -> size_t {
+  if (!IsRawType(expr->GetReturnType())) {
+    return 0;
+  }
+  size_t start = program_.size();
+
+  // Compile both children of a binary node, return 0 if either one cannot be compiled.
+  auto emit_children = [&]() -> size_t {
+    size_t left = Emit(expr->GetChildAt(0).get());
+    if (left == 0) {
+      return 0;
+    }
+    size_t right = Emit(expr->GetChildAt(1).get());
+    if (right == 0) {
+      return 0;
+    }
+    return std::max(left, right + 1);
+  };
+
+  size_t depth = 0;
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    uint8_t side = is_join_ ? column->GetTupleIdx() : 0;
+    const Schema *schema = side == 0 ? left_schema_ : right_schema_;
+    if (side <= 1 && column->GetColIdx() < schema->GetColumnCount()) {
+      const auto &col = schema->GetColumn(column->GetColIdx());
+      Instruction ins{OpCode::LoadInt8};
+      ins.side_ = side;
+      ins.offset_ = col.GetOffset();
+      switch (col.GetType()) {
+        case TypeId::BOOLEAN:
+        case TypeId::TINYINT:
+          ins.op_ = OpCode::LoadInt8;
+          depth = 1;
+          break;
+        case TypeId::SMALLINT:
+          ins.op_ = OpCode::LoadInt16;
+          depth = 1;
+          break;
+        case TypeId::INTEGER:
+          ins.op_ = OpCode::LoadInt32;
+          depth = 1;
+          break;
+        case TypeId::BIGINT:
+          ins.op_ = OpCode::LoadInt64;
+          depth = 1;
+          break;
+        default:
+          break;
+      }
+      if (depth != 0) {
+        program_.push_back(ins);
+      }
+    }
+  } else if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+    Instruction ins{OpCode::Constant};
+    ins.constant_ = FromValue(constant->val_, &ins.is_null_);
+    program_.push_back(ins);
+    depth = 1;
+  } else if (const auto *arithmetic = dynamic_cast<const ArithmeticExpression *>(expr); arithmetic != nullptr) {
+    depth = emit_children();
+    if (depth != 0) {
+      program_.push_back({arithmetic->compute_type_ == ArithmeticType::Plus ? OpCode::Plus : OpCode::Minus});
+    }
+  } else if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(expr); comparison != nullptr) {
+    // BOOLEAN is only compared with BOOLEAN, and integers only with integers.
+    bool left_bool = comparison->GetChildAt(0)->GetReturnType() == TypeId::BOOLEAN;
+    bool right_bool = comparison->GetChildAt(1)->GetReturnType() == TypeId::BOOLEAN;
+    if (left_bool == right_bool) {
+      depth = emit_children();
+    }
+    if (depth != 0) {
+      switch (comparison->comp_type_) {
+        case ComparisonType::Equal:
+          program_.push_back({OpCode::Equal});
+          break;
+        case ComparisonType::NotEqual:
+          program_.push_back({OpCode::NotEqual});
+          break;
+        case ComparisonType::LessThan:
+          program_.push_back({OpCode::LessThan});
+          break;
+        case ComparisonType::LessThanOrEqual:
+          program_.push_back({OpCode::LessThanOrEqual});
+          break;
+        case ComparisonType::GreaterThan:
+          program_.push_back({OpCode::GreaterThan});
+          break;
+        case ComparisonType::GreaterThanOrEqual:
+          program_.push_back({OpCode::GreaterThanOrEqual});
+          break;
+      }
+    }
+  } else if (const auto *logic = dynamic_cast<const LogicExpression *>(expr); logic != nullptr) {
+    depth = emit_children();
+    if (depth != 0) {
+      program_.push_back({logic->logic_type_ == LogicType::And ? OpCode::And : OpCode::Or});
+    }
+  }
+
+  if (depth == 0 || depth > MAX_STACK_DEPTH) {
+    // Evaluate this sub-tree the usual way, its result still lands on the stack.
+    program_.resize(start);
+    Instruction ins{OpCode::Tree};
+    ins.expr_ = expr;
+    program_.push_back(ins);
+    depth = 1;
+  }
+  return depth;
+}
+
+auto CompiledExpression::FromValue(const Value &value, bool *is_null) -> int64_t {
+  *is_null = value.IsNull();
+  if (*is_null) {
+    return 0;
+  }
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return value.GetAs<int8_t>();
+    case TypeId::SMALLINT:
+      return value.GetAs<int16_t>();
+    case TypeId::INTEGER:
+      return value.GetAs<int32_t>();
+    case TypeId::BIGINT:
+      return value.GetAs<int64_t>();
+    default:
+      UNREACHABLE("not a raw type");
+  }
+}
+
+auto CompiledExpression::ToValue(int64_t result, bool is_null) const -> Value {
+  auto type = expr_->GetReturnType();
+  if (is_null) {
+    return ValueFactory::GetNullValueByType(type);
+  }
+  switch (type) {
+    case TypeId::BOOLEAN:
+      return ValueFactory::GetBooleanValue(result != 0);
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(static_cast<int8_t>(result));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(result));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(static_cast<int32_t>(result));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(result);
+    default:
+      UNREACHABLE("not a raw type");
+  }
+}
+
+auto CompiledExpression::Run(const Tuple *left, const Tuple *right, bool *is_null) const -> int64_t {
+  int64_t stack[MAX_STACK_DEPTH];
+  bool nulls[MAX_STACK_DEPTH];
+  size_t top = 0;
+  const char *data[2] = {left->GetData(), right != nullptr ? right->GetData() : nullptr};
+
+  for (const auto &ins : program_) {
+    switch (ins.op_) {
+      case OpCode::LoadInt8: {
+        int8_t v;
+        memcpy(&v, data[ins.side_] + ins.offset_, sizeof(v));
+        nulls[top] = v == BUSTUB_INT8_NULL;
+        stack[top++] = v;
+        break;
+      }
+      case OpCode::LoadInt16: {
+        int16_t v;
+        memcpy(&v, data[ins.side_] + ins.offset_, sizeof(v));
+        nulls[top] = v == BUSTUB_INT16_NULL;
+        stack[top++] = v;
+        break;
+      }
+      case OpCode::LoadInt32: {
+        int32_t v;
+        memcpy(&v, data[ins.side_] + ins.offset_, sizeof(v));
+        nulls[top] = v == BUSTUB_INT32_NULL;
+        stack[top++] = v;
+        break;
+      }
+      case OpCode::LoadInt64: {
+        int64_t v;
+        memcpy(&v, data[ins.side_] + ins.offset_, sizeof(v));
+        nulls[top] = v == BUSTUB_INT64_NULL;
+        stack[top++] = v;
+        break;
+      }
+      case OpCode::Constant:
+        nulls[top] = ins.is_null_;
+        stack[top++] = ins.constant_;
+        break;
+      case OpCode::Tree: {
+        Value value = is_join_ ? ins.expr_->EvaluateJoin(left, *left_schema_, right, *right_schema_)
+                               : ins.expr_->Evaluate(left, *left_schema_);
+        stack[top] = FromValue(value, &nulls[top]);
+        top++;
+        break;
+      }
+      case OpCode::Plus:
+      case OpCode::Minus: {
+        // Arithmetic is defined on INTEGER only; it wraps around like int32_t and the NULL marker reads as NULL.
+        top--;
+        auto lhs = static_cast<uint32_t>(stack[top - 1]);
+        auto rhs = static_cast<uint32_t>(stack[top]);
+        auto res = static_cast<int32_t>(ins.op_ == OpCode::Plus ? lhs + rhs : lhs - rhs);
+        nulls[top - 1] = nulls[top - 1] || nulls[top] || res == BUSTUB_INT32_NULL;
+        stack[top - 1] = res;
+        break;
+      }
+      case OpCode::And:
+      case OpCode::Or: {
+        top--;
+        bool l_null = nulls[top - 1];
+        bool r_null = nulls[top];
+        bool l = stack[top - 1] != 0;
+        bool r = stack[top] != 0;
+        // Three-valued logic: a decisive side wins over NULL.
+        bool decisive = ins.op_ == OpCode::Or;
+        if ((!l_null && l == decisive) || (!r_null && r == decisive)) {
+          nulls[top - 1] = false;
+          stack[top - 1] = static_cast<int64_t>(decisive);
+        } else if (l_null || r_null) {
+          nulls[top - 1] = true;
+        } else {
+          stack[top - 1] = static_cast<int64_t>(!decisive);
+        }
+        break;
+      }
+      default: {
+        top--;
+        int64_t lhs = stack[top - 1];
+        int64_t rhs = stack[top];
+        bool res = false;
+        switch (ins.op_) {
+          case OpCode::Equal:
+            res = lhs == rhs;
+            break;
+          case OpCode::NotEqual:
+            res = lhs != rhs;
+            break;
+          case OpCode::LessThan:
+            res = lhs < rhs;
+            break;
+          case OpCode::LessThanOrEqual:
+            res = lhs <= rhs;
+            break;
+          case OpCode::GreaterThan:
+            res = lhs > rhs;
+            break;
+          case OpCode::GreaterThanOrEqual:
+            res = lhs >= rhs;
+            break;
+          default:
+            UNREACHABLE("unknown opcode");
+        }
+        nulls[top - 1] = nulls[top - 1] || nulls[top];
+        stack[top - 1] = static_cast<int64_t>(res);
+        break;
+      }
+    }
+  }
+  *is_null = nulls[0];
+  return stack[0];
+}
+
+auto CompiledExpression::Evaluate(const Tuple *tuple) const -> Value {
+  if (program_.empty()) {
+    return expr_->Evaluate(tuple, *left_schema_);
+  }
+  bool is_null;
+  int64_t result = Run(tuple, nullptr, &is_null);
+  return ToValue(result, is_null);
+}
+
+auto CompiledExpression::EvaluateJoin(const Tuple *left_tuple, const Tuple *right_tuple) const -> Value {
+  if (program_.empty()) {
+    return expr_->EvaluateJoin(left_tuple, *left_schema_, right_tuple, *right_schema_);
+  }
+  bool is_null;
+  int64_t result = Run(left_tuple, right_tuple, &is_null);
+  return ToValue(result, is_null);
+}
+
+auto CompiledExpression::EvaluatePredicate(const Tuple *tuple) const -> bool {
+  if (program_.empty()) {
+    auto value = expr_->Evaluate(tuple, *left_schema_);
+    return !value.IsNull() && value.GetAs<bool>();
+  }
+  bool is_null;
+  int64_t result = Run(tuple, nullptr, &is_null);
+  return !is_null && result != 0;
+}
+
+auto CompiledExpression::EvaluateJoinPredicate(const Tuple *left_tuple, const Tuple *right_tuple) const -> bool {
+  if (program_.empty()) {
+    auto value = expr_->EvaluateJoin(left_tuple, *left_schema_, right_tuple, *right_schema_);
+    return !value.IsNull() && value.GetAs<bool>();
+  }
+  bool is_null;
+  int64_t result = Run(left_tuple, right_tuple, &is_null);
+  return !is_null && result != 0;
+}
+
+}  // namespace bustub
@@ -22,6 +22,7 @@
 #include <memory>
 
 #include "execution/executors/delete_executor.h"
+#include "execution/plans/seq_scan_plan.h"
 
 namespace bustub {
 
@@ -37,16 +38,63 @@ void DeleteExecutor::Init() {
   child_executor_->Init();
   // IX  Init()
   try {
-    bool is_locked = exec_ctx_->GetLockManager()->LockTable(
-        exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE, table_info_->oid_);
+    // A write driven by a full scan changes every row, so lock the table instead of each row if nobody is in the way.
+    const auto *scan = dynamic_cast<const SeqScanPlanNode *>(plan_->GetChildPlan().get());
+    bool whole_table = scan != nullptr && scan->IsFullScan() && scan->GetTableOid() == table_info_->oid_;
+    auto *txn = exec_ctx_->GetTransaction();
+    auto *lock_manager = exec_ctx_->GetLockManager();
+    table_oid_t oid = table_info_->oid_;
+    bool is_locked = (whole_table && lock_manager->TryLockTable(txn, LockManager::LockMode::EXCLUSIVE, oid)) ||
+                     lock_manager->LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid);
     if (!is_locked) {
       throw ExecutionException("Delete Executor Get Table Lock Failed");
     }
-  } catch (TransactionAbortException e) {
+  } catch (const TransactionAbortException &e) {
     throw ExecutionException("Delete Executor Get Table Lock Failed");
   }
   table_indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);//
 }
+
+void DeleteExecutor::LockRows(const std::vector<RID> &rids) {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (rids.empty() || LockManager::IsRowLockCovered(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_)) {
+    return;
+  }
+  try {
+    bool is_locked =
+        exec_ctx_->GetLockManager()->LockRows(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_, rids);
+    if (!is_locked) {
+      throw ExecutionException("Delete Executor Get Row Lock Failed");
+    }
+  } catch (const TransactionAbortException &e) {
+    throw ExecutionException("Delete Executor Get Row Lock Failed");
+  }
+}
+
+void DeleteExecutor::LockIndexKeys(const Tuple &tuple) {
+  auto *txn = exec_ctx_->GetTransaction();
+  auto *lock_manager = exec_ctx_->GetLockManager();
+  for (auto *index : table_indexes_) {
+    auto *tree = dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index->index_.get());
+    if (tree == nullptr) {
+      continue;
+    }
+    auto key = tuple.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
+    IntegerKeyType index_key;
+    index_key.SetFromKey(key);
+    try {
+      bool is_locked =
+          lock_manager->LockKey(txn, LockManager::LockMode::EXCLUSIVE, index->index_oid_, IntegerKeyValue(index_key)) &&
+          lock_manager->LockNextKey(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, index->index_oid_,
+                                    [tree, &key] { return NextIntegerKeyValue(tree, key, LockManager::KEY_SUPREMUM); });
+      if (!is_locked) {
+        throw ExecutionException("Delete Executor Get Key Lock Failed");
+      }
+    } catch (const TransactionAbortException &e) {
+      throw ExecutionException("Delete Executor Get Key Lock Failed");
+    }
+  }
+}
 //ɾڱtupleԪ
 //Next() һ޸ tuple
 //Next() ֻ᷵һһ integer value  tupleʾ table жܵӰ
@@ -54,33 +102,57 @@ auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (is_end_) {
     return false;
   }
-  Tuple to_delete_tuple{};
-  RID emit_rid;
+  Tuple child_tuple{};
+  RID child_rid;
+  std::vector<Tuple> to_delete_tuples;
+  std::vector<RID> emit_rids;
   int32_t delete_count = 0;
   //ֻһӽڵ㣬ʾҪӱɾļ¼ɾִӦòһʾӱɾҪ
-  while (child_executor_->Next(&to_delete_tuple, &emit_rid)) {
-    // X   Next()
-    try {
-      bool is_locked = exec_ctx_->GetLockManager()->LockRow(
-          exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE, table_info_->oid_, emit_rid);
-      if (!is_locked) {
-        throw ExecutionException("Delete Executor Get Row Lock Failed");
-      }
-    } catch (TransactionAbortException e) {
-      throw ExecutionException("Delete Executor Get Row Lock Failed");
+  bool has_next = child_executor_->Next(&child_tuple, &child_rid);
+  while (has_next) {
+    // The rows are locked a batch at a time, see LockManager::LockRows().
+    to_delete_tuples.clear();
+    emit_rids.clear();
+    while (has_next && emit_rids.size() < LOCK_BATCH_SIZE) {
+      to_delete_tuples.push_back(child_tuple);
+      emit_rids.push_back(child_rid);
+      has_next = child_executor_->Next(&child_tuple, &child_rid);
     }
+    LockRows(emit_rids);
+
+    for (size_t i = 0; i < emit_rids.size(); i++) {
+      const Tuple &to_delete_tuple = to_delete_tuples[i];
+      const RID &emit_rid = emit_rids[i];
+      // The snapshot read by the child is stale if another transaction changed the row since, the first updater wins.
+      if (table_info_->table_->HasWriteConflict(emit_rid, exec_ctx_->GetTransaction())) {
+        exec_ctx_->GetTransaction()->SetState(TransactionState::ABORTED);
+        throw ExecutionException("Delete Executor Write-Write Conflict");
+      }
 
-    bool deleted = table_info_->table_->MarkDelete(emit_rid, exec_ctx_->GetTransaction());
+      // Scans must neither miss the deleted keys before this transaction ends nor depend on them, see KEY LOCKS in
+      // lock_manager.h.
+      if (!LockManager::IsRowLockCovered(exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE,
+                                         table_info_->oid_)) {
+        LockIndexKeys(to_delete_tuple);
+      }
+
+      bool deleted = table_info_->table_->MarkDelete(emit_rid, exec_ctx_->GetTransaction());
 
-    if (deleted) {
-        //ɾ󣬸     ڱһDeleteEntrykey,*rid,
-      std::for_each(table_indexes_.begin(), table_indexes_.end(),
-                    [&to_delete_tuple, &rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index) {
-                      index->index_->DeleteEntry(to_delete_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
-                                                                              index->index_->GetKeyAttrs()),
-                                                 *rid, exec_ctx->GetTransaction());
-                    });
-      delete_count++;
+      if (deleted) {
+          //ɾ󣬸     ڱһDeleteEntrykey,*rid,
+        // The key is kept in the index write set as it is, a rollback inserts it without building it again.
+        std::for_each(table_indexes_.begin(), table_indexes_.end(),
+                      [&to_delete_tuple, &emit_rid, &table_info = table_info_,
+                       &exec_ctx = exec_ctx_](IndexInfo *index) {
+                        auto key = to_delete_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
+                                                                index->index_->GetKeyAttrs());
+                        index->index_->DeleteEntry(key, emit_rid, exec_ctx->GetTransaction());
+                        exec_ctx->GetTransaction()->AppendIndexWriteRecord(
+                            IndexWriteRecord(emit_rid, table_info->oid_, WType::DELETE, Tuple{}, index->index_oid_,
+                                             exec_ctx->GetCatalog(), key));
+                      });
+        delete_count++;
+      }
     }
   }
   std::vector<Value> values{};
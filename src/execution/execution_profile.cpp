@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// execution_profile.cpp
+//
+// Identification: src/execution/execution_profile.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/execution_profile.h"
+
+#include <cmath>
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+namespace {
+
+auto Milliseconds(uint64_t ns) -> std::string { return fmt::format("{:.3f}ms", static_cast<double>(ns) / 1e6); }
+
+}  // namespace
+
+auto ExecutionProfile::GetOperator(const AbstractPlanNode *plan) -> OperatorProfile * {
+  std::scoped_lock lock(latch_);
+  // Elements of an unordered_map are not moved when it grows, the pointer stays valid.
+  return &operators_[plan];
+}
+
+auto ExecutionProfile::ToString(const AbstractPlanNode &plan,
+                                const std::function<std::optional<double>(const AbstractPlanNode &)> &estimate) const
+    -> std::string {
+  std::scoped_lock lock(latch_);
+  std::string output;
+  ToString(plan, estimate, 0, &output);
+  return output;
+}
+
+void ExecutionProfile::ToString(const AbstractPlanNode &plan,
+                                const std::function<std::optional<double>(const AbstractPlanNode &)> &estimate,
+                                size_t indent, std::string *output) const {
+  auto rows = estimate(plan);
+  auto estimated = rows.has_value() ? fmt::format("{}", std::llround(*rows)) : "?";
+  if (!output->empty()) {
+    output->push_back('\n');
+  }
+  output->append(indent, ' ');
+  output->append(plan.NodeToString(false));
+  auto profile = operators_.find(&plan);
+  if (profile == operators_.end() || profile->second.loops_ == 0) {
+    output->append(fmt::format(" (estimated rows={}, never executed)", estimated));
+  } else {
+    const auto &op = profile->second;
+    output->append(fmt::format(
+        " (estimated rows={}, actual rows={}, loops={}, init={}, next={}, pages fetched={} missed={} flushed={})",
+        estimated, op.rows_, op.loops_, Milliseconds(op.init_ns_), Milliseconds(op.next_ns_), op.pages_.fetched_,
+        op.pages_.missed_, op.pages_.flushed_));
+    for (const auto &note : op.notes_) {
+      output->push_back('\n');
+      output->append(indent + 2, ' ');
+      output->append(fmt::format("note: {}", note));
+    }
+  }
+  for (const auto &child : plan.GetChildren()) {
+    ToString(*child, estimate, indent + 2, output);
+  }
+}
+
+}  // namespace bustub
@@ -16,12 +16,14 @@
 #include <utility>
 
 #include "execution/executors/abstract_executor.h"
+#include "execution/executors/adaptive_join_executor.h"
 #include "execution/executors/aggregation_executor.h"
 #include "execution/executors/delete_executor.h"
 #include "execution/executors/filter_executor.h"
 #include "execution/executors/hash_join_executor.h"
 #include "execution/executors/index_scan_executor.h"
 #include "execution/executors/insert_executor.h"
+#include "execution/executors/instrumented_executor.h"
 #include "execution/executors/limit_executor.h"
 #include "execution/executors/mock_scan_executor.h"
 #include "execution/executors/nested_index_join_executor.h"
@@ -44,6 +46,15 @@ namespace bustub {
 
 auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPlanNodeRef &plan)
     -> std::unique_ptr<AbstractExecutor> {
+  auto executor = CreatePlanExecutor(exec_ctx, plan);
+  if (exec_ctx->GetProfile() != nullptr) {
+    return std::make_unique<InstrumentedExecutor>(exec_ctx, plan.get(), std::move(executor));
+  }
+  return executor;
+}
+
+auto ExecutorFactory::CreatePlanExecutor(ExecutorContext *exec_ctx, const AbstractPlanNodeRef &plan)
+    -> std::unique_ptr<AbstractExecutor> {
   switch (plan->GetType()) {
     // Create a new sequential scan executor
     case PlanType::SeqScan: {
@@ -114,6 +125,14 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
       return std::make_unique<HashJoinExecutor>(exec_ctx, hash_join_plan, std::move(left), std::move(right));
     }
 
+    // Create a new adaptive join executor
+    case PlanType::AdaptiveJoin: {
+      const auto *adaptive_join_plan = dynamic_cast<const AdaptiveJoinPlanNode *>(plan.get());
+      auto left = ExecutorFactory::CreateExecutor(exec_ctx, adaptive_join_plan->GetLeftPlan());
+      auto right = ExecutorFactory::CreateExecutor(exec_ctx, adaptive_join_plan->GetRightPlan());
+      return std::make_unique<AdaptiveJoinExecutor>(exec_ctx, adaptive_join_plan, std::move(left), std::move(right));
+    }
+
     // Create a new mock scan executor
     case PlanType::MockScan: {
       const auto *mock_scan_plan = dynamic_cast<const MockScanPlanNode *>(plan.get());
@@ -11,11 +11,10 @@ FilterExecutor::FilterExecutor(ExecutorContext *exec_ctx, const FilterPlanNode *
 void FilterExecutor::Init() {
   // Initialize the child executor
   child_executor_->Init();
+  predicate_ = std::make_unique<CompiledExpression>(plan_->GetPredicate().get(), child_executor_->GetOutputSchema());
 }
 
 auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  auto filter_expr = plan_->GetPredicate();
-
   while (true) {
     // Get the next tuple
     const auto status = child_executor_->Next(tuple, rid);
@@ -24,8 +23,7 @@ auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
       return false;
     }
 
-    auto value = filter_expr->Evaluate(tuple, child_executor_->GetOutputSchema());
-    if (!value.IsNull() && value.GetAs<bool>()) {
+    if (predicate_->EvaluatePredicate(tuple)) {
       return true;
     }
   }
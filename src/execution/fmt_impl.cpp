@@ -9,6 +9,7 @@
 #include "execution/plans/aggregation_plan.h"
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/sort_plan.h"
 #include "execution/plans/topn_plan.h"
 
@@ -35,6 +36,14 @@ auto AggregationPlanNode::PlanNodeToString() const -> std::string {
   return fmt::format("Agg {{ types={}, aggregates={}, group_by={} }}", agg_types_, aggregates_, group_bys_);
 }
 
+auto SeqScanPlanNode::PlanNodeToString() const -> std::string {
+  std::string columns = column_ids_.empty() ? "" : fmt::format(", columns={}", column_ids_);
+  if (filter_predicate_) {
+    return fmt::format("SeqScan {{ table={}, filter={}{} }}", table_name_, filter_predicate_, columns);
+  }
+  return fmt::format("SeqScan {{ table={}{} }}", table_name_, columns);
+}
+
 auto ProjectionPlanNode::PlanNodeToString() const -> std::string {
   return fmt::format("Projection {{ exprs={} }}", expressions_);
 }
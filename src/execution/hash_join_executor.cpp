@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/hash_join_executor.h"
+#include "execution/compiled_expression.h"
 #include "type/value_factory.h"
 
 // Note for 2022 Fall: You don't need to implement HashJoinExecutor to pass all tests. You ONLY need to implement it
@@ -25,8 +26,9 @@ HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlan
       plan_{plan},
       left_executor_{std::move(left_child)},
       right_executor_(std::move(right_child)) {
-  if (!(plan->GetJoinType() == JoinType::LEFT || plan->GetJoinType() == JoinType::INNER)) {
-    // Note for 2022 Fall: You ONLY need to implement left join and inner join.
+  auto join_type = plan->GetJoinType();
+  if (join_type != JoinType::LEFT && join_type != JoinType::INNER && join_type != JoinType::SEMI &&
+      join_type != JoinType::ANTI && join_type != JoinType::NULL_AWARE_ANTI) {
     throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
   }
 }
@@ -34,45 +36,79 @@ HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlan
 void HashJoinExecutor::Init() {
   left_executor_->Init();
   right_executor_->Init();
+  hash_join_table_.clear();
+  output_tuples_.clear();
 
+  const auto &left_schema = plan_->GetLeftPlan()->OutputSchema();
+  const auto &right_schema = plan_->GetRightPlan()->OutputSchema();
+  CompiledExpression left_key(&plan_->LeftJoinKeyExpression(), left_schema);
+  CompiledExpression right_key(&plan_->RightJoinKeyExpression(), right_schema);
+
+  auto join_type = plan_->GetJoinType();
   Tuple tmp_tuple{};
   RID rid;
+  // A NULL key equals nothing, but makes `NOT IN` NULL for every left tuple that does not match.
+  bool is_right_empty = true;
+  bool has_right_null = false;
   while (right_executor_->Next(&tmp_tuple, &rid)) {
-    auto join_key = plan_->RightJoinKeyExpression().Evaluate(&tmp_tuple, plan_->GetRightPlan()->OutputSchema());
-    hash_join_table_[HashUtil::HashValue(&join_key)].push_back(tmp_tuple);
+    is_right_empty = false;
+    auto join_key = right_key.Evaluate(&tmp_tuple);
+    if (join_key.IsNull()) {
+      has_right_null = true;
+      continue;
+    }
+    hash_join_table_[HashUtil::HashValue(&join_key)].emplace_back(join_key, tmp_tuple);
+  }
+
+  Tuple null_right_tuple{};
+  if (join_type == JoinType::LEFT) {
+    std::vector<Value> values{};
+    values.reserve(right_schema.GetColumnCount());
+    for (const auto &column : right_schema.GetColumns()) {
+      values.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+    }
+    null_right_tuple = Tuple{values, &right_schema};
   }
 
   while (left_executor_->Next(&tmp_tuple, &rid)) {
-    auto join_key = plan_->LeftJoinKeyExpression().Evaluate(&tmp_tuple, plan_->GetLeftPlan()->OutputSchema());
-    if (hash_join_table_.count(HashUtil::HashValue(&join_key)) > 0) {
-      auto right_tuples = hash_join_table_[HashUtil::HashValue(&join_key)];
-      for (const auto &tuple : right_tuples) {
-        auto right_join_key = plan_->RightJoinKeyExpression().Evaluate(&tuple, plan_->GetRightPlan()->OutputSchema());
-        if (right_join_key.CompareEquals(join_key) == CmpBool::CmpTrue) {
-          std::vector<Value> values{};
-          values.reserve(plan_->GetLeftPlan()->OutputSchema().GetColumnCount() +
-                         plan_->GetRightPlan()->OutputSchema().GetColumnCount());
-          for (uint32_t col_idx = 0; col_idx < plan_->GetLeftPlan()->OutputSchema().GetColumnCount(); col_idx++) {
-            values.push_back(tmp_tuple.GetValue(&plan_->GetLeftPlan()->OutputSchema(), col_idx));
-          }
-          for (uint32_t col_idx = 0; col_idx < plan_->GetRightPlan()->OutputSchema().GetColumnCount(); col_idx++) {
-            values.push_back(tuple.GetValue(&plan_->GetRightPlan()->OutputSchema(), col_idx));
-          }
-          output_tuples_.emplace_back(values, &GetOutputSchema());
+    auto join_key = left_key.Evaluate(&tmp_tuple);
+    bool matched = false;
+    if (auto bucket = hash_join_table_.find(HashUtil::HashValue(&join_key)); bucket != hash_join_table_.end()) {
+      for (const auto &[right_join_key, right_tuple] : bucket->second) {
+        if (right_join_key.CompareEquals(join_key) != CmpBool::CmpTrue) {
+          continue;
         }
+        matched = true;
+        if (join_type != JoinType::INNER && join_type != JoinType::LEFT) {
+          // Semi and anti joins only need to know whether there is a match.
+          break;
+        }
+        output_tuples_.emplace_back(tmp_tuple, &left_schema, right_tuple, &right_schema);
       }
-    } else if (plan_->GetJoinType() == JoinType::LEFT) {
-      std::vector<Value> values{};
-      values.reserve(plan_->GetLeftPlan()->OutputSchema().GetColumnCount() +
-                     plan_->GetRightPlan()->OutputSchema().GetColumnCount());
-      for (uint32_t col_idx = 0; col_idx < plan_->GetLeftPlan()->OutputSchema().GetColumnCount(); col_idx++) {
-        values.push_back(tmp_tuple.GetValue(&plan_->GetLeftPlan()->OutputSchema(), col_idx));
-      }
-      for (uint32_t col_idx = 0; col_idx < plan_->GetRightPlan()->OutputSchema().GetColumnCount(); col_idx++) {
-        values.push_back(
-            ValueFactory::GetNullValueByType(plan_->GetRightPlan()->OutputSchema().GetColumn(col_idx).GetType()));
-      }
-      output_tuples_.emplace_back(values, &GetOutputSchema());
+    }
+    switch (join_type) {
+      case JoinType::LEFT:
+        if (!matched) {
+          output_tuples_.emplace_back(tmp_tuple, &left_schema, null_right_tuple, &right_schema);
+        }
+        break;
+      case JoinType::SEMI:
+        if (matched) {
+          output_tuples_.push_back(tmp_tuple);
+        }
+        break;
+      case JoinType::ANTI:
+        if (!matched) {
+          output_tuples_.push_back(tmp_tuple);
+        }
+        break;
+      case JoinType::NULL_AWARE_ANTI:
+        if (!matched && (is_right_empty || (!has_right_null && !join_key.IsNull()))) {
+          output_tuples_.push_back(tmp_tuple);
+        }
+        break;
+      default:
+        break;
     }
   }
 
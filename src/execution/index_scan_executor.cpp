@@ -10,7 +10,6 @@
 //
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
-#include "execution/expressions/constant_value_expression.h"
 
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
@@ -18,70 +17,177 @@ IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanP
       plan_{plan},
       index_info_{this->exec_ctx_->GetCatalog()->GetIndex(plan_->index_oid_)},
       table_info_{this->exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_)},
-      tree_{dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index_info_->index_.get())},
       //Ϣõ
       //ƻʼΪ BPlusTreeIndexForOneIntegerColumnȫؽת洢ִ
-      //ĵ
-      //tree_ iter
-      iter_{plan_->filter_predicate_ != nullptr ? BPlusTreeIndexIteratorForOneIntegerColumn(nullptr, nullptr)
-                                                : tree_->GetBeginIterator()} {}
+      tree_{dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index_info_->index_.get())} {}
 
 void IndexScanExecutor::Init() {
-  if (plan_->filter_predicate_ != nullptr) {
-    if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
-      try {
-        bool is_locked = exec_ctx_->GetLockManager()->LockTable(
-            exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_SHARED, table_info_->oid_);
-        if (!is_locked) {
-          throw ExecutionException("IndexScan Executor Get Table Lock Failed");
-        }
-      } catch (TransactionAbortException e) {
-        throw ExecutionException("IndexScan Executor Get Table Lock Failed" + e.GetInfo());
+  auto *txn = exec_ctx_->GetTransaction();
+  if (IsLockingRead()) {
+    try {
+      // A full scan reads every row, so lock the table instead of each row if nobody is in the way.
+      auto *lock_manager = exec_ctx_->GetLockManager();
+      table_oid_t oid = table_info_->oid_;
+      bool is_locked = (plan_->IsFullScan() && lock_manager->TryLockTable(txn, LockManager::LockMode::SHARED, oid)) ||
+                       lock_manager->LockTable(txn, LockManager::LockMode::INTENTION_SHARED, oid);
+      if (!is_locked) {
+        throw ExecutionException("IndexScan Executor Get Table Lock Failed");
+      }
+    } catch (const TransactionAbortException &e) {
+      throw ExecutionException("IndexScan Executor Get Table Lock Failed" + e.GetInfo());
+    }
+  }
+  // Under REPEATABLE_READ, a scan must not see new rows in its range when it runs again, unless the table lock
+  // keeps writers out anyway.
+  lock_keys_ = txn->GetIsolationLevel() == IsolationLevel::REPEATABLE_READ &&
+               !LockManager::IsRowLockCovered(txn, LockManager::LockMode::SHARED, table_info_->oid_);
+  if (plan_->low_.has_value()) {
+    cursor_.SetFromKey(Tuple{{plan_->low_->key_}, index_info_->index_->GetKeySchema()});
+  }
+  // An optimistic transaction validates what it read when it commits. A point lookup depends on the row it finds,
+  // any other scan also on the rows that could be inserted into its range, which only the table shows.
+  record_rows_ = txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && plan_->IsPointLookup();
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC && !record_rows_) {
+    txn->AddIntoReadTableSet(table_info_->table_.get());
+  }
+  entries_.clear();
+  next_entry_ = 0;
+  started_ = false;
+  done_ = false;
+  found_ = false;
+}
+
+auto IndexScanExecutor::IsPastRange(const Value &key) const -> bool {
+  if (!plan_->high_.has_value()) {
+    return false;
+  }
+  const auto &high = *plan_->high_;
+  return (high.inclusive_ ? key.CompareGreaterThan(high.key_) : key.CompareGreaterThanEquals(high.key_)) ==
+         CmpBool::CmpTrue;
+}
+
+auto IndexScanExecutor::IsLastKey(const Value &key) const -> bool {
+  return plan_->high_.has_value() && plan_->high_->inclusive_ &&
+         key.CompareEquals(plan_->high_->key_) == CmpBool::CmpTrue;
+}
+
+auto IndexScanExecutor::LockKeys(const std::vector<Entry> &batch, size_t batch_size) -> size_t {
+  auto *txn = exec_ctx_->GetTransaction();
+  auto *lock_manager = exec_ctx_->GetLockManager();
+  try {
+    for (size_t i = 0; i < batch.size(); i++) {
+      int64_t key = IntegerKeyValue(batch[i].first);
+      if (!lock_manager->LockKey(txn, LockManager::LockMode::SHARED, index_info_->index_oid_, key)) {
+        throw ExecutionException("IndexScan Executor Get Key Lock Failed");
+      }
+      // The gap up to the first key past the range is in the range, the gap above it is not.
+      Value value(TypeId::INTEGER, static_cast<int32_t>(key));
+      if (IsPastRange(value) || IsLastKey(value)) {
+        return i + 1;
       }
     }
-    const auto *right_expr =
-        dynamic_cast<const ConstantValueExpression *>(plan_->filter_predicate_->children_[1].get());
-    Value v = right_expr->val_;
-    tree_->ScanKey(Tuple{{v}, index_info_->index_->GetKeySchema()}, &rids_, exec_ctx_->GetTransaction());
-    rid_iter_ = rids_.begin();
+    if (batch.size() < batch_size &&
+        !lock_manager->LockKey(txn, LockManager::LockMode::SHARED, index_info_->index_oid_,
+                               LockManager::KEY_SUPREMUM)) {
+      throw ExecutionException("IndexScan Executor Get Key Lock Failed");
+    }
+  } catch (const TransactionAbortException &e) {
+    throw ExecutionException("IndexScan Executor Get Key Lock Failed" + e.GetInfo());
+  }
+  return batch.size();
+}
+
+void IndexScanExecutor::FetchEntries() {
+  // A point lookup reads either its key or the key above it, which is all it needs to lock.
+  size_t batch_size = plan_->IsPointLookup() ? 1 : BATCH_SIZE;
+  const IntegerKeyType *from = started_ || plan_->low_.has_value() ? &cursor_ : nullptr;
+  bool strict = started_ || (plan_->low_.has_value() && !plan_->low_->inclusive_);
+  std::vector<Entry> batch;
+  tree_->ScanEntries(from, strict, batch_size, &batch);
+  while (lock_keys_) {
+    // What was read before the locks were granted may be stale: a key may have been inserted into a locked gap or
+    // deleted in the meantime. Read again, the locked keys and gaps cannot change any more.
+    size_t locked = LockKeys(batch, batch_size);
+    std::vector<Entry> check;
+    tree_->ScanEntries(from, strict, batch_size, &check);
+    bool same = locked == batch.size() ? check.size() == batch.size() : check.size() >= locked;
+    for (size_t i = 0; same && i < locked; i++) {
+      same = IntegerKeyValue(check[i].first) == IntegerKeyValue(batch[i].first);
+    }
+    batch = std::move(check);
+    if (same) {
+      break;
+    }
+  }
+
+  started_ = true;
+  entries_.clear();
+  next_entry_ = 0;
+  if (batch.size() < batch_size) {
+    done_ = true;
+  } else {
+    cursor_ = batch.back().first;
+  }
+  for (const auto &entry : batch) {
+    Value key(TypeId::INTEGER, static_cast<int32_t>(IntegerKeyValue(entry.first)));
+    if (IsPastRange(key)) {
+      done_ = true;
+      break;
+    }
+    // NULL keys are smaller than every other key but never in a range.
+    if (!key.IsNull()) {
+      entries_.push_back(entry);
+    }
+    if (IsLastKey(key)) {
+      done_ = true;
+      break;
+    }
   }
 }
-//Ȼĵiter_ ->Ȼӵiter_óridã-> ͨridڱõӦtupleԪ
+
+//ȴ˳õһ<key,rid> -> ͨridڱõӦtupleԪ
 //˳ tuplerid
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (plan_->filter_predicate_ != nullptr) {
-    if (rid_iter_ != rids_.end()) {
-      *rid = *rid_iter_;//ãõpair<key,value> rid
-      if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
-        try {
-          bool is_locked = exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(),
-                                                                LockManager::LockMode::SHARED, table_info_->oid_, *rid);
-          if (!is_locked) {
-            throw ExecutionException("IndexScan Executor Get Table Lock Failed");
-          }
-        } catch (TransactionAbortException e) {
+  while (true) {
+    if (next_entry_ == entries_.size()) {
+      if (done_) {
+        if (record_rows_ && !found_) {
+          // The key is missing, so the lookup depends on nobody inserting it.
+          exec_ctx_->GetTransaction()->AddIntoReadTableSet(table_info_->table_.get());
+        }
+        return false;
+      }
+      FetchEntries();
+      continue;
+    }
+    *rid = entries_[next_entry_++].second;  //õpair<key,value> rid
+    auto *txn = exec_ctx_->GetTransaction();
+    // A row the transaction wrote itself is under its X lock already.
+    if (IsLockingRead() && !LockManager::IsRowLockCovered(txn, LockManager::LockMode::SHARED, table_info_->oid_) &&
+        !txn->IsRowExclusiveLocked(table_info_->oid_, *rid)) {
+      try {
+        bool is_locked =
+            exec_ctx_->GetLockManager()->LockRow(txn, LockManager::LockMode::SHARED, table_info_->oid_, *rid);
+        if (!is_locked) {
           throw ExecutionException("IndexScan Executor Get Row Lock Failed");
         }
+      } catch (const TransactionAbortException &e) {
+        throw ExecutionException("IndexScan Executor Get Row Lock Failed");
       }
+    }
 
-      auto result = table_info_->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction());
-      rid_iter_++;
-      return result;
+    // Skip entries whose row is not visible, e.g. not yet committed in a snapshot.
+    //õridȥѱtuple  table_table_info_һָѱָ
+    if (table_info_->table_->GetTuple(*rid, tuple, txn)) {
+      if (record_rows_) {
+        txn->AppendReadRecord(table_info_->table_.get(), *rid);
+        found_ = true;
+      }
+      return true;
     }
-    return false;
-  }
-  if (iter_ == tree_->GetEndIterator()) {
-    return false;
   }
-  //IndexScanExecutor iter_ҵԪ RIDȻRID ӦıǵԪtuple
-  //ЩԪ顣
-  *rid = (*iter_).second;//ãpair<key,value>  õrid
-  //õridȥѱtuple  table_table_info_һָѱָ
-  auto result = table_info_->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction());
-  ++iter_;
-  return result;
 }
 
 }  // namespace bustub
-// iterɨмԪ IDӱвԪ飬˳򷢳ԪΪִ
+//˳ɨ跶ΧڵļԪ IDӱвԪ飬˳򷢳ԪΪִ
 //BusTub ֧־еΨһевظļ
@@ -32,11 +32,48 @@ void InsertExecutor::Init() {
     if (!is_locked) {
       throw ExecutionException("Insert Executor Get Table Lock Failed");
     }
-  } catch (TransactionAbortException e) {
+  } catch (const TransactionAbortException &e) {
     throw ExecutionException("Insert Executor Get Table Lock Failed");
   }
   table_indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);//
 }
+
+void InsertExecutor::LockRow(const RID &rid) {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (LockManager::IsRowLockCovered(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_)) {
+    return;
+  }
+  try {
+    bool is_locked =
+        exec_ctx_->GetLockManager()->LockRow(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_, rid);
+    if (!is_locked) {
+      throw ExecutionException("Insert Executor Get Row Lock Failed");
+    }
+  } catch (const TransactionAbortException &e) {
+    throw ExecutionException("Insert Executor Get Row Lock Failed");
+  }
+}
+
+void InsertExecutor::LockIndexGaps(const Tuple &tuple) {
+  auto *txn = exec_ctx_->GetTransaction();
+  for (auto *index : table_indexes_) {
+    auto *tree = dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index->index_.get());
+    if (tree == nullptr) {
+      continue;
+    }
+    auto key = tuple.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
+    try {
+      bool is_locked = exec_ctx_->GetLockManager()->LockNextKey(
+          txn, LockManager::LockMode::INTENTION_EXCLUSIVE, index->index_oid_,
+          [tree, &key] { return NextIntegerKeyValue(tree, key, LockManager::KEY_SUPREMUM); });
+      if (!is_locked) {
+        throw ExecutionException("Insert Executor Get Key Lock Failed");
+      }
+    } catch (const TransactionAbortException &e) {
+      throw ExecutionException("Insert Executor Get Key Lock Failed");
+    }
+  }
+}
     // auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {   
     //     if(is_success){     
     //         return false;  
@@ -73,32 +110,35 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   //ÿȥӵnextÿηһtupleridֻҪfalseһֱ
   //whileѭ֮˵ҪֵˣʱҪظһ
   while (child_executor_->Next(&to_insert_tuple, &emit_rid)) {
+    // The new keys must not show up in a range another transaction scanned, see KEY LOCKS in lock_manager.h.
+    if (!LockManager::IsRowLockCovered(exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE,
+                                       table_info_->oid_)) {
+      LockIndexGaps(to_insert_tuple);
+    }
     //Ȱtuple뵽
     //ڲInsertTuple棬ridһ£Ѿֵ治ȥrid治øֵ
-    bool inserted = table_info_->table_->InsertTuple(to_insert_tuple, rid, exec_ctx_->GetTransaction());
-    if (inserted) {
-      try {
-        // X
-        bool is_locked = exec_ctx_->GetLockManager()->LockRow(
-            exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE, table_info_->oid_, *rid);
-        if (!is_locked) {
-          throw ExecutionException("Insert Executor Get Row Lock Failed");
-        }
-      } catch (TransactionAbortException e) {
-        throw ExecutionException("Insert Executor Get Row Lock Failed");
-      }
-      //tupleҪ¡
-      // table_indexes_ еÿ IndexInfo 󣬽вصkeyInsertEntry()
-      //²Ԫtupleı == InsertEntry()
-      //ʱҪȫtupleϢҪתtupleϢ keytuple5УֻһУ
-      std::for_each(table_indexes_.begin(), table_indexes_.end(),
-                    [&to_insert_tuple, &rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index) {
-                      index->index_->InsertEntry(to_insert_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
-                                                                              index->index_->GetKeyAttrs()),
-                                                 *rid, exec_ctx->GetTransaction());
-                    });
-      insert_count++;
+    if (!table_info_->table_->InsertTuple(to_insert_tuple, rid, exec_ctx_->GetTransaction())) {
+      continue;
     }
+    // The row is locked before the next one is inserted, so nobody else reads or locks it while it is uncommitted.
+    // Its RID is only known once it is in the table, unlike the rows a delete or an update locks a batch at a time.
+    LockRow(*rid);
+
+    //tupleҪ¡
+    // table_indexes_ еÿ IndexInfo 󣬽вصkeyInsertEntry()
+    //²Ԫtupleı == InsertEntry()
+    //ʱҪȫtupleϢҪתtupleϢ keytuple5УֻһУ
+    // The key is kept in the index write set as it is, a rollback deletes it without building it again.
+    std::for_each(table_indexes_.begin(), table_indexes_.end(),
+                  [&to_insert_tuple, &rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index) {
+                    auto key = to_insert_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
+                                                            index->index_->GetKeyAttrs());
+                    index->index_->InsertEntry(key, *rid, exec_ctx->GetTransaction());
+                    exec_ctx->GetTransaction()->AppendIndexWriteRecord(
+                        IndexWriteRecord(*rid, table_info->oid_, WType::INSERT, Tuple{}, index->index_oid_,
+                                         exec_ctx->GetCatalog(), key));
+                  });
+    insert_count++;
 //to_insert_tuple.KeyFromTuple(table_info->schema_, index->key_schema_, index->index_->GetKeyAttrs())
 //ͬҪkey
 
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// instrumented_executor.cpp
+//
+// Identification: src/execution/instrumented_executor.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/instrumented_executor.h"
+
+#include <chrono>  // NOLINT
+
+#include "execution/executors/adaptive_join_executor.h"
+
+namespace bustub {
+
+namespace {
+
+/** Adds the time and pages of a call of an executor to its profile when it goes out of scope */
+class ScopedMeasure {
+ public:
+  ScopedMeasure(uint64_t *ns, BufferPoolStats *pages)
+      : ns_(ns),
+        pages_(pages),
+        start_(std::chrono::steady_clock::now()),
+        start_pages_(BufferPoolManager::ThreadStats()) {}
+
+  ~ScopedMeasure() {
+    const auto &now = BufferPoolManager::ThreadStats();
+    pages_->fetched_ += now.fetched_ - start_pages_.fetched_;
+    pages_->missed_ += now.missed_ - start_pages_.missed_;
+    pages_->flushed_ += now.flushed_ - start_pages_.flushed_;
+    *ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+  }
+
+  DISALLOW_COPY_AND_MOVE(ScopedMeasure);
+
+ private:
+  uint64_t *ns_;
+  BufferPoolStats *pages_;
+  std::chrono::steady_clock::time_point start_;
+  BufferPoolStats start_pages_;
+};
+
+}  // namespace
+
+InstrumentedExecutor::InstrumentedExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                                           std::unique_ptr<AbstractExecutor> &&child)
+    : AbstractExecutor(exec_ctx), child_(std::move(child)), profile_(exec_ctx->GetProfile()->GetOperator(plan)) {}
+
+void InstrumentedExecutor::Init() {
+  {
+    ScopedMeasure measure(&profile_->init_ns_, &profile_->pages_);
+    child_->Init();
+  }
+  profile_->loops_++;
+  if (const auto *adaptive_join = dynamic_cast<const AdaptiveJoinExecutor *>(child_.get()); adaptive_join != nullptr) {
+    profile_->notes_ = adaptive_join->GetDecisions();
+  }
+}
+
+auto InstrumentedExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  ScopedMeasure measure(&profile_->next_ns_, &profile_->pages_);
+  if (!child_->Next(tuple, rid)) {
+    return false;
+  }
+  profile_->rows_++;
+  return true;
+}
+
+}  // namespace bustub
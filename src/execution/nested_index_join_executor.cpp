@@ -34,10 +34,13 @@ NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const Ne
   table_info_ = exec_ctx->GetCatalog()->GetTable(plan_->GetInnerTableOid());
 }
 
-void NestIndexJoinExecutor::Init() { child_executor_->Init(); }
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  matches_.clear();
+  next_match_ = 0;
+}
 
 auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  Tuple left_tuple;
   RID left_rid;
   /*
    * 1. ȴchildҲNextȡһtupleA
@@ -47,44 +50,44 @@ auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
    /*ɨȻֱӲ*/
    //˼·ͨɨÿtupleȡؼеֵvalueұвǷͬkeyֵ
    //ҵˣұлȡӦtupletupleұtupleϲһµtuple
-  while (child_executor_->Next(&left_tuple, &left_rid)) {//tuple
+  // A key can match many inner tuples, which are emitted one per call before the next outer tuple is read.
+  while (true) {
+    while (next_match_ < matches_.size()) {
+      Tuple right_tuple;
+      if (table_info_->table_->GetTuple(matches_[next_match_++], &right_tuple, exec_ctx_->GetTransaction())) {
+        std::vector<Value> tuple_values;
+        for (uint32_t i = 0; i < child_executor_->GetOutputSchema().GetColumnCount(); i++) {
+          tuple_values.push_back(left_tuple_.GetValue(&child_executor_->GetOutputSchema(), i));
+        }
+        for (uint32_t i = 0; i < table_info_->schema_.GetColumnCount(); i++) {
+          tuple_values.push_back(right_tuple.GetValue(&table_info_->schema_, i));
+        }
+        *tuple = {tuple_values, &plan_->OutputSchema()};
+        return true;
+      }
+    }
+    if (!child_executor_->Next(&left_tuple_, &left_rid)) {
+      return false;
+    }
     /*left_tupleӦschema*/
     auto key_schema = index_info_->index_->GetKeySchema();// key schema
     // tupleschemakeyӦֵ
-    auto value = plan_->KeyPredicate()->Evaluate(&left_tuple, child_executor_->GetOutputSchema());
+    auto value = plan_->KeyPredicate()->Evaluate(&left_tuple_, child_executor_->GetOutputSchema());
     std::vector<Value> values;
     values.push_back(value);
     Tuple key(values, key_schema);//keyֵװһtuple
-    std::vector<RID> results;
+    matches_.clear();
+    next_match_ = 0;
     //ʹҷkeyұtuplerid
-    index_info_->index_->ScanKey(key, &results, exec_ctx_->GetTransaction());
+    index_info_->index_->ScanKey(key, &matches_, exec_ctx_->GetTransaction());
     //ȥвûkeyӦtupleBresult¼rid
-    /*ƥΪkeyBظƥ䣬϶ƥһξͽinner*/
-    
-    if (!results.empty()) {// ҵұtuple
-      for (auto rid_b : results) { // ÿұtuplerid
-        Tuple right_tuple; 
-        // ÿв鵽rid_bͨcatalogöӦtupleұtupleBright_tuple
-        if (table_info_->table_->GetTuple(rid_b, &right_tuple, exec_ctx_->GetTransaction())) {
-          std::vector<Value> tuple_values;
-          for (uint32_t i = 0; i < child_executor_->GetOutputSchema().GetColumnCount(); i++) {
-            tuple_values.push_back(left_tuple.GetValue(&child_executor_->GetOutputSchema(), i));
-          }
-          for (uint32_t i = 0; i < table_info_->schema_.GetColumnCount(); i++) {
-            tuple_values.push_back(right_tuple.GetValue(&table_info_->schema_, i));
-          }
-          *tuple = {tuple_values, &plan_->OutputSchema()};//صtupletuple+ұtuple ӵ
-          return true;
-        }
-      }
-    }
     /*ұûԪʱleft joinҪnull
      * inner joinûκƥ䣬ùܣֱӺ
      * */
-    if (is_left_) {
+    if (matches_.empty() && is_left_) {
       std::vector<Value> tuple_values;
       for (uint32_t i = 0; i < child_executor_->GetOutputSchema().GetColumnCount(); i++) {
-        tuple_values.push_back(left_tuple.GetValue(&child_executor_->GetOutputSchema(), i));
+        tuple_values.push_back(left_tuple_.GetValue(&child_executor_->GetOutputSchema(), i));
       }
       for (uint32_t i = 0; i < table_info_->schema_.GetColumnCount(); i++) {
         tuple_values.push_back(ValueFactory::GetNullValueByType(table_info_->schema_.GetColumn(i).GetType()));
@@ -93,7 +96,6 @@ auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
       return true;
     }
   }
-  return false;
 }
 
 }  // namespace bustub
@@ -11,18 +11,10 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/nested_loop_join_executor.h"
 #include "binder/table_ref/bound_join_ref.h"
+#include "common/config.h"
 #include "common/exception.h"
 #include "type/value_factory.h"
 
-//ûɽģ͵next()
-//ÿtupleֻܵһΣֱѭôڲѭֻᴦѭеĵһݣݽᱻ
-//ǿԿȰڲtuplesȫ浽ڴУֻҪÿεtuplesȡһtuple
-
-//ܴtupleû꣬ڶtupleˡ
-//leftӽڵÿεNext()ȡһtuple֮ǰȰһtupleȡݱꡣ
-
-//left joinright joinһģǰƴ
-//leftjoinұûκƥϣҪNULL
 namespace bustub {
 
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const NestedLoopJoinPlanNode *plan,
@@ -30,167 +22,118 @@ NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const
                                                std::unique_ptr<AbstractExecutor> &&right_executor)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
+      join_type_(plan->GetJoinType()),
       left_executor_(std::move(left_executor)),
       right_executor_(std::move(right_executor)),
       left_schema_(left_executor_->GetOutputSchema()),
       right_schema_(right_executor_->GetOutputSchema()) {
-  if (plan->GetJoinType() != JoinType::LEFT && plan->GetJoinType() != JoinType::INNER) {
-    // Note for 2022 Fall: You ONLY need to implement left join and inner join.
-    throw bustub::NotImplementedException(fmt::format("join type {} not supported", plan->GetJoinType()));
+  if (join_type_ != JoinType::LEFT && join_type_ != JoinType::INNER && join_type_ != JoinType::SEMI &&
+      join_type_ != JoinType::ANTI && join_type_ != JoinType::NULL_AWARE_ANTI) {
+    throw bustub::NotImplementedException(fmt::format("join type {} not supported", join_type_));
+  }
+  predicate_ = std::make_unique<CompiledExpression>(&plan_->Predicate(), left_schema_, right_schema_);
+  if (join_type_ == JoinType::LEFT) {
+    std::vector<Value> values;
+    values.reserve(right_schema_.GetColumnCount());
+    for (const auto &column : right_schema_.GetColumns()) {
+      values.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+    }
+    null_right_tuple_ = Tuple{values, &right_schema_};
   }
-  is_ineer_ = (plan_->GetJoinType() == JoinType::INNER);
 }
 
 void NestedLoopJoinExecutor::Init() {
-  Tuple tuple;
-  RID rid;
   left_executor_->Init();
+  LoadBlock();
   right_executor_->Init();
-  /*Ȱұߵtuple*/
-  //Ƚұtuple浽ڴУԱѭӲʹ
-  while (right_executor_->Next(&tuple, &rid)) {//ڲѭұߣtuplesȫ浽ڴ
-    right_tuples_.push_back(tuple);
-    //ұԪ鶼ᱻڴright_tuples_УԱںǶѭӲʹ
-    //ǶѭӲӹֱӷұĻԪ飬
-    //ҪÿӲ·ұִȡԪݡӲЧʡ
-  }
 }
 
-auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  // ȡУӵ
-  std::vector<Column> columns(left_schema_.GetColumns());
-  /* ܵˮƽƴ */
-  for (const auto &column : right_schema_.GetColumns()) {
-    columns.push_back(column);
-  }
-  // µSchemaڱʾԵˮƽƴ
-  Schema schema(columns);
-  if (is_ineer_) {
-     //ӣInnerJoin
-    return InnerJoin(schema, tuple);
+void NestedLoopJoinExecutor::LoadBlock() {
+  block_.clear();
+  matched_.clear();
+  block_idx_ = 0;
+  unmatched_idx_ = 0;
+  has_right_tuple_ = false;
+
+  // Always take at least one tuple so that a single huge tuple still makes progress.
+  size_t block_size = 0;
+  size_t budget = nested_loop_join_block_size;
+  Tuple tuple;
+  RID rid;
+  while ((block_.empty() || block_size < budget) && left_executor_->Next(&tuple, &rid)) {
+    block_size += sizeof(Tuple) + tuple.GetLength();
+    block_.push_back(tuple);
   }
-   // 򣬵LeftJoin
-  return LeftJoin(schema, tuple);
+  matched_.resize(block_.size(), false);
+  unmatched_count_ = block_.size();
 }
 
-auto NestedLoopJoinExecutor::InnerJoin(const Schema &schema, Tuple *tuple) -> bool {
-  // ѾұԪĴСʾеӲɣfalse
-  if (index_ > right_tuples_.size()) {
-    return false;
-  }
-  if (index_ != 0) {
-    //ұ߻ûб꣬ѭұ߻ÿһ tupleƥµ tuple  true
-    // indexʼұԪ
-    for (uint32_t j = index_; j < right_tuples_.size(); j++) {
-      index_ = (index_ + 1) % right_tuples_.size();
-      // ʹνжұϢǷƥ
-      if (plan_->Predicate().EvaluateJoin(&left_tuple_, left_schema_, &right_tuples_[j], right_schema_).GetAs<bool>()) {
-        // ƥ䣬ϲԪ鲢
-        std::vector<Value> value;
-        for (uint32_t i = 0; i < left_schema_.GetColumnCount(); i++) {
-          value.push_back(left_tuple_.GetValue(&left_schema_, i));
-        }
-        for (uint32_t i = 0; i < right_schema_.GetColumnCount(); i++) {
-          value.push_back(right_tuples_[j].GetValue(&right_schema_, i));
-        }
-        *tuple = {value, &schema};
-        return true;
-      }
-    }
-  }
-  //ұ߻Ѿ߻Ϊգ
-  //ӽڵÿһ tupleұߵһ tuple ƥ䣬µ tuple  true
-  if (index_ == 0) {
-    // Ԫұеȫݽƥ
-    //leftӽڵÿεNext()ȡһtuple֮ǰȰһtupleȡݱꡣ
-    while (left_executor_->Next(&left_tuple_, &left_rid_)) {
-      for (const auto &right_tuple : right_tuples_) {
-        // ұеÿԪ
-        index_ = (index_ + 1) % right_tuples_.size();
-        // ʹνжұϢǷƥ
-        if (plan_->Predicate().EvaluateJoin(&left_tuple_, left_schema_, &right_tuple, right_schema_).GetAs<bool>()) {
-          // ƥ䣬ϲԪ鲢
-          std::vector<Value> value;
-          for (uint32_t i = 0; i < left_schema_.GetColumnCount(); i++) {
-            value.push_back(left_tuple_.GetValue(&left_schema_, i));
-          }
-          for (uint32_t i = 0; i < right_schema_.GetColumnCount(); i++) {
-            value.push_back(right_tuple.GetValue(&right_schema_, i));
+auto NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  bool is_semi_or_anti =
+      join_type_ == JoinType::SEMI || join_type_ == JoinType::ANTI || join_type_ == JoinType::NULL_AWARE_ANTI;
+  while (!block_.empty()) {
+    if (!has_right_tuple_) {
+      RID right_rid;
+      // A semi or anti join has nothing left to learn about a block once all of its tuples matched.
+      bool is_done = is_semi_or_anti && unmatched_count_ == 0;
+      if (!is_done && right_executor_->Next(&right_tuple_, &right_rid)) {
+        has_right_tuple_ = true;
+        block_idx_ = 0;
+      } else {
+        // The inner side is exhausted for this block: return the left tuples that never matched, then move on.
+        if (join_type_ != JoinType::INNER && join_type_ != JoinType::SEMI) {
+          while (unmatched_idx_ < block_.size()) {
+            size_t idx = unmatched_idx_++;
+            if (matched_[idx]) {
+              continue;
+            }
+            if (join_type_ == JoinType::LEFT) {
+              *tuple = Tuple{block_[idx], &left_schema_, null_right_tuple_, &right_schema_};
+            } else {
+              *tuple = block_[idx];
+            }
+            return true;
           }
-          /*ע⣺forѭڲغϲԪϢûбұԪ
-          //forѭright_tuple10ֻϲһͷˣʱʣµľҪ´ν뺯ʱȷ*/
-          *tuple = {value, &schema};
-          return true;
         }
+        LoadBlock();
+        if (block_.empty()) {
+          return false;
+        }
+        right_executor_->Init();
+        continue;
       }
     }
-    //ԪѾ꣬һЧֵ
-    index_ = right_tuples_.size() + 1;
-  }
-  return false;
-}
 
-auto NestedLoopJoinExecutor::LeftJoin(const Schema &schema, Tuple *tuple) -> bool {
-  if (index_ > right_tuples_.size()) {
-    return false;
-  }
-  if (index_ != 0) {
-    for (uint32_t j = index_; j < right_tuples_.size(); j++) {
-      index_ = (index_ + 1) % right_tuples_.size();
-      if (plan_->Predicate().EvaluateJoin(&left_tuple_, left_schema_, &right_tuples_[j], right_schema_).GetAs<bool>()) {
-        std::vector<Value> value;
-        for (uint32_t i = 0; i < left_schema_.GetColumnCount(); i++) {
-          value.push_back(left_tuple_.GetValue(&left_schema_, i));
-        }
-        for (uint32_t i = 0; i < right_schema_.GetColumnCount(); i++) {
-          value.push_back(right_tuples_[j].GetValue(&right_schema_, i));
-        }
-        is_match_ = true;
-        *tuple = {value, &schema};
-        return true;
+    while (block_idx_ < block_.size()) {
+      size_t idx = block_idx_++;
+      if (is_semi_or_anti && matched_[idx]) {
+        continue;
       }
-    }
-  }
-  if (index_ == 0) {
-    //ӽڵÿһtuple
-    while (left_executor_->Next(&left_tuple_, &left_rid_)) {//next()ÿλһtuple
-      is_match_ = false;
-      //ѭұ߻ÿһtuple
-      for (const auto &right_tuple : right_tuples_) {
-        index_ = (index_ + 1) % right_tuples_.size();
-        //if(ƥ)
-        if (plan_->Predicate().EvaluateJoin(&left_tuple_, left_schema_, &right_tuple, right_schema_).GetAs<bool>()) {
-          std::vector<Value> value;
-          for (uint32_t i = 0; i < left_schema_.GetColumnCount(); i++) {
-            value.push_back(left_tuple_.GetValue(&left_schema_, i));
-          }
-          for (uint32_t i = 0; i < right_schema_.GetColumnCount(); i++) {
-            value.push_back(right_tuple.GetValue(&right_schema_, i));
-          }
-          is_match_ = true;
-          *tuple = {value, &schema};
-          return true;//ֻƥһ
-        }
+      bool is_match;
+      if (join_type_ == JoinType::NULL_AWARE_ANTI) {
+        // `x NOT IN (...)` is not true, and drops the tuple, when `x = y` is NULL for some y.
+        auto value = predicate_->EvaluateJoin(&block_[idx], &right_tuple_);
+        is_match = value.IsNull() || value.GetAs<bool>();
+      } else {
+        is_match = predicate_->EvaluateJoinPredicate(&block_[idx], &right_tuple_);
       }
-      /*ұΪպûκƥ*/
-      /*ӽڵtupleұûκһƥ䣬Ҫһtuplejoin*/
-      if (!is_match_) {
-        std::vector<Value> value;
-
-        for (uint32_t i = 0; i < left_schema_.GetColumnCount(); i++) {
-          value.push_back(left_tuple_.GetValue(&left_schema_, i));
-        }
-        /*ұȫֵ*/
-        for (uint32_t i = 0; i < right_schema_.GetColumnCount(); i++) {
-          value.push_back(ValueFactory::GetNullValueByType(right_schema_.GetColumn(i).GetType()));
-        }
-        *tuple = {value, &schema};
-        is_match_ = true;
+      if (!is_match) {
+        continue;
+      }
+      if (!matched_[idx]) {
+        matched_[idx] = true;
+        unmatched_count_--;
+      }
+      if (join_type_ == JoinType::SEMI) {
+        *tuple = block_[idx];
+        return true;
+      }
+      if (join_type_ == JoinType::INNER || join_type_ == JoinType::LEFT) {
+        *tuple = Tuple{block_[idx], &left_schema_, right_tuple_, &right_schema_};
         return true;
       }
     }
-    /*ӽڵtuple֮󣬲ٽ߼ֱںڴfalse*/
-    index_ = right_tuples_.size() + 1;
+    has_right_tuple_ = false;
   }
   return false;
 }
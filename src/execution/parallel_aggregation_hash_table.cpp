@@ -0,0 +1,528 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_aggregation_hash_table.cpp
+//
+// Identification: src/execution/parallel_aggregation_hash_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/parallel_aggregation_hash_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "common/macros.h"
+#include "execution/batch_worker_pool.h"
+#include "murmur3/MurmurHash3.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t NUM_PARTITIONS = 1 << AGGREGATION_RADIX_BITS;
+
+/**
+ * A partition record is laid out as
+ * | hash (8) | key_len (4) | key (key_len) | nulls (8) | vals (8 * num_aggs) |
+ * and a spill page as
+ * | used bytes (4) | record | record | ... |
+ */
+constexpr size_t RECORD_HEADER_SIZE = sizeof(hash_t) + sizeof(uint32_t);
+constexpr size_t SPILL_PAGE_HEADER_SIZE = sizeof(uint32_t);
+
+auto HashKey(const char *data, size_t len) -> hash_t {
+  uint64_t hash[2];
+  murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(data), static_cast<int>(len), 0,
+                               reinterpret_cast<void *>(&hash));
+  return hash[0];
+}
+
+/** Radix partitioning uses the high bits so that it is independent of the pre-aggregation slot (low bits). */
+auto PartitionOf(hash_t hash) -> size_t { return hash >> (sizeof(hash_t) * 8 - AGGREGATION_RADIX_BITS); }
+
+auto RecordSize(const char *record, uint32_t num_aggs) -> size_t {
+  uint32_t key_len;
+  memcpy(&key_len, record + sizeof(hash_t), sizeof(uint32_t));
+  return RECORD_HEADER_SIZE + key_len + sizeof(uint64_t) + sizeof(int64_t) * num_aggs;
+}
+
+struct KeyHash {
+  auto operator()(const std::string &key) const -> std::size_t { return HashKey(key.data(), key.size()); }
+};
+
+}  // namespace
+
+struct ParallelAggregationHashTable::WorkerState {
+  explicit WorkerState(const ParallelAggregationHashTable *ht)
+      : ht_(ht),
+        slot_used_(AGGREGATION_PREAGG_SLOTS, false),
+        slot_hash_(AGGREGATION_PREAGG_SLOTS),
+        slot_key_(AGGREGATION_PREAGG_SLOTS),
+        slot_vals_(static_cast<size_t>(AGGREGATION_PREAGG_SLOTS) * ht->num_aggs_),
+        slot_nulls_(AGGREGATION_PREAGG_SLOTS),
+        buffers_(NUM_PARTITIONS),
+        spilled_pages_(NUM_PARTITIONS),
+        input_(ht->num_aggs_) {}
+
+  /** Pre-aggregate one tuple into the fixed-size table, evicting the previous occupant of the slot on a conflict. */
+  void Process(const Tuple &tuple) {
+    ht_->MakeKey(tuple, &key_);
+    uint64_t input_nulls = ht_->MakeInput(tuple, input_.data());
+    hash_t hash = HashKey(key_.data(), key_.size());
+    size_t slot = hash & (AGGREGATION_PREAGG_SLOTS - 1);
+    int64_t *vals = &slot_vals_[slot * ht_->num_aggs_];
+    if (!slot_used_[slot] || slot_hash_[slot] != hash || slot_key_[slot] != key_) {
+      if (slot_used_[slot]) {
+        Evict(slot);
+      }
+      slot_used_[slot] = true;
+      slot_hash_[slot] = hash;
+      slot_key_[slot] = key_;
+      ht_->InitState(vals, &slot_nulls_[slot]);
+    }
+    ht_->CombineState(vals, &slot_nulls_[slot], input_.data(), input_nulls);
+  }
+
+  /** Move every group left in the pre-aggregation table into its partition. */
+  void Flush() {
+    for (size_t slot = 0; slot < slot_used_.size(); slot++) {
+      if (slot_used_[slot]) {
+        Evict(slot);
+        slot_used_[slot] = false;
+      }
+    }
+  }
+
+  void Evict(size_t slot) {
+    const auto &key = slot_key_[slot];
+    auto &buffer = buffers_[PartitionOf(slot_hash_[slot])];
+    auto key_len = static_cast<uint32_t>(key.size());
+    size_t offset = buffer.size();
+    size_t record_size = RECORD_HEADER_SIZE + key_len + sizeof(uint64_t) + sizeof(int64_t) * ht_->num_aggs_;
+    buffer.resize(offset + record_size);
+    char *record = buffer.data() + offset;
+    memcpy(record, &slot_hash_[slot], sizeof(hash_t));
+    memcpy(record + sizeof(hash_t), &key_len, sizeof(uint32_t));
+    memcpy(record + RECORD_HEADER_SIZE, key.data(), key_len);
+    memcpy(record + RECORD_HEADER_SIZE + key_len, &slot_nulls_[slot], sizeof(uint64_t));
+    memcpy(record + RECORD_HEADER_SIZE + key_len + sizeof(uint64_t), &slot_vals_[slot * ht_->num_aggs_],
+           sizeof(int64_t) * ht_->num_aggs_);
+    buffered_bytes_ += record_size;
+    if (buffered_bytes_ > aggregation_spill_threshold.load() && !spill_failed_) {
+      Spill();
+    }
+  }
+
+  /** Write the in-memory partition buffers out to temporary pages. Records that do not fit stay in memory. */
+  void Spill() {
+    if (ht_->bpm_ == nullptr) {
+      return;
+    }
+    buffered_bytes_ = 0;
+    for (size_t partition = 0; partition < NUM_PARTITIONS; partition++) {
+      auto &buffer = buffers_[partition];
+      if (spill_failed_) {
+        buffered_bytes_ += buffer.size();
+        continue;
+      }
+      std::vector<char> residual;
+      Page *page = nullptr;
+      page_id_t page_id = INVALID_PAGE_ID;
+      uint32_t used = 0;
+      size_t offset = 0;
+      while (offset < buffer.size()) {
+        const char *record = buffer.data() + offset;
+        size_t record_size = RecordSize(record, ht_->num_aggs_);
+        if (record_size > BUSTUB_PAGE_SIZE - SPILL_PAGE_HEADER_SIZE) {
+          residual.insert(residual.end(), record, record + record_size);
+          offset += record_size;
+          continue;
+        }
+        if (page == nullptr || used + record_size > BUSTUB_PAGE_SIZE) {
+          if (page != nullptr) {
+            memcpy(page->GetData(), &used, sizeof(uint32_t));
+            ht_->bpm_->UnpinPage(page_id, true);
+          }
+          page = ht_->bpm_->NewPage(&page_id);
+          if (page == nullptr) {
+            // The buffer pool is full of pinned pages; keep the rest of this worker's state in memory.
+            spill_failed_ = true;
+            break;
+          }
+          spilled_pages_[partition].push_back(page_id);
+          used = SPILL_PAGE_HEADER_SIZE;
+        }
+        memcpy(page->GetData() + used, record, record_size);
+        used += record_size;
+        offset += record_size;
+      }
+      if (page != nullptr) {
+        memcpy(page->GetData(), &used, sizeof(uint32_t));
+        ht_->bpm_->UnpinPage(page_id, true);
+      }
+      // Whatever could not be spilled (no free frame, oversized record) is kept in memory.
+      residual.insert(residual.end(), buffer.begin() + offset, buffer.end());
+      buffered_bytes_ += residual.size();
+      buffer = std::move(residual);
+    }
+  }
+
+  /** Free the spilled pages that have not been merged yet. */
+  void DropSpilledPages() {
+    for (auto &pages : spilled_pages_) {
+      for (auto page_id : pages) {
+        ht_->bpm_->DeletePage(page_id);
+      }
+      pages.clear();
+    }
+  }
+
+  auto SpilledPageCount() const -> size_t {
+    size_t count = 0;
+    for (const auto &pages : spilled_pages_) {
+      count += pages.size();
+    }
+    return count;
+  }
+
+  const ParallelAggregationHashTable *ht_;
+
+  /** The fixed-size pre-aggregation table */
+  std::vector<bool> slot_used_;
+  std::vector<hash_t> slot_hash_;
+  std::vector<std::string> slot_key_;
+  std::vector<int64_t> slot_vals_;
+  std::vector<uint64_t> slot_nulls_;
+
+  /** In-memory partition records and the pages spilled for each partition */
+  std::vector<std::vector<char>> buffers_;
+  std::vector<std::vector<page_id_t>> spilled_pages_;
+  size_t buffered_bytes_{0};
+  bool spill_failed_{false};
+
+  /** Scratch space reused for every input tuple */
+  std::string key_;
+  std::vector<int64_t> input_;
+};
+
+ParallelAggregationHashTable::ParallelAggregationHashTable(const AggregationPlanNode *plan, const Schema *child_schema,
+                                                           BufferPoolManager *bpm)
+    : plan_(plan), child_schema_(child_schema), bpm_(bpm), num_aggs_(plan->GetAggregates().size()) {
+  for (const auto &expr : plan_->GetGroupBys()) {
+    key_types_.push_back(expr->GetReturnType());
+  }
+  for (uint32_t i = 0; i < num_aggs_; i++) {
+    switch (plan_->GetAggregateTypes()[i]) {
+      case AggregationType::CountStarAggregate:
+        count_star_idx_.push_back(i);
+        break;
+      case AggregationType::CountAggregate:
+        count_idx_.push_back(i);
+        break;
+      case AggregationType::SumAggregate:
+        sum_idx_.push_back(i);
+        initial_nulls_ |= 1ULL << i;
+        break;
+      case AggregationType::MinAggregate:
+        min_idx_.push_back(i);
+        initial_nulls_ |= 1ULL << i;
+        break;
+      case AggregationType::MaxAggregate:
+        max_idx_.push_back(i);
+        initial_nulls_ |= 1ULL << i;
+        break;
+      case AggregationType::CountDistinctAggregate:
+      case AggregationType::SumDistinctAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        UNREACHABLE("distinct aggregates are rejected by IsSupported()");
+    }
+  }
+}
+
+ParallelAggregationHashTable::~ParallelAggregationHashTable() { Reset(); }
+
+auto ParallelAggregationHashTable::IsSupported(const AggregationPlanNode *plan) -> bool {
+  if (plan->GetAggregates().size() > sizeof(uint64_t) * 8) {
+    return false;
+  }
+  for (const auto &expr : plan->GetGroupBys()) {
+    if (expr->GetReturnType() == TypeId::INVALID) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < plan->GetAggregates().size(); i++) {
+    auto agg_type = plan->GetAggregateTypes()[i];
+    if (agg_type == AggregationType::CountDistinctAggregate || agg_type == AggregationType::SumDistinctAggregate ||
+        agg_type == AggregationType::ApproxCountDistinctAggregate) {
+      // Distinct values are not flat state, they are counted by the simple hash table.
+      return false;
+    }
+    if (agg_type != AggregationType::CountStarAggregate && agg_type != AggregationType::CountAggregate &&
+        plan->GetAggregateAt(i)->GetReturnType() != TypeId::INTEGER) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParallelAggregationHashTable::MakeKey(const Tuple &tuple, std::string *key) const {
+  key->clear();
+  const auto &group_bys = plan_->GetGroupBys();
+  for (size_t i = 0; i < group_bys.size(); i++) {
+    Value val = group_bys[i]->Evaluate(&tuple, *child_schema_);
+    if (val.IsNull()) {
+      key->push_back(1);
+      continue;
+    }
+    key->push_back(0);
+    size_t offset = key->size();
+    if (key_types_[i] == TypeId::VARCHAR) {
+      uint32_t len = val.GetLength();
+      key->resize(offset + sizeof(uint32_t) + len);
+      val.SerializeTo(key->data() + offset);
+    } else {
+      key->resize(offset + Type::GetTypeSize(key_types_[i]));
+      val.SerializeTo(key->data() + offset);
+    }
+  }
+}
+
+auto ParallelAggregationHashTable::MakeInput(const Tuple &tuple, int64_t *vals) const -> uint64_t {
+  uint64_t nulls = 0;
+  const auto &aggregates = plan_->GetAggregates();
+  for (auto i : count_star_idx_) {
+    vals[i] = 1;
+  }
+  for (auto i : count_idx_) {
+    vals[i] = aggregates[i]->Evaluate(&tuple, *child_schema_).IsNull() ? 0 : 1;
+  }
+  for (const auto *idx : {&sum_idx_, &min_idx_, &max_idx_}) {
+    for (auto i : *idx) {
+      Value val = aggregates[i]->Evaluate(&tuple, *child_schema_);
+      if (val.IsNull()) {
+        nulls |= 1ULL << i;
+      } else {
+        vals[i] = val.GetAs<int32_t>();
+      }
+    }
+  }
+  return nulls;
+}
+
+void ParallelAggregationHashTable::InitState(int64_t *vals, uint64_t *nulls) const {
+  std::fill(vals, vals + num_aggs_, 0);
+  *nulls = initial_nulls_;
+}
+
+void ParallelAggregationHashTable::CombineState(int64_t *vals, uint64_t *nulls, const int64_t *other,
+                                                uint64_t other_nulls) const {
+  for (auto i : count_star_idx_) {
+    vals[i] += other[i];
+  }
+  for (auto i : count_idx_) {
+    vals[i] += other[i];
+  }
+  // SUM / MIN / MAX take the other value as-is if this side is still NULL, and ignore a NULL other side.
+  for (auto i : sum_idx_) {
+    if ((other_nulls >> i & 1) == 0) {
+      vals[i] = (*nulls >> i & 1) != 0 ? other[i] : vals[i] + other[i];
+      *nulls &= ~(1ULL << i);
+    }
+  }
+  for (auto i : min_idx_) {
+    if ((other_nulls >> i & 1) == 0) {
+      vals[i] = (*nulls >> i & 1) != 0 ? other[i] : std::min(vals[i], other[i]);
+      *nulls &= ~(1ULL << i);
+    }
+  }
+  for (auto i : max_idx_) {
+    if ((other_nulls >> i & 1) == 0) {
+      vals[i] = (*nulls >> i & 1) != 0 ? other[i] : std::max(vals[i], other[i]);
+      *nulls &= ~(1ULL << i);
+    }
+  }
+}
+
+void ParallelAggregationHashTable::Build(AbstractExecutor *child) {
+  Reset();
+
+  auto batch = BatchWorkerPool::ReadBatch(child, AGGREGATION_BATCH_SIZE);
+  size_t num_workers = std::max<size_t>(1, aggregation_parallelism.load());
+  if (batch.size() < AGGREGATION_BATCH_SIZE || num_workers == 1) {
+    // Small inputs (and single-threaded configurations) are aggregated on the calling thread.
+    workers_.emplace_back(std::make_unique<WorkerState>(this));
+    auto &worker = *workers_.back();
+    while (!batch.empty()) {
+      for (const auto &tuple : batch) {
+        worker.Process(tuple);
+      }
+      batch = BatchWorkerPool::ReadBatch(child, AGGREGATION_BATCH_SIZE);
+    }
+    worker.Flush();
+    spilled_page_count_ = worker.SpilledPageCount();
+    return;
+  }
+
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.emplace_back(std::make_unique<WorkerState>(this));
+  }
+  BatchWorkerPool pool(num_workers, AGGREGATION_BATCH_SIZE);
+  try {
+    pool.Run(
+        child, std::move(batch),
+        [this](size_t worker, const std::vector<Tuple> &tuples) {
+          for (const auto &tuple : tuples) {
+            workers_[worker]->Process(tuple);
+          }
+        },
+        [this](size_t worker) { workers_[worker]->Flush(); });
+  } catch (...) {
+    Reset();
+    throw;
+  }
+  for (const auto &worker : workers_) {
+    spilled_page_count_ += worker->SpilledPageCount();
+  }
+}
+
+void ParallelAggregationHashTable::MergePartition(size_t partition, const Schema *output_schema,
+                                                  std::vector<Tuple> *result) const {
+  std::unordered_map<std::string, size_t, KeyHash> groups;
+  std::vector<int64_t> vals;
+  std::vector<uint64_t> nulls;
+
+  auto consume = [&](const char *record) -> size_t {
+    uint32_t key_len;
+    memcpy(&key_len, record + sizeof(hash_t), sizeof(uint32_t));
+    const char *state = record + RECORD_HEADER_SIZE + key_len;
+    uint64_t other_nulls;
+    memcpy(&other_nulls, state, sizeof(uint64_t));
+    const auto *other = reinterpret_cast<const int64_t *>(state + sizeof(uint64_t));
+    auto [it, inserted] = groups.try_emplace(std::string(record + RECORD_HEADER_SIZE, key_len), nulls.size());
+    if (inserted) {
+      vals.insert(vals.end(), other, other + num_aggs_);
+      nulls.push_back(other_nulls);
+    } else {
+      CombineState(&vals[it->second * num_aggs_], &nulls[it->second], other, other_nulls);
+    }
+    return RECORD_HEADER_SIZE + key_len + sizeof(uint64_t) + sizeof(int64_t) * num_aggs_;
+  };
+
+  for (const auto &worker : workers_) {
+    for (auto page_id : worker->spilled_pages_[partition]) {
+      Page *page = bpm_->FetchPage(page_id);
+      if (page == nullptr) {
+        throw ExecutionException("aggregation failed to read back a spilled partition page");
+      }
+      uint32_t used;
+      memcpy(&used, page->GetData(), sizeof(uint32_t));
+      for (size_t offset = SPILL_PAGE_HEADER_SIZE; offset < used;) {
+        offset += consume(page->GetData() + offset);
+      }
+      bpm_->UnpinPage(page_id, false);
+    }
+    const auto &buffer = worker->buffers_[partition];
+    for (size_t offset = 0; offset < buffer.size();) {
+      offset += consume(buffer.data() + offset);
+    }
+  }
+
+  result->reserve(result->size() + groups.size());
+  std::vector<Value> values;
+  for (const auto &[key, group] : groups) {
+    values.clear();
+    const char *ptr = key.data();
+    for (auto type : key_types_) {
+      if (*ptr++ != 0) {
+        values.emplace_back(ValueFactory::GetNullValueByType(type));
+        continue;
+      }
+      values.emplace_back(Value::DeserializeFrom(ptr, type));
+      ptr += type == TypeId::VARCHAR ? sizeof(uint32_t) + values.back().GetLength() : Type::GetTypeSize(type);
+    }
+    for (uint32_t i = 0; i < num_aggs_; i++) {
+      if ((nulls[group] >> i & 1) != 0) {
+        values.emplace_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+      } else {
+        int64_t val = vals[group * num_aggs_ + i];
+        if (val < BUSTUB_INT32_MIN || val > BUSTUB_INT32_MAX) {
+          // The state is 64-bit wide, but the aggregation outputs INTEGER just like the simple hash table.
+          throw Exception(ExceptionType::OUT_OF_RANGE, "Numeric value out of range.");
+        }
+        values.emplace_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(val)));
+      }
+    }
+    result->emplace_back(values, output_schema);
+  }
+}
+
+auto ParallelAggregationHashTable::Merge(const Schema *output_schema, std::vector<Tuple> *result) -> size_t {
+  std::vector<std::vector<Tuple>> outputs(NUM_PARTITIONS);
+  size_t num_threads = workers_.size() > 1 ? std::min(aggregation_parallelism.load(), NUM_PARTITIONS) : 1;
+
+  if (num_threads <= 1) {
+    for (size_t partition = 0; partition < NUM_PARTITIONS; partition++) {
+      MergePartition(partition, output_schema, &outputs[partition]);
+    }
+  } else {
+    std::atomic<size_t> next_partition{0};
+    std::mutex latch;
+    std::exception_ptr error = nullptr;
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++) {
+      threads.emplace_back([&]() {
+        try {
+          size_t partition;
+          while ((partition = next_partition.fetch_add(1)) < NUM_PARTITIONS) {
+            MergePartition(partition, output_schema, &outputs[partition]);
+          }
+        } catch (...) {
+          std::scoped_lock<std::mutex> l(latch);
+          error = std::current_exception();
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    if (error != nullptr) {
+      Reset();
+      std::rethrow_exception(error);
+    }
+  }
+
+  size_t num_groups = 0;
+  for (const auto &output : outputs) {
+    num_groups += output.size();
+  }
+  result->reserve(result->size() + num_groups);
+  for (auto &output : outputs) {
+    std::move(output.begin(), output.end(), std::back_inserter(*result));
+  }
+  Reset();
+  return num_groups;
+}
+
+void ParallelAggregationHashTable::Reset() {
+  for (auto &worker : workers_) {
+    worker->DropSpilledPages();
+  }
+  workers_.clear();
+}
+
+}  // namespace bustub
@@ -10,6 +10,11 @@ ProjectionExecutor::ProjectionExecutor(ExecutorContext *exec_ctx, const Projecti
 void ProjectionExecutor::Init() {
   // Initialize the child executor
   child_executor_->Init();
+  expressions_.clear();
+  expressions_.reserve(plan_->GetExpressions().size());
+  for (const auto &expr : plan_->GetExpressions()) {
+    expressions_.emplace_back(expr.get(), child_executor_->GetOutputSchema());
+  }
 }
 
 auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
@@ -25,8 +30,8 @@ auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   // Compute expressions
   std::vector<Value> values{};
   values.reserve(GetOutputSchema().GetColumnCount());
-  for (const auto &expr : plan_->GetExpressions()) {
-    values.push_back(expr->Evaluate(&child_tuple, child_executor_->GetOutputSchema()));
+  for (const auto &expr : expressions_) {
+    values.push_back(expr.Evaluate(&child_tuple));
   }
 
   *tuple = Tuple{values, &GetOutputSchema()};
@@ -17,6 +17,9 @@
 //ύһεNextʱǰͷ
 //ظύ/ֹʱ Transaction Manager ͳһͷ
 #include "execution/executors/seq_scan_executor.h"
+
+#include "storage/page/table_page.h"
+
 namespace bustub {
 //һҪ֪ĵǰġһҪ
 //ִģƻڵ㣨ÿִһSQLתΪִܶнڵ㣩
@@ -30,57 +33,184 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
   this->table_info_ = this->exec_ctx_->GetCatalog()->GetTable(plan_->table_oid_);
 }
 void SeqScanExecutor::Init() {
+  auto *txn = exec_ctx_->GetTransaction();
+  // A snapshot read takes no locks at all, it never sees a change that was not committed before it began.
+  is_snapshot_ = txn->ReadsSnapshot();
+  // An optimistic transaction validates the whole table it scanned when it commits, a row inserted after its
+  // snapshot is a change to what it read as well.
+  if (txn->GetIsolationLevel() == IsolationLevel::OPTIMISTIC) {
+    txn->AddIntoReadTableSet(table_info_->table_.get());
+  }
   // IS  init()  ų˶δύֻԶύظб  ļ
-  if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
+  if (txn->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED && !is_snapshot_) {
     try {
-      bool is_locked = exec_ctx_->GetLockManager()->LockTable(
-          exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_SHARED, table_info_->oid_);
+      // A full scan locks every row anyway, so take one S lock on the table instead if no writer is in the way.
+      auto *lock_manager = exec_ctx_->GetLockManager();
+      table_oid_t oid = table_info_->oid_;
+      bool is_locked = (plan_->IsFullScan() && lock_manager->TryLockTable(txn, LockManager::LockMode::SHARED, oid)) ||
+                       lock_manager->LockTable(txn, LockManager::LockMode::INTENTION_SHARED, oid);
       if (!is_locked) {
         throw ExecutionException("SeqScan Executor Get Table Lock Failed");
       }
-    } catch (TransactionAbortException e) {
+    } catch (const TransactionAbortException &e) {
       throw ExecutionException("SeqScan Executor Get Table Lock Failed" + e.GetInfo());
     }
   }
-  this->table_iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());
+  // Release the page a previous run may still have pinned.
+  cursor_ = nullptr;
+  if (is_snapshot_) {
+    cursor_ = std::make_unique<TableCursor>(table_info_->table_.get(), txn);
+  } else if (enable_zero_copy_scan) {
+    cursor_ = std::make_unique<TableCursor>(table_info_->table_.get());
+  } else {
+    this->table_iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());
+  }
+  if (plan_->filter_predicate_ != nullptr) {
+    filter_predicate_ = std::make_unique<CompiledExpression>(plan_->filter_predicate_.get(), table_info_->schema_);
+  }
+  // A scan that locks rows reads a page ahead and locks its rows together, see NextPage(). Under an S or X table lock
+  // no other transaction can change the rows, and they are read straight away.
+  lock_rows_ = txn->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED && !is_snapshot_ &&
+               !LockManager::IsRowLockCovered(txn, LockManager::LockMode::SHARED, table_info_->oid_);
+  page_tuples_.clear();
+  page_cursor_ = 0;
+  has_lookahead_ = lock_rows_ && NextRid(&lookahead_);
 }
 
-auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  do {
-    if (table_iter_ == table_info_->table_->End()) {
-      //ύһεNextʱǰͷ(ͷͷű)
-      //ĩβһΪδύûмԲ뼶ֻǶύظ
-      //ظֻcommitʱͷҪֶȥƣֻʣ ύ
-      if (exec_ctx_->GetTransaction()->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
-        const auto locked_row_set = exec_ctx_->GetTransaction()->GetSharedRowLockSet()->at(table_info_->oid_);
-        table_oid_t oid = table_info_->oid_;
-        for (auto rid : locked_row_set) {
-          exec_ctx_->GetLockManager()->UnlockRow(exec_ctx_->GetTransaction(), oid, rid);
+auto SeqScanExecutor::NextTuple(Tuple *tuple) -> bool {
+  if (cursor_ != nullptr) {
+    // Evaluate the filter on the tuple in the page, only the tuple we return is copied out, and only the columns the
+    // plan needs if it names them.
+    Tuple view;
+    while (cursor_->Next(&view)) {
+      if (filter_predicate_ == nullptr || filter_predicate_->EvaluatePredicate(&view)) {
+        if (plan_->column_ids_.empty()) {
+          *tuple = view;
+        } else {
+          *tuple = view.ProjectColumns(table_info_->schema_, plan_->OutputSchema(), plan_->column_ids_);
         }
-        exec_ctx_->GetLockManager()->UnlockTable(exec_ctx_->GetTransaction(), table_info_->oid_);
-      }  
-      return false;
+        cursor_->Unlatch();
+        return true;
+      }
     }
+    return false;
+  }
+
+  while (table_iter_ != table_info_->table_->End()) {
     *tuple = *table_iter_;
-    *rid = tuple->GetRid();
-    ++table_iter_;//νʹ жϵǰԪǷϹν   Ԫ飨tupleϢеģʽtable_info_->schema_
-  } while (plan_->filter_predicate_ != nullptr && !plan_->filter_predicate_->Evaluate(tuple, table_info_->schema_).GetAs<bool>());
-  //һtupleǰֻԱisȥһеʱӦü  S
-  //뼶ǶδύǶύظ 
-  //δύ 
-  if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
-    // S   
-    try {
-      bool is_locked = exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), LockManager::LockMode::SHARED,
-                                                            table_info_->oid_, *rid);
-      if (!is_locked) {
-        throw ExecutionException("SeqScan Executor Get Table Lock Failed");
+    ++table_iter_;
+    if (filter_predicate_ == nullptr || filter_predicate_->EvaluatePredicate(tuple)) {
+      if (!plan_->column_ids_.empty()) {
+        *tuple = tuple->ProjectColumns(table_info_->schema_, plan_->OutputSchema(), plan_->column_ids_);
       }
-    } catch (TransactionAbortException e) {
-      throw ExecutionException("SeqScan Executor Get Row Lock Failed");
+      return true;
     }
   }
+  return false;
+}
 
+auto SeqScanExecutor::NextRid(RID *rid) -> bool {
+  if (cursor_ != nullptr) {
+    Tuple view;
+    if (!cursor_->Next(&view)) {
+      return false;
+    }
+    *rid = view.GetRid();
+    cursor_->Unlatch();
+    return true;
+  }
+  if (table_iter_ == table_info_->table_->End()) {
+    return false;
+  }
+  *rid = table_iter_->GetRid();
+  ++table_iter_;
+  return true;
+}
+
+auto SeqScanExecutor::NextPage() -> bool {
+  page_tuples_.clear();
+  page_cursor_ = 0;
+  auto *txn = exec_ctx_->GetTransaction();
+  table_oid_t oid = table_info_->oid_;
+  // Pages none of whose rows satisfy the filter are skipped.
+  while (has_lookahead_ && page_tuples_.empty()) {
+    page_id_t page_id = lookahead_.GetPageId();
+    std::vector<RID> page_rids;
+    std::vector<RID> rids;
+    while (has_lookahead_ && lookahead_.GetPageId() == page_id) {
+      page_rids.push_back(lookahead_);
+      // A row this transaction wrote is X locked already, which covers the read.
+      if (!txn->IsRowExclusiveLocked(oid, lookahead_)) {
+        rids.push_back(lookahead_);
+      }
+      has_lookahead_ = NextRid(&lookahead_);
+    }
+    if (!rids.empty()) {
+      try {
+        bool is_locked = exec_ctx_->GetLockManager()->LockRows(txn, LockManager::LockMode::SHARED, oid, rids);
+        if (!is_locked) {
+          throw ExecutionException("SeqScan Executor Get Row Lock Failed");
+        }
+      } catch (const TransactionAbortException &e) {
+        throw ExecutionException("SeqScan Executor Get Row Lock Failed");
+      }
+    }
+
+    // The rows are read again now that they are locked: a writer that held one has committed or rolled back since, and
+    // the filter must see what it left behind. A row whose insert was rolled back is gone.
+    auto *bpm = exec_ctx_->GetBufferPoolManager();
+    auto *page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+    BUSTUB_ENSURE(page != nullptr, "BPM full");
+    page->RLatch();
+    Tuple view;
+    for (const auto &rid : page_rids) {
+      if (page->GetTupleView(rid, &view) &&
+          (filter_predicate_ == nullptr || filter_predicate_->EvaluatePredicate(&view))) {
+        page_tuples_.push_back(plan_->column_ids_.empty() ? Tuple(view)
+                                                          : view.ProjectColumns(table_info_->schema_,
+                                                                                plan_->OutputSchema(),
+                                                                                plan_->column_ids_));
+      }
+    }
+    page->RUnlatch();
+    bpm->UnpinPage(page_id, false);
+  }
+  return !page_tuples_.empty();
+}
+
+auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  bool has_tuple = false;
+  if (lock_rows_) {
+    has_tuple = page_cursor_ < page_tuples_.size() || NextPage();
+    if (has_tuple) {
+      *tuple = std::move(page_tuples_[page_cursor_++]);
+    }
+  } else {
+    has_tuple = NextTuple(tuple);
+  }
+  if (!has_tuple) {
+    //ύһεNextʱǰͷ(ͷͷű)
+    //ĩβһΪδύûмԲ뼶ֻǶύظ
+    //ظֻcommitʱͷҪֶȥƣֻʣ ύ
+    auto *txn = exec_ctx_->GetTransaction();
+    if (txn->GetIsolationLevel() == IsolationLevel::READ_COMMITTED) {
+      table_oid_t oid = table_info_->oid_;
+      // No row lock is taken under a table lock that covers the rows.
+      auto locked_rows = txn->GetSharedRowLockSet()->find(oid);
+      if (locked_rows != txn->GetSharedRowLockSet()->end()) {
+        const auto locked_row_set = locked_rows->second;
+        for (auto rid : locked_row_set) {
+          exec_ctx_->GetLockManager()->UnlockRow(txn, oid, rid);
+        }
+      }
+      // Keep the table lock if a writer of this transaction holds it, only a lock the scan took is released early.
+      if (txn->IsTableIntentionSharedLocked(oid) || txn->IsTableSharedLocked(oid)) {
+        exec_ctx_->GetLockManager()->UnlockTable(txn, oid);
+      }
+    }  
+    return false;
+  }
+  *rid = tuple->GetRid();
   return true;
 }
 
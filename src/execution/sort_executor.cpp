@@ -1,5 +1,10 @@
 #include "execution/executors/sort_executor.h"
 
+#include <numeric>
+
+#include "execution/compiled_expression.h"
+#include "execution/topn_heap.h"
+
 namespace bustub {
 
 SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
@@ -10,42 +15,46 @@ void SortExecutor::Init() {
   Tuple tuple;
   RID rid;
   child_executor_->Init();
+  sorted_tuples_.clear();
+
+  // Evaluate the sort keys once per tuple instead of once per comparison.
+  const auto &order_bys = plan_->GetOrderBy();
+  std::vector<CompiledExpression> key_exprs;
+  key_exprs.reserve(order_bys.size());
+  for (const auto &[order_by_type, expr] : order_bys) {
+    key_exprs.emplace_back(expr.get(), child_executor_->GetOutputSchema());
+  }
+  std::vector<std::vector<Value>> keys;
   while (child_executor_->Next(&tuple, &rid)) {
+    std::vector<Value> key;
+    key.reserve(key_exprs.size());
+    for (const auto &key_expr : key_exprs) {
+      key.push_back(key_expr.Evaluate(&tuple));
+    }
+    keys.push_back(std::move(key));
     sorted_tuples_.push_back(tuple);
   }
-  std::sort(sorted_tuples_.begin(), sorted_tuples_.end(), [this](const Tuple &a, const Tuple &b) {
-    //ʽ ǰʲôһнֵ
-    //õͺıʽÿһȥһȽϣжһǲ
-    for (auto [order_by_type, expr] : plan_->GetOrderBy()) {
-      bool asc_order_by = (order_by_type == OrderByType::DEFAULT || order_by_type == OrderByType::ASC);
-      if(asc_order_by) {
-        //exprʽÿһȥһevaluateȥһжϣһȽ a,bν
-        //⣺a.name == b.name Բֱӷأһȥ
-        //return a < b;true/false 
-        //return a > b;true/false 
-        if(expr->Evaluate(&a, child_executor_->GetOutputSchema()).CompareLessThan(
-                expr->Evaluate(&b, child_executor_->GetOutputSchema())) == CmpBool::CmpTrue) {
-          return true;
-        }
-        if(expr->Evaluate(&a, child_executor_->GetOutputSchema()).CompareGreaterThan(
-                expr->Evaluate(&b, child_executor_->GetOutputSchema())) == CmpBool::CmpTrue) {
-          return false;
-        }
-        //Ȳһȥ
-      }else{
-        if(expr->Evaluate(&a, child_executor_->GetOutputSchema()).CompareLessThan(
-                expr->Evaluate(&b, child_executor_->GetOutputSchema())) == CmpBool::CmpTrue) {
-          return false;
-        }
-        if(expr->Evaluate(&a, child_executor_->GetOutputSchema()).CompareGreaterThan(
-                expr->Evaluate(&b, child_executor_->GetOutputSchema())) == CmpBool::CmpTrue) {
-          return true;
-        }
+
+  std::vector<size_t> order(sorted_tuples_.size());
+  std::iota(order.begin(), order.end(), 0);
+  // NULLs sort first under ASC and last under DESC, as in TopNExecutor.
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    for (size_t i = 0; i < order_bys.size(); i++) {
+      int cmp = TopNHeap::CompareValues(keys[a][i], keys[b][i]);
+      if (cmp != 0) {
+        return order_bys[i].first == OrderByType::DESC ? cmp > 0 : cmp < 0;
       }
     }
-    return false;//sortfalseʾʲô
+    return false;
   });
-  iterator_ = sorted_tuples_.begin();//ڻɽģͣÿnextһtuple֪ǰĸλˣһʼҪڿʼλ
+
+  std::vector<Tuple> sorted;
+  sorted.reserve(order.size());
+  for (auto idx : order) {
+    sorted.push_back(std::move(sorted_tuples_[idx]));
+  }
+  sorted_tuples_ = std::move(sorted);
+  iterator_ = sorted_tuples_.begin();
 }
 
 auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool {
@@ -1,5 +1,9 @@
 #include "execution/executors/topn_executor.h"
 
+#include <utility>
+
+#include "execution/batch_worker_pool.h"
+
 namespace bustub {
 
 TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan,
@@ -8,61 +12,55 @@ TopNExecutor::TopNExecutor(ExecutorContext *exec_ctx, const TopNPlanNode *plan,
 
 void TopNExecutor::Init() {
   child_->Init();
-
-  auto cmp = [order_bys = plan_->order_bys_, schema = child_->GetOutputSchema()](const Tuple &a, const Tuple &b) {
-    for (const auto &order_key : order_bys) {
-      switch (order_key.first) {
-        case OrderByType::INVALID:
-        case OrderByType::DEFAULT:
-        case OrderByType::ASC:
-          if (static_cast<bool>(
-                  order_key.second->Evaluate(&a, schema).CompareLessThan(order_key.second->Evaluate(&b, schema)))) {
-            return true;
-          } else if (static_cast<bool>(order_key.second->Evaluate(&a, schema)
-                                           .CompareGreaterThan(order_key.second->Evaluate(&b, schema)))) {
-            return false;
-          }
-          break;
-        case OrderByType::DESC:
-          if (static_cast<bool>(
-                  order_key.second->Evaluate(&a, schema).CompareGreaterThan(order_key.second->Evaluate(&b, schema)))) {
-            return true;
-          } else if (static_cast<bool>(order_key.second->Evaluate(&a, schema)
-                                           .CompareLessThan(order_key.second->Evaluate(&b, schema)))) {
-            return false;
-          }
-          break;
-      }
+  sorted_tuples_.clear();
+  cursor_ = 0;
+
+  TopNHeap heap(plan_->GetOrderBy(), child_->GetOutputSchema(), plan_->GetN());
+
+  auto batch = BatchWorkerPool::ReadBatch(child_.get(), TOPN_BATCH_SIZE);
+  if (batch.size() == TOPN_BATCH_SIZE && topn_parallelism > 1) {
+    ParallelBuild(std::move(batch), &heap);
+  } else {
+    // Small inputs (and single-threaded configurations) stay on the executor thread. The heap only copies the child
+    // tuples that make it into the first N.
+    for (const auto &tuple : batch) {
+      heap.Push(tuple);
     }
-    return false;
-  };
+    RID child_rid;
+    Tuple child_tuple{};
+    while (child_->Next(&child_tuple, &child_rid)) {
+      heap.Push(child_tuple);
+    }
+  }
 
-  std::priority_queue<Tuple, std::vector<Tuple>, decltype(cmp)> pq(cmp);//ԶĴ
+  sorted_tuples_ = heap.Drain();
+}
 
-  Tuple child_tuple{};
-  RID child_rid;
-  //СֻN Ԫ
-  while (child_->Next(&child_tuple, &child_rid)) {//һchild_tuple
-    pq.push(child_tuple);
-    if (pq.size() > plan_->GetN()) {
-      pq.pop();
-    }
+void TopNExecutor::ParallelBuild(std::vector<Tuple> batch, TopNHeap *heap) {
+  size_t num_workers = topn_parallelism;
+  std::vector<std::unique_ptr<TopNHeap>> heaps;
+  for (size_t i = 0; i < num_workers; i++) {
+    heaps.emplace_back(std::make_unique<TopNHeap>(plan_->GetOrderBy(), child_->GetOutputSchema(), plan_->GetN()));
   }
-  //ջ
-  while (!pq.empty()) {
-    child_tuples_.push(pq.top());
-    pq.pop();
+
+  BatchWorkerPool pool(num_workers, TOPN_BATCH_SIZE);
+  pool.Run(child_.get(), std::move(batch), [&heaps](size_t worker, const std::vector<Tuple> &tuples) {
+    for (const auto &tuple : tuples) {
+      heaps[worker]->Push(tuple);
+    }
+  });
+
+  for (auto &worker_heap : heaps) {
+    heap->Merge(worker_heap.get());
   }
 }
 
 auto TopNExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (child_tuples_.empty()) {
+  if (cursor_ == sorted_tuples_.size()) {
     return false;
   }
-  *tuple = child_tuples_.top();//ȡһtuple
+  *tuple = sorted_tuples_[cursor_++];
   *rid = tuple->GetRid();
-  child_tuples_.pop();
-
   return true;
 }
 }  // namespace bustub
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_heap.cpp
+//
+// Identification: src/execution/topn_heap.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/topn_heap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+constexpr uint64_t SIGN_BIT = 1ULL << 63;
+
+/** Map a non-NULL value to a word whose unsigned order is the order of the values (NULL maps to 0). */
+auto EncodeValue(const Value &value) -> uint64_t {
+  if (value.IsNull()) {
+    return 0;
+  }
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int8_t>())) ^ SIGN_BIT;
+    case TypeId::SMALLINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int16_t>())) ^ SIGN_BIT;
+    case TypeId::INTEGER:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int32_t>())) ^ SIGN_BIT;
+    case TypeId::BIGINT:
+      // The smallest BIGINT is the NULL marker, so no valid value maps to 0.
+      return static_cast<uint64_t>(value.GetAs<int64_t>()) ^ SIGN_BIT;
+    case TypeId::DECIMAL: {
+      auto d = value.GetAs<double>();
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      // Negative doubles order backwards by their bits, positive ones order forwards above all negative ones.
+      return (bits & SIGN_BIT) != 0 ? ~bits : bits | SIGN_BIT;
+    }
+    case TypeId::TIMESTAMP:
+      // The largest TIMESTAMP is the NULL marker, so this does not overflow.
+      return value.GetAs<uint64_t>() + 1;
+    case TypeId::VARCHAR: {
+      // Big-endian prefix, so that comparing words compares the first 8 bytes like memcmp does.
+      uint64_t prefix = 0;
+      const auto *data = reinterpret_cast<const uint8_t *>(value.GetData());
+      uint32_t len = std::min<uint32_t>(value.GetLength(), sizeof(prefix));
+      for (uint32_t i = 0; i < len; i++) {
+        prefix |= static_cast<uint64_t>(data[i]) << (8 * (7 - i));
+      }
+      return prefix;
+    }
+    default:
+      UNREACHABLE("Unsupported ORDER BY type");
+  }
+}
+
+}  // namespace
+
+auto TopNHeap::CompareValues(const Value &a, const Value &b) -> int {
+  if (a.IsNull() || b.IsNull()) {
+    return static_cast<int>(b.IsNull()) - static_cast<int>(a.IsNull());
+  }
+  if (a.CompareLessThan(b) == CmpBool::CmpTrue) {
+    return -1;
+  }
+  if (a.CompareGreaterThan(b) == CmpBool::CmpTrue) {
+    return 1;
+  }
+  return 0;
+}
+
+TopNHeap::TopNHeap(const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys, const Schema &schema,
+                   size_t n)
+    : n_(n), width_(order_bys.size()), scratch_(order_bys.size()) {
+  exprs_.reserve(width_);
+  for (const auto &[type, expr] : order_bys) {
+    exprs_.emplace_back(expr.get(), schema);
+    types_.push_back(expr->GetReturnType());
+    descending_.push_back(type == OrderByType::DESC);
+    tie_break_.push_back(expr->GetReturnType() == TypeId::VARCHAR);
+    any_tie_break_ = any_tie_break_ || tie_break_.back();
+  }
+  size_t initial = std::min<size_t>(n_, 1024);
+  keys_.reserve(initial * width_);
+  tuples_.reserve(initial);
+  heap_.reserve(initial);
+}
+
+void TopNHeap::EncodeKey(const Tuple &tuple, uint64_t *key) const {
+  for (size_t i = 0; i < width_; i++) {
+    uint64_t word = EncodeValue(exprs_[i].Evaluate(&tuple));
+    key[i] = descending_[i] ? ~word : word;
+  }
+}
+
+auto TopNHeap::Compare(const uint64_t *a_key, const Tuple &a, const uint64_t *b_key, const Tuple &b) const -> int {
+  for (size_t i = 0; i < width_; i++) {
+    if (a_key[i] != b_key[i]) {
+      return a_key[i] < b_key[i] ? -1 : 1;
+    }
+    if (any_tie_break_ && tie_break_[i]) {
+      int cmp = CompareValues(exprs_[i].Evaluate(&a), exprs_[i].Evaluate(&b));
+      if (cmp != 0) {
+        return descending_[i] ? -cmp : cmp;
+      }
+    }
+  }
+  return 0;
+}
+
+void TopNHeap::Push(const Tuple &tuple) {
+  if (n_ == 0) {
+    return;
+  }
+  EncodeKey(tuple, scratch_.data());
+  PushEncoded(scratch_.data(), tuple);
+}
+
+void TopNHeap::PushEncoded(const uint64_t *key, const Tuple &tuple) {
+  if (heap_.size() == n_) {
+    uint32_t top = heap_[0];
+    if (Compare(key, tuple, KeyAt(top), tuples_[top]) >= 0) {
+      return;
+    }
+    // Replace the largest tuple in place, reusing its slot.
+    std::copy(key, key + width_, KeyAt(top));
+    tuples_[top] = tuple;
+    SiftDown(0);
+    return;
+  }
+
+  auto slot = static_cast<uint32_t>(tuples_.size());
+  keys_.insert(keys_.end(), key, key + width_);
+  tuples_.push_back(tuple);
+  heap_.push_back(slot);
+  SiftUp(heap_.size() - 1);
+}
+
+void TopNHeap::Merge(TopNHeap *other) {
+  for (uint32_t slot : other->heap_) {
+    PushEncoded(other->KeyAt(slot), other->tuples_[slot]);
+  }
+  other->keys_.clear();
+  other->tuples_.clear();
+  other->heap_.clear();
+}
+
+auto TopNHeap::Drain() -> std::vector<Tuple> {
+  std::sort(heap_.begin(), heap_.end(), [this](uint32_t a, uint32_t b) { return SlotGreater(b, a); });
+  std::vector<Tuple> result;
+  result.reserve(heap_.size());
+  for (uint32_t slot : heap_) {
+    result.push_back(std::move(tuples_[slot]));
+  }
+  keys_.clear();
+  tuples_.clear();
+  heap_.clear();
+  return result;
+}
+
+void TopNHeap::SiftUp(size_t pos) {
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+    if (!SlotGreater(heap_[pos], heap_[parent])) {
+      break;
+    }
+    std::swap(heap_[pos], heap_[parent]);
+    pos = parent;
+  }
+}
+
+void TopNHeap::SiftDown(size_t pos) {
+  size_t size = heap_.size();
+  while (true) {
+    size_t largest = pos;
+    size_t left = 2 * pos + 1;
+    size_t right = left + 1;
+    if (left < size && SlotGreater(heap_[left], heap_[largest])) {
+      largest = left;
+    }
+    if (right < size && SlotGreater(heap_[right], heap_[largest])) {
+      largest = right;
+    }
+    if (largest == pos) {
+      break;
+    }
+    std::swap(heap_[pos], heap_[largest]);
+    pos = largest;
+  }
+}
+
+}  // namespace bustub
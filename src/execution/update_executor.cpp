@@ -12,6 +12,7 @@
 #include <memory>
 
 #include "execution/executors/update_executor.h"
+#include "execution/plans/seq_scan_plan.h"
 
 namespace bustub {
 
@@ -25,62 +26,97 @@ UpdateExecutor::UpdateExecutor(ExecutorContext *exec_ctx, const UpdatePlanNode *
 void UpdateExecutor::Init() {
   child_executor_->Init();
   try {
-    bool is_locked = exec_ctx_->GetLockManager()->LockTable(
-        exec_ctx_->GetTransaction(), LockManager::LockMode::INTENTION_EXCLUSIVE, table_info_->oid_);
+    // A write driven by a full scan changes every row, so lock the table instead of each row if nobody is in the way.
+    const auto *scan = dynamic_cast<const SeqScanPlanNode *>(plan_->GetChildPlan().get());
+    bool whole_table = scan != nullptr && scan->IsFullScan() && scan->GetTableOid() == table_info_->oid_;
+    auto *txn = exec_ctx_->GetTransaction();
+    auto *lock_manager = exec_ctx_->GetLockManager();
+    table_oid_t oid = table_info_->oid_;
+    bool is_locked = (whole_table && lock_manager->TryLockTable(txn, LockManager::LockMode::EXCLUSIVE, oid)) ||
+                     lock_manager->LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid);
     if (!is_locked) {
       throw ExecutionException("Update Executor Get Table Lock Failed");
     }
-  } catch (TransactionAbortException e) {
+  } catch (const TransactionAbortException &e) {
     throw ExecutionException("Update Executor Get Table Lock Failed");
   }
   table_indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
 }
 
+void UpdateExecutor::LockRows(const std::vector<RID> &rids) {
+  auto *txn = exec_ctx_->GetTransaction();
+  if (rids.empty() || LockManager::IsRowLockCovered(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_)) {
+    return;
+  }
+  try {
+    bool is_locked =
+        exec_ctx_->GetLockManager()->LockRows(txn, LockManager::LockMode::EXCLUSIVE, table_info_->oid_, rids);
+    if (!is_locked) {
+      throw ExecutionException("Update Executor Get Row Lock Failed");
+    }
+  } catch (const TransactionAbortException &e) {
+    throw ExecutionException("Update Executor Get Row Lock Failed");
+  }
+}
+
 auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (is_end_) {
     return false;
   }
-  Tuple old_tuple{};
-  RID old_rid;
+  Tuple child_tuple{};
+  RID child_rid;
+  std::vector<Tuple> old_tuples;
+  std::vector<RID> old_rids;
   int32_t update_count = 0;
 
-  while (child_executor_->Next(&old_tuple, &old_rid)) {
-    try {
-      bool is_locked = exec_ctx_->GetLockManager()->LockRow(
-          exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE, table_info_->oid_, old_rid);
-      if (!is_locked) {
-        throw ExecutionException("Update Executor Get Row Lock Failed");
-      }
-    } catch (TransactionAbortException e) {
-      throw ExecutionException("Update Executor Get Row Lock Failed");
+  bool has_next = child_executor_->Next(&child_tuple, &child_rid);
+  while (has_next) {
+    // The rows are locked a batch at a time, see LockManager::LockRows().
+    old_tuples.clear();
+    old_rids.clear();
+    while (has_next && old_rids.size() < LOCK_BATCH_SIZE) {
+      old_tuples.push_back(child_tuple);
+      old_rids.push_back(child_rid);
+      has_next = child_executor_->Next(&child_tuple, &child_rid);
     }
+    LockRows(old_rids);
 
-    std::vector<Value> values{};
-    values.reserve(child_executor_->GetOutputSchema().GetColumnCount());
-    for (const auto &expr : plan_->target_expressions_) {
-      values.push_back(expr->Evaluate(&old_tuple, child_executor_->GetOutputSchema()));
-    }
+    for (size_t i = 0; i < old_rids.size(); i++) {
+      const Tuple &old_tuple = old_tuples[i];
+      const RID &old_rid = old_rids[i];
+      // The snapshot read by the child is stale if another transaction changed the row since, the first updater wins.
+      if (table_info_->table_->HasWriteConflict(old_rid, exec_ctx_->GetTransaction())) {
+        exec_ctx_->GetTransaction()->SetState(TransactionState::ABORTED);
+        throw ExecutionException("Update Executor Write-Write Conflict");
+      }
 
-    auto to_update_tuple = Tuple{values, &child_executor_->GetOutputSchema()};
+      std::vector<Value> values{};
+      values.reserve(child_executor_->GetOutputSchema().GetColumnCount());
+      for (const auto &expr : plan_->target_expressions_) {
+        values.push_back(expr->Evaluate(&old_tuple, child_executor_->GetOutputSchema()));
+      }
+
+      auto to_update_tuple = Tuple{values, &child_executor_->GetOutputSchema()};
 
-    bool updated = table_info_->table_->UpdateTuple(to_update_tuple, old_rid, exec_ctx_->GetTransaction());
+      bool updated = table_info_->table_->UpdateTuple(to_update_tuple, old_rid, exec_ctx_->GetTransaction());
 
-    if (updated) {
-      // std::for_each(table_indexes_.begin(), table_indexes_.end(),
-      //               [&old_tuple, &rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index) {
-      //                 index->index_->DeleteEntry(old_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
-      //                                                                         index->index_->GetKeyAttrs()),
-      //                                            *rid, exec_ctx->GetTransaction());
-      //               });
-      // std::for_each(table_indexes_.begin(), table_indexes_.end(),
-      //               [&to_update_tuple, &old_rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index)
-      //               {
-      //                 index->index_->InsertEntry(to_update_tuple.KeyFromTuple(table_info->schema_,
-      //                 index->key_schema_,
-      //                                                                         index->index_->GetKeyAttrs()),
-      //                                            old_rid, exec_ctx->GetTransaction());
-      //               });
-      update_count++;
+      if (updated) {
+        // std::for_each(table_indexes_.begin(), table_indexes_.end(),
+        //               [&old_tuple, &rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index) {
+        //                 index->index_->DeleteEntry(old_tuple.KeyFromTuple(table_info->schema_, index->key_schema_,
+        //                                                                         index->index_->GetKeyAttrs()),
+        //                                            *rid, exec_ctx->GetTransaction());
+        //               });
+        // std::for_each(table_indexes_.begin(), table_indexes_.end(),
+        //              [&to_update_tuple, &old_rid, &table_info = table_info_, &exec_ctx = exec_ctx_](IndexInfo *index)
+        //               {
+        //                 index->index_->InsertEntry(to_update_tuple.KeyFromTuple(table_info->schema_,
+        //                 index->key_schema_,
+        //                                                                         index->index_->GetKeyAttrs()),
+        //                                            old_rid, exec_ctx->GetTransaction());
+        //               });
+        update_count++;
+      }
     }
   }
   std::vector<Value> values{};
@@ -79,8 +79,12 @@ class BoundSubqueryRef;
 class CreateStatement;
 class ExplainStatement;
 class IndexStatement;
+class AnalyzeStatement;
 class DeleteStatement;
 class UpdateStatement;
+class PrepareStatement;
+class ExecuteStatement;
+class DeallocateStatement;
 
 /**
  * The binder is responsible for transforming the Postgres parse tree to a binder tree
@@ -95,6 +99,9 @@ class Binder {
    */
   void ParseAndSave(const std::string &query);
 
+  /** @return the text of each statement saved by `ParseAndSave` */
+  auto GetStatementTexts() const -> std::vector<std::string>;
+
   /** Return true if the given text matches a keyword of the parser. */
   static auto IsKeyword(const std::string &text) -> bool;
 
@@ -143,6 +150,8 @@ class Binder {
 
   auto BindConstant(duckdb_libpgquery::PGAConst *node) -> std::unique_ptr<BoundExpression>;
 
+  auto BindParameter(duckdb_libpgquery::PGParamRef *node) -> std::unique_ptr<BoundExpression>;
+
   auto BindColumnRef(duckdb_libpgquery::PGColumnRef *node) -> std::unique_ptr<BoundExpression>;
 
   auto BindResTarget(duckdb_libpgquery::PGResTarget *root) -> std::unique_ptr<BoundExpression>;
@@ -155,6 +164,8 @@ class Binder {
 
   auto BindBoolExpr(duckdb_libpgquery::PGBoolExpr *root) -> std::unique_ptr<BoundExpression>;
 
+  auto BindSubLink(duckdb_libpgquery::PGSubLink *root) -> std::unique_ptr<BoundExpression>;
+
   auto BindFrom(duckdb_libpgquery::PGList *list) -> std::unique_ptr<BoundTableRef>;
 
   auto BindBaseTableRef(std::string table_name, std::optional<std::string> alias) -> std::unique_ptr<BoundBaseTableRef>;
@@ -194,6 +205,8 @@ class Binder {
 
   auto BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<IndexStatement>;
 
+  auto BindAnalyze(duckdb_libpgquery::PGVacuumStmt *stmt) -> std::unique_ptr<AnalyzeStatement>;
+
   auto BindDelete(duckdb_libpgquery::PGDeleteStmt *stmt) -> std::unique_ptr<DeleteStatement>;
 
   auto BindUpdate(duckdb_libpgquery::PGUpdateStmt *stmt) -> std::unique_ptr<UpdateStatement>;
@@ -204,6 +217,12 @@ class Binder {
 
   auto BindVariableShow(duckdb_libpgquery::PGVariableShowStmt *stmt) -> std::unique_ptr<VariableShowStatement>;
 
+  auto BindPrepare(duckdb_libpgquery::PGPrepareStmt *stmt) -> std::unique_ptr<PrepareStatement>;
+
+  auto BindExecute(duckdb_libpgquery::PGExecuteStmt *stmt) -> std::unique_ptr<ExecuteStatement>;
+
+  auto BindDeallocate(duckdb_libpgquery::PGDeallocateStmt *stmt) -> std::unique_ptr<DeallocateStatement>;
+
   class ContextGuard {
    public:
     explicit ContextGuard(const BoundTableRef **scope, const CTEList **cte_scope) {
@@ -237,6 +256,9 @@ class Binder {
   /** Store all statement parse node */
   std::vector<duckdb_libpgquery::PGNode *> statement_nodes_;
 
+  /** The types of the parameters `$1`, `$2`, ... of the statements, see PREPARE */
+  std::vector<TypeId> parameter_types_;
+
  private:
   /** Catalog will be used during the binding process. USERS SHOULD ENSURE IT OUTLIVES THE BINDER,
    * otherwise it's a dangling reference.
@@ -249,9 +271,20 @@ class Binder {
   /** The current scope for resolving tables in CTEs, used in binding tables */
   const CTEList *cte_scope_{nullptr};
 
+  /**
+   * The scopes of the queries around the subquery being bound, innermost last. Columns not found in the current
+   * scope are resolved in them, which makes the subquery correlated.
+   */
+  std::vector<const BoundTableRef *> outer_scopes_;
+
   /** Sometimes we will need to assign a name to some unnamed items. This variable gives them a universal ID. */
   size_t universal_id_{0};
 
+  /** The parsed text, and the start and length of the statement being bound in it, 0 for the rest of it */
+  std::string sql_;
+  int stmt_location_{0};
+  int stmt_len_{0};
+
   duckdb::PostgresParser parser_;
 };
 
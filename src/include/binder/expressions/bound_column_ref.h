@@ -35,5 +35,8 @@ class BoundColumnRef : public BoundExpression {
 
   /** The name of the column. */
   std::vector<std::string> col_name_;
+
+  /** How many queries out the column is from, 0 for the query being bound, 1 for the query around a subquery. */
+  size_t depth_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "binder/bound_expression.h"
+#include "binder/statement/select_statement.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+/**
+ * The kinds of subqueries in an expression.
+ */
+enum class SubqueryType : uint8_t {
+  INVALID = 0, /**< Invalid subquery type. */
+  EXISTS = 1,  /**< `EXISTS (SELECT ...)`, whether the subquery returns any row. */
+  IN = 2,      /**< `x IN (SELECT y ...)`, whether the subquery returns a row equal to `x`. */
+};
+
+/**
+ * A subquery in an expression, e.g. `EXISTS (SELECT * FROM y WHERE y.a = x.a)`. Columns of the query around it are
+ * bound with `depth_` 1 in the subquery. `NOT EXISTS` and `NOT IN` are bound as a `BoundUnaryOp` "not" over it.
+ */
+class BoundSubqueryExpr : public BoundExpression {
+ public:
+  BoundSubqueryExpr(SubqueryType subquery_type, std::unique_ptr<SelectStatement> subquery,
+                    std::unique_ptr<BoundExpression> test_expr)
+      : BoundExpression(ExpressionType::SUBQUERY),
+        subquery_type_(subquery_type),
+        subquery_(std::move(subquery)),
+        test_expr_(std::move(test_expr)) {}
+
+  auto ToString() const -> std::string override;
+
+  auto HasAggregation() const -> bool override { return test_expr_ != nullptr && test_expr_->HasAggregation(); }
+
+  /** The kind of subquery. */
+  SubqueryType subquery_type_;
+
+  /** The subquery. */
+  std::unique_ptr<SelectStatement> subquery_;
+
+  /** The value looked up in the subquery by `IN`, nullptr for `EXISTS`. */
+  std::unique_ptr<BoundExpression> test_expr_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,37 @@
+//===----------------------------------------------------------------------===//
+//                         BusTub
+//
+// binder/analyze_statement.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "binder/bound_statement.h"
+#include "binder/expressions/bound_column_ref.h"
+#include "binder/table_ref/bound_base_table_ref.h"
+
+namespace bustub {
+
+class AnalyzeStatement : public BoundStatement {
+ public:
+  explicit AnalyzeStatement(std::unique_ptr<BoundBaseTableRef> table, std::vector<std::unique_ptr<BoundColumnRef>> cols,
+                            bool verbose);
+
+  /** The table to analyze, `nullptr` to analyze all tables */
+  std::unique_ptr<BoundBaseTableRef> table_;
+
+  /** The columns to collect statistics for, empty for all columns */
+  std::vector<std::unique_ptr<BoundColumnRef>> cols_;
+
+  /** Whether to print the collected statistics */
+  bool verbose_;
+
+  auto ToString() const -> std::string override;
+};
+
+}  // namespace bustub
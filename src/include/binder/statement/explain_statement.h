@@ -18,6 +18,7 @@ enum ExplainOptions : uint8_t {
   PLANNER = 2,   /**< Show planner results. */
   OPTIMIZER = 4, /**< Show optimizer results. */
   SCHEMA = 8,    /**< Show schema. */
+  ANALYZE = 16,  /**< Execute the optimized plan and show what every plan node did. */
 };
 
 namespace bustub {
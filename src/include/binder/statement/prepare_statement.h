@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//                         BusTub
+//
+// binder/prepare_statement.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_statement.h"
+#include "common/enums/statement_type.h"
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+#include "type/type.h"
+#include "type/type_id.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class PrepareStatement : public BoundStatement {
+ public:
+  explicit PrepareStatement(std::string name, std::vector<TypeId> types, std::string query)
+      : BoundStatement(StatementType::PREPARE_STATEMENT),
+        name_(std::move(name)),
+        types_(std::move(types)),
+        query_(std::move(query)) {}
+
+  std::string name_;
+
+  /** The declared types of the parameters, the others are the types of the values they are executed with */
+  std::vector<TypeId> types_;
+
+  /** The text of the prepared statement, with parameters `$1`, `$2`, ... */
+  std::string query_;
+
+  auto ToString() const -> std::string override {
+    std::vector<std::string> types;
+    for (auto type : types_) {
+      types.push_back(Type::TypeIdToString(type));
+    }
+    return fmt::format("BoundPrepare {{ name={}, types={}, query={} }}", name_, types, query_);
+  }
+};
+
+class ExecuteStatement : public BoundStatement {
+ public:
+  explicit ExecuteStatement(std::string name, std::vector<Value> params)
+      : BoundStatement(StatementType::EXECUTE_STATEMENT), name_(std::move(name)), params_(std::move(params)) {}
+
+  std::string name_;
+
+  /** The values of the parameters */
+  std::vector<Value> params_;
+
+  auto ToString() const -> std::string override {
+    std::vector<std::string> params;
+    for (const auto &param : params_) {
+      params.push_back(param.ToString());
+    }
+    return fmt::format("BoundExecute {{ name={}, params={} }}", name_, params);
+  }
+};
+
+class DeallocateStatement : public BoundStatement {
+ public:
+  /** @param name the prepared statement to remove, empty to remove all of them */
+  explicit DeallocateStatement(std::string name)
+      : BoundStatement(StatementType::DEALLOCATE_STATEMENT), name_(std::move(name)) {}
+
+  std::string name_;
+
+  auto ToString() const -> std::string override { return fmt::format("BoundDeallocate {{ name={} }}", name_); }
+};
+
+}  // namespace bustub
@@ -18,7 +18,14 @@ enum class JoinType : uint8_t {
   LEFT = 1,    /**< Left join. */
   RIGHT = 3,   /**< Right join. */
   INNER = 4,   /**< Inner join. */
-  OUTER = 5    /**< Outer join. */
+  OUTER = 5,   /**< Outer join. */
+  SEMI = 6,    /**< Semi join, the left tuples that match a right tuple, planned for `EXISTS` and `IN`. */
+  ANTI = 7,    /**< Anti join, the left tuples that match no right tuple, planned for `NOT EXISTS`. */
+  /**
+   * Anti join planned for `NOT IN`, which also drops the left tuples for which the predicate is NULL, e.g. those
+   * with a NULL key, or all of them if a right key is NULL.
+   */
+  NULL_AWARE_ANTI = 8
 };
 
 /**
@@ -74,6 +81,15 @@ struct fmt::formatter<bustub::JoinType> : formatter<string_view> {
       case bustub::JoinType::OUTER:
         name = "Outer";
         break;
+      case bustub::JoinType::SEMI:
+        name = "Semi";
+        break;
+      case bustub::JoinType::ANTI:
+        name = "Anti";
+        break;
+      case bustub::JoinType::NULL_AWARE_ANTI:
+        name = "NullAwareAnti";
+        break;
       default:
         name = "Unknown";
         break;
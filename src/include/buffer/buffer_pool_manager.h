@@ -23,6 +23,16 @@
 
 namespace bustub {
 
+/** Page requests of one thread to the buffer pools, see BufferPoolManager::ThreadStats */
+struct BufferPoolStats {
+  /** Pages fetched, whether they were in the buffer pool or not */
+  uint64_t fetched_{0};
+  /** Pages fetched that had to be read from disk */
+  uint64_t missed_{0};
+  /** Pages written to disk, when they were evicted or flushed */
+  uint64_t flushed_{0};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -87,6 +97,15 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /**
+   * @return the page requests the calling thread made to any buffer pool. The counters are per thread so that they
+   * cost nothing to update, the difference of two snapshots is what the thread requested in between.
+   */
+  static auto ThreadStats() -> BufferPoolStats & {
+    thread_local BufferPoolStats stats;
+    return stats;
+  }
+
  protected:
   /**
    * Grading function. Do not modify!
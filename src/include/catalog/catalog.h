@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -20,6 +21,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
+#include "catalog/table_stats.h"
 #include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
@@ -152,6 +154,7 @@ class Catalog {
     tables_.emplace(table_oid, std::move(meta));
     table_names_.emplace(table_name, table_oid);
     index_names_.emplace(table_name, std::unordered_map<std::string, index_oid_t>{});
+    version_++;
 
     return tmp;
   }
@@ -248,6 +251,7 @@ class Catalog {
     // Update internal tracking
     indexes_.emplace(index_oid, std::move(index_info));
     table_indexes.emplace(index_name, index_oid);
+    version_++;
 
     return tmp;
   }
@@ -300,7 +304,7 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
@@ -335,6 +339,29 @@ class Catalog {
     return indexes;
   }
 
+  /**
+   * Replace the statistics of a table, see ANALYZE.
+   * @param table_oid The OID of the analyzed table
+   * @param stats What ANALYZE found out about the table
+   */
+  void SetTableStats(table_oid_t table_oid, std::shared_ptr<const TableStats> stats) {
+    table_stats_[table_oid] = std::move(stats);
+    version_++;
+  }
+
+  /**
+   * Query the statistics of a table.
+   * @param table_oid The OID of the table to query
+   * @return The statistics of the last ANALYZE of the table, or `nullptr` if it was never analyzed
+   */
+  auto GetTableStats(table_oid_t table_oid) const -> std::shared_ptr<const TableStats> {
+    auto stats = table_stats_.find(table_oid);
+    return stats == table_stats_.end() ? nullptr : stats->second;
+  }
+
+  /** @return a number that changes whenever a table or an index is created or a table is analyzed */
+  auto GetVersion() const -> uint64_t { return version_; }
+
   auto GetTableNames() -> std::vector<std::string> {
     std::vector<std::string> result;
     for (const auto &x : table_names_) {
@@ -373,6 +400,12 @@ class Catalog {
 
   /** The next index identifier to be used. */
   std::atomic<index_oid_t> next_index_oid_{0};
+
+  /** Map table identifier -> statistics of the last ANALYZE of the table. */
+  std::unordered_map<table_oid_t, std::shared_ptr<const TableStats>> table_stats_;
+
+  /** Changed by every change of the catalog, plans made before a change are planned again. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
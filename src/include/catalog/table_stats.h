@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_stats.h
+//
+// Identification: src/include/catalog/table_stats.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "type/value.h"
+
+namespace bustub {
+
+class TableHeap;
+class Transaction;
+
+/**
+ * The distribution of the values of one column, collected by ANALYZE.
+ *
+ * The most common values are kept with their frequencies; the other non-NULL values are summarized by an equi-depth
+ * histogram, whose buckets between two consecutive bounds hold about the same number of values each.
+ */
+struct ColumnStats {
+  /** Fraction of the rows where the column is NULL */
+  double null_fraction_{0};
+  /** Estimated number of distinct non-NULL values */
+  uint64_t distinct_{0};
+  /** The most common values and the fraction of the rows holding each, most common first */
+  std::vector<std::pair<Value, double>> most_common_;
+  /** Ascending bounds of the histogram of the values that are not among the most common ones, empty if there are none */
+  std::vector<Value> histogram_bounds_;
+
+  /** @return the fraction of the rows where `column = value` */
+  auto EqualSelectivity(const Value &value) const -> double;
+
+  /**
+   * @return the fraction of the rows where the column lies within a range
+   * @param low the low end of the range, `nullptr` if it is open
+   * @param high the high end of the range, `nullptr` if it is open
+   */
+  auto RangeSelectivity(const Value *low, bool low_inclusive, const Value *high, bool high_inclusive) const -> double;
+
+ private:
+  /** @return the fraction of the rows where `column < value`, or `column <= value` if inclusive */
+  auto LessSelectivity(const Value &value, bool inclusive) const -> double;
+
+  /** @return the fraction of the rows that are neither NULL nor among the most common values */
+  auto HistogramFraction() const -> double;
+};
+
+/** What ANALYZE found out about a table */
+struct TableStats {
+  /** At most this many rows are sampled to build the most common values and histograms */
+  static constexpr size_t SAMPLE_ROWS = 30000;
+  static constexpr size_t MAX_MOST_COMMON = 10;
+  static constexpr size_t HISTOGRAM_BUCKETS = 100;
+
+  uint64_t row_count_{0};
+  uint64_t page_count_{0};
+  /** The statistics of every column of the schema, or nullopt for a column that was not analyzed */
+  std::vector<std::optional<ColumnStats>> columns_;
+
+  /**
+   * Scan a table and collect the statistics of some of its columns.
+   * @param table the table to scan
+   * @param schema the schema of the table
+   * @param col_ids the columns to collect statistics for
+   * @param txn the transaction of the scan, whose snapshot is read if it has one; the newest tuples are read otherwise
+   */
+  static auto Collect(TableHeap *table, const Schema &schema, const std::vector<uint32_t> &col_ids,
+                      Transaction *txn) -> TableStats;
+
+  auto ToString(const Schema &schema) const -> std::string;
+};
+
+}  // namespace bustub
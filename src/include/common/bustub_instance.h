@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
@@ -25,7 +26,9 @@
 #include "catalog/catalog.h"
 #include "common/config.h"
 #include "common/util/string_util.h"
+#include "execution/plans/abstract_plan.h"
 #include "libfort/lib/fort.hpp"
+#include "planner/plan_cache.h"
 #include "type/value.h"
 
 namespace bustub {
@@ -40,6 +43,7 @@ class LogManager;
 class CheckpointManager;
 class Catalog;
 class ExecutionEngine;
+class PrepareStatement;
 
 class ResultWriter {
  public:
@@ -253,6 +257,7 @@ class BustubInstance {
   Catalog *catalog_;
   ExecutionEngine *execution_engine_;
   std::shared_mutex catalog_lock_;
+  PlanCache plan_cache_;
 
   auto GetSessionVariable(const std::string &key) -> std::string {
     if (session_variables_.find(key) != session_variables_.end()) {
@@ -270,8 +275,26 @@ class BustubInstance {
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  /** Show the lock metrics, or dump them as JSON with option `json`, or clear them with option `reset` */
+  void CmdDisplayLocks(const std::string &option, ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
+
+  /**
+   * Get the plan of a statement with parameters `$1`, `$2`, ... from the plan cache, or plan it and cache it.
+   * @param prepared whether to throw the errors of a statement that cannot be planned, otherwise the statement is
+   * cached as uncacheable so that the caller executes it as usual
+   */
+  auto GetCachedPlan(const std::string &query, const std::vector<Value> &params, bool prepared)
+      -> std::shared_ptr<const CachedPlan>;
+
+  /** Execute an optimized plan and write its result with the names of the given schema */
+  auto ExecutePlan(const AbstractPlanNodeRef &plan, const Schema &schema, ResultWriter &writer, Transaction *txn)
+      -> bool;
+
   std::unordered_map<std::string, std::string> session_variables_;
+  /** The statements of PREPARE by name, guarded by `prepared_statements_latch_` as statements run concurrently */
+  std::unordered_map<std::string, std::shared_ptr<const PrepareStatement>> prepared_statements_;
+  std::mutex prepared_statements_latch_;
 };
 
 }  // namespace bustub
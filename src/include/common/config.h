@@ -18,8 +18,24 @@
 
 namespace bustub {
 
-/** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
-extern std::chrono::milliseconds cycle_detection_interval;
+/** How the lock manager keeps transactions that wait for locks from deadlocking. */
+enum class DeadlockPolicy {
+  DETECTION,   // abort the newest transaction on a waits-for cycle as soon as the cycle forms
+  WAIT_DIE,    // a transaction only waits for newer ones; a newer requester aborts itself instead
+  WOUND_WAIT,  // an older requester aborts the newer transactions it waits for; a newer requester waits
+};
+
+/** The deadlock policy of the lock manager. */
+extern std::atomic<DeadlockPolicy> deadlock_policy;
+
+/** Row locks a transaction may hold on one table before they are escalated to a table lock; 0 disables escalation. */
+extern std::atomic<size_t> lock_escalation_threshold;
+
+/** True if LockManager::LockRows() should grant uncontended rows under one latch per partition, not row by row. */
+extern std::atomic<bool> enable_batched_row_locks;
+
+/** True if the lock manager should keep the counters and latency histograms of LockMetrics. */
+extern std::atomic<bool> enable_lock_metrics;
 
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
@@ -27,20 +43,63 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** True if aggregations over fixed-width inputs should use the two-phase parallel hash table. */
+extern std::atomic<bool> enable_parallel_aggregation;
+
+/** Number of worker threads used by the parallel hash aggregation. */
+extern std::atomic<size_t> aggregation_parallelism;
+
+/** Bytes of partitioned aggregate state a worker may buffer in memory before spilling it to disk. */
+extern std::atomic<size_t> aggregation_spill_threshold;
+
+/** True if the optimizer should plan equi-joins as adaptive joins, which pick their algorithm at runtime. */
+extern std::atomic<bool> enable_adaptive_join;
+
+/** Rows of each input an adaptive join buffers before it picks index nested loop, hash or spilling hash join. */
+extern std::atomic<size_t> adaptive_join_buffer_rows;
+
+/** Bytes of build tuples an adaptive join holds in memory before it partitions both of its inputs to disk. */
+extern std::atomic<size_t> hash_join_spill_threshold;
+
+/** Bytes of outer tuples a nested loop join buffers for every pass over its inner side. */
+extern std::atomic<size_t> nested_loop_join_block_size;
+
+/** True if sequential scans should evaluate their filter on tuples in the page and only copy out the ones they emit. */
+extern std::atomic<bool> enable_zero_copy_scan;
+
+/** Number of worker threads used by top-N; 1 keeps top-N on the executor thread. */
+extern std::atomic<size_t> topn_parallelism;
+
+/** How often the background garbage collector drops tuple versions that no snapshot can read any more. */
+extern std::chrono::milliseconds version_gc_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
+static constexpr int INVALID_TS = -1;                                                // invalid commit timestamp
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
 static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int AGGREGATION_PREAGG_SLOTS = 1024;  // slots in a thread-local pre-aggregation table
+static constexpr int AGGREGATION_RADIX_BITS = 4;       // log2 of the number of aggregation partitions
+static constexpr int AGGREGATION_BATCH_SIZE = 1024;    // tuples handed to an aggregation worker at a time
+static constexpr int TOPN_BATCH_SIZE = 1024;           // tuples handed to a top-N worker at a time
+static constexpr int LOCK_TABLE_PARTITION_BITS = 6;    // log2 of the number of lock table partitions
+static constexpr int VERSION_STORE_PARTITION_BITS = 4;  // log2 of the number of version store partitions
+static constexpr int TXN_MAP_SHARD_BITS = 6;            // log2 of the number of transaction map shards
+static constexpr int TXN_POOL_SIZE = 64;                // freed transactions a thread keeps for reuse
+static constexpr int LOCK_BATCH_SIZE = 128;             // rows a write executor locks with one LockRows() call
+static constexpr int PLAN_CACHE_SIZE = 256;             // statements whose optimized plans are cached
+static constexpr int HASH_JOIN_PARTITIONS = 16;         // partitions of a hash join that spills to disk
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
 using txn_id_t = int32_t;      // transaction id type
 using lsn_t = int32_t;         // log sequence number type
+using timestamp_t = int64_t;   // commit timestamp type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
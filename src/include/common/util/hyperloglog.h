@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hyperloglog.h
+//
+// Identification: src/include/common/util/hyperloglog.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "common/util/hash_util.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * HyperLogLog estimates the number of distinct values in a stream in constant memory.
+ *
+ * Every value is hashed to 64 bits; the first PRECISION bits pick a register, which keeps the longest run of leading
+ * zeros seen in the remaining bits. With 4096 registers the estimate is within about 1.6% of the true count.
+ */
+class HyperLogLog {
+ public:
+  static constexpr uint32_t PRECISION = 12;
+  static constexpr size_t REGISTERS = size_t{1} << PRECISION;
+
+  /** Add a value, NULLs are not counted */
+  void Add(const Value &value) {
+    if (!value.IsNull()) {
+      AddHash(Key(value));
+    }
+  }
+
+  /** Add the hash of a value, which must tell distinct values apart but does not need to be well distributed */
+  void AddHash(hash_t hash) {
+    auto mixed = Mix(hash);
+    auto index = mixed >> (64 - PRECISION);
+    // Keep a stop bit below the remaining bits so that a run of zeros is at most 64 - PRECISION long.
+    auto rest = (mixed << PRECISION) | (uint64_t{1} << (PRECISION - 1));
+    auto rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+  }
+
+  /** Count the values added to another sketch as well */
+  void Merge(const HyperLogLog &other) {
+    for (size_t i = 0; i < REGISTERS; i++) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  /** @return the estimated number of distinct values added */
+  auto Estimate() const -> uint64_t {
+    double sum = 0;
+    size_t zeros = 0;
+    for (auto rank : registers_) {
+      sum += std::ldexp(1.0, -rank);
+      zeros += rank == 0 ? 1 : 0;
+    }
+    constexpr auto m = static_cast<double>(REGISTERS);
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros != 0) {
+      // Few values leave registers empty, linear counting is more accurate for them.
+      estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+  }
+
+ private:
+  /**
+   * @return a key that differs for distinct values. Numbers are their own key, HashUtil::HashValue() would map many
+   * small integers to the same hash.
+   */
+  static auto Key(const Value &value) -> uint64_t {
+    switch (value.GetTypeId()) {
+      case TypeId::TINYINT:
+        return static_cast<uint64_t>(value.GetAs<int8_t>());
+      case TypeId::SMALLINT:
+        return static_cast<uint64_t>(value.GetAs<int16_t>());
+      case TypeId::INTEGER:
+        return static_cast<uint64_t>(value.GetAs<int32_t>());
+      case TypeId::BIGINT:
+        return static_cast<uint64_t>(value.GetAs<int64_t>());
+      case TypeId::DECIMAL: {
+        auto number = value.GetAs<double>();
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        return bits;
+      }
+      case TypeId::VARCHAR:
+        return std::hash<std::string_view>{}(std::string_view(value.GetData(), value.GetLength()));
+      default:
+        return HashUtil::HashValue(&value);
+    }
+  }
+
+  /** The finalizer of MurmurHash3, so that every input bit affects every output bit */
+  static auto Mix(uint64_t hash) -> uint64_t {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  std::array<uint8_t, REGISTERS> registers_{};
+};
+
+}  // namespace bustub
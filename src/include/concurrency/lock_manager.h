@@ -13,11 +13,14 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <condition_variable>  // NOLINT
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
-#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -25,6 +28,7 @@
 
 #include "common/config.h"
 #include "common/rid.h"
+#include "concurrency/lock_metrics.h"
 #include "concurrency/transaction.h"
 
 namespace bustub {
@@ -40,7 +44,7 @@ class LockManager {
 
   /**
    * Structure to hold a lock request.
-   * This could be a lock request on a table OR a row.
+   * This could be a lock request on a table, a row OR an index key.
    * For table lock requests, the rid_ attribute would be unused.
    */
   class LockRequest {
@@ -49,23 +53,61 @@ class LockManager {
         : txn_id_(txn_id), lock_mode_(lock_mode), oid_(oid) {}
     LockRequest(txn_id_t txn_id, LockMode lock_mode, table_oid_t oid, RID rid) /** Row lock request */
         : txn_id_(txn_id), lock_mode_(lock_mode), oid_(oid), rid_(rid) {}
+    LockRequest(txn_id_t txn_id, LockMode lock_mode, index_oid_t index_oid, int64_t key) /** Key lock request */
+        : txn_id_(txn_id), lock_mode_(lock_mode), oid_(index_oid), key_(key) {}
 
     /** Txn_id of the txn requesting the lock */
     txn_id_t txn_id_;
     /** Locking mode of the requested lock */
     LockMode lock_mode_;
-    /** Oid of the table for a table lock; oid of the table the row belong to for a row lock */
+    /** Oid of the table for a table lock; oid of the table the row belong to for a row lock; oid of the index for a
+     * key lock */
     table_oid_t oid_;
     /** Rid of the row for a row lock; unused for table locks */
     RID rid_;
+    /** The locked key for a key lock */
+    int64_t key_{0};
     /** Whether the lock has been granted or not */
     bool granted_{false};
+    /** When the lock was granted, see LockMetrics::Granted() */
+    uint64_t granted_at_{0};
   };
 
   class LockRequestQueue {
    public:
+    /**
+     * Insert a request before `pos`, reusing a released request node if there is one. The caller must hold latch_.
+     * @return the queued request, which stays at the same address until it is released
+     */
+    auto Insert(std::list<LockRequest>::iterator pos, const LockRequest &request) -> LockRequest * {
+      if (free_requests_.empty()) {
+        return &*request_queue_.insert(pos, request);
+      }
+      request_queue_.splice(pos, free_requests_, free_requests_.begin());
+      auto iter = std::prev(pos);
+      *iter = request;
+      return &*iter;
+    }
+
+    /** Remove a request from the queue and keep its node for reuse. The caller must hold latch_. */
+    void Release(std::list<LockRequest>::iterator iter) {
+      free_requests_.splice(free_requests_.begin(), request_queue_, iter);
+    }
+
+    /** Remove a request from the queue and keep its node for reuse. The caller must hold latch_. */
+    void Release(const LockRequest *request) {
+      for (auto iter = request_queue_.begin(); iter != request_queue_.end(); ++iter) {
+        if (&*iter == request) {
+          Release(iter);
+          return;
+        }
+      }
+    }
+
     /** List of lock requests for the same resource (table or row) */
-    std::list<std::shared_ptr<LockRequest>> request_queue_;
+    std::list<LockRequest> request_queue_;
+    /** Nodes of released requests, spliced back into request_queue_ so that queuing a request does not allocate */
+    std::list<LockRequest> free_requests_;
     /** For notifying blocked transactions on this rid */
     std::condition_variable cv_;
     /** txn_id of an upgrading transaction (if any) */
@@ -75,18 +117,10 @@ class LockManager {
   };
 
   /**
-   * Creates a new lock manager configured for the deadlock detection policy.
+   * Creates a new lock manager. Deadlocks are handled as configured by `deadlock_policy`, on the thread of the
+   * transaction that is about to wait.
    */
-  LockManager() {
-    enable_cycle_detection_ = true;
-    cycle_detection_thread_ = new std::thread(&LockManager::RunCycleDetection, this);
-  }
-
-  ~LockManager() {
-    enable_cycle_detection_ = false;
-    cycle_detection_thread_->join();
-    delete cycle_detection_thread_;
-  }
+  LockManager() = default;
 
   /**
    * [LOCK_NOTE]
@@ -133,6 +167,10 @@ class LockManager {
    *        X, IX locks are allowed in the GROWING state.
    *        S, IS, SIX locks are never allowed
    *
+   *    OPTIMISTIC:
+   *        The transaction only takes the IX, X locks of its writes, and never waits: a lock that cannot be granted
+   *        right away sets the TransactionState as ABORTED and returns false.
+   *
    *
    * MULTILEVEL LOCKING:
    *    While locking rows, Lock() should ensure that the transaction has an appropriate lock on the table which the row
@@ -161,6 +199,30 @@ class LockManager {
    *    Multiple concurrent lock upgrades on the same resource should set the TransactionState as
    *    ABORTED and throw a TransactionAbortException (UPGRADE_CONFLICT).
    *
+   *    A request for a mode that the held lock already covers (see CoversLock()) returns true without changing the
+   *    held lock, and a request for IX under a held S lock, or for S under IX, upgrades it to SIX.
+   *
+   *
+   * LOCK ESCALATION:
+   *    A row lock covered by the table lock of the transaction (S rows under S, SIX or X, X rows under X) need not
+   *    be taken, see IsRowLockCovered(), so an executor that expects to touch every row may lock the table up front
+   *    with TryLockTable().
+   *    Once a transaction holds `lock_escalation_threshold` row locks on one table, LockRow() and LockRows() try to
+   *    escalate them to a covering table lock, see TryEscalate().
+   *
+   *
+   * KEY LOCKS:
+   *    Locks on the keys of an index keep the range scans of REPEATABLE_READ transactions free of phantoms without
+   *    locking the whole table (next-key locking). A lock on a key also stands for the gap below it, down to the next
+   *    smaller key of the index; the gap above the largest key belongs to KEY_SUPREMUM.
+   *    - A scan takes S on every key it reads and on the first key past the end of its range.
+   *    - An insert takes IX on the key above the new one. IX does not conflict with IX, so inserts into one gap go
+   *      ahead together, but they wait for a scan that read the gap, and a later scan waits for them.
+   *    - A delete takes X on the deleted key, whose gap then becomes part of the gap above it, and IX on the key
+   *      above it.
+   *    Key locks are taken in the GROWING state only and are held until the transaction ends. A request for a mode
+   *    the held lock covers returns true, S and IX join into SIX, and any other request upgrades the held lock.
+   *
    *
    * BOOK KEEPING:
    *    If a lock is granted to a transaction, lock manager should update its
@@ -250,6 +312,31 @@ class LockManager {
    */
   auto LockRow(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid) -> bool;
 
+  /**
+   * Acquire locks on a batch of rows of one table in the given lock_mode, as LockRow() would one row at a time.
+   *
+   * The rows are locked in one global order, by lock table partition and then by RID, so that two batches never
+   * wait for each other in a cycle. Each partition latch is taken once for all the rows of the batch it holds, and a
+   * row nobody else holds or waits for is granted under it; so is an S lock held by nobody else that is upgraded to
+   * X. A lock the transaction already holds in X mode also stands for S. Once a row has to wait, that row and the
+   * rest of the batch are locked one by one with LockRow(). If `enable_batched_row_locks` is off, every row is.
+   *
+   * This method throws like LockRow(), see [LOCK_NOTE].
+   *
+   * @param txn the transaction requesting the locks
+   * @param lock_mode SHARED or EXCLUSIVE
+   * @param oid the table_oid_t of the table the rows belong to
+   * @param rids the RIDs of the rows to be locked, in any order and possibly repeated
+   * @return true if every lock is granted, false if the transaction was aborted while it waited
+   */
+  auto LockRows(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, std::vector<RID> rids) -> bool;
+
+  /** @return the partition and queue latches the calling thread has taken in LockRow() and LockRows(), for benchmarks */
+  static auto RowLatchCount() -> uint64_t;
+
+  /** @return the counters and latency histograms of all lock requests so far, shown by the `\locks` shell command */
+  auto GetMetrics() -> LockMetrics & { return metrics_; }
+
   /**
    * Release the lock held on a row by the transaction.
    *
@@ -265,6 +352,38 @@ class LockManager {
    */
   auto UnlockRow(Transaction *txn, const table_oid_t &oid, const RID &rid) -> bool;
 
+  /** The key that stands for the gap above the largest key of an index */
+  static constexpr int64_t KEY_SUPREMUM = std::numeric_limits<int64_t>::max();
+
+  /**
+   * Acquire a lock on a key of an index in the given lock_mode, or upgrade the lock held on it.
+   * See KEY LOCKS in [LOCK_NOTE].
+   *
+   * @param txn the transaction requesting the lock
+   * @param lock_mode SHARED for a scan, INTENTION_EXCLUSIVE for the key above an inserted or deleted key, EXCLUSIVE
+   * for a deleted key
+   * @param index_oid the index of the key
+   * @param key the key, or KEY_SUPREMUM
+   * @return true if the lock is granted, false if the transaction was aborted while it waited
+   */
+  auto LockKey(Transaction *txn, LockMode lock_mode, const index_oid_t &index_oid, int64_t key) -> bool;
+
+  /**
+   * Release a key lock. Key locks are held until the transaction ends, so this does not change its state.
+   * @return false if the transaction holds no lock on the key
+   */
+  auto UnlockKey(Transaction *txn, const index_oid_t &index_oid, int64_t key) -> bool;
+
+  /**
+   * Lock the key above an inserted or deleted key, i.e. the gap the key falls into. The key above may change until it
+   * is locked, so it is looked up again once the lock is granted, until it stays the same.
+   *
+   * @param next_key looks up the smallest key greater than the inserted or deleted one, KEY_SUPREMUM if there is none
+   * @return true if the lock is granted, false if the transaction was aborted while it waited
+   */
+  auto LockNextKey(Transaction *txn, LockMode lock_mode, const index_oid_t &index_oid,
+                   const std::function<int64_t()> &next_key) -> bool;
+
   /*** Graph API ***/
 
   /**
@@ -282,7 +401,8 @@ class LockManager {
   auto RemoveEdge(txn_id_t t1, txn_id_t t2) -> void;
 
   /**
-   * Checks if the graph has a cycle, returning the newest transaction ID in the cycle if so.
+   * Checks if the graph has a cycle, returning the newest transaction ID in the cycle if so. The graph is searched with
+   * FindCycle(), starting from the oldest transaction, as WaitForGrant() searches it.
    * @param[out] txn_id if the graph has a cycle, will contain the newest transaction ID
    * @return false if the graph has no cycle, otherwise stores the newest transaction ID in the cycle to txn_id
    */
@@ -294,18 +414,84 @@ class LockManager {
   auto GetEdgeList() -> std::vector<std::pair<txn_id_t, txn_id_t>>;
 
   /**
-   * Runs cycle detection in the background.
+   * Sleeps until a lock request that cannot be granted yet may be grantable, applying the deadlock policy first.
+   *
+   * The waits-for edges of a transaction are added when it goes to sleep and removed when it wakes up, so the graph
+   * only holds the transactions that are blocked right now. Under DETECTION, a new cycle must go through the sleeping
+   * transaction, so only the cycles through it are searched. Returns without sleeping if the transaction is aborted.
+   *
+   * @param txn the transaction waiting for the lock
+   * @param lock_request the ungranted request of the transaction
+   * @param lock_request_queue the queue holding the request
+   * @param lock the held latch of lock_request_queue
+   */
+  auto WaitForGrant(Transaction *txn, const LockRequest *lock_request, LockRequestQueue *lock_request_queue,
+                    std::unique_lock<std::mutex> *lock) -> void;
+
+  /** @return the transactions with a request ahead of `lock_request` that keeps it from being granted */
+  static auto Blockers(const LockRequest *lock_request, const LockRequestQueue *lock_request_queue)
+      -> std::vector<txn_id_t>;
+
+  /**
+   * Searches a waits-for path from txn_id back to source. The caller must hold waits_for_latch_.
+   * @param[out] cycle the transactions on the path, starting with txn_id
+   */
+  auto FindCycle(txn_id_t source, txn_id_t txn_id, std::unordered_set<txn_id_t> *visited,
+                 std::vector<txn_id_t> *cycle) -> bool;
+
+  /** @return true if a lock in mode `requested` can be granted next to a granted lock in mode `held` */
+  static auto AreLocksCompatible(LockMode held, LockMode requested) -> bool;
+
+  /**
+   * @return true if holding a table lock in mode `held` grants everything a lock in mode `requested` on the same
+   * table, or on one of its rows, would grant
    */
-  auto RunCycleDetection() -> void;
+  static auto CoversLock(LockMode held, LockMode requested) -> bool;
 
-  auto GrantLock(const std::shared_ptr<LockRequest> &lock_request,
-                 const std::shared_ptr<LockRequestQueue> &lock_request_queue) -> bool;
+  /** @return true if the table lock of the transaction covers a row lock in mode `lock_mode` on the table */
+  static auto IsRowLockCovered(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool;
 
-  auto InsertOrDeleteTableLockSet(Transaction *txn, const std::shared_ptr<LockRequest> &lock_request, bool insert)
-      -> void;
+  /**
+   * Find the lock a transaction holds on a table.
+   * @param[out] lock_mode the mode of the held lock
+   * @return false if the transaction holds no lock on the table
+   */
+  static auto GetTableLockMode(Transaction *txn, const table_oid_t &oid, LockMode *lock_mode) -> bool;
+
+  /**
+   * Acquire or upgrade a table lock only if it can be granted right away, i.e. nobody waits in the table's queue and
+   * no other transaction holds a conflicting lock. Never waits, so it cannot create a deadlock, and never aborts the
+   * transaction; an executor falls back to a weaker lock with LockTable() if it fails.
+   * @return true if the transaction holds a lock that covers `lock_mode` on the table
+   */
+  auto TryLockTable(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> bool;
+
+  /**
+   * Escalates the row locks of a transaction on a table to a table lock that covers them: S rows under IS escalate
+   * to S, S rows under IX to SIX, and X rows to X. The covered row locks are released without moving the transaction
+   * to SHRINKING. The table lock is taken with TryLockTable(), so escalation never waits; the caller tries again
+   * later.
+   *
+   * @param txn the transaction holding the row locks
+   * @param row_mode the mode of the row lock that was just granted
+   * @param oid the table of the rows
+   * @return true if the table lock was escalated
+   */
+  auto TryEscalate(Transaction *txn, LockMode row_mode, const table_oid_t &oid) -> bool;
+
+  /**
+   * Removes the granted request of a transaction from the queue of a row and wakes up the waiters. The queue is
+   * recycled once nobody holds or waits for the row.
+   * @param[out] lock_mode the mode of the removed request
+   * @return false if the transaction holds no lock on the row
+   */
+  auto ReleaseRowLock(Transaction *txn, const RID &rid, LockMode *lock_mode) -> bool;
+
+  auto GrantLock(const LockRequest *lock_request, const LockRequestQueue *lock_request_queue) -> bool;
 
-  auto InsertOrDeleteRowLockSet(Transaction *txn, const std::shared_ptr<LockRequest> &lock_request, bool insert)
-      -> void;
+  auto InsertOrDeleteTableLockSet(Transaction *txn, const LockRequest &lock_request, bool insert) -> void;
+
+  auto InsertOrDeleteRowLockSet(Transaction *txn, const LockRequest &lock_request, bool insert) -> void;
   
 
   //idм
@@ -328,57 +514,113 @@ class LockManager {
     row_lock_set->second.erase(rid);
   }
 
-  auto Dfs(txn_id_t txn_id) -> bool {
-    //˸仯Ż
-    if (safe_set_.find(txn_id) != safe_set_.end()) {//ȫҵˣֱܷӷ
-      return false;
+ private:
+  /**
+   * One partition of a lock table. A resource belongs to the partition picked by its hash, and the partition latch
+   * only guards the partition's map and queue pool, so threads locking different resources rarely contend on it.
+   * Latch order: a partition latch is taken before the latch of any of its queues.
+   */
+  template <typename K, typename Hash>
+  class LockTablePartition {
+   public:
+    /** Coordination */
+    std::mutex latch_;
+    using LockMap = std::unordered_map<K, std::unique_ptr<LockRequestQueue>, Hash>;
+
+    /** Structure that holds lock requests for the resources of this partition */
+    LockMap lock_map_;
+    /** Map nodes of rows that are no longer locked by anyone, reused with their queue for the next row */
+    std::vector<typename LockMap::node_type> free_queues_;
+  };
+
+  static constexpr size_t LOCK_TABLE_PARTITIONS = 1 << LOCK_TABLE_PARTITION_BITS;
+
+  /** Find the queue of a resource in its partition, creating it if needed. The caller must hold the partition latch. */
+  template <typename K, typename Hash>
+  static auto GetOrCreateQueue(LockTablePartition<K, Hash> *partition, const K &key) -> LockRequestQueue *;
+
+  /** Abort the transaction and throw if it may not lock a row of the table in `lock_mode`, see [LOCK_NOTE]. */
+  static auto CheckRowLock(Transaction *txn, LockMode lock_mode, const table_oid_t &oid) -> void;
+
+  /**
+   * Grant a row lock to the transaction if it does not have to wait for anybody, see LockRows(). The caller must hold
+   * the latch of the row's partition.
+   * @param requested_at when LockRows() was called, see LockMetrics::Now()
+   * @return false if the lock has to be requested with LockRow()
+   */
+  auto TryGrantRowLock(Transaction *txn, LockMode lock_mode, const table_oid_t &oid, const RID &rid,
+                       LockTablePartition<RID, std::hash<RID>> *partition, uint64_t requested_at) -> bool;
+
+  /** Removes the granted request of a transaction for any resource, see ReleaseRowLock(). */
+  template <typename K, typename Hash>
+  auto ReleaseLock(Transaction *txn, LockTablePartition<K, Hash> *partition, const K &key, LockMode *lock_mode)
+      -> bool;
+
+  /** Mark a request granted and record it, see LockMetrics::Granted(). The caller must hold the queue latch. */
+  void MarkGranted(LockMetrics::Resource resource, LockRequest *lock_request, uint64_t requested_at,
+                   uint64_t wait_start) {
+    lock_request->granted_ = true;
+    lock_request->granted_at_ = metrics_.Granted(resource, static_cast<size_t>(lock_request->lock_mode_),
+                                                 lock_request->oid_, lock_request->rid_, requested_at, wait_start);
+  }
+
+  /** Record a request given up while it waited, see LockMetrics::Failed() */
+  void MarkFailed(LockMetrics::Resource resource, const LockRequest *lock_request, uint64_t wait_start) {
+    metrics_.Failed(resource, static_cast<size_t>(lock_request->lock_mode_), lock_request->oid_, lock_request->rid_,
+                    wait_start);
+  }
+
+  /** The resource of a key lock */
+  struct IndexKey {
+    index_oid_t index_oid_;
+    int64_t key_;
+
+    auto operator==(const IndexKey &other) const -> bool {
+      return index_oid_ == other.index_oid_ && key_ == other.key_;
     }
-    active_set_.insert(txn_id);
-
-    std::vector<txn_id_t> &next_node_vector = waits_for_[txn_id];//ڽӵ飬֮ǰĹͼȡ
-    std::sort(next_node_vector.begin(), next_node_vector.end());
-    //ڽӵ
-    for (txn_id_t const next_node : next_node_vector) {
-      if (active_set_.find(next_node) != active_set_.end()) { //ڽӵڻԾ棬˵յĶ㣬
-        return true;
-      }
-      if (Dfs(next_node)) {
-        return true;
-      }
+  };
+
+  struct IndexKeyHash {
+    auto operator()(const IndexKey &index_key) const -> size_t {
+      return std::hash<int64_t>()(index_key.key_) ^ (static_cast<size_t>(index_key.index_oid_) << 48);
     }
-    //ʾڽӵûҵӦڻԾϣҪɾ뵽ȫļ
-    active_set_.erase(txn_id);
-    safe_set_.insert(txn_id);
-    return false;
+  };
+
+  static auto PartitionIndex(size_t hash) -> size_t {
+    return (hash * 0x9E3779B97F4A7C15ULL) >> (64 - LOCK_TABLE_PARTITION_BITS);
+  }
+
+  auto TablePartition(table_oid_t oid) -> LockTablePartition<table_oid_t, std::hash<table_oid_t>> & {
+    return table_lock_partitions_[PartitionIndex(oid)];
   }
 
-  auto DeleteNode(txn_id_t txn_id) -> void;
+  auto RowPartition(const RID &rid) -> LockTablePartition<RID, std::hash<RID>> & {
+    return row_lock_partitions_[PartitionIndex(std::hash<RID>()(rid))];
+  }
+
+  auto KeyPartition(const IndexKey &index_key) -> LockTablePartition<IndexKey, IndexKeyHash> & {
+    return key_lock_partitions_[PartitionIndex(IndexKeyHash()(index_key))];
+  }
 
- private:
   /** Fall 2022 */
-  /** Structure that holds lock requests for a given table oid */
-  std::unordered_map<table_oid_t, std::shared_ptr<LockRequestQueue>> table_lock_map_;//ϣ
-  /** Coordination */
-  std::mutex table_lock_map_latch_;
-
-  /** Structure that holds lock requests for a given RID */
-  std::unordered_map<RID, std::shared_ptr<LockRequestQueue>> row_lock_map_;//ϣ
-  /** Coordination */
-  std::mutex row_lock_map_latch_;
-
-  std::atomic<bool> enable_cycle_detection_;  //Ƿ
-  std::thread *cycle_detection_thread_;
+  /** Lock requests for table oids, partitioned by oid */
+  std::array<LockTablePartition<table_oid_t, std::hash<table_oid_t>>, LOCK_TABLE_PARTITIONS> table_lock_partitions_;//ϣ
+
+  /** Lock requests for RIDs, partitioned by RID */
+  std::array<LockTablePartition<RID, std::hash<RID>>, LOCK_TABLE_PARTITIONS> row_lock_partitions_;//ϣ
+
+  /** Lock requests for index keys, partitioned by key */
+  std::array<LockTablePartition<IndexKey, IndexKeyHash>, LOCK_TABLE_PARTITIONS> key_lock_partitions_;
+
   /** Waits-for graph representation. */
   //ȴͼ   ߱ʾ T1ָT2 ʾT1ȴT2ͷ
   std::unordered_map<txn_id_t, std::vector<txn_id_t>> waits_for_;
   std::mutex waits_for_latch_;
 
-  std::set<txn_id_t> safe_set_;//ȫ
-  std::set<txn_id_t> txn_set_; //ID
-  std::unordered_set<txn_id_t> active_set_;//Ծ񼯺
+  /** The queue each transaction in waits_for_ is sleeping on, to wake it up when it is aborted */
+  std::unordered_map<txn_id_t, LockRequestQueue *> waiting_queue_;
 
-  std::unordered_map<txn_id_t, RID> map_txn_rid_;
-  std::unordered_map<txn_id_t, table_oid_t> map_txn_oid_;  //  δȨ
+  LockMetrics metrics_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,176 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_metrics.h
+//
+// Identification: src/include/concurrency/lock_metrics.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+using table_oid_t = uint32_t;
+
+/**
+ * Counters and latency histograms of a lock manager and the transactions using it.
+ *
+ * Every lock request updates a few relaxed atomics, so the metrics stay on while benchmarks run; requests that had to
+ * wait also update the contention of their table or row under a latch, which costs little next to the wait. Nothing
+ * is recorded while `enable_lock_metrics` is off.
+ */
+class LockMetrics {
+ public:
+  /** The kinds of locked resources */
+  enum class Resource { TABLE, ROW, KEY };
+
+  static constexpr size_t RESOURCES = 3;
+  /** Lock modes in the order of LockManager::LockMode */
+  static constexpr size_t MODES = 5;
+  static constexpr std::array<const char *, RESOURCES> RESOURCE_NAMES{"table", "row", "key"};
+  static constexpr std::array<const char *, MODES> MODE_NAMES{"S", "X", "IS", "IX", "SIX"};
+  /** Rows whose contention is tracked at most; waits for other rows only count towards their table and mode */
+  static constexpr size_t MAX_CONTENDED_ROWS = 10000;
+
+  /** A latency histogram with a bucket per power of two nanoseconds */
+  class Histogram {
+   public:
+    static constexpr size_t BUCKETS = 48;
+
+    void Record(uint64_t nanos);
+    auto Count() const -> uint64_t;
+    auto TotalNanos() const -> uint64_t { return total_nanos_.load(std::memory_order_relaxed); }
+    /** @return the upper bound in nanoseconds of the bucket that holds the given fraction of the samples, 0 if empty */
+    auto Percentile(double fraction) const -> uint64_t;
+    void Reset();
+
+   private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> total_nanos_{0};
+  };
+
+  /** What happened to the requests for one lock mode on one kind of resource */
+  struct ModeMetrics {
+    /** Requests granted, including upgrades */
+    std::atomic<uint64_t> acquired_{0};
+    /** Granted requests that had to wait */
+    std::atomic<uint64_t> waited_{0};
+    /** Requests given up because the transaction was aborted while it waited */
+    std::atomic<uint64_t> failed_{0};
+    /** Upgrades of a held lock to this mode */
+    std::atomic<uint64_t> upgrades_{0};
+    /** From the request to the grant */
+    Histogram acquire_;
+    /** From the request to the grant, of the requests that waited */
+    Histogram wait_;
+    /** From the grant to the release */
+    Histogram hold_;
+  };
+
+  /** The waits for one table or row */
+  struct Contention {
+    uint64_t waits_{0};
+    uint64_t wait_nanos_{0};
+  };
+
+  /** @return nanoseconds on a steady clock, 0 if metrics are off */
+  static auto Now() -> uint64_t;
+
+  /**
+   * Records that a request could not be granted right away, before it waits or, e.g. under WAIT_DIE, gives up.
+   * @param queue_length the number of requests in the queue, including the waiting one
+   * @return the time the wait began
+   */
+  auto Waiting(size_t queue_length) -> uint64_t;
+
+  /**
+   * Records a granted request.
+   * @param oid the table of a table or row lock
+   * @param rid the row of a row lock
+   * @param requested_at when the request was made, see Now()
+   * @param wait_start when the request first went to sleep, 0 if it did not, see Waiting()
+   * @return the time of the grant, to be passed to Released()
+   */
+  auto Granted(Resource resource, size_t mode, table_oid_t oid, const RID &rid, uint64_t requested_at,
+               uint64_t wait_start) -> uint64_t;
+
+  /** Records a request that was given up while it waited, see Granted() */
+  void Failed(Resource resource, size_t mode, table_oid_t oid, const RID &rid, uint64_t wait_start);
+
+  /** Records an upgrade of a held lock, before it is granted */
+  void Upgrading(Resource resource, size_t mode) { Mode(resource, mode).upgrades_.fetch_add(1, Relaxed()); }
+
+  /** Records a released lock granted at `granted_at` */
+  void Released(Resource resource, size_t mode, uint64_t granted_at);
+
+  auto Mode(Resource resource, size_t mode) -> ModeMetrics & {
+    return modes_[static_cast<size_t>(resource) * MODES + mode];
+  }
+
+  auto Mode(Resource resource, size_t mode) const -> const ModeMetrics & {
+    return modes_[static_cast<size_t>(resource) * MODES + mode];
+  }
+
+  /** @return the tables with the most waits, most first */
+  auto TopTables(size_t n) -> std::vector<std::pair<table_oid_t, Contention>>;
+
+  /** @return the rows with the most waits, most first */
+  auto TopRows(size_t n) -> std::vector<std::pair<RID, Contention>>;
+
+  /** @return all counters, percentiles and the top contended resources as one JSON object */
+  auto ToJson(size_t top = 10) -> std::string;
+
+  /** Clears everything, e.g. between the phases of a benchmark */
+  void Reset();
+
+  /** Requests that could not be granted right away, and the sum of the lengths of their queues at that time */
+  std::atomic<uint64_t> waits_{0};
+  std::atomic<uint64_t> waiting_queue_length_{0};
+  std::atomic<uint64_t> max_queue_length_{0};
+  /** Upgrades refused because another transaction was upgrading the same lock */
+  std::atomic<uint64_t> upgrade_conflicts_{0};
+  /** Row locks escalated to a table lock */
+  std::atomic<uint64_t> escalations_{0};
+  /** Cycles found by deadlock detection, each of which aborted one transaction */
+  std::atomic<uint64_t> deadlocks_{0};
+  /** Transactions that died rather than wait for an older one under WAIT_DIE */
+  std::atomic<uint64_t> wait_die_aborts_{0};
+  /** Newer transactions aborted by an older one under WOUND_WAIT */
+  std::atomic<uint64_t> wounds_{0};
+  /** OPTIMISTIC transactions aborted because a lock was not free */
+  std::atomic<uint64_t> no_wait_aborts_{0};
+
+  std::atomic<uint64_t> committed_txns_{0};
+  std::atomic<uint64_t> aborted_txns_{0};
+  /** OPTIMISTIC transactions aborted at commit, counted in aborted_txns_ too */
+  std::atomic<uint64_t> validation_failures_{0};
+
+  static constexpr auto Relaxed() -> std::memory_order { return std::memory_order_relaxed; }
+
+ private:
+  void Contended(Resource resource, table_oid_t oid, const RID &rid, uint64_t wait_nanos);
+
+  std::array<ModeMetrics, RESOURCES * MODES> modes_;
+
+  std::mutex contention_latch_;
+  std::unordered_map<table_oid_t, Contention> contended_tables_;
+  std::unordered_map<RID, Contention> contended_rows_;
+};
+
+}  // namespace bustub
@@ -19,6 +19,8 @@
 #include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/logger.h"
@@ -46,8 +48,16 @@ enum class TransactionState { GROWING, SHRINKING, COMMITTED, ABORTED };
 
 /**
  * Transaction isolation level.
+ *
+ * SNAPSHOT_ISOLATION reads the versions committed before the transaction began without taking row locks; its writes
+ * still take exclusive locks and abort if the row was changed after the snapshot (first updater wins).
+ *
+ * OPTIMISTIC reads its snapshot like SNAPSHOT_ISOLATION and records what it read. It never waits for a lock, a lock
+ * it cannot get right away aborts it. Its writes stay invisible to other snapshots until it commits, and the commit
+ * fails if anything it read was changed by a commit after its snapshot (backward validation), which makes it
+ * serializable.
  */
-enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED };
+enum class IsolationLevel { READ_UNCOMMITTED, REPEATABLE_READ, READ_COMMITTED, SNAPSHOT_ISOLATION, OPTIMISTIC };
 
 /**
  * Type of write operation.
@@ -84,6 +94,17 @@ class IndexWriteRecord {
                    Catalog *catalog)
       : rid_(rid), table_oid_(table_oid), wtype_(wtype), tuple_(tuple), index_oid_(index_oid), catalog_(catalog) {}
 
+  /** A record of an index entry written with `key`, which a rollback uses without building it from `tuple` again */
+  IndexWriteRecord(RID rid, table_oid_t table_oid, WType wtype, const Tuple &tuple, index_oid_t index_oid,
+                   Catalog *catalog, const Tuple &key)
+      : rid_(rid),
+        table_oid_(table_oid),
+        wtype_(wtype),
+        tuple_(tuple),
+        index_oid_(index_oid),
+        catalog_(catalog),
+        key_(key) {}
+
   /** The rid is the value stored in the index. */
   RID rid_;
   /** Table oid. */
@@ -98,6 +119,8 @@ class IndexWriteRecord {
   index_oid_t index_oid_;
   /** The catalog contains metadata required to locate index. */
   Catalog *catalog_;
+  /** The key of an inserted or deleted entry as it was written, empty if it is built from `tuple_` */
+  Tuple key_;
 };
 
 /**
@@ -124,9 +147,9 @@ class TransactionAbortException : public std::exception {
  public:
   explicit TransactionAbortException(txn_id_t txn_id, AbortReason abort_reason)
       : txn_id_(txn_id), abort_reason_(abort_reason) {}
-  auto GetTransactionId() -> txn_id_t { return txn_id_; }
-  auto GetAbortReason() -> AbortReason { return abort_reason_; }
-  auto GetInfo() -> std::string {
+  auto GetTransactionId() const -> txn_id_t { return txn_id_; }
+  auto GetAbortReason() const -> AbortReason { return abort_reason_; }
+  auto GetInfo() const -> std::string {
     switch (abort_reason_) {
       case AbortReason::LOCK_ON_SHRINKING:
         return "Transaction " + std::to_string(txn_id_) +
@@ -155,6 +178,10 @@ class TransactionAbortException : public std::exception {
 
 /**
  * Transaction tracks information related to a transaction.
+ *
+ * Most transactions are short and touch few rows, so setting one up must be cheap. The lock sets are stored inline and
+ * allocate nothing until a lock is taken, the write and page sets are only allocated when they are first used, and the
+ * memory of finished transactions is recycled for the next ones.
  */
 class Transaction {
  public:
@@ -162,27 +189,18 @@ class Transaction {
       : isolation_level_(isolation_level),
         thread_id_(std::this_thread::get_id()),
         txn_id_(txn_id),
-        prev_lsn_(INVALID_LSN),
-        shared_lock_set_{new std::unordered_set<RID>},
-        exclusive_lock_set_{new std::unordered_set<RID>},
-        s_table_lock_set_{new std::unordered_set<table_oid_t>},
-        x_table_lock_set_{new std::unordered_set<table_oid_t>},
-        is_table_lock_set_{new std::unordered_set<table_oid_t>},
-        ix_table_lock_set_{new std::unordered_set<table_oid_t>},
-        six_table_lock_set_{new std::unordered_set<table_oid_t>},
-        s_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>},
-        x_row_lock_set_{new std::unordered_map<table_oid_t, std::unordered_set<RID>>} {
-    // Initialize the sets that will be tracked.
-    table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
-    index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
-    page_set_ = std::make_shared<std::deque<bustub::Page *>>();
-    deleted_page_set_ = std::make_shared<std::unordered_set<page_id_t>>();
-  }
+        prev_lsn_(INVALID_LSN) {}
 
   ~Transaction() = default;
 
   DISALLOW_COPY(Transaction);
 
+  /** Allocate a transaction, reusing the memory of one freed earlier on the same thread if there is any. */
+  static auto operator new(size_t size) -> void *;
+
+  /** Free a transaction, keeping its memory around for the next one allocated on this thread. */
+  static void operator delete(void *ptr, size_t size);
+
   /** @return the id of the thread running the transaction */
   inline auto GetThreadId() const -> std::thread::id { return thread_id_; }
 
@@ -192,21 +210,64 @@ class Transaction {
   /** @return the isolation level of this transaction */
   inline auto GetIsolationLevel() const -> IsolationLevel { return isolation_level_; }
 
+  /** @return true if the transaction reads a snapshot instead of locking the rows it reads */
+  inline auto ReadsSnapshot() const -> bool {
+    return isolation_level_ == IsolationLevel::SNAPSHOT_ISOLATION || isolation_level_ == IsolationLevel::OPTIMISTIC;
+  }
+
+  /** @return the commit timestamp of the snapshot this transaction reads */
+  inline auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  /**
+   * Set the read timestamp of the transaction.
+   * @param read_ts the commit timestamp of the snapshot
+   */
+  inline void SetReadTs(timestamp_t read_ts) { read_ts_ = read_ts; }
+
   /** @return the list of table write records of this transaction */
-  inline auto GetWriteSet() -> std::shared_ptr<std::deque<TableWriteRecord>> { return table_write_set_; }
+  inline auto GetWriteSet() -> std::shared_ptr<std::deque<TableWriteRecord>> { return Lazy(&table_write_set_); }
 
   /** @return the list of index write records of this transaction */
-  inline auto GetIndexWriteSet() -> std::shared_ptr<std::deque<IndexWriteRecord>> { return index_write_set_; }
+  inline auto GetIndexWriteSet() -> std::shared_ptr<std::deque<IndexWriteRecord>> {
+    return Lazy(&index_write_set_);
+  }
+
+  /** @return true if the transaction has no write records, without allocating its write sets */
+  inline auto IsReadOnly() const -> bool {
+    return (table_write_set_ == nullptr || table_write_set_->empty()) &&
+           (index_write_set_ == nullptr || index_write_set_->empty());
+  }
+
+  /** @return the rows an OPTIMISTIC transaction read, validated when it commits */
+  inline auto GetReadSet() -> std::shared_ptr<std::vector<std::pair<TableHeap *, RID>>> { return Inline(&read_set_); }
+
+  /** @return the tables an OPTIMISTIC transaction scanned, validated as a whole when it commits */
+  inline auto GetReadTableSet() -> std::shared_ptr<std::unordered_set<TableHeap *>> {
+    return Inline(&read_table_set_);
+  }
+
+  /**
+   * Adds a row to the read set.
+   * @param table the table the row belongs to
+   * @param rid the row read
+   */
+  inline void AppendReadRecord(TableHeap *table, const RID &rid) { read_set_.emplace_back(table, rid); }
+
+  /**
+   * Adds a table to the read table set, e.g. for a scan that could miss rows inserted after the snapshot.
+   * @param table the table read
+   */
+  inline void AddIntoReadTableSet(TableHeap *table) { read_table_set_.insert(table); }
 
   /** @return the page set */
-  inline auto GetPageSet() -> std::shared_ptr<std::deque<Page *>> { return page_set_; }
+  inline auto GetPageSet() -> std::shared_ptr<std::deque<Page *>> { return Lazy(&page_set_); }
 
   /**
    * Adds a tuple write record into the table write set.
    * @param write_record write record to be added
    */
   inline void AppendTableWriteRecord(const TableWriteRecord &write_record) {
-    table_write_set_->push_back(write_record);
+    GetWriteSet()->push_back(write_record);
   }
 
   /**
@@ -214,59 +275,70 @@ class Transaction {
    * @param write_record write record to be added
    */
   inline void AppendIndexWriteRecord(const IndexWriteRecord &write_record) {
-    index_write_set_->push_back(write_record);
+    GetIndexWriteSet()->push_back(write_record);
   }
 
   /**
    * Adds a page into the page set.
    * @param page page to be added
    */
-  inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(Page *page) { GetPageSet()->push_back(page); }
 
   /** @return the deleted page set */
-  inline auto GetDeletedPageSet() -> std::shared_ptr<std::unordered_set<page_id_t>> { return deleted_page_set_; }
+  inline auto GetDeletedPageSet() -> std::shared_ptr<std::unordered_set<page_id_t>> {
+    return Inline(&deleted_page_set_);
+  }
 
   /**
    * Adds a page to the deleted page set.
    * @param page_id id of the page to be marked as deleted
    */
-  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_->insert(page_id); }
+  inline void AddIntoDeletedPageSet(page_id_t page_id) { deleted_page_set_.insert(page_id); }
 
   /** @return the set of resources under a shared lock */
-  inline auto GetSharedLockSet() -> std::shared_ptr<std::unordered_set<RID>> { return shared_lock_set_; }
+  inline auto GetSharedLockSet() -> std::shared_ptr<std::unordered_set<RID>> { return Inline(&shared_lock_set_); }
 
   /** @return the set of rows under a shared lock */
   inline auto GetSharedRowLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> {
-    return s_row_lock_set_;
+    return Inline(&s_row_lock_set_);
   }
 
   /** @return the set of resources under an exclusive lock */
-  inline auto GetExclusiveLockSet() -> std::shared_ptr<std::unordered_set<RID>> { return exclusive_lock_set_; }
+  inline auto GetExclusiveLockSet() -> std::shared_ptr<std::unordered_set<RID>> {
+    return Inline(&exclusive_lock_set_);
+  }
 
   /** @return the set of rows in under an exclusive lock */
   inline auto GetExclusiveRowLockSet() -> std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> {
-    return x_row_lock_set_;
+    return Inline(&x_row_lock_set_);
+  }
+
+  /** @return the set of index keys under a key lock of any mode */
+  inline auto GetKeyLockSet() -> std::shared_ptr<std::unordered_map<index_oid_t, std::unordered_set<int64_t>>> {
+    return Inline(&key_lock_set_);
   }
 
   /** @return the set of resources under a shared lock */
-  inline auto GetSharedTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> { return s_table_lock_set_; }
+  inline auto GetSharedTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
+    return Inline(&s_table_lock_set_);
+  }
   inline auto GetExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return x_table_lock_set_;
+    return Inline(&x_table_lock_set_);
   }
   inline auto GetIntentionSharedTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return is_table_lock_set_;
+    return Inline(&is_table_lock_set_);
   }
   inline auto GetIntentionExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return ix_table_lock_set_;
+    return Inline(&ix_table_lock_set_);
   }
   inline auto GetSharedIntentionExclusiveTableLockSet() -> std::shared_ptr<std::unordered_set<table_oid_t>> {
-    return six_table_lock_set_;
+    return Inline(&six_table_lock_set_);
   }
 
   /** @return true if rid (belong to table oid) is shared locked by this transaction */
   auto IsRowSharedLocked(const table_oid_t &oid, const RID &rid) -> bool {
-    auto row_lock_set = s_row_lock_set_->find(oid);
-    if (row_lock_set == s_row_lock_set_->end()) {
+    auto row_lock_set = s_row_lock_set_.find(oid);
+    if (row_lock_set == s_row_lock_set_.end()) {
       return false;
     }
     return row_lock_set->second.find(rid) != row_lock_set->second.end();
@@ -274,31 +346,31 @@ class Transaction {
 
   /** @return true if rid (belong to table oid) is exclusive locked by this transaction */
   auto IsRowExclusiveLocked(const table_oid_t &oid, const RID &rid) -> bool {
-    auto row_lock_set = x_row_lock_set_->find(oid);
-    if (row_lock_set == x_row_lock_set_->end()) {
+    auto row_lock_set = x_row_lock_set_.find(oid);
+    if (row_lock_set == x_row_lock_set_.end()) {
       return false;
     }
     return row_lock_set->second.find(rid) != row_lock_set->second.end();
   }
 
   auto IsTableIntentionSharedLocked(const table_oid_t &oid) -> bool {
-    return is_table_lock_set_->find(oid) != is_table_lock_set_->end();
+    return is_table_lock_set_.find(oid) != is_table_lock_set_.end();
   }
 
   auto IsTableSharedLocked(const table_oid_t &oid) -> bool {
-    return s_table_lock_set_->find(oid) != s_table_lock_set_->end();
+    return s_table_lock_set_.find(oid) != s_table_lock_set_.end();
   }
 
   auto IsTableIntentionExclusiveLocked(const table_oid_t &oid) -> bool {
-    return ix_table_lock_set_->find(oid) != ix_table_lock_set_->end();
+    return ix_table_lock_set_.find(oid) != ix_table_lock_set_.end();
   }
 
   auto IsTableExclusiveLocked(const table_oid_t &oid) -> bool {
-    return x_table_lock_set_->find(oid) != x_table_lock_set_->end();
+    return x_table_lock_set_.find(oid) != x_table_lock_set_.end();
   }
 
   auto IsTableSharedIntentionExclusiveLocked(const table_oid_t &oid) -> bool {
-    return six_table_lock_set_->find(oid) != six_table_lock_set_->end();
+    return six_table_lock_set_.find(oid) != six_table_lock_set_.end();
   }
 
   /** @return the current state of the transaction */
@@ -324,6 +396,24 @@ class Transaction {
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
  private:
+  /**
+   * The sets are owned by the transaction; the shared pointers handed out for them do not own anything and must not
+   * outlive it.
+   */
+  template <typename T>
+  static auto Inline(T *set) -> std::shared_ptr<T> {
+    return std::shared_ptr<T>(std::shared_ptr<T>(), set);
+  }
+
+  /** Allocate a set on first use. */
+  template <typename T>
+  static auto Lazy(std::unique_ptr<T> *set) -> std::shared_ptr<T> {
+    if (*set == nullptr) {
+      *set = std::make_unique<T>();
+    }
+    return Inline(set->get());
+  }
+
   /** The current transaction state. */
   TransactionState state_{TransactionState::GROWING};
   /** The isolation level of the transaction. */
@@ -332,36 +422,44 @@ class Transaction {
   std::thread::id thread_id_;
   /** The ID of this transaction. */
   txn_id_t txn_id_;
+  /** The snapshot read by a SNAPSHOT_ISOLATION transaction: every version committed at or before this timestamp. */
+  timestamp_t read_ts_{INVALID_TS};
 
   /** The undo set of table tuples. */
-  std::shared_ptr<std::deque<TableWriteRecord>> table_write_set_;
+  std::unique_ptr<std::deque<TableWriteRecord>> table_write_set_;
   /** The undo set of indexes. */
-  std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
+  std::unique_ptr<std::deque<IndexWriteRecord>> index_write_set_;
+  /** The rows and tables an OPTIMISTIC transaction read. */
+  std::vector<std::pair<TableHeap *, RID>> read_set_;
+  std::unordered_set<TableHeap *> read_table_set_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
 
   std::mutex latch_;
 
   /** Concurrent index: the pages that were latched during index operation. */
-  std::shared_ptr<std::deque<Page *>> page_set_;
+  std::unique_ptr<std::deque<Page *>> page_set_;
   /** Concurrent index: the page IDs that were deleted during index operation.*/
-  std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
+  std::unordered_set<page_id_t> deleted_page_set_;
 
   /** LockManager: the set of shared-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> shared_lock_set_;
+  std::unordered_set<RID> shared_lock_set_;
   /** LockManager: the set of exclusive-locked tuples held by this transaction. */
-  std::shared_ptr<std::unordered_set<RID>> exclusive_lock_set_;
+  std::unordered_set<RID> exclusive_lock_set_;
 
   /** LockManager: the set of table locks held by this transaction. */
-  std::shared_ptr<std::unordered_set<table_oid_t>> s_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> x_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> is_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> ix_table_lock_set_;
-  std::shared_ptr<std::unordered_set<table_oid_t>> six_table_lock_set_;
+  std::unordered_set<table_oid_t> s_table_lock_set_;
+  std::unordered_set<table_oid_t> x_table_lock_set_;
+  std::unordered_set<table_oid_t> is_table_lock_set_;
+  std::unordered_set<table_oid_t> ix_table_lock_set_;
+  std::unordered_set<table_oid_t> six_table_lock_set_;
 
   /** LockManager: the set of row locks held by this transaction. */
-  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> s_row_lock_set_;
-  std::shared_ptr<std::unordered_map<table_oid_t, std::unordered_set<RID>>> x_row_lock_set_;
+  std::unordered_map<table_oid_t, std::unordered_set<RID>> s_row_lock_set_;
+  std::unordered_map<table_oid_t, std::unordered_set<RID>> x_row_lock_set_;
+
+  /** LockManager: the set of key locks held by this transaction. */
+  std::unordered_map<index_oid_t, std::unordered_set<int64_t>> key_lock_set_;
 };
 
 }  // namespace bustub
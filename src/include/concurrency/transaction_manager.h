@@ -12,10 +12,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <map>
+#include <mutex>  // NOLINT
 #include <shared_mutex>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -24,16 +31,25 @@
 
 namespace bustub {
 class LockManager;
+class TableHeap;
 
 /**
  * TransactionManager keeps track of all the transactions running in the system.
+ *
+ * It is also the timestamp oracle of snapshot isolation. Commits are numbered in order: a committing transaction
+ * stamps its tuple versions with the next commit timestamp under the commit latch, and a SNAPSHOT_ISOLATION transaction
+ * reads everything committed at or before the last commit timestamp when it began. The oldest snapshot still active
+ * is the watermark; versions older than it are dropped at commit or by the background garbage collector.
+ *
+ * An OPTIMISTIC transaction reads a snapshot the same way. When it commits, it checks under the commit latch that no
+ * commit since its snapshot changed a row it read or, for a scan, any row of the table; otherwise it is aborted.
  */
 class TransactionManager {
  public:
   explicit TransactionManager(LockManager *lock_manager, LogManager *log_manager = nullptr)
       : lock_manager_(lock_manager), log_manager_(log_manager) {}
 
-  ~TransactionManager() = default;
+  ~TransactionManager() { StopGarbageCollection(); }
 
   /**
    * Begins a new transaction.
@@ -47,8 +63,9 @@ class TransactionManager {
   /**
    * Commits a transaction.
    * @param txn the transaction to commit
+   * @return false if the transaction is OPTIMISTIC and failed validation, in which case it was aborted instead
    */
-  void Commit(Transaction *txn);
+  auto Commit(Transaction *txn) -> bool;
 
   /**
    * Aborts a transaction
@@ -56,27 +73,42 @@ class TransactionManager {
    */
   void Abort(Transaction *txn);
 
+  /** A shard of the global list of running transactions, which holds the transactions whose ids map to it. */
+  struct TxnMapShard {
+    std::shared_mutex latch_;
+    std::unordered_map<txn_id_t, Transaction *> txns_;
+  };
+
   /**
-   * Global list of running transactions
+   * The transaction map is a global list of all the running transactions in the system. Transaction ids are handed
+   * out in order, so sharding by the low bits of the id spreads the transactions that begin and finish together.
    */
-
-  /** The transaction map is a global list of all the running transactions in the system. */
-  static std::unordered_map<txn_id_t, Transaction *> txn_map;
-  static std::shared_mutex txn_map_mutex;
+  static std::array<TxnMapShard, 1 << TXN_MAP_SHARD_BITS> txn_map;
 
   /**
    * Locates and returns the transaction with the given transaction ID.
-   * @param txn_id the id of the transaction to be found, it must exist!
-   * @return the transaction with the given transaction id
+   * @param txn_id the id of the transaction to be found
+   * @return the transaction with the given transaction id, or nullptr if it has already finished
    */
   static auto GetTransaction(txn_id_t txn_id) -> Transaction * {
-    std::shared_lock<std::shared_mutex> l(TransactionManager::txn_map_mutex);
-    assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
-    auto *res = TransactionManager::txn_map[txn_id];
-    assert(res != nullptr);
-    return res;
+    auto &shard = TxnMapShardOf(txn_id);
+    std::shared_lock<std::shared_mutex> l(shard.latch_);
+    auto iter = shard.txns_.find(txn_id);
+    return iter == shard.txns_.end() ? nullptr : iter->second;
   }
 
+  /** @return the commit timestamp of the oldest active snapshot, or of the last commit if there is none */
+  auto GetWatermark() -> timestamp_t;
+
+  /** Drop the tuple versions that no active snapshot reads from every table that has some. */
+  void GarbageCollect();
+
+  /** Start collecting garbage every `version_gc_interval` in a background thread. */
+  void StartGarbageCollection();
+
+  /** Stop the background garbage collector, before the tables it collects are destroyed. */
+  void StopGarbageCollection();
+
   /** Prevents all transactions from performing operations, used for checkpointing. */
   void BlockAllTransactions();
 
@@ -84,6 +116,16 @@ class TransactionManager {
   void ResumeTransactions();
 
  private:
+  static auto TxnMapShardOf(txn_id_t txn_id) -> TxnMapShard & {
+    return txn_map[static_cast<uint32_t>(txn_id) & ((1 << TXN_MAP_SHARD_BITS) - 1)];
+  }
+
+  /** Add a transaction to the transaction map when it begins */
+  static void RegisterTransaction(Transaction *txn);
+
+  /** Remove a transaction from the transaction map once it has released its locks */
+  static void UnregisterTransaction(Transaction *txn);
+
   /**
    * Releases all the locks held by the given transaction.
    * @param txn the transaction whose locks should be released
@@ -103,6 +145,14 @@ class TransactionManager {
       }
     }
 
+    /** Drop all key locks */
+    std::vector<std::pair<index_oid_t, int64_t>> key_lock_set;
+    for (const auto &[index_oid, keys] : *txn->GetKeyLockSet()) {
+      for (auto key : keys) {
+        key_lock_set.emplace_back(index_oid, key);
+      }
+    }
+
     /** Drop all table locks */
     std::unordered_set<table_oid_t> table_lock_set;
     for (auto oid : *txn->GetSharedTableLockSet()) {
@@ -129,12 +179,54 @@ class TransactionManager {
       }
     }
 
+    for (const auto &[index_oid, key] : key_lock_set) {
+      lock_manager_->UnlockKey(txn, index_oid, key);
+    }
+
     for (auto oid : table_lock_set) {
       lock_manager_->UnlockTable(txn, oid);
     }
   }
 
+  /**
+   * Stamp the versions of a committing transaction, end its snapshot, and collect the versions no snapshot reads.
+   * @return false if an OPTIMISTIC transaction failed validation, nothing was changed then
+   */
+  auto CommitWrites(Transaction *txn) -> bool;
+
+  /**
+   * Backward validation of an OPTIMISTIC transaction, under the commit latch.
+   * @return true if no row or table it read was changed by a commit after its snapshot
+   */
+  auto Validate(Transaction *txn) -> bool;
+
+  /** Remove a finished transaction's snapshot from the active ones */
+  void EndSnapshot(Transaction *txn);
+
+  /** Undo the table writes of an aborting transaction, newest first, one table and one page at a time */
+  void RollbackTableWrites(Transaction *txn);
+
+  /** Undo the index writes of an aborting transaction, newest first, one index at a time */
+  void RollbackIndexWrites(Transaction *txn);
+
   std::atomic<txn_id_t> next_txn_id_{0};
+
+  /** The commit timestamp of the last committed transaction */
+  std::atomic<timestamp_t> last_commit_ts_{0};
+  /** Makes stamping the versions of a commit and publishing its timestamp atomic */
+  std::mutex commit_latch_;
+  /** Protects `active_snapshots_` */
+  std::mutex snapshot_latch_;
+  /** The number of active SNAPSHOT_ISOLATION transactions per read timestamp */
+  std::map<timestamp_t, size_t> active_snapshots_;
+
+  /** Protects `versioned_tables_` */
+  std::mutex gc_latch_;
+  /** Tables that kept versions after a commit, collected by the background garbage collector */
+  std::unordered_set<TableHeap *> versioned_tables_;
+  std::atomic<bool> enable_gc_{false};
+  std::condition_variable gc_cv_;
+  std::thread gc_thread_;
   LockManager *lock_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
 
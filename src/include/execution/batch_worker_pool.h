@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// batch_worker_pool.h
+//
+// Identification: src/include/execution/batch_worker_pool.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "execution/executors/abstract_executor.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * BatchWorkerPool hands the tuples of a child executor to worker threads, a batch at a time.
+ *
+ * The calling thread pulls batches from the child and queues them, at most two per worker, so that a slow worker
+ * throttles the child instead of letting the queue grow. Every worker takes the next queued batch until the child is
+ * drained. The first exception thrown by the child or a worker stops every worker and is rethrown by Run().
+ */
+class BatchWorkerPool {
+ public:
+  /** Called on worker `worker` with one batch of tuples */
+  using ProcessFn = std::function<void(size_t worker, const std::vector<Tuple> &tuples)>;
+  /** Called on worker `worker` once the child is drained */
+  using FinishFn = std::function<void(size_t worker)>;
+
+  /**
+   * @param num_workers The number of worker threads
+   * @param batch_size The number of tuples pulled from the child at a time
+   */
+  BatchWorkerPool(size_t num_workers, size_t batch_size) : num_workers_(num_workers), batch_size_(batch_size) {}
+
+  /**
+   * Pull up to `batch_size` tuples from the child.
+   * @return the tuples, fewer than `batch_size` only once the child is drained
+   */
+  static auto ReadBatch(AbstractExecutor *child, size_t batch_size) -> std::vector<Tuple>;
+
+  /**
+   * Start the workers, feed them the rest of the child and wait for all of them to finish.
+   * @param child The child executor
+   * @param batch The first batch of tuples, already pulled from the child
+   * @param process Called for every batch, on the worker that took it
+   * @param finish Called on every worker that did not fail, after its last batch; may be empty
+   */
+  void Run(AbstractExecutor *child, std::vector<Tuple> batch, const ProcessFn &process,
+           const FinishFn &finish = nullptr);
+
+ private:
+  size_t num_workers_;
+  size_t batch_size_;
+};
+
+}  // namespace bustub
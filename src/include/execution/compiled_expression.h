@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_expression.h
+//
+// Identification: src/include/execution/compiled_expression.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * CompiledExpression is an expression tree flattened into a postfix program over a small stack of int64 registers.
+ *
+ * Column loads are resolved to raw byte offsets into the tuple image and specialized by width, so evaluating a
+ * predicate such as `#0.1 < 10 AND #0.2 = #0.3` reads the tuple bytes directly and never materializes a `Value` or
+ * goes through `Type::GetInstance`. BOOLEAN and integer (TINYINT/SMALLINT/INTEGER/BIGINT) sub-trees are compiled;
+ * anything else (e.g. a comparison of VARCHARs) becomes a single instruction that calls back into the tree. If the
+ * root itself does not produce a BOOLEAN or integer, the whole tree is evaluated the usual way.
+ *
+ * A compiled expression holds no mutable state and may be evaluated by several threads at once. It keeps a pointer to
+ * the source expression and the schemas, which must outlive it.
+ */
+class CompiledExpression {
+ public:
+  /**
+   * Compile an expression evaluated over the tuples of one schema (`AbstractExpression::Evaluate`).
+   * @param expr The expression
+   * @param schema The schema of the input tuples
+   */
+  CompiledExpression(const AbstractExpression *expr, const Schema &schema);
+
+  /**
+   * Compile an expression evaluated over a pair of tuples (`AbstractExpression::EvaluateJoin`).
+   * @param expr The expression
+   * @param left_schema The schema of the left input tuples
+   * @param right_schema The schema of the right input tuples
+   */
+  CompiledExpression(const AbstractExpression *expr, const Schema &left_schema, const Schema &right_schema);
+
+  /** @return the value of the expression for a tuple */
+  auto Evaluate(const Tuple *tuple) const -> Value;
+
+  /** @return the value of the expression for a pair of tuples */
+  auto EvaluateJoin(const Tuple *left_tuple, const Tuple *right_tuple) const -> Value;
+
+  /** @return `true` if the predicate holds (is neither false nor NULL) for a tuple */
+  auto EvaluatePredicate(const Tuple *tuple) const -> bool;
+
+  /** @return `true` if the predicate holds (is neither false nor NULL) for a pair of tuples */
+  auto EvaluateJoinPredicate(const Tuple *left_tuple, const Tuple *right_tuple) const -> bool;
+
+  /** @return `true` if the expression was flattened into a program, `false` if it is evaluated as a tree */
+  auto IsCompiled() const -> bool { return !program_.empty(); }
+
+ private:
+  enum class OpCode : uint8_t {
+    LoadInt8,
+    LoadInt16,
+    LoadInt32,
+    LoadInt64,
+    Constant,
+    Plus,
+    Minus,
+    Equal,
+    NotEqual,
+    LessThan,
+    LessThanOrEqual,
+    GreaterThan,
+    GreaterThanOrEqual,
+    And,
+    Or,
+    Tree,
+  };
+
+  struct Instruction {
+    OpCode op_;
+    /** Load: 0 = left tuple, 1 = right tuple */
+    uint8_t side_{0};
+    /** Constant: whether the constant is NULL */
+    bool is_null_{false};
+    /** Load: byte offset of the column in the tuple */
+    uint32_t offset_{0};
+    /** Constant: the value */
+    int64_t constant_{0};
+    /** Tree: the sub-tree evaluated through `Evaluate` / `EvaluateJoin` */
+    const AbstractExpression *expr_{nullptr};
+  };
+
+  /** Upper bound of the evaluation stack; deeper trees are evaluated as a tree */
+  static constexpr size_t MAX_STACK_DEPTH = 32;
+
+  /** Append the program of `expr`, return the stack depth it needs, or 0 if the tree cannot be compiled at all. */
+  auto Emit(const AbstractExpression *expr) -> size_t;
+
+  /** Run the program. `right` may be `nullptr` for single-tuple expressions. */
+  auto Run(const Tuple *left, const Tuple *right, bool *is_null) const -> int64_t;
+
+  /** Convert the raw result of the program into a `Value` of the expression's return type */
+  auto ToValue(int64_t result, bool is_null) const -> Value;
+
+  static auto IsRawType(TypeId type) -> bool;
+
+  /** Convert a `Value` of a raw type to int64 */
+  static auto FromValue(const Value &value, bool *is_null) -> int64_t;
+
+  const AbstractExpression *expr_;
+  const Schema *left_schema_;
+  const Schema *right_schema_;
+  bool is_join_;
+  std::vector<Instruction> program_;
+};
+
+}  // namespace bustub
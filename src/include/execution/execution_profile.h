@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// execution_profile.h
+//
+// Identification: src/include/execution/execution_profile.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * What the executors of one plan node did. Times and pages include those of the children of the plan node, which
+ * run inside its Init and Next, and only count the pages requested by the thread that executes the plan.
+ */
+struct OperatorProfile {
+  /** Calls of Init, more than one if the parent scans the plan again, e.g. the inner side of a nested loop join */
+  uint64_t loops_{0};
+  uint64_t init_ns_{0};
+  uint64_t next_ns_{0};
+  /** Tuples returned by Next */
+  uint64_t rows_{0};
+  BufferPoolStats pages_;
+  /** What the executor decided at runtime, e.g. the algorithm an adaptive join picked */
+  std::vector<std::string> notes_;
+};
+
+/**
+ * ExecutionProfile collects an OperatorProfile for every plan node of a query run by EXPLAIN ANALYZE, see
+ * InstrumentedExecutor.
+ */
+class ExecutionProfile {
+ public:
+  /** @return the profile of a plan node, created empty the first time */
+  auto GetOperator(const AbstractPlanNode *plan) -> OperatorProfile *;
+
+  /**
+   * @return the plan, with what every plan node did next to it
+   * @param plan the plan that was executed
+   * @param estimate the number of rows the optimizer expected a plan node to return, nullopt if it cannot tell
+   */
+  auto ToString(const AbstractPlanNode &plan,
+                const std::function<std::optional<double>(const AbstractPlanNode &)> &estimate) const -> std::string;
+
+ private:
+  void ToString(const AbstractPlanNode &plan,
+                const std::function<std::optional<double>(const AbstractPlanNode &)> &estimate, size_t indent,
+                std::string *output) const;
+
+  mutable std::mutex latch_;
+  std::unordered_map<const AbstractPlanNode *, OperatorProfile> operators_;
+};
+
+}  // namespace bustub
@@ -21,6 +21,9 @@
 #include "storage/page/tmp_tuple_page.h"
 
 namespace bustub {
+
+class ExecutionProfile;
+
 /**
  * ExecutorContext stores all the context necessary to run an executor.
  */
@@ -60,6 +63,12 @@ class ExecutorContext {
   /** @return the transaction manager */
   auto GetTransactionManager() -> TransactionManager * { return txn_mgr_; }
 
+  /** @return the profile the executors record what they do into, or `nullptr` if they are not instrumented */
+  auto GetProfile() -> ExecutionProfile * { return profile_; }
+
+  /** Instrument the executors created from now on, see ExecutorFactory::CreateExecutor */
+  void SetProfile(ExecutionProfile *profile) { profile_ = profile; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -71,6 +80,8 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** The profile of EXPLAIN ANALYZE */
+  ExecutionProfile *profile_{nullptr};
 };
 
 }  // namespace bustub
@@ -24,12 +24,18 @@ namespace bustub {
 class ExecutorFactory {
  public:
   /**
-   * Creates a new executor given the executor context and plan node.
+   * Creates a new executor given the executor context and plan node. If the context has a profile, every executor of
+   * the plan tree is wrapped by an InstrumentedExecutor.
    * @param exec_ctx The executor context for the created executor
    * @param plan The plan node that needs to be executed
    * @return An executor for the given plan in the provided context
    */
   static auto CreateExecutor(ExecutorContext *exec_ctx, const AbstractPlanNodeRef &plan)
       -> std::unique_ptr<AbstractExecutor>;
+
+ private:
+  /** @return the executor of the given plan node, not instrumented */
+  static auto CreatePlanExecutor(ExecutorContext *exec_ctx, const AbstractPlanNodeRef &plan)
+      -> std::unique_ptr<AbstractExecutor>;
 };
 }  // namespace bustub
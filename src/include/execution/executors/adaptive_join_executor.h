@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_join_executor.h
+//
+// Identification: src/include/execution/executors/adaptive_join_executor.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/util/hash_util.h"
+#include "execution/compiled_expression.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/adaptive_join_plan.h"
+#include "storage/page/page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * AdaptiveJoinExecutor executes an equi-JOIN with the algorithm that suits the sizes of its inputs. It reads up to
+ * `adaptive_join_buffer_rows` tuples of the left input, and of the right one if needed, before it decides:
+ *
+ * - the left input fits in the buffer and the right key has an index: a nested loop over the index, the right input
+ *   is not read at all;
+ * - the right input fits in the buffer: a hash join built on the right input;
+ * - only the left input fits in the buffer: a hash join built on the left input, probed by the right one;
+ * - neither does: a hash join built on the right input, which partitions both inputs into pages of the buffer pool
+ *   once the right input takes more than `hash_join_spill_threshold` bytes, and joins them partition by partition.
+ *
+ * The decisions taken are kept in GetDecisions().
+ */
+class AdaptiveJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new AdaptiveJoinExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The adaptive join plan to be executed
+   * @param left_child The child executor that produces tuples for the left side of join
+   * @param right_child The child executor that produces tuples for the right side of join
+   */
+  AdaptiveJoinExecutor(ExecutorContext *exec_ctx, const AdaptiveJoinPlanNode *plan,
+                       std::unique_ptr<AbstractExecutor> &&left_child, std::unique_ptr<AbstractExecutor> &&right_child);
+
+  ~AdaptiveJoinExecutor() override;
+
+  /** Initialize the join, reading its inputs until it can pick an algorithm */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the join.
+   * @param[out] tuple The next tuple produced by the join.
+   * @param[out] rid The next tuple RID, not used by adaptive join.
+   * @return `true` if a tuple was produced, `false` if there are no more tuples.
+   */
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  /** @return The output schema for the join */
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
+
+  /** @return The algorithms picked by the last Init, with the sizes of the inputs they were picked for */
+  auto GetDecisions() const -> const std::vector<std::string> & { return decisions_; }
+
+ private:
+  enum class Strategy { IndexNestedLoop, HashBuildRight, HashBuildLeft, PartitionedHash };
+
+  /** A tuple of the input the hash table is built on */
+  struct BuildEntry {
+    Value key_;
+    Tuple tuple_;
+    bool matched_;
+  };
+
+  /** The tuples of one input that fall into a partition, in pages of the buffer pool */
+  struct Partition {
+    std::vector<page_id_t> pages_;
+    /** The page being filled, pinned until the input is partitioned */
+    Page *write_page_{nullptr};
+    /** Tuples kept in memory, because they do not fit in a page or the buffer pool has no free frame */
+    std::vector<Tuple> resident_;
+  };
+
+  /** Read up to `limit` more tuples of an input into `buffer`, @return `true` if the input is exhausted */
+  auto Fill(AbstractExecutor *executor, std::vector<Tuple> *buffer, size_t limit) -> bool;
+  void Build(std::vector<Tuple> *tuples, bool build_left);
+  void Insert(Tuple tuple, bool build_left);
+  void Spill(const Tuple &tuple, bool left, std::vector<Partition> *partitions);
+  void FinishSpill(std::vector<Partition> *partitions);
+  /** @return the tuples of a page of a partition, dropping the page */
+  auto ReadPage(page_id_t page_id) -> std::vector<Tuple>;
+  /** Build the hash table on the right tuples of a partition */
+  void LoadPartition(size_t partition);
+  void DropPartitions();
+
+  auto NextProbeTuple(Tuple *tuple) -> bool;
+  auto RefillProbe() -> bool;
+  void FindMatches();
+  auto EmitMatch(Tuple *tuple) -> bool;
+
+  /** The adaptive join plan node to be executed. */
+  const AdaptiveJoinPlanNode *plan_;
+
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+
+  std::optional<CompiledExpression> left_key_;
+  std::optional<CompiledExpression> right_key_;
+  Tuple null_right_tuple_;
+
+  Strategy strategy_{Strategy::HashBuildRight};
+  std::vector<std::string> decisions_;
+
+  /** The hash table, over the tuples of the build input bucketed by the hash of their key */
+  std::vector<BuildEntry> build_;
+  std::unordered_map<hash_t, std::vector<size_t>> table_;
+
+  /** The probe input: the tuples read ahead, then the rest of the input or the pages of the current partition */
+  AbstractExecutor *probe_executor_{nullptr};
+  bool probe_exhausted_{false};
+  std::vector<Tuple> probe_batch_;
+  size_t probe_pos_{0};
+
+  std::vector<Partition> left_partitions_;
+  std::vector<Partition> right_partitions_;
+  size_t partition_{0};
+  size_t probe_page_{0};
+  bool probe_resident_read_{false};
+
+  /** The probe tuple being joined and what it matched that was not emitted yet */
+  Tuple probe_tuple_;
+  std::vector<size_t> matches_;
+  std::vector<RID> rids_;
+  size_t next_match_{0};
+  bool pending_null_{false};
+  size_t next_unmatched_{0};
+
+  IndexInfo *index_info_{nullptr};
+  TableInfo *table_info_{nullptr};
+  const std::vector<uint32_t> *right_column_ids_{nullptr};
+};
+
+}  // namespace bustub
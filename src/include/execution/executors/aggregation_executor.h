@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -22,6 +23,7 @@
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/parallel_aggregation_hash_table.h"
 #include "execution/plans/aggregation_plan.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
@@ -41,7 +43,16 @@ class SimpleAggregationHashTable {
    //ʽۼ
   SimpleAggregationHashTable(const std::vector<AbstractExpressionRef> &agg_exprs,
                              const std::vector<AggregationType> &agg_types)
-      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {}
+      : agg_exprs_{agg_exprs}, agg_types_{agg_types} {
+    for (const auto &agg_type : agg_types_) {
+      sketch_idx_.push_back(num_sketches_);
+      if (agg_type == AggregationType::ApproxCountDistinctAggregate) {
+        num_sketches_++;
+      }
+      has_distinct_ = has_distinct_ || agg_type == AggregationType::CountDistinctAggregate ||
+                      agg_type == AggregationType::SumDistinctAggregate;
+    }
+  }
 
   /** @return The initial aggregrate value for this aggregation executor */
   //ʼۺֵvalue
@@ -57,12 +68,15 @@ class SimpleAggregationHashTable {
         case AggregationType::SumAggregate:
         case AggregationType::MinAggregate:
         case AggregationType::MaxAggregate:
+        case AggregationType::CountDistinctAggregate:
+        case AggregationType::SumDistinctAggregate:
+        case AggregationType::ApproxCountDistinctAggregate:
           // Others starts at null.   Ϊnull
           values.emplace_back(ValueFactory::GetNullValueByType(TypeId::INTEGER));
           break;
       }
     }
-    return {values};
+    return {values, std::vector<HyperLogLog>(num_sketches_)};
   }
 
   /**
@@ -87,6 +101,7 @@ class SimpleAggregationHashTable {
           result->aggregates_[i] = result->aggregates_[i].Add(ValueFactory::GetIntegerValue(1));
           break;
         case AggregationType::CountAggregate:
+        case AggregationType::CountDistinctAggregate:
         //count(*) countʲô
         //count(*) ͳжУʹһҲûУҲӦ÷0УNULLͳƽʱ򣬲ֵΪNULL
         //count()ֻһ̣ͳƽʱ򣬻ֵΪ
@@ -98,6 +113,7 @@ class SimpleAggregationHashTable {
           }
           break;
         case AggregationType::SumAggregate:
+        case AggregationType::SumDistinctAggregate:
         //result ûֵʱȸֵ
           if (result->aggregates_[i].IsNull()) {
             result->aggregates_[i] = input.aggregates_[i];
@@ -122,6 +138,10 @@ class SimpleAggregationHashTable {
             result->aggregates_[i] = result->aggregates_[i].Max(input.aggregates_[i]);
           }
           break;
+        case AggregationType::ApproxCountDistinctAggregate:
+          // The estimate is only computed by Finalize(), after every value is added.
+          result->sketches_[sketch_idx_[i]].Add(input.aggregates_[i]);
+          break;
       }
     }
   }
@@ -139,15 +159,54 @@ class SimpleAggregationHashTable {
     }
     //ϣѾˣôҪgroupзͳ
     //õ飬ִоۺvalue
-    CombineAggregateValues(&ht_[agg_key], agg_val);
+    if (!has_distinct_) {
+      CombineAggregateValues(&ht_[agg_key], agg_val);
+      return;
+    }
+    // A value a distinct aggregate of the group has seen already is combined as NULL, which changes neither a count
+    // nor a sum.
+    AggregateValue input{agg_val};
+    for (uint32_t i = 0; i < agg_types_.size(); i++) {
+      if ((agg_types_[i] != AggregationType::CountDistinctAggregate &&
+           agg_types_[i] != AggregationType::SumDistinctAggregate) ||
+          input.aggregates_[i].IsNull()) {
+        continue;
+      }
+      AggregateKey seen{agg_key};
+      seen.group_bys_.push_back(ValueFactory::GetIntegerValue(static_cast<int32_t>(i)));
+      seen.group_bys_.push_back(input.aggregates_[i]);
+      if (!distinct_values_.insert(std::move(seen)).second) {
+        input.aggregates_[i] = ValueFactory::GetNullValueByType(input.aggregates_[i].GetTypeId());
+      }
+    }
+    CombineAggregateValues(&ht_[agg_key], input);
   }
 
   void InsertIntialCombine() { ht_.insert({{std::vector<Value>()}, GenerateInitialAggregateValue()}); }
 
+  /** Replace the sketches of the APPROX_COUNT_DISTINCT aggregates of every group by their estimate */
+  void Finalize() {
+    if (num_sketches_ == 0) {
+      return;
+    }
+    for (auto &[_, value] : ht_) {
+      for (uint32_t i = 0; i < agg_types_.size(); i++) {
+        if (agg_types_[i] == AggregationType::ApproxCountDistinctAggregate) {
+          auto estimate = value.sketches_[sketch_idx_[i]].Estimate();
+          value.aggregates_[i] = ValueFactory::GetIntegerValue(static_cast<int32_t>(estimate));
+        }
+      }
+      value.sketches_.clear();
+    }
+  }
+
   /**
    * Clear the hash table
    */
-  void Clear() { ht_.clear(); }
+  void Clear() {
+    ht_.clear();
+    distinct_values_.clear();
+  }
 
   /** An iterator over the aggregation hash table */
   class Iterator {
@@ -193,6 +252,14 @@ class SimpleAggregationHashTable {
   const std::vector<AbstractExpressionRef> &agg_exprs_;
   /** The types of aggregations that we have */
   const std::vector<AggregationType> &agg_types_;
+  /** The group-by values of every group, followed by the index and value of every distinct aggregate seen */
+  std::unordered_set<AggregateKey> distinct_values_{};
+  /** Whether an aggregate is COUNT(DISTINCT) or SUM(DISTINCT) */
+  bool has_distinct_{false};
+  /** The sketch in `AggregateValue::sketches_` of every APPROX_COUNT_DISTINCT aggregate */
+  std::vector<size_t> sketch_idx_{};
+  /** The number of APPROX_COUNT_DISTINCT aggregates */
+  size_t num_sketches_{0};
 };
 
 /**
@@ -227,6 +294,11 @@ class AggregationExecutor : public AbstractExecutor {
   /** Do not use or remove this function, otherwise you will get zero points. */
   auto GetChildExecutor() const -> const AbstractExecutor *;
 
+  /** @return The number of partition pages the two-phase aggregation spilled to disk during the last Init */
+  auto GetSpilledPageCount() const -> size_t {
+    return parallel_aht_ == nullptr ? 0 : parallel_aht_->GetSpilledPageCount();
+  }
+
  private:
   /** @return The tuple as an AggregateKey */
   auto MakeAggregateKey(const Tuple *tuple) -> AggregateKey {
@@ -262,5 +334,17 @@ class AggregationExecutor : public AbstractExecutor {
   SimpleAggregationHashTable aht_;
   /** Simple aggregation hash table iterator */
   SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** Two-phase aggregation hash table, used instead of `aht_` when the aggregates fit into flat state */
+  std::unique_ptr<ParallelAggregationHashTable> parallel_aht_;
+  /** Output of the parallel aggregation */
+  std::vector<Tuple> results_;
+  /** Position in `results_` */
+  size_t result_idx_{0};
+  /** True if this run emits from `results_` rather than `aht_` */
+  bool use_results_{false};
+  /** True if the plan only groups, i.e. is a DISTINCT, whose groups are returned as soon as they are first seen */
+  bool is_distinct_;
+  /** The groups a DISTINCT returned already */
+  std::unordered_set<AggregateKey> distinct_keys_;
 };
 }  // namespace bustub
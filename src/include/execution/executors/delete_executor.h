@@ -56,6 +56,12 @@ class DeleteExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
  private:
+  /** Lock a batch of rows produced by the child in X mode, unless the table lock covers them */
+  void LockRows(const std::vector<RID> &rids);
+
+  /** Lock the keys of a deleted tuple, and the gaps above them, in the indexes of the table */
+  void LockIndexKeys(const Tuple &tuple);
+
   /** The delete plan node to be executed */
   const DeletePlanNode *plan_;
   /** The child executor from which RIDs for deleted tuples are pulled */
@@ -15,6 +15,7 @@
 #include <memory>
 #include <vector>
 
+#include "execution/compiled_expression.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/filter_plan.h"
@@ -57,5 +58,8 @@ class FilterExecutor : public AbstractExecutor {
 
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** The predicate, compiled against the child output schema */
+  std::unique_ptr<CompiledExpression> predicate_;
 };
 }  // namespace bustub
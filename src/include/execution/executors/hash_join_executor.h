@@ -26,7 +26,8 @@
 namespace bustub {
 
 /**
- * HashJoinExecutor executes a nested-loop JOIN on two tables.
+ * HashJoinExecutor executes a hash JOIN on two tables, building a hash table over the right side. Semi and anti joins
+ * return the left tuples only.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -61,7 +62,8 @@ class HashJoinExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
 
-  std::unordered_map<hash_t, std::vector<Tuple>> hash_join_table_;
+  /** Right tuples with their join key, bucketed by the hash of the key. Tuples with a NULL key are left out. */
+  std::unordered_map<hash_t, std::vector<std::pair<Value, Tuple>>> hash_join_table_;
 
   std::vector<Tuple> output_tuples_;
   std::vector<Tuple>::const_iterator output_tuples_iter_;
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "common/rid.h"
@@ -42,14 +43,56 @@ class IndexScanExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  using Entry = std::pair<IntegerKeyType, RID>;
+
+  /** The number of index entries read at a time */
+  static constexpr size_t BATCH_SIZE = 128;
+
+  /** Whether rows are locked while they are read, which neither READ_UNCOMMITTED nor a snapshot read does */
+  auto IsLockingRead() const -> bool {
+    auto *txn = exec_ctx_->GetTransaction();
+    return txn->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED && !txn->ReadsSnapshot();
+  }
+
+  /**
+   * Read the next entries of the range from the index into entries_. No latch is held between two batches, so the
+   * scan can wait for locks. If lock_keys_, the keys read and the first key past the range are locked before the
+   * batch is trusted, see KEY LOCKS in lock_manager.h.
+   */
+  void FetchEntries();
+
+  /**
+   * Lock the keys of a batch the scan depends on: the keys in the range, the first key past it, and the supremum
+   * if the batch reaches the end of the index.
+   * @return the number of entries locked
+   */
+  auto LockKeys(const std::vector<Entry> &batch, size_t batch_size) -> size_t;
+
+  /** @return true if the key lies past the high end of the range */
+  auto IsPastRange(const Value &key) const -> bool;
+
+  /** @return true if the key is the inclusive high end of the range, so that no larger key can be in it */
+  auto IsLastKey(const Value &key) const -> bool;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
   const IndexInfo *index_info_;
   const TableInfo *table_info_;
   //ƻʼΪ BPlusTreeIndexForOneIntegerColumnȫؽת洢ִ
   BPlusTreeIndexForOneIntegerColumn *tree_;  //B+
-  BPlusTreeIndexIteratorForOneIntegerColumn iter_;//IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>
-  std::vector<RID> rids_;
-  std::vector<RID>::const_iterator rid_iter_{};
+  /** Entries of the range read from the index, and the next one to return */
+  std::vector<Entry> entries_;
+  size_t next_entry_{0};
+  /** The next batch starts after this key, or at the low end of the range before the first batch */
+  IntegerKeyType cursor_;
+  bool started_{false};
+  /** Whether the whole range has been read */
+  bool done_{false};
+  /** Whether the scan locks the keys it reads to keep phantoms out of its range */
+  bool lock_keys_{false};
+  /** Whether an optimistic transaction validates the rows the scan returns rather than the whole table */
+  bool record_rows_{false};
+  /** Whether the scan returned a row */
+  bool found_{false};
 };
 }  // namespace bustub
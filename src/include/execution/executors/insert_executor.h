@@ -56,6 +56,12 @@ class InsertExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
  private:
+  /** Lock a new row in X mode, unless the table lock covers it */
+  void LockRow(const RID &rid);
+
+  /** Lock the gaps the keys of a new tuple fall into in the indexes of the table */
+  void LockIndexGaps(const Tuple &tuple);
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
 
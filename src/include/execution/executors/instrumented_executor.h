@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// instrumented_executor.h
+//
+// Identification: src/include/execution/executors/instrumented_executor.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+
+#include "execution/execution_profile.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/abstract_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * InstrumentedExecutor wraps the executor of a plan node when the query is run by EXPLAIN ANALYZE, and records in the
+ * profile of the executor context how long its Init and Next took, how many tuples it returned and how many pages it
+ * requested from the buffer pool.
+ */
+class InstrumentedExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new InstrumentedExecutor instance.
+   * @param exec_ctx The executor context, with the profile to record into
+   * @param plan The plan node executed by the child
+   * @param child The executor of the plan node
+   */
+  InstrumentedExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan,
+                       std::unique_ptr<AbstractExecutor> &&child);
+
+  void Init() override;
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputSchema() const -> const Schema & override { return child_->GetOutputSchema(); }
+
+ private:
+  std::unique_ptr<AbstractExecutor> child_;
+  OperatorProfile *profile_;
+};
+
+}  // namespace bustub
@@ -53,6 +53,10 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   bool is_left_{false};
   IndexInfo *index_info_;
   TableInfo *table_info_;
+  /** The outer tuple being joined and the RIDs of the inner tuples it matches that are not emitted yet */
+  Tuple left_tuple_;
+  std::vector<RID> matches_;
+  size_t next_match_{0};
 };
 }  // namespace bustub
 
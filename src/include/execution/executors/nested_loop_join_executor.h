@@ -14,7 +14,9 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "execution/compiled_expression.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/nested_loop_join_plan.h"
@@ -23,7 +25,14 @@
 namespace bustub {
 
 /**
- * NestedLoopJoinExecutor executes a nested-loop JOIN on two tables.
+ * NestedLoopJoinExecutor executes a block nested-loop JOIN on two tables.
+ *
+ * The left (outer) side is buffered in blocks of at most `nested_loop_join_block_size` bytes. For every block the
+ * right (inner) side is re-initialized and streamed once, so the inner side is never materialized.
+ *
+ * Semi and anti joins return the left tuples only: a semi join returns a left tuple at its first match, an anti join
+ * returns the left tuples of the block that never matched once the inner side is exhausted. Once every tuple of the
+ * block has matched, a semi or anti join stops streaming the inner side for the block.
  */
 class NestedLoopJoinExecutor : public AbstractExecutor {
  public:
@@ -53,20 +62,33 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); };
 
  private:
-  auto InnerJoin(const Schema &schema, Tuple *tuple) -> bool;
-  auto LeftJoin(const Schema &schema, Tuple *tuple) -> bool;
+  /** Buffer the next block of left tuples. */
+  void LoadBlock();
+
   /** The NestedLoopJoin plan node to be executed. */
   const NestedLoopJoinPlanNode *plan_;
-  bool is_ineer_{false};
+  JoinType join_type_;
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
-  std::vector<Tuple> right_tuples_;
-  uint64_t index_{0};
-  Tuple left_tuple_;
-  RID left_rid_;
   Schema left_schema_;
   Schema right_schema_;
-  bool is_match_{true};
+  /** The join predicate, compiled against the two child schemas */
+  std::unique_ptr<CompiledExpression> predicate_;
+  /** All-NULL right tuple padded to unmatched left tuples of a left join */
+  Tuple null_right_tuple_;
+
+  /** The current block of left tuples, and whether each of them has matched (all but inner join) */
+  std::vector<Tuple> block_;
+  std::vector<bool> matched_;
+  /** Tuples of the block that have not matched yet */
+  size_t unmatched_count_{0};
+  /** Next left tuple of the block to join with `right_tuple_` */
+  size_t block_idx_{0};
+  /** Next left tuple of the block to check for a missing match once the inner side is exhausted */
+  size_t unmatched_idx_{0};
+  /** The current right tuple */
+  Tuple right_tuple_;
+  bool has_right_tuple_{false};
 };
 
 }  // namespace bustub
@@ -15,6 +15,7 @@
 #include <memory>
 #include <vector>
 
+#include "execution/compiled_expression.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/projection_plan.h"
@@ -56,5 +57,8 @@ class ProjectionExecutor : public AbstractExecutor {
 
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
+
+  /** The projected expressions, compiled against the child output schema */
+  std::vector<CompiledExpression> expressions_;
 };
 }  // namespace bustub
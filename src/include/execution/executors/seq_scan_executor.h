@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "execution/compiled_expression.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "storage/table/table_cursor.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -48,10 +51,37 @@ class SeqScanExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
  private:
+  /** Yield the next tuple that satisfies the filter predicate, without taking any lock */
+  auto NextTuple(Tuple *tuple) -> bool;
+
+  /** Yield the RID of the next row of the table, filtered or not, without taking any lock */
+  auto NextRid(RID *rid) -> bool;
+
+  /**
+   * S lock the rows of the next page with one LockManager::LockRows() call, then read the ones that satisfy the filter
+   * predicate into `page_tuples_`. A row is only read once it is locked, so the scan never sees an uncommitted change.
+   * @return false if there are no more tuples
+   */
+  auto NextPage() -> bool;
+
   /** The sequential scan plan node to be executed */
   //ܣǰģϢҪĸ Ϣȥɽģ͵ĵÿε÷һtuple
   const SeqScanPlanNode *plan_;
   TableIterator table_iter_ = {nullptr, RID(), nullptr};//
   const TableInfo *table_info_;
+  /** The pushed-down filter, compiled against the table schema (`nullptr` if there is none) */
+  std::unique_ptr<CompiledExpression> filter_predicate_;
+  /** Zero-copy cursor over the table, `nullptr` if the scan copies every tuple through `table_iter_` */
+  std::unique_ptr<TableCursor> cursor_;
+  /** Whether the scan reads the snapshot of its transaction through `cursor_` */
+  bool is_snapshot_{false};
+  /** Whether the scan S locks the rows it reads, a page at a time through `page_tuples_` */
+  bool lock_rows_{false};
+  /** The tuples of the current page that are yet to be emitted from `page_cursor_` on, their rows locked */
+  std::vector<Tuple> page_tuples_;
+  size_t page_cursor_{0};
+  /** The first row past the current page, valid if `has_lookahead_` is set */
+  RID lookahead_;
+  bool has_lookahead_{false};
 };
 }  // namespace bustub
@@ -12,13 +12,13 @@
 #pragma once
 
 #include <memory>
-#include <stack>
 #include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/topn_plan.h"
+#include "execution/topn_heap.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -54,7 +54,16 @@ class TopNExecutor : public AbstractExecutor {
   const TopNPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_;
 
-  std::stack<Tuple> child_tuples_;
+  /**
+   * Hand the child's tuples to `topn_parallelism` worker threads in batches, each with its own heap, and merge the
+   * worker heaps into `heap`.
+   * @param batch The first batch of tuples, already pulled from the child
+   */
+  void ParallelBuild(std::vector<Tuple> batch, TopNHeap *heap);
+
+  /** The first N tuples in ORDER BY order */
+  std::vector<Tuple> sorted_tuples_;
+  size_t cursor_{0};
 };
 }  // namespace bustub
 
@@ -58,6 +58,9 @@ class UpdateExecutor : public AbstractExecutor {
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
  private:
+  /** Lock a batch of rows produced by the child in X mode, unless the table lock covers them */
+  void LockRows(const std::vector<RID> &rids);
+
   /** The update plan node to be executed */
   const UpdatePlanNode *plan_;
   /** Metadata identifying the table that should be updated */
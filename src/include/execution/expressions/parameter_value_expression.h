@@ -0,0 +1,51 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parameter_value_expression.h
+//
+// Identification: src/include/execution/expressions/parameter_value_expression.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "execution/expressions/abstract_expression.h"
+
+namespace bustub {
+/**
+ * ParameterValueExpression is a parameter `$n` of a prepared or cached plan. The parameters are replaced by constants,
+ * see PlanCache::BindParameters, before the plan is executed.
+ */
+class ParameterValueExpression : public AbstractExpression {
+ public:
+  /**
+   * @param param_idx the index of the parameter, 0 for `$1`
+   * @param ret_type the type of the values of the parameter
+   */
+  ParameterValueExpression(uint32_t param_idx, TypeId ret_type)
+      : AbstractExpression({}, ret_type), param_idx_(param_idx) {}
+
+  auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value override {
+    throw Exception(fmt::format("parameter ${} is not bound", param_idx_ + 1));
+  }
+
+  auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
+                    const Schema &right_schema) const -> Value override {
+    throw Exception(fmt::format("parameter ${} is not bound", param_idx_ + 1));
+  }
+
+  /** @return the string representation of the plan node and its children */
+  auto ToString() const -> std::string override { return fmt::format("${}", param_idx_ + 1); }
+
+  BUSTUB_EXPR_CLONE_WITH_CHILDREN(ParameterValueExpression);
+
+  /** The index of the parameter, 0 for `$1` */
+  uint32_t param_idx_;
+};
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_aggregation_hash_table.h
+//
+// Identification: src/include/execution/parallel_aggregation_hash_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/plans/aggregation_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * ParallelAggregationHashTable is a two-phase hash aggregation over fixed-width aggregate state.
+ *
+ * Phase 1 (Build): the calling thread pulls batches of tuples from the child executor and hands them to worker
+ * threads. Every worker pre-aggregates into its own small, fixed-size table. When two groups collide on a slot, the
+ * older group is evicted into one of 2^AGGREGATION_RADIX_BITS radix partitions (chosen by the high bits of its hash).
+ * Once a worker has buffered more than `aggregation_spill_threshold` bytes of partition data, it spills the buffers
+ * to temporary pages through the buffer pool.
+ *
+ * Phase 2 (Merge): worker threads claim whole partitions, merge the partial states of every worker (in memory and
+ * spilled) into a partition-local table, and materialize the output tuples.
+ *
+ * Each group is stored as its serialized key followed by one int64 slot per aggregate and a null bitmap, so combining
+ * two groups never goes through `Value`. Only COUNT(*) / COUNT over any input and SUM / MIN / MAX over INTEGER inputs
+ * are supported; see `IsSupported`.
+ */
+class ParallelAggregationHashTable {
+ public:
+  /**
+   * Construct a new ParallelAggregationHashTable.
+   * @param plan The aggregation plan
+   * @param child_schema The schema of the tuples fed into the aggregation
+   * @param bpm The buffer pool used for spilling partitions, may be `nullptr` to disable spilling
+   */
+  ParallelAggregationHashTable(const AggregationPlanNode *plan, const Schema *child_schema, BufferPoolManager *bpm);
+
+  ~ParallelAggregationHashTable();
+
+  DISALLOW_COPY_AND_MOVE(ParallelAggregationHashTable);
+
+  /** @return `true` if the aggregates of the plan can be kept in flat int64 state */
+  static auto IsSupported(const AggregationPlanNode *plan) -> bool;
+
+  /**
+   * Phase 1: consume every tuple of the child executor.
+   * @param child The (already initialized) child executor
+   */
+  void Build(AbstractExecutor *child);
+
+  /**
+   * Phase 2: merge all partitions and materialize one tuple per group.
+   * @param output_schema The schema of the aggregation output (group-bys + aggregates)
+   * @param[out] result The output tuples
+   * @return the number of groups
+   */
+  auto Merge(const Schema *output_schema, std::vector<Tuple> *result) -> size_t;
+
+  /** @return the number of partition pages that were spilled to disk during the last Build */
+  auto GetSpilledPageCount() const -> size_t { return spilled_page_count_; }
+
+ private:
+  /** The thread-local pre-aggregation table and radix partitions of one worker */
+  struct WorkerState;
+
+  /** Serialize the group-by values of a tuple into `key`. */
+  void MakeKey(const Tuple &tuple, std::string *key) const;
+
+  /**
+   * Evaluate the aggregate inputs of a tuple into `vals` and return their null bitmap. The result is the partial state
+   * of a group holding only this tuple, so it can be folded in with `CombineState`.
+   */
+  auto MakeInput(const Tuple &tuple, int64_t *vals) const -> uint64_t;
+
+  /** Reset the aggregate state of a group to its initial value. */
+  void InitState(int64_t *vals, uint64_t *nulls) const;
+
+  /** Fold the partial state of a group into the aggregate state of the same group. */
+  void CombineState(int64_t *vals, uint64_t *nulls, const int64_t *other, uint64_t other_nulls) const;
+
+  /** Merge one partition of every worker and append its groups to `result`. */
+  void MergePartition(size_t partition, const Schema *output_schema, std::vector<Tuple> *result) const;
+
+  /** Release all worker state and spilled pages. */
+  void Reset();
+
+  const AggregationPlanNode *plan_;
+  const Schema *child_schema_;
+  BufferPoolManager *bpm_;
+
+  /** Types of the group-by expressions */
+  std::vector<TypeId> key_types_;
+  /** Aggregates are bucketed by kind so combining does not branch on the aggregation type per value */
+  std::vector<uint32_t> count_star_idx_;
+  std::vector<uint32_t> count_idx_;
+  std::vector<uint32_t> sum_idx_;
+  std::vector<uint32_t> min_idx_;
+  std::vector<uint32_t> max_idx_;
+  /** Bits of the null bitmap that start out set (SUM / MIN / MAX are NULL until they see a non-NULL input) */
+  uint64_t initial_nulls_{0};
+  /** Number of aggregates */
+  uint32_t num_aggs_;
+
+  /** One state per worker thread of the last Build */
+  std::vector<std::unique_ptr<WorkerState>> workers_;
+  /** Number of partition pages spilled during the last Build */
+  size_t spilled_page_count_{0};
+};
+
+}  // namespace bustub
@@ -42,6 +42,7 @@ enum class PlanType {
   NestedLoopJoin,
   NestedIndexJoin,
   HashJoin,
+  AdaptiveJoin,
   Filter,
   Values,
   Projection,
@@ -92,6 +93,14 @@ class AbstractPlanNode {
     return fmt::format("{}{}", PlanNodeToString(), ChildrenToString(2, with_schema));
   }
 
+  /** @return the string representation of the plan node, without its children */
+  auto NodeToString(bool with_schema = true) const -> std::string {
+    if (with_schema) {
+      return fmt::format("{} | {}", PlanNodeToString(), output_schema_);
+    }
+    return PlanNodeToString();
+  }
+
   /** @return the cloned plan node with new children */
   virtual auto CloneWithChildren(std::vector<AbstractPlanNodeRef> children) const
       -> std::unique_ptr<AbstractPlanNode> = 0;
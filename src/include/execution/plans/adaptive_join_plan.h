@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_join_plan.h
+//
+// Identification: src/include/execution/plans/adaptive_join_plan.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binder/table_ref/bound_join_ref.h"
+#include "catalog/catalog.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * Adaptive join performs an equi-JOIN with the algorithm that suits the sizes of its inputs, which it finds out by
+ * reading them: a nested loop over an index of the right table, a hash join built on the smaller input, or a hash join
+ * that partitions both inputs to disk.
+ */
+class AdaptiveJoinPlanNode : public AbstractPlanNode {
+ public:
+  /**
+   * Construct a new AdaptiveJoinPlanNode instance.
+   * @param output_schema The output schema for the JOIN
+   * @param left The left input, which is probed
+   * @param right The right input, which is built unless it turns out larger than the left one
+   * @param left_key_expression The expression for the left JOIN key
+   * @param right_key_expression The expression for the right JOIN key
+   * @param join_type The join type, INNER or LEFT
+   * @param index_oid An index on the right key if the right input is a full scan of a table, otherwise nullopt
+   * @param index_name The name of the index
+   */
+  AdaptiveJoinPlanNode(SchemaRef output_schema, AbstractPlanNodeRef left, AbstractPlanNodeRef right,
+                       AbstractExpressionRef left_key_expression, AbstractExpressionRef right_key_expression,
+                       JoinType join_type, std::optional<index_oid_t> index_oid, std::string index_name)
+      : AbstractPlanNode(std::move(output_schema), {std::move(left), std::move(right)}),
+        left_key_expression_{std::move(left_key_expression)},
+        right_key_expression_{std::move(right_key_expression)},
+        join_type_(join_type),
+        index_oid_(index_oid),
+        index_name_(std::move(index_name)) {}
+
+  /** @return The type of the plan node */
+  auto GetType() const -> PlanType override { return PlanType::AdaptiveJoin; }
+
+  /** @return The expression to compute the left join key */
+  auto LeftJoinKeyExpression() const -> const AbstractExpression & { return *left_key_expression_; }
+
+  /** @return The expression to compute the right join key */
+  auto RightJoinKeyExpression() const -> const AbstractExpression & { return *right_key_expression_; }
+
+  /** @return The left plan node of the join */
+  auto GetLeftPlan() const -> AbstractPlanNodeRef {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Adaptive joins should have exactly two children plans.");
+    return GetChildAt(0);
+  }
+
+  /** @return The right plan node of the join */
+  auto GetRightPlan() const -> AbstractPlanNodeRef {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Adaptive joins should have exactly two children plans.");
+    return GetChildAt(1);
+  }
+
+  /** @return The join type used in the join */
+  auto GetJoinType() const -> JoinType { return join_type_; };
+
+  BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(AdaptiveJoinPlanNode);
+
+  /** The expression to compute the left JOIN key */
+  AbstractExpressionRef left_key_expression_;
+  /** The expression to compute the right JOIN key */
+  AbstractExpressionRef right_key_expression_;
+
+  /** The join type */
+  JoinType join_type_;
+
+  /** The index on the right key, which the right input, a full table scan, can be replaced by */
+  std::optional<index_oid_t> index_oid_;
+  std::string index_name_;
+
+ protected:
+  auto PlanNodeToString() const -> std::string override {
+    if (index_oid_.has_value()) {
+      return fmt::format("AdaptiveJoin {{ type={}, left_key={}, right_key={}, index={} }}", join_type_,
+                         left_key_expression_, right_key_expression_, index_name_);
+    }
+    return fmt::format("AdaptiveJoin {{ type={}, left_key={}, right_key={} }}", join_type_, left_key_expression_,
+                       right_key_expression_);
+  }
+};
+
+}  // namespace bustub
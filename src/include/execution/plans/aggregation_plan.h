@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "common/util/hash_util.h"
+#include "common/util/hyperloglog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
 #include "fmt/format.h"
@@ -26,7 +27,19 @@
 namespace bustub {
 
 /** AggregationType enumerates all the possible aggregation functions in our system */
-enum class AggregationType { CountStarAggregate, CountAggregate, SumAggregate, MinAggregate, MaxAggregate };
+enum class AggregationType {
+  CountStarAggregate,
+  CountAggregate,
+  SumAggregate,
+  MinAggregate,
+  MaxAggregate,
+  /** COUNT(DISTINCT x), counted exactly with a hash set of the values seen */
+  CountDistinctAggregate,
+  /** SUM(DISTINCT x) */
+  SumDistinctAggregate,
+  /** APPROX_COUNT_DISTINCT(x), estimated with a HyperLogLog sketch in constant memory per group */
+  ApproxCountDistinctAggregate
+};
 
 /**
  * AggregationPlanNode represents the various SQL aggregation functions.
@@ -116,6 +129,8 @@ struct AggregateKey {
 struct AggregateValue {
   /** The aggregate values */
   std::vector<Value> aggregates_;
+  /** The sketches of the APPROX_COUNT_DISTINCT aggregates, in the order of the aggregates */
+  std::vector<HyperLogLog> sketches_{};
 };
 
 }  // namespace bustub
@@ -160,6 +175,15 @@ struct fmt::formatter<bustub::AggregationType> : formatter<std::string> {
       case AggregationType::MaxAggregate:
         name = "max";
         break;
+      case AggregationType::CountDistinctAggregate:
+        name = "count_distinct";
+        break;
+      case AggregationType::SumDistinctAggregate:
+        name = "sum_distinct";
+        break;
+      case AggregationType::ApproxCountDistinctAggregate:
+        name = "approx_count_distinct";
+        break;
     }
     return formatter<std::string>::format(name, ctx);
   }
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -20,6 +21,15 @@
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
+
+/** One end of the range of keys an index scan reads */
+struct IndexScanBound {
+  Value key_;
+  bool inclusive_;
+  /** The parameter whose value is the key, in a plan with parameters, see PlanCache::BindParameters */
+  std::optional<uint32_t> param_idx_{};
+};
+
 /**
  * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
  */
@@ -29,17 +39,37 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param filter_predicate the predicate the scanned range stands for, only kept for printing
+   * @param low the lowest key to read, or none to start at the smallest key
+   * @param high the highest key to read, or none to read up to the largest key
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef filter_predicate = nullptr)
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, AbstractExpressionRef filter_predicate = nullptr,
+                    std::optional<IndexScanBound> low = std::nullopt, std::optional<IndexScanBound> high = std::nullopt)
       : AbstractPlanNode(std::move(output), {}),
         index_oid_(index_oid),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        low_(std::move(low)),
+        high_(std::move(high)) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the identifier of the table that should be scanned */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return true if the scan reads every key of the index, in key order */
+  auto IsFullScan() const -> bool { return !low_.has_value() && !high_.has_value(); }
+
+  /** @return true if the scan reads at most one key */
+  auto IsPointLookup() const -> bool {
+    if (!low_.has_value() || !high_.has_value() || !low_->inclusive_ || !high_->inclusive_) {
+      return false;
+    }
+    if (low_->param_idx_.has_value() || high_->param_idx_.has_value()) {
+      return low_->param_idx_ == high_->param_idx_;
+    }
+    return low_->key_.CompareEquals(high_->key_) == CmpBool::CmpTrue;
+  }
+
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(IndexScanPlanNode);
 
   /** The table whose tuples should be scanned. */
@@ -49,6 +79,10 @@ class IndexScanPlanNode : public AbstractPlanNode {
 
   AbstractExpressionRef filter_predicate_;
 
+  /** The range of keys to read */
+  std::optional<IndexScanBound> low_;
+  std::optional<IndexScanBound> high_;
+
  protected:
   auto PlanNodeToString() const -> std::string override {
     if (filter_predicate_) {
@@ -15,6 +15,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "binder/table_ref/bound_base_table_ref.h"
 #include "catalog/catalog.h"
@@ -33,13 +34,15 @@ class SeqScanPlanNode : public AbstractPlanNode {
    * Construct a new SeqScanPlanNode instance.
    * @param output The output schema of this sequential scan plan node
    * @param table_oid The identifier of table to be scanned
+   * @param column_ids The columns of the table in the output, empty for all of them
    */
   SeqScanPlanNode(SchemaRef output, table_oid_t table_oid, std::string table_name,
-                  AbstractExpressionRef filter_predicate = nullptr)
+                  AbstractExpressionRef filter_predicate = nullptr, std::vector<uint32_t> column_ids = {})
       : AbstractPlanNode(std::move(output), {}),
         table_oid_{table_oid},
         table_name_(std::move(table_name)),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        column_ids_(std::move(column_ids)) {}
 
   /** @return The type of the plan node */
   auto GetType() const -> PlanType override { return PlanType::SeqScan; }
@@ -47,6 +50,9 @@ class SeqScanPlanNode : public AbstractPlanNode {
   /** @return The identifier of the table that should be scanned */
   auto GetTableOid() const -> table_oid_t { return table_oid_; }
 
+  /** @return true if the scan reads every tuple of the table, so that locking the table beats locking each row */
+  auto IsFullScan() const -> bool { return filter_predicate_ == nullptr; }
+
   static auto InferScanSchema(const BoundBaseTableRef &table_ref) -> Schema;
 
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(SeqScanPlanNode);
@@ -63,13 +69,14 @@ class SeqScanPlanNode : public AbstractPlanNode {
   */
   AbstractExpressionRef filter_predicate_;
 
+  /**
+   * The columns of the table that the scan copies out of the pages, in the order of the output schema. Empty if the
+   * scan returns whole tuples. The filter predicate reads the columns of the table, not those of the output.
+   */
+  std::vector<uint32_t> column_ids_;
+
  protected:
-  auto PlanNodeToString() const -> std::string override {
-    if (filter_predicate_) {
-      return fmt::format("SeqScan {{ table={}, filter={} }}", table_name_, filter_predicate_);
-    }
-    return fmt::format("SeqScan {{ table={} }}", table_name_);
-  }
+  auto PlanNodeToString() const -> std::string override;
 };
 
 }  // namespace bustub
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_heap.h
+//
+// Identification: src/include/execution/topn_heap.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_order_by.h"
+#include "catalog/schema.h"
+#include "execution/compiled_expression.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TopNHeap keeps the first N tuples of an ORDER BY in a bounded max-heap.
+ *
+ * Every ORDER BY expression is evaluated once per input tuple into one uint64 word of a fixed-width sort key. The
+ * words are encoded so that comparing them as unsigned integers gives the requested order; NULLs sort first under ASC
+ * and last under DESC. A VARCHAR key only keeps its first 8 bytes, and a tie on such a prefix is broken by evaluating
+ * and comparing the full values.
+ *
+ * Keys and tuples are stored in flat slot arrays that grow up to N entries and are then reused in place; the heap
+ * itself is an array of slot numbers with the largest key on top. A tuple whose key does not beat the top of a full
+ * heap is rejected before it is copied.
+ *
+ * Push is not thread-safe, a parallel top-N builds one heap per thread and merges them.
+ */
+class TopNHeap {
+ public:
+  /**
+   * Construct an empty heap.
+   * @param order_bys The ORDER BY clauses
+   * @param schema The schema of the pushed tuples, must outlive the heap
+   * @param n The number of tuples to keep
+   */
+  TopNHeap(const std::vector<std::pair<OrderByType, AbstractExpressionRef>> &order_bys, const Schema &schema,
+           size_t n);
+
+  /** Offer a tuple to the heap; the tuple is only copied if it belongs to the first N tuples seen so far. */
+  void Push(const Tuple &tuple);
+
+  /** Offer all tuples of another heap over the same ORDER BY to this heap, leaving the other heap empty. */
+  void Merge(TopNHeap *other);
+
+  /** Remove all tuples from the heap and return them in ORDER BY order. */
+  auto Drain() -> std::vector<Tuple>;
+
+  /** @return the number of tuples in the heap */
+  auto Size() const -> size_t { return heap_.size(); }
+
+  /**
+   * Three-way comparison of two ORDER BY values in ascending order, NULLs first; DESC negates it. SortExecutor orders
+   * its tuples by it as well, so that a top-N returns the first N tuples of the full sort.
+   */
+  static auto CompareValues(const Value &a, const Value &b) -> int;
+
+ private:
+  /** Offer a tuple with an already encoded key. */
+  void PushEncoded(const uint64_t *key, const Tuple &tuple);
+
+  /** Encode the sort key of a tuple into `width_` words. */
+  void EncodeKey(const Tuple &tuple, uint64_t *key) const;
+
+  /** Three-way comparison of two tuples in ORDER BY order. */
+  auto Compare(const uint64_t *a_key, const Tuple &a, const uint64_t *b_key, const Tuple &b) const -> int;
+
+  auto KeyAt(uint32_t slot) -> uint64_t * { return &keys_[static_cast<size_t>(slot) * width_]; }
+  auto KeyAt(uint32_t slot) const -> const uint64_t * { return &keys_[static_cast<size_t>(slot) * width_]; }
+
+  /** `true` if the tuple in slot `a` sorts after the tuple in slot `b` */
+  auto SlotGreater(uint32_t a, uint32_t b) const -> bool {
+    return Compare(KeyAt(a), tuples_[a], KeyAt(b), tuples_[b]) > 0;
+  }
+
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+
+  size_t n_;
+  /** Number of key words per tuple, one per ORDER BY expression */
+  size_t width_;
+  std::vector<CompiledExpression> exprs_;
+  std::vector<TypeId> types_;
+  std::vector<bool> descending_;
+  /** Whether a tie on the key word must be broken by comparing the full values (VARCHAR prefixes) */
+  std::vector<bool> tie_break_;
+  bool any_tie_break_{false};
+
+  /** Key words of every slot, `width_` words per slot */
+  std::vector<uint64_t> keys_;
+  /** Tuple of every slot */
+  std::vector<Tuple> tuples_;
+  /** Slots ordered as a max-heap on their keys */
+  std::vector<uint32_t> heap_;
+  /** Key of the tuple being pushed */
+  std::vector<uint64_t> scratch_;
+};
+
+}  // namespace bustub
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -28,6 +29,27 @@ class Optimizer {
 
   auto OptimizeCustom(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief estimate the rows a plan returns, from the statistics of the tables it reads and the selectivity of its
+   * predicates. EXPLAIN ANALYZE prints the estimates next to the rows the plan actually returned.
+   *
+   * @return the estimated rows, nullopt if the size of a table the plan reads is not known
+   */
+  auto EstimateRows(const AbstractPlanNode &plan) -> std::optional<double>;
+
+  /**
+   * @brief fold the parts of an expression that read no columns or parameters into constants, and simplify its
+   * boolean logic, e.g. `x AND true` into `x` and `x OR true` into `true`. The plan cache folds the expressions of a
+   * cached plan again once their parameters are bound.
+   *
+   * @return the simplified expression, nullptr if the expression is nullptr
+   */
+  static auto SimplifyExpression(const AbstractExpressionRef &expr) -> AbstractExpressionRef;
+
+  /** @brief replace every expression of a plan node, not of its children, by what `rewrite` returns for it */
+  static void RewriteExpressions(AbstractPlanNode *plan,
+                                 const std::function<AbstractExpressionRef(const AbstractExpressionRef &)> &rewrite);
+
  private:
   /**
    * @brief merge projections that do identical project.
@@ -55,6 +77,12 @@ class Optimizer {
    */
   auto OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize nested loop join with one equal condition into adaptive join, which picks index join, hash join or
+   * spilling hash join once it has seen how large its inputs are. Only applied if `enable_adaptive_join` is set.
+   */
+  auto OptimizeNLJAsAdaptiveJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief eliminate always true filter
    */
@@ -96,27 +124,87 @@ class Optimizer {
    */
   auto OptimizeSortLimitAsTopN(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
-  auto OptimizeReorderJoinUseIndex(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
-
+  /**
+   * @brief push filters down towards the scans.
+   * Predicates are split into their conjuncts, which move below projections, below aggregations if they only read the
+   * groups, into the predicate of inner joins and below them to the input they read, and below left joins into the
+   * left input. Equalities of columns with a constant are added for the columns that inner joins make equal to them.
+   * The filters end up right above the scans, where OptimizeMergeFilterIndexScan and OptimizeMergeFilterScan merge
+   * them.
+   */
   auto OptimizePredicatePushDown(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief reorder trees of inner joins by their estimated cost.
+   * A tree of inner nested loop joins is flattened into its inputs and the conjuncts of its predicates. Predicates on
+   * one input are pushed down to it, the inputs are joined again in the order with the lowest cost found, by dynamic
+   * programming over all subsets of up to 10 inputs or greedily for more, and every join is left with a single
+   * equality where there is one, so that OptimizeNLJAsIndexJoin and OptimizeNLJAsHashJoin can pick its algorithm. The
+   * cost model assumes those rules: an index join where the right input is a table scan with an index on the key, a
+   * hash join for other equalities and a nested loop join otherwise.
+   */
+  auto OptimizeJoinOrder(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   auto OptimizeFalseFilter(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
   auto OptimizeRemoveJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
-  auto OptimizeRemoveColumn(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+  /**
+   * @brief prune the columns no plan reads. Every plan returns only the columns its parent reads, projections and
+   * aggregations drop the expressions nobody reads, and table scans return only the columns read above them. Runs last,
+   * after the join algorithms are picked. The inner side of index joins and the children of modifications read whole
+   * tuples and are not pruned.
+   */
+  auto OptimizeColumnPruning(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief simplify every expression of the plan with SimplifyExpression. Filters whose predicate became a constant
+   * are removed, or replaced by an empty result if it is false or NULL. Runs first, so that the other rules see the
+   * folded predicates.
+   */
+  auto OptimizeSimplifyExpressions(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief compute the subexpressions that a projection or an aggregation and the filters right below it evaluate
+   * more than once only once. A projection is added below them that appends every such subexpression to its input as
+   * a column, and the expressions above read that column instead. Runs before OptimizeColumnPruning, which drops the
+   * columns of the input the added projection passes on but nobody reads.
+   */
+  auto OptimizeHoistCommonExpressions(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
   auto OptimizeMergeFilterIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
   /**
-   * @brief get the estimated cardinality for a table based on the table name. Useful when join reordering. BusTub
-   * doesn't support statistics for now, so it's the only way for you to get the table size :(
+   * @brief get the estimated cardinality for a table. Useful when join reordering. The row count of the last ANALYZE
+   * of the table is used if there is one, otherwise the size is guessed from the suffix of the table name.
    *
    * @param table_name
    * @return std::optional<size_t>
    */
   auto EstimatedCardinality(const std::string &table_name) -> std::optional<size_t>;
 
+  /**
+   * @brief estimate the fraction of the rows of a table that satisfy a predicate, from the statistics of the table.
+   * Comparisons of a column with a constant are looked up in the most common values and histogram of the column,
+   * conjunctions and disjunctions of them are assumed to be independent, except for ranges of one column.
+   *
+   * @param predicate a predicate over the columns of the table
+   * @param stats the statistics of the table
+   * @param schema the schema of the table
+   */
+  auto EstimateSelectivity(const AbstractExpression &predicate, const TableStats &stats, const Schema &schema)
+      -> double;
+
+  /** @return the estimated fraction of the rows of a table a predicate over its columns keeps, 1 if it is nullptr */
+  auto EstimateTableSelectivity(const AbstractExpressionRef &predicate, table_oid_t table_oid) -> double;
+
+  /** Selectivities of predicates on columns without statistics */
+  static constexpr double DEFAULT_EQUALITY_SELECTIVITY = 0.1;
+  static constexpr double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+
+  /** An index scan fetches a page for every row it reads, so a filter that keeps more rows is cheaper to scan */
+  static constexpr double INDEX_SCAN_MAX_SELECTIVITY = 0.2;
+
   /** Catalog will be used during the planning process. USERS SHOULD ENSURE IT OUTLIVES
    * OPTIMIZER, otherwise it's a dangling reference.
    */
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// plan_cache.h
+//
+// Identification: src/include/planner/plan_cache.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "execution/plans/abstract_plan.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** A statement with its constants replaced by parameters `$1`, `$2`, ..., and the values of the parameters */
+struct ParameterizedQuery {
+  std::string query_;
+  std::vector<Value> params_;
+};
+
+/** The optimized plan of a statement with parameters */
+struct CachedPlan {
+  /** The plan, or `nullptr` if the statement cannot be planned with parameters, e.g. CREATE TABLE */
+  AbstractPlanNodeRef plan_;
+  /** The output schema of the statement as written, with the names of its columns */
+  SchemaRef output_schema_;
+  /** The version of the catalog the statement was planned with, see Catalog::GetVersion */
+  uint64_t catalog_version_;
+};
+
+/**
+ * PlanCache keeps the optimized plans of the statements executed last, so that a statement executed again with other
+ * constants skips parsing, binding, planning and optimizing. Plans are looked up by the text of the statement with
+ * parameters and the types of their values, a plan made before the catalog changed is planned again.
+ */
+class PlanCache {
+ public:
+  explicit PlanCache(size_t capacity = PLAN_CACHE_SIZE) : capacity_(capacity) {}
+
+  /**
+   * Replace the integer and string constants of a statement by parameters. The constants of LIMIT and OFFSET, which
+   * the planner reads, and those after a `-` stay in the text.
+   * @return the statement with parameters, or nullopt if it is not a SELECT, INSERT, UPDATE or DELETE or if it has
+   * parameters of its own
+   */
+  static auto Parameterize(const std::string &sql) -> std::optional<ParameterizedQuery>;
+
+  /** @return the key of the plan of a statement with parameters, for parameters of the types of the given values */
+  static auto Key(const std::string &query, const std::vector<Value> &params) -> std::string;
+
+  /** @return the plan with its parameters replaced by the given values */
+  static auto BindParameters(const AbstractPlanNodeRef &plan, const std::vector<Value> &params) -> AbstractPlanNodeRef;
+
+  /** @return the cached plan, or `nullptr` if there is none or it was made with another version of the catalog */
+  auto Get(const std::string &key, uint64_t catalog_version) -> std::shared_ptr<const CachedPlan>;
+
+  /** Cache a plan, evicting the least recently used one when the cache is full */
+  void Put(const std::string &key, std::shared_ptr<const CachedPlan> plan);
+
+  /** Drop all plans, e.g. when a session variable the optimizer reads changed */
+  void Clear();
+
+  auto GetHits() const -> uint64_t { return hits_; }
+  auto GetMisses() const -> uint64_t { return misses_; }
+
+ private:
+  size_t capacity_;
+  std::mutex latch_;
+  /** The keys of the cached plans, the most recently used first */
+  std::list<std::string> keys_;
+  std::unordered_map<std::string, std::pair<std::shared_ptr<const CachedPlan>, std::list<std::string>::iterator>>
+      plans_;
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace bustub
@@ -35,6 +35,7 @@ class BoundJoinRef;
 class BoundExpressionListRef;
 class BoundAggCall;
 class BoundCTERef;
+class BoundSubqueryExpr;
 class ColumnValueExpression;
 
 /**
@@ -100,6 +101,33 @@ class Planner {
 
   auto PlanSubquery(const BoundSubqueryRef &table_ref, const std::string &alias) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief Plan a WHERE clause over the plan of the FROM clause.
+   *
+   * Conjuncts that are `EXISTS`, `IN`, `NOT EXISTS` or `NOT IN` subqueries are planned as semi and anti joins, see
+   * `PlanSubqueryExpr`, subqueries elsewhere are not supported.
+   * @param correlated if the WHERE clause is of a subquery, where the conjuncts reading columns of the query around it
+   * go, as they become the predicate of the join rather than a filter. nullptr otherwise.
+   */
+  auto PlanWhere(const BoundExpression &where, AbstractPlanNodeRef plan,
+                 std::vector<const BoundExpression *> *correlated) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief Decorrelate a subquery of a WHERE clause into a join of the plan with the rows of the subquery.
+   *
+   * `EXISTS` and `IN` become a semi join, `NOT EXISTS` an anti join and `NOT IN` a null-aware anti join. The predicate
+   * of the join is the equality tested by `IN` and the conjuncts of the WHERE clause of the subquery that read columns
+   * of the plan, which are left out of the plan of the subquery. Subqueries with aggregation or LIMIT are planned as
+   * they are, and may not be correlated.
+   * @param negated whether it is `NOT EXISTS` or `NOT IN`
+   * @param left the plan whose rows are filtered
+   */
+  auto PlanSubqueryExpr(const BoundSubqueryExpr &expr, bool negated, AbstractPlanNodeRef left) -> AbstractPlanNodeRef;
+
+  /** Plan an expression of a correlated subquery, reading its own columns from `inner` and the others from `outer` */
+  auto PlanCorrelatedExpression(const BoundExpression &expr, const AbstractPlanNodeRef &outer,
+                                const AbstractPlanNodeRef &inner) -> AbstractExpressionRef;
+
   auto PlanBaseTableRef(const BoundBaseTableRef &table_ref) -> AbstractPlanNodeRef;
 
   auto PlanCrossProductRef(const BoundCrossProductRef &table_ref) -> AbstractPlanNodeRef;
@@ -58,6 +58,11 @@ class BPlusTree {
   // return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
+  // Copy out up to max_entries entries in key order, starting at the first key not less than (or, if strict, greater
+  // than) the given key, or at the smallest key if key is nullptr. Unlike an iterator, it holds no latch once it
+  // returns, so the caller may block between two calls.
+  void GetEntries(const KeyType *key, bool strict, size_t max_entries, std::vector<MappingType> *result);
+
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
@@ -82,6 +87,9 @@ class BPlusTree {
                 bool rightMost = false) -> Page *;
   void ReleaseLatchFromQueue(Transaction *transaction);
 
+  // Copy out entries starting at index of the read latched leaf page, then release its latch.
+  void CopyEntries(Page *page, int index, size_t max_entries, std::vector<MappingType> *result);
+
  private:
   void UpdateRootPageId(int insert_record = 0);
 
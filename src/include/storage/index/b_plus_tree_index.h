@@ -14,6 +14,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "container/hash/hash_function.h"
@@ -35,6 +36,9 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** Copy out up to `max_entries` entries in key order, see BPlusTree::GetEntries() */
+  void ScanEntries(const KeyType *key, bool strict, size_t max_entries, std::vector<MappingType> *result);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -60,4 +64,21 @@ using BPlusTreeIndexIteratorForOneIntegerColumn =
     IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
 using IntegerHashFunctionType = HashFunction<IntegerKeyType>;
 
+/** @return the value of a key of an index on one integer column, which also names the key in key locks */
+inline auto IntegerKeyValue(const IntegerKeyType &key) -> int64_t {
+  int32_t value;
+  memcpy(&value, key.data_, sizeof(value));
+  return value;
+}
+
+/** @return the value of the smallest key greater than `key` in the index, or `supremum` if there is none */
+inline auto NextIntegerKeyValue(BPlusTreeIndexForOneIntegerColumn *index, const Tuple &key, int64_t supremum)
+    -> int64_t {
+  IntegerKeyType index_key;
+  index_key.SetFromKey(key);
+  std::vector<std::pair<IntegerKeyType, IntegerValueType>> next;
+  index->ScanEntries(&index_key, true, 1, &next);
+  return next.empty() ? supremum : IntegerKeyValue(next[0].first);
+}
+
 }  // namespace bustub
@@ -123,20 +123,32 @@ class TablePage : public Page {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool;
 
+  /**
+   * Point a tuple at the bytes of a tuple in this page, without copying them. The view is only valid while the page
+   * stays pinned and latched; copying the view (copy constructor / assignment) materializes it.
+   * @param rid rid of the tuple to read
+   * @param[out] tuple the view of the tuple
+   * @param[out] is_deleted if not `nullptr`, tuples marked deleted are read too and this tells whether it is one
+   * @return true if the tuple exists
+   */
+  auto GetTupleView(const RID &rid, Tuple *tuple, bool *is_deleted = nullptr) -> bool;
+
   /** @return the rid of the first tuple in this page */
 
   /**
    * @param[out] first_rid the RID of the first tuple in this page
+   * @param include_deleted whether tuples that are marked deleted count
    * @return true if the first tuple exists, false otherwise
    */
-  auto GetFirstTupleRid(RID *first_rid) -> bool;
+  auto GetFirstTupleRid(RID *first_rid, bool include_deleted = false) -> bool;
 
   /**
    * @param cur_rid the RID of the current tuple
    * @param[out] next_rid the RID of the tuple following the current tuple
+   * @param include_deleted whether tuples that are marked deleted count
    * @return true if the next tuple exists, false otherwise
    */
-  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
+  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid, bool include_deleted = false) -> bool;
 
  private:
   static_assert(sizeof(page_id_t) == 4);
@@ -196,6 +208,14 @@ class TablePage : public Page {
     return static_cast<bool>(tuple_size & DELETE_MASK) || tuple_size == 0;
   }
 
+  /** @return true if the slot holds no tuple at all, not even one marked deleted */
+  static auto IsEmpty(uint32_t tuple_size) -> bool { return (tuple_size & ~DELETE_MASK) == 0; }
+
+  /** @return true if the slot is skipped by a scan that does or does not include tuples marked deleted */
+  static auto IsSkipped(uint32_t tuple_size, bool include_deleted) -> bool {
+    return include_deleted ? IsEmpty(tuple_size) : IsDeleted(tuple_size);
+  }
+
   /** @return tuple size with the deleted flag set */
   static auto SetDeletedFlag(uint32_t tuple_size) -> uint32_t {
     return static_cast<uint32_t>(tuple_size | DELETE_MASK);
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_cursor.h
+//
+// Identification: src/include/storage/table/table_cursor.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class TableHeap;
+class TablePage;
+class Transaction;
+class VersionStore;
+
+/**
+ * TableCursor enables a sequential scan of a TableHeap that does not copy tuples out of their pages.
+ *
+ * Next() points the tuple at the bytes inside the page frame. The page the cursor sits on stays pinned until the
+ * cursor moves past it, and read-latched until Unlatch() is called, so a view is valid until the next call to Next()
+ * or Unlatch(), whichever comes first. Copying a view (Tuple copy constructor / assignment) materializes it.
+ *
+ * A caller must Unlatch() before it returns control to other operators or waits for anything (e.g. a lock), so that
+ * writers of the page are never blocked behind a latch held by a waiting reader. Next() re-latches the page and
+ * continues after the last tuple it returned.
+ *
+ * A cursor for a transaction that reads a snapshot returns the version of every row in the transaction's snapshot,
+ * which is either the tuple in the page (also one marked deleted by a newer transaction) or an older version copied
+ * out of the table's VersionStore.
+ */
+class TableCursor {
+ public:
+  /**
+   * Create a cursor positioned before the first tuple of a table.
+   * @param table_heap the table to scan
+   * @param snapshot the transaction whose snapshot is scanned, `nullptr` to scan the newest tuples
+   */
+  explicit TableCursor(TableHeap *table_heap, Transaction *snapshot = nullptr);
+
+  ~TableCursor();
+
+  DISALLOW_COPY_AND_MOVE(TableCursor);
+
+  /**
+   * Point a tuple at the next tuple of the table.
+   * @param[out] tuple the view of the next tuple
+   * @return false if there are no more tuples
+   */
+  auto Next(Tuple *tuple) -> bool;
+
+  /** Release the latch of the current page, keeping it pinned. Views handed out so far become invalid. */
+  void Unlatch();
+
+ private:
+  /** Move to the next row of the latched page that is visible to the snapshot */
+  auto NextVersion(Tuple *tuple) -> bool;
+
+  /** Unlatch and unpin the current page */
+  void ReleasePage();
+
+  BufferPoolManager *buffer_pool_manager_;
+  VersionStore *version_store_;
+  Transaction *snapshot_;
+  /** The page the cursor sits on, INVALID_PAGE_ID once the scan is over */
+  page_id_t page_id_;
+  /** The pinned current page, or `nullptr` */
+  TablePage *page_{nullptr};
+  bool latched_{false};
+  /** The last tuple returned from the current page, invalid if none was returned yet */
+  RID rid_{};
+};
+
+}  // namespace bustub
@@ -12,11 +12,14 @@
 
 #pragma once
 
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/version_store.h"
 
 namespace bustub {
 
@@ -26,6 +29,7 @@ namespace bustub {
  */
 class TableHeap {
   friend class TableIterator;
+  friend class TableCursor;
 
  public:
   ~TableHeap() = default;
@@ -91,7 +95,15 @@ class TableHeap {
   void RollbackDelete(const RID &rid, Transaction *txn);
 
   /**
-   * Read a tuple from the table.
+   * Called on abort to undo the writes of a transaction to this table. Every page is fetched and latched once for all
+   * the records on it.
+   * @param records the write records of the transaction on this table, newest first
+   * @param txn transaction performing the rollback
+   */
+  void Rollback(std::vector<const TableWriteRecord *> records, Transaction *txn);
+
+  /**
+   * Read a tuple from the table. A transaction that reads a snapshot reads the version in its snapshot.
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
@@ -99,6 +111,25 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
 
+  /**
+   * Check whether a transaction that reads a snapshot may change a row it holds the exclusive lock on, i.e. whether the
+   * row was not changed by another transaction since the snapshot was taken (first updater wins).
+   * @return true if the transaction must abort instead of writing the row
+   */
+  auto HasWriteConflict(const RID &rid, Transaction *txn) -> bool;
+
+  /**
+   * Drop the versions of rows that no snapshot at or after the watermark reads, and remove the tuples from their pages
+   * that were deleted and no snapshot reads any more.
+   */
+  void CollectVersions(const std::vector<RID> &rids, timestamp_t watermark);
+
+  /** Collect the versions of all rows of the table. */
+  void CollectVersions(timestamp_t watermark);
+
+  /** @return the older versions of the rows of this table */
+  inline auto GetVersionStore() -> VersionStore * { return &version_store_; }
+
   /** @return the begin iterator of this table */
   auto Begin(Transaction *txn) -> TableIterator;
 
@@ -108,11 +139,18 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the number of pages of this table, including empty ones */
+  auto GetPageCount() -> size_t;
+
  private:
+  /** Remove deleted tuples from their pages, fetching and latching every page once */
+  void ApplyDeletes(std::vector<RID> rids);
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  VersionStore version_store_;
 };
 
 }  // namespace bustub
@@ -42,12 +42,21 @@ class Tuple {
   // constructor for creating a new tuple based on input value
   Tuple(std::vector<Value> values, const Schema *schema);
 
+  // constructor for the concatenation of two tuples, copies both tuple images without going through Value
+  Tuple(const Tuple &left, const Schema *left_schema, const Tuple &right, const Schema *right_schema);
+
   // copy constructor, deep copy
   Tuple(const Tuple &other);
 
   // assign operator, deep copy
   auto operator=(const Tuple &other) -> Tuple &;
 
+  // move constructor, takes over the buffer of a tuple that owns one and deep copies a view
+  Tuple(Tuple &&other) noexcept;
+
+  // move assign operator, takes over the buffer of a tuple that owns one and deep copies a view
+  auto operator=(Tuple &&other) noexcept -> Tuple &;
+
   ~Tuple() {
     if (allocated_) {
       delete[] data_;
@@ -75,7 +84,12 @@ class Tuple {
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
   // Generates a key tuple given schemas and attributes
-  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
+
+  // Copies some of the columns into a new tuple, which keeps the rid of this one
+  auto ProjectColumns(const Schema &schema, const Schema &projected_schema,
+                      const std::vector<uint32_t> &column_ids) const -> Tuple;
 
   // Is the column value null ?
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.h
+//
+// Identification: src/include/storage/table/version_store.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/** Which version of a row a snapshot reads. */
+enum class VersionVisibility {
+  IN_PAGE,  // the tuple bytes in the table page, even if the tuple is marked deleted
+  OLDER,    // an older version kept in the version store
+  NONE,     // the row does not exist in the snapshot
+};
+
+/**
+ * VersionStore keeps the older versions of the rows of one table for snapshot reads.
+ *
+ * The table page always holds the newest version of a row. Every change to a row pushes an undo record onto the
+ * row's chain that tells what the row looked like before the change: absent before an insert, the tuple that is still
+ * in the page before a delete, and a copy of the old tuple before an update. The record is stamped with the commit
+ * timestamp of its transaction on commit and removed on abort. A reader starts from the page and walks the chain back
+ * until it reaches a change of its own or one committed at or before its snapshot.
+ *
+ * Once every active snapshot reads the newest version, i.e. the chain is committed at or before the watermark, the
+ * chain is dropped. Only then is a deleted tuple removed from its page, so that its slot is not reused while some
+ * snapshot still reads it.
+ *
+ * Chains are kept in partitions with a latch each. A writer pushes its record while it holds the write latch of the
+ * page, and a reader looks a chain up while it holds the read latch of the page, so a reader never sees a change in
+ * the page without its record. Most rows have no chain, so a counting filter over the rows that have one lets a
+ * reader skip the partition latch for them.
+ */
+class VersionStore {
+ public:
+  VersionStore() = default;
+
+  DISALLOW_COPY_AND_MOVE(VersionStore);
+
+  /**
+   * Record a change before it becomes visible in the page. Only the first change of a transaction to a row is
+   * recorded, other snapshots undo all of its changes to the same version.
+   * @param rid the changed row
+   * @param type the change
+   * @param txn_id the writer
+   * @param old_tuple the tuple before an update, `nullptr` for an insert or a delete
+   */
+  void Push(const RID &rid, WType type, txn_id_t txn_id, const Tuple *old_tuple = nullptr);
+
+  /** Stamp the changes of a committing transaction to a row with its commit timestamp. */
+  void Commit(const RID &rid, txn_id_t txn_id, timestamp_t commit_ts);
+
+  /** Forget the changes of an aborted transaction to a row, once the page has been rolled back. */
+  void Abort(const RID &rid, txn_id_t txn_id);
+
+  /**
+   * Find the version of a row that a snapshot reads.
+   * @param rid the row
+   * @param is_deleted whether the tuple in the page is marked deleted
+   * @param read_ts the snapshot
+   * @param txn_id the reader, which also reads its own changes
+   * @param[out] tuple the older version, only set if that is the visible one
+   */
+  auto GetVisibleVersion(const RID &rid, bool is_deleted, timestamp_t read_ts, txn_id_t txn_id, Tuple *tuple)
+      -> VersionVisibility;
+
+  /** @return true if the newest change to a row was made by another transaction after the snapshot */
+  auto HasWriteConflict(const RID &rid, timestamp_t read_ts, txn_id_t txn_id) -> bool;
+
+  /** @return true if a change to a row was committed after the snapshot, for validating an OPTIMISTIC read */
+  auto IsChangedSince(const RID &rid, timestamp_t read_ts) -> bool;
+
+  /** @return the commit timestamp of the last commit that changed any row of the table */
+  auto GetLastCommitTs() const -> timestamp_t { return last_commit_ts_.load(std::memory_order_acquire); }
+
+  /**
+   * Drop the records of a row that no snapshot at or after the watermark reads.
+   * @return true if the chain is gone and the row was deleted; the caller then removes the tuple from its page
+   */
+  auto Collect(const RID &rid, timestamp_t watermark) -> bool;
+
+  /**
+   * Collect the chains of all rows.
+   * @param watermark the oldest snapshot still active
+   * @param[out] deleted the deleted rows whose tuples the caller must remove from their pages
+   */
+  void CollectAll(timestamp_t watermark, std::vector<RID> *deleted);
+
+  /** @return the number of rows that have a chain */
+  auto Size() const -> size_t { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  /** The state of a row before a change */
+  struct UndoRecord {
+    WType type_;
+    txn_id_t txn_id_;
+    timestamp_t commit_ts_{INVALID_TS};
+    /** The tuple before an update */
+    Tuple old_tuple_;
+  };
+
+  struct VersionChain {
+    /** Undo records, newest last */
+    std::vector<UndoRecord> undo_;
+    /** Whether the newest change deleted the row */
+    bool deleted_{false};
+  };
+
+  struct Partition {
+    std::mutex latch_;
+    std::unordered_map<RID, VersionChain> chains_;
+  };
+
+  static constexpr size_t PARTITIONS = 1 << VERSION_STORE_PARTITION_BITS;
+  static constexpr int FILTER_BITS = 12;
+
+  static auto Hash(const RID &rid) -> uint64_t { return std::hash<RID>()(rid) * 0x9E3779B97F4A7C15ULL; }
+
+  auto GetPartition(const RID &rid) -> Partition & {
+    return partitions_[Hash(rid) >> (64 - VERSION_STORE_PARTITION_BITS)];
+  }
+
+  auto FilterSlot(const RID &rid) -> std::atomic<uint32_t> & {
+    return filter_[(Hash(rid) >> (64 - VERSION_STORE_PARTITION_BITS - FILTER_BITS)) & ((1 << FILTER_BITS) - 1)];
+  }
+
+  /** @return false if the row certainly has no chain */
+  auto MayHaveChain(const RID &rid) -> bool { return FilterSlot(rid).load(std::memory_order_relaxed) != 0; }
+
+  /** Count a chain that was added (+1) or dropped (-1) */
+  void CountChain(const RID &rid, int delta) {
+    FilterSlot(rid).fetch_add(delta, std::memory_order_relaxed);
+    size_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  /** Drop the records no snapshot at or after the watermark reads, return true if none are left */
+  static auto Trim(VersionChain *chain, timestamp_t watermark) -> bool;
+
+  std::array<Partition, PARTITIONS> partitions_;
+  /** The number of chains per filter slot */
+  std::array<std::atomic<uint32_t>, 1 << FILTER_BITS> filter_{};
+  std::atomic<size_t> size_{0};
+  std::atomic<timestamp_t> last_commit_ts_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "catalog/column.h"
+#include "catalog/schema.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/adaptive_join_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** The position of every column of the output of a plan in the output of the pruned plan, nullopt if pruned */
+using ColumnMap = std::vector<std::optional<uint32_t>>;
+
+/** Mark the columns an expression reads, of the left and right tuple of a join or of tuple 0 otherwise */
+void Require(const AbstractExpression &expr, std::vector<bool> *left, std::vector<bool> *right) {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(&expr); column != nullptr) {
+    (column->GetTupleIdx() == 0 ? left : right)->at(column->GetColIdx()) = true;
+    return;
+  }
+  for (const auto &child : expr.GetChildren()) {
+    Require(*child, left, right);
+  }
+}
+
+/** @return the expression reading the columns of the pruned inputs */
+auto Remap(const AbstractExpressionRef &expr, const ColumnMap &left, const ColumnMap *right) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    const auto &columns = column->GetTupleIdx() == 0 ? left : *right;
+    return std::make_shared<ColumnValueExpression>(column->GetTupleIdx(), *columns[column->GetColIdx()],
+                                                   column->GetReturnType());
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Remap(child, left, right));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/** @return the schema of the columns to keep, and where they end up in it */
+auto KeepColumns(const Schema &schema, const std::vector<bool> &keep, ColumnMap *columns) -> SchemaRef {
+  std::vector<Column> kept;
+  columns->assign(schema.GetColumnCount(), std::nullopt);
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    if (keep[i]) {
+      (*columns)[i] = kept.size();
+      kept.push_back(schema.GetColumn(i));
+    }
+  }
+  return std::make_shared<Schema>(kept);
+}
+
+/** @return the columns of two joined inputs, one after the other */
+auto Concat(const Schema &left, const Schema &right) -> SchemaRef {
+  std::vector<Column> columns(left.GetColumns());
+  columns.insert(columns.end(), right.GetColumns().begin(), right.GetColumns().end());
+  return std::make_shared<Schema>(columns);
+}
+
+auto Prune(const AbstractPlanNodeRef &plan, std::vector<bool> required, ColumnMap *columns) -> AbstractPlanNodeRef;
+
+/** @return the left and right keys of a hash join or an adaptive join */
+auto GetJoinKeys(const AbstractPlanNode &plan) -> std::pair<AbstractExpressionRef, AbstractExpressionRef> {
+  if (const auto *hash_join = dynamic_cast<const HashJoinPlanNode *>(&plan); hash_join != nullptr) {
+    return {hash_join->left_key_expression_, hash_join->right_key_expression_};
+  }
+  const auto &adaptive_join = dynamic_cast<const AdaptiveJoinPlanNode &>(plan);
+  return {adaptive_join.left_key_expression_, adaptive_join.right_key_expression_};
+}
+
+void SetJoinKeys(AbstractPlanNode *plan, AbstractExpressionRef left_key, AbstractExpressionRef right_key) {
+  if (auto *hash_join = dynamic_cast<HashJoinPlanNode *>(plan); hash_join != nullptr) {
+    hash_join->left_key_expression_ = std::move(left_key);
+    hash_join->right_key_expression_ = std::move(right_key);
+    return;
+  }
+  auto &adaptive_join = dynamic_cast<AdaptiveJoinPlanNode &>(*plan);
+  adaptive_join.left_key_expression_ = std::move(left_key);
+  adaptive_join.right_key_expression_ = std::move(right_key);
+}
+
+/**
+ * @return a join of two pruned inputs, whose output columns are all of the left input followed by all of the right
+ * input, with the predicates reading the left and right tuple remapped, and the right keys reading tuple 0 of the
+ * right input remapped
+ */
+auto PruneJoin(const AbstractPlanNodeRef &plan, const std::vector<bool> &required,
+               const std::vector<AbstractExpressionRef *> &predicates,
+               const std::vector<AbstractExpressionRef *> &right_keys, ColumnMap *columns, ColumnMap *right_columns)
+    -> std::unique_ptr<AbstractPlanNode> {
+  const auto &left_plan = plan->GetChildAt(0);
+  const auto &right_plan = plan->GetChildAt(1);
+  auto left_count = left_plan->OutputSchema().GetColumnCount();
+  // A semi or anti join only returns the left columns.
+  bool is_left_only = plan->OutputSchema().GetColumnCount() == left_count;
+  std::vector<bool> left_required(required.begin(), required.begin() + left_count);
+  std::vector<bool> right_required(right_plan->OutputSchema().GetColumnCount(), false);
+  if (!is_left_only) {
+    std::copy(required.begin() + left_count, required.end(), right_required.begin());
+  }
+  for (const auto *predicate : predicates) {
+    Require(**predicate, &left_required, &right_required);
+  }
+  // Also for a semi or anti join, whose output has none of the right columns.
+  for (const auto *right_key : right_keys) {
+    Require(**right_key, &right_required, nullptr);
+  }
+  ColumnMap left_columns;
+  auto left = Prune(left_plan, std::move(left_required), &left_columns);
+  auto right = Prune(right_plan, std::move(right_required), right_columns);
+  auto pruned_left_count = left->OutputSchema().GetColumnCount();
+  *columns = left_columns;
+  auto pruned = plan->CloneWithChildren({left, right});
+  if (is_left_only) {
+    pruned->output_schema_ = std::make_shared<Schema>(left->OutputSchema());
+  } else {
+    for (const auto &column : *right_columns) {
+      columns->push_back(column.has_value() ? std::make_optional(pruned_left_count + *column) : std::nullopt);
+    }
+    pruned->output_schema_ = Concat(left->OutputSchema(), right->OutputSchema());
+  }
+  for (auto *predicate : predicates) {
+    *predicate = Remap(*predicate, left_columns, right_columns);
+  }
+  for (auto *right_key : right_keys) {
+    *right_key = Remap(*right_key, *right_columns, nullptr);
+  }
+  return pruned;
+}
+
+/**
+ * Prune the columns of the output of a plan that are not required, and those of its inputs that it does not need.
+ * @param required the columns of the output the parent reads
+ * @param[out] columns where the columns of the output of the plan ended up
+ */
+auto Prune(const AbstractPlanNodeRef &plan, std::vector<bool> required, ColumnMap *columns) -> AbstractPlanNodeRef {
+  // A plan returns at least one column, e.g. for `SELECT count(*)`.
+  if (!required.empty() && std::find(required.begin(), required.end(), true) == required.end()) {
+    required[0] = true;
+  }
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*plan);
+      if (std::find(required.begin(), required.end(), false) == required.end()) {
+        break;
+      }
+      std::vector<uint32_t> column_ids;
+      for (uint32_t i = 0; i < required.size(); i++) {
+        if (required[i]) {
+          column_ids.push_back(seq_scan.column_ids_.empty() ? i : seq_scan.column_ids_[i]);
+        }
+      }
+      return std::make_shared<SeqScanPlanNode>(KeepColumns(plan->OutputSchema(), required, columns),
+                                               seq_scan.table_oid_, seq_scan.table_name_, seq_scan.filter_predicate_,
+                                               std::move(column_ids));
+    }
+    case PlanType::Projection: {
+      const auto &projection_plan = dynamic_cast<const ProjectionPlanNode &>(*plan);
+      std::vector<bool> child_required(projection_plan.GetChildPlan()->OutputSchema().GetColumnCount());
+      std::vector<AbstractExpressionRef> exprs;
+      for (size_t i = 0; i < required.size(); i++) {
+        if (required[i]) {
+          Require(*projection_plan.GetExpressions()[i], &child_required, nullptr);
+        }
+      }
+      ColumnMap child_columns;
+      auto child = Prune(projection_plan.GetChildPlan(), std::move(child_required), &child_columns);
+      for (size_t i = 0; i < required.size(); i++) {
+        if (required[i]) {
+          exprs.push_back(Remap(projection_plan.GetExpressions()[i], child_columns, nullptr));
+        }
+      }
+      return std::make_shared<ProjectionPlanNode>(KeepColumns(plan->OutputSchema(), required, columns),
+                                                  std::move(exprs), std::move(child));
+    }
+    case PlanType::Aggregation: {
+      // Every group is kept, aggregates that are not read are not computed.
+      const auto &agg_plan = dynamic_cast<const AggregationPlanNode &>(*plan);
+      auto group_count = agg_plan.GetGroupBys().size();
+      std::fill(required.begin(), required.begin() + group_count, true);
+      std::vector<bool> child_required(agg_plan.GetChildPlan()->OutputSchema().GetColumnCount());
+      for (size_t i = 0; i < required.size(); i++) {
+        if (required[i]) {
+          const auto &expr = i < group_count ? agg_plan.GetGroupBys()[i] : agg_plan.GetAggregates()[i - group_count];
+          Require(*expr, &child_required, nullptr);
+        }
+      }
+      ColumnMap child_columns;
+      auto child = Prune(agg_plan.GetChildPlan(), std::move(child_required), &child_columns);
+      std::vector<AbstractExpressionRef> group_bys;
+      std::vector<AbstractExpressionRef> aggregates;
+      std::vector<AggregationType> agg_types;
+      for (size_t i = 0; i < required.size(); i++) {
+        if (i < group_count) {
+          group_bys.push_back(Remap(agg_plan.GetGroupBys()[i], child_columns, nullptr));
+        } else if (required[i]) {
+          aggregates.push_back(Remap(agg_plan.GetAggregates()[i - group_count], child_columns, nullptr));
+          agg_types.push_back(agg_plan.GetAggregateTypes()[i - group_count]);
+        }
+      }
+      return std::make_shared<AggregationPlanNode>(KeepColumns(plan->OutputSchema(), required, columns),
+                                                   std::move(child), std::move(group_bys), std::move(aggregates),
+                                                   std::move(agg_types));
+    }
+    case PlanType::Filter:
+    case PlanType::Sort:
+    case PlanType::TopN:
+    case PlanType::Limit: {
+      // These return the rows of their child as they are, with the columns their parent or they themselves read.
+      auto pruned = plan->CloneWithChildren(plan->GetChildren());
+      std::vector<AbstractExpressionRef *> exprs;
+      if (auto *filter_plan = dynamic_cast<FilterPlanNode *>(pruned.get()); filter_plan != nullptr) {
+        exprs.push_back(&filter_plan->predicate_);
+      } else if (auto *sort_plan = dynamic_cast<SortPlanNode *>(pruned.get()); sort_plan != nullptr) {
+        for (auto &order_by : sort_plan->order_bys_) {
+          exprs.push_back(&order_by.second);
+        }
+      } else if (auto *topn_plan = dynamic_cast<TopNPlanNode *>(pruned.get()); topn_plan != nullptr) {
+        for (auto &order_by : topn_plan->order_bys_) {
+          exprs.push_back(&order_by.second);
+        }
+      }
+      for (const auto *expr : exprs) {
+        Require(**expr, &required, nullptr);
+      }
+      auto child = Prune(plan->GetChildAt(0), std::move(required), columns);
+      for (auto *expr : exprs) {
+        *expr = Remap(*expr, *columns, nullptr);
+      }
+      pruned->children_ = {child};
+      pruned->output_schema_ = child->output_schema_;
+      return pruned;
+    }
+    case PlanType::NestedLoopJoin: {
+      auto predicate = dynamic_cast<const NestedLoopJoinPlanNode &>(*plan).predicate_;
+      ColumnMap right_columns;
+      auto pruned = PruneJoin(plan, required, {&predicate}, {}, columns, &right_columns);
+      dynamic_cast<NestedLoopJoinPlanNode &>(*pruned).predicate_ = predicate;
+      return pruned;
+    }
+    case PlanType::HashJoin:
+    case PlanType::AdaptiveJoin: {
+      // Both keys read tuple 0, the left one of the left input and the right one of the right input.
+      auto [left_key, right_key] = GetJoinKeys(*plan);
+      ColumnMap right_columns;
+      auto pruned = PruneJoin(plan, required, {&left_key}, {&right_key}, columns, &right_columns);
+      SetJoinKeys(pruned.get(), left_key, right_key);
+      return pruned;
+    }
+    case PlanType::NestedIndexJoin: {
+      // The inner tuples are read from the table as a whole, only the outer input is pruned.
+      const auto &index_join_plan = dynamic_cast<const NestedIndexJoinPlanNode &>(*plan);
+      auto outer_count = index_join_plan.GetChildPlan()->OutputSchema().GetColumnCount();
+      std::vector<bool> outer_required(required.begin(), required.begin() + outer_count);
+      Require(*index_join_plan.key_predicate_, &outer_required, nullptr);
+      ColumnMap outer_columns;
+      auto outer = Prune(index_join_plan.GetChildPlan(), std::move(outer_required), &outer_columns);
+      auto pruned = plan->CloneWithChildren({outer});
+      auto &pruned_index_join = dynamic_cast<NestedIndexJoinPlanNode &>(*pruned);
+      pruned_index_join.key_predicate_ = Remap(index_join_plan.key_predicate_, outer_columns, nullptr);
+      pruned_index_join.output_schema_ = Concat(outer->OutputSchema(), *index_join_plan.inner_table_schema_);
+      *columns = outer_columns;
+      for (uint32_t i = 0; i < index_join_plan.inner_table_schema_->GetColumnCount(); i++) {
+        columns->push_back(outer->OutputSchema().GetColumnCount() + i);
+      }
+      return pruned;
+    }
+    default:
+      break;
+  }
+  // Other plans keep their output and read every column of their children, e.g. a delete removes whole tuples.
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    ColumnMap child_columns;
+    std::vector<bool> child_required(child->OutputSchema().GetColumnCount(), true);
+    children.emplace_back(Prune(child, std::move(child_required), &child_columns));
+  }
+  columns->clear();
+  for (uint32_t i = 0; i < plan->OutputSchema().GetColumnCount(); i++) {
+    columns->push_back(i);
+  }
+  return plan->CloneWithChildren(std::move(children));
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeColumnPruning(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  ColumnMap columns;
+  return Prune(plan, std::vector<bool>(plan->OutputSchema().GetColumnCount(), true), &columns);
+}
+
+}  // namespace bustub
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/column.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "fmt/format.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Count how often every subexpression that is not a column or a constant occurs, by its text */
+void Count(const AbstractExpression &expr, std::unordered_map<std::string, size_t> *counts) {
+  if (expr.GetChildren().empty()) {
+    return;
+  }
+  (*counts)[expr.ToString()]++;
+  for (const auto &child : expr.GetChildren()) {
+    Count(*child, counts);
+  }
+}
+
+/** The subexpressions computed once below the plans that read them */
+struct Hoisted {
+  /** The hoisted subexpressions, in the order they are first read */
+  std::vector<AbstractExpressionRef> exprs_;
+  /** The index of every hoisted subexpression by its text */
+  std::unordered_map<std::string, size_t> indexes_;
+  /** The lowest plan of the chain that reads every hoisted subexpression */
+  std::vector<size_t> levels_;
+};
+
+/** Collect the outermost subexpressions that occur more than once of an expression of plan `level` of the chain */
+void Collect(const AbstractExpressionRef &expr, const std::unordered_map<std::string, size_t> &counts, size_t level,
+             Hoisted *hoisted) {
+  if (expr->GetChildren().empty()) {
+    return;
+  }
+  auto key = expr->ToString();
+  if (counts.at(key) > 1) {
+    auto [index, inserted] = hoisted->indexes_.emplace(key, hoisted->exprs_.size());
+    if (inserted) {
+      hoisted->exprs_.push_back(expr);
+      hoisted->levels_.push_back(level);
+    } else {
+      hoisted->levels_[index->second] = std::max(hoisted->levels_[index->second], level);
+    }
+    return;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    Collect(child, counts, level, hoisted);
+  }
+}
+
+/** @return the expression with its hoisted subexpressions read from their column */
+auto Replace(const AbstractExpressionRef &expr, const std::unordered_map<std::string, uint32_t> &columns)
+    -> AbstractExpressionRef {
+  if (expr->GetChildren().empty()) {
+    return expr;
+  }
+  if (auto column = columns.find(expr->ToString()); column != columns.end()) {
+    return std::make_shared<ColumnValueExpression>(0, column->second, expr->GetReturnType());
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Replace(child, columns));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/** @return the expression with column `i` of tuple 0 read from column `columns[i]` */
+auto Renumber(const AbstractExpressionRef &expr, const std::vector<uint32_t> &columns) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    return std::make_shared<ColumnValueExpression>(0, columns[column->GetColIdx()], column->GetReturnType());
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Renumber(child, columns));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/**
+ * Drop the aggregates an aggregation computes more than once, which the planner plans for every time an aggregate is
+ * written, e.g. in the select list and in HAVING.
+ * @param[out] columns the column of the new aggregation every column of the old one ended up in
+ * @return the new aggregation, or nullptr if every aggregate is computed once already
+ */
+auto DedupAggregates(const AggregationPlanNode &agg_plan, std::vector<uint32_t> *columns) -> AbstractPlanNodeRef {
+  auto group_count = static_cast<uint32_t>(agg_plan.GetGroupBys().size());
+  const auto &schema = agg_plan.OutputSchema();
+  std::vector<Column> output_columns(schema.GetColumns().begin(), schema.GetColumns().begin() + group_count);
+  std::vector<AbstractExpressionRef> aggregates;
+  std::vector<AggregationType> agg_types;
+  std::unordered_map<std::string, uint32_t> seen;
+  columns->clear();
+  for (uint32_t i = 0; i < group_count; i++) {
+    columns->push_back(i);
+  }
+  for (size_t i = 0; i < agg_plan.GetAggregates().size(); i++) {
+    auto key = fmt::format("{}{}", agg_plan.GetAggregateTypes()[i], agg_plan.GetAggregateAt(i));
+    auto [column, inserted] = seen.emplace(key, group_count + aggregates.size());
+    if (inserted) {
+      aggregates.push_back(agg_plan.GetAggregateAt(i));
+      agg_types.push_back(agg_plan.GetAggregateTypes()[i]);
+      output_columns.push_back(schema.GetColumn(group_count + i));
+    }
+    columns->push_back(column->second);
+  }
+  if (aggregates.size() == agg_plan.GetAggregates().size()) {
+    return nullptr;
+  }
+  return std::make_shared<AggregationPlanNode>(std::make_shared<Schema>(output_columns), agg_plan.GetChildPlan(),
+                                               agg_plan.GetGroupBys(), std::move(aggregates), std::move(agg_types));
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeHoistCommonExpressions(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeHoistCommonExpressions(child));
+  }
+  std::shared_ptr<AbstractPlanNode> optimized_plan = plan->CloneWithChildren(std::move(children));
+  if (optimized_plan->GetType() != PlanType::Projection && optimized_plan->GetType() != PlanType::Aggregation) {
+    return optimized_plan;
+  }
+
+  // The plan and the filters right below it all read the columns of the input below the filters.
+  std::vector<std::shared_ptr<AbstractPlanNode>> chain{optimized_plan};
+  while (chain.back()->GetChildAt(0)->GetType() == PlanType::Filter) {
+    const auto &filter = chain.back()->GetChildAt(0);
+    chain.push_back(filter->CloneWithChildren(filter->GetChildren()));
+  }
+  auto input = chain.back()->GetChildAt(0);
+  // Put a new input below the chain, which the filters pass on.
+  auto link = [&chain](const AbstractPlanNodeRef &child) {
+    chain.back()->children_ = {child};
+    for (size_t i = chain.size() - 1; i > 0; i--) {
+      chain[i]->output_schema_ = child->output_schema_;
+      chain[i - 1]->children_ = {chain[i]};
+    }
+  };
+
+  if (input->GetType() == PlanType::Aggregation) {
+    std::vector<uint32_t> columns;
+    if (auto deduped = DedupAggregates(dynamic_cast<const AggregationPlanNode &>(*input), &columns);
+        deduped != nullptr) {
+      auto renumber = [&columns](const AbstractExpressionRef &expr) { return Renumber(expr, columns); };
+      for (const auto &node : chain) {
+        RewriteExpressions(node.get(), renumber);
+      }
+      input = deduped;
+      link(input);
+    }
+  }
+
+  std::unordered_map<std::string, size_t> counts;
+  for (const auto &node : chain) {
+    RewriteExpressions(node.get(), [&counts](const AbstractExpressionRef &expr) {
+      Count(*expr, &counts);
+      return expr;
+    });
+  }
+  if (std::none_of(counts.begin(), counts.end(), [](const auto &count) { return count.second > 1; })) {
+    return optimized_plan;
+  }
+
+  Hoisted hoisted;
+  for (size_t level = 0; level < chain.size(); level++) {
+    RewriteExpressions(chain[level].get(), [&counts, &hoisted, level](const AbstractExpressionRef &expr) {
+      Collect(expr, counts, level, &hoisted);
+      return expr;
+    });
+  }
+
+  // Every subexpression is computed by a projection right below the lowest plan that reads it, so that it is never
+  // computed for the rows a filter further down drops. A projection passes its input on followed by the subexpressions
+  // it computes, hence the columns of the lowest projection come first.
+  std::vector<std::vector<size_t>> computed(chain.size());
+  for (size_t i = 0; i < hoisted.exprs_.size(); i++) {
+    computed[hoisted.levels_[i]].push_back(i);
+  }
+  std::unordered_map<std::string, uint32_t> columns;
+  auto column_count = input->OutputSchema().GetColumnCount();
+  for (size_t level = chain.size(); level-- > 0;) {
+    for (auto i : computed[level]) {
+      columns.emplace(hoisted.exprs_[i]->ToString(), column_count++);
+    }
+  }
+  for (const auto &node : chain) {
+    RewriteExpressions(node.get(), [&columns](const AbstractExpressionRef &expr) { return Replace(expr, columns); });
+  }
+
+  AbstractPlanNodeRef child = input;
+  for (size_t level = chain.size(); level-- > 0;) {
+    if (!computed[level].empty()) {
+      // The input is passed on as it is, followed by the hoisted subexpressions.
+      std::vector<AbstractExpressionRef> exprs;
+      std::vector<Column> output_columns = child->OutputSchema().GetColumns();
+      for (uint32_t i = 0; i < output_columns.size(); i++) {
+        exprs.push_back(std::make_shared<ColumnValueExpression>(0, i, output_columns[i].GetType()));
+      }
+      for (auto i : computed[level]) {
+        auto name = fmt::format("__bustub_internal.common_{}", i);
+        auto type = hoisted.exprs_[i]->GetReturnType();
+        output_columns.emplace_back(type == TypeId::VARCHAR ? Column(name, type, VARCHAR_DEFAULT_LENGTH)
+                                                            : Column(name, type));
+        exprs.push_back(hoisted.exprs_[i]);
+      }
+      child = std::make_shared<ProjectionPlanNode>(std::make_shared<Schema>(output_columns), std::move(exprs), child);
+    }
+    chain[level]->children_ = {child};
+    if (level > 0) {
+      chain[level]->output_schema_ = child->output_schema_;
+    }
+    child = chain[level];
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "catalog/column.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/mock_scan_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/values_plan.h"
+#include "optimizer/optimizer.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Relations of an input whose size is not known */
+constexpr double DEFAULT_CARDINALITY = 1000;
+/** At most this many relations are joined by dynamic programming over all their subsets, more are joined greedily */
+constexpr size_t MAX_DP_RELATIONS = 10;
+/** Relations are numbered by the bits of a mask */
+constexpr size_t MAX_RELATIONS = 64;
+/** Building a hash table costs this much per row, looking up an index per outer row */
+constexpr double HASH_BUILD_COST = 2;
+constexpr double INDEX_LOOKUP_COST = 4;
+/** Size of a row buffered by a nested loop join */
+constexpr double ESTIMATED_ROW_BYTES = 64;
+/**
+ * The written join order is kept unless another one is estimated to be this much cheaper, since a join order changes
+ * the order of the rows a query returns without ORDER BY.
+ */
+constexpr double REORDER_MIN_GAIN = 0.9;
+
+auto IsInnerJoin(const AbstractPlanNode &plan) -> bool {
+  const auto *nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode *>(&plan);
+  return nlj_plan != nullptr && nlj_plan->GetJoinType() == JoinType::INNER;
+}
+
+/** @return true for an inner join, or a filter above an inner join, whose inputs can be joined in any order */
+auto IsJoinTree(const AbstractPlanNode &plan) -> bool {
+  if (plan.GetType() == PlanType::Filter) {
+    return IsInnerJoin(*plan.GetChildAt(0));
+  }
+  return IsInnerJoin(plan);
+}
+
+auto CountRelations(const AbstractPlanNode &plan) -> size_t {
+  if (!IsJoinTree(plan)) {
+    return 1;
+  }
+  if (plan.GetType() == PlanType::Filter) {
+    return CountRelations(*plan.GetChildAt(0));
+  }
+  return CountRelations(*plan.GetChildAt(0)) + CountRelations(*plan.GetChildAt(1));
+}
+
+auto Lowest(uint64_t relations) -> size_t { return __builtin_ctzll(relations); }
+
+auto IsSingle(uint64_t relations) -> bool { return relations != 0 && (relations & (relations - 1)) == 0; }
+
+auto And(const std::vector<AbstractExpressionRef> &exprs) -> AbstractExpressionRef {
+  AbstractExpressionRef result;
+  for (const auto &expr : exprs) {
+    result = result == nullptr ? expr : std::make_shared<LogicExpression>(result, expr, LogicType::And);
+  }
+  return result;
+}
+
+/** @return the expression with every column numbered by `(tuple, column) -> positions[column]` */
+auto Rebind(const AbstractExpressionRef &expr, const std::vector<std::pair<uint32_t, uint32_t>> &positions)
+    -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    auto [tuple_idx, col_idx] = positions[column->GetColIdx()];
+    return std::make_shared<ColumnValueExpression>(tuple_idx, col_idx, column->GetReturnType());
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Rebind(child, positions));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/** A relation joined by a flattened tree of inner joins */
+struct JoinLeaf {
+  AbstractPlanNodeRef plan_;
+  /** Position of the first column of the relation in the output of the written join tree */
+  uint32_t offset_{0};
+  /** Estimated rows of the relation, and of those that satisfy its own predicates */
+  double base_rows_{DEFAULT_CARDINALITY};
+  double rows_{DEFAULT_CARDINALITY};
+  /** Estimated distinct values of every column, 0 if unknown */
+  std::vector<double> distinct_;
+  /** Columns an index join can look up, only for a table scan that keeps every row */
+  std::vector<bool> indexed_;
+};
+
+/** A conjunct of the predicates of a join tree, whose columns are numbered as in the output of the written tree */
+struct JoinConjunct {
+  AbstractExpressionRef expr_;
+  /** The relations the conjunct refers to */
+  uint64_t relations_{0};
+  /** The two columns of `a = b` between two relations */
+  std::optional<std::pair<uint32_t, uint32_t>> equi_columns_;
+  double selectivity_{1};
+};
+
+/** The cheapest way found to join a set of relations */
+struct JoinEntry {
+  double rows_{0};
+  double cost_{0};
+  /** The relations of the left and right input, 0 for a single relation */
+  uint64_t left_{0};
+  uint64_t right_{0};
+};
+
+using JoinTable = std::unordered_map<uint64_t, JoinEntry>;
+
+/**
+ * A tree of inner joins flattened into its relations and the conjuncts of its predicates, which can be joined again
+ * in any order.
+ */
+class JoinGraph {
+ public:
+  /** Collect the relations and predicates of a join tree, see IsJoinTree() */
+  void Flatten(const AbstractPlanNodeRef &plan) { Collect(plan); }
+
+  auto Leaves() -> std::vector<JoinLeaf> & { return leaves_; }
+  auto Conjuncts() -> std::vector<JoinConjunct> & { return conjuncts_; }
+  auto ColumnCount() const -> uint32_t { return static_cast<uint32_t>(column_relation_.size()); }
+
+  /** @return the conjuncts that refer only to one relation, numbered as in the output of that relation */
+  auto LocalConjuncts(size_t leaf) const -> std::vector<AbstractExpressionRef> {
+    std::vector<std::pair<uint32_t, uint32_t>> positions(column_relation_.size());
+    for (uint32_t i = leaves_[leaf].offset_; i < positions.size() && column_relation_[i] == leaf; i++) {
+      positions[i] = {0, i - leaves_[leaf].offset_};
+    }
+    std::vector<AbstractExpressionRef> local;
+    for (const auto &conjunct : conjuncts_) {
+      if (conjunct.relations_ == uint64_t{1} << leaf) {
+        local.push_back(Rebind(conjunct.expr_, positions));
+      }
+    }
+    return local;
+  }
+
+  auto ColumnRelation(uint32_t column) const -> size_t { return column_relation_[column]; }
+
+  /** @return the joins of the written tree, each input before the join that reads it */
+  auto WrittenJoinTable() -> JoinTable {
+    auto table = LeafTable();
+    for (auto [left, right] : written_joins_) {
+      table[left | right] = Join(left, right, table);
+    }
+    return table;
+  }
+
+  /** @return the cheapest join of all relations, found by dynamic programming or greedily for many relations */
+  auto BestJoinTable() -> JoinTable {
+    auto table = LeafTable();
+    uint64_t all = AllRelations();
+    if (leaves_.size() > MAX_DP_RELATIONS) {
+      JoinGreedily(&table);
+      return table;
+    }
+    for (uint64_t set = 1; set <= all; set++) {
+      if (IsSingle(set)) {
+        continue;
+      }
+      // Cross products are considered only for a set of relations that no predicate connects.
+      std::optional<JoinEntry> best;
+      for (bool connected_only : {true, false}) {
+        for (uint64_t left = (set - 1) & set; left != 0; left = (left - 1) & set) {
+          uint64_t right = set ^ left;
+          if (connected_only && !Connected(left, right)) {
+            continue;
+          }
+          auto entry = Join(left, right, table);
+          if (!best.has_value() || entry.cost_ < best->cost_) {
+            best = entry;
+          }
+        }
+        if (best.has_value()) {
+          break;
+        }
+      }
+      table[set] = *best;
+    }
+    return table;
+  }
+
+  auto AllRelations() const -> uint64_t {
+    return leaves_.size() == MAX_RELATIONS ? ~uint64_t{0} : (uint64_t{1} << leaves_.size()) - 1;
+  }
+
+  /**
+   * Build the joins of a table as plan nodes.
+   * @param[out] columns the columns of the output of the plan, numbered as in the output of the written tree
+   */
+  auto Build(uint64_t relations, const JoinTable &table, std::vector<uint32_t> *columns) const
+      -> AbstractPlanNodeRef {
+    const auto &entry = table.at(relations);
+    if (entry.left_ == 0) {
+      const auto &leaf = leaves_[Lowest(relations)];
+      for (uint32_t i = 0; i < leaf.plan_->OutputSchema().GetColumnCount(); i++) {
+        columns->push_back(leaf.offset_ + i);
+      }
+      auto local = And(LocalConjuncts(Lowest(relations)));
+      if (local == nullptr) {
+        return leaf.plan_;
+      }
+      return std::make_shared<FilterPlanNode>(leaf.plan_->output_schema_, std::move(local), leaf.plan_);
+    }
+
+    std::vector<uint32_t> left_columns;
+    std::vector<uint32_t> right_columns;
+    auto left = Build(entry.left_, table, &left_columns);
+    auto right = Build(entry.right_, table, &right_columns);
+    std::vector<std::pair<uint32_t, uint32_t>> join_positions(column_relation_.size());
+    std::vector<std::pair<uint32_t, uint32_t>> output_positions(column_relation_.size());
+    for (uint32_t i = 0; i < left_columns.size(); i++) {
+      join_positions[left_columns[i]] = {0, i};
+      output_positions[left_columns[i]] = {0, i};
+    }
+    for (uint32_t i = 0; i < right_columns.size(); i++) {
+      join_positions[right_columns[i]] = {1, i};
+      output_positions[right_columns[i]] = {0, static_cast<uint32_t>(left_columns.size()) + i};
+    }
+    std::vector<Column> schema(left->OutputSchema().GetColumns());
+    for (const auto &column : right->OutputSchema().GetColumns()) {
+      schema.push_back(column);
+    }
+    auto output_schema = std::make_shared<Schema>(schema);
+    columns->insert(columns->end(), left_columns.begin(), left_columns.end());
+    columns->insert(columns->end(), right_columns.begin(), right_columns.end());
+
+    // A join on one equality can run as a hash or index join, the other predicates of the join filter its output.
+    const auto *key = KeyConjunct(entry.left_, entry.right_);
+    std::vector<AbstractExpressionRef> join_predicates;
+    std::vector<AbstractExpressionRef> residual;
+    for (const auto &conjunct : conjuncts_) {
+      if (!Joins(conjunct, entry.left_, entry.right_)) {
+        continue;
+      }
+      if (key == nullptr || &conjunct == key) {
+        join_predicates.push_back(Rebind(conjunct.expr_, join_positions));
+      } else {
+        residual.push_back(Rebind(conjunct.expr_, output_positions));
+      }
+    }
+    auto predicate = join_predicates.empty()
+                         ? std::make_shared<ConstantValueExpression>(ValueFactory::GetBooleanValue(true))
+                         : And(join_predicates);
+    AbstractPlanNodeRef join = std::make_shared<NestedLoopJoinPlanNode>(output_schema, std::move(left),
+                                                                        std::move(right), predicate, JoinType::INNER);
+    if (!residual.empty()) {
+      join = std::make_shared<FilterPlanNode>(output_schema, And(residual), join);
+    }
+    return join;
+  }
+
+ private:
+  auto Collect(const AbstractPlanNodeRef &plan) -> uint64_t {
+    if (plan->GetType() == PlanType::Filter && IsJoinTree(*plan)) {
+      const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*plan);
+      auto relations = Collect(filter_plan.GetChildPlan());
+      auto offset = leaves_[Lowest(relations)].offset_;
+      AddConjuncts(filter_plan.GetPredicate(), offset, offset);
+      return relations;
+    }
+    if (IsInnerJoin(*plan)) {
+      const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*plan);
+      auto left = Collect(nlj_plan.GetLeftPlan());
+      auto right = Collect(nlj_plan.GetRightPlan());
+      written_joins_.emplace_back(left, right);
+      AddConjuncts(nlj_plan.predicate_, leaves_[Lowest(left)].offset_, leaves_[Lowest(right)].offset_);
+      return left | right;
+    }
+    JoinLeaf leaf;
+    leaf.plan_ = plan;
+    leaf.offset_ = static_cast<uint32_t>(column_relation_.size());
+    column_relation_.insert(column_relation_.end(), plan->OutputSchema().GetColumnCount(), leaves_.size());
+    leaves_.push_back(std::move(leaf));
+    return uint64_t{1} << (leaves_.size() - 1);
+  }
+
+  /** Split a predicate into its conjuncts, whose columns of the left and right tuple start at the given offsets */
+  void AddConjuncts(const AbstractExpressionRef &expr, uint32_t left_offset, uint32_t right_offset) {
+    if (const auto *logic = dynamic_cast<const LogicExpression *>(expr.get());
+        logic != nullptr && logic->logic_type_ == LogicType::And) {
+      AddConjuncts(logic->children_[0], left_offset, right_offset);
+      AddConjuncts(logic->children_[1], left_offset, right_offset);
+      return;
+    }
+    if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr.get());
+        constant != nullptr && !constant->val_.IsNull() && constant->val_.CastAs(TypeId::BOOLEAN).GetAs<bool>()) {
+      return;
+    }
+    JoinConjunct conjunct;
+    conjunct.expr_ = Flat(expr, left_offset, right_offset, &conjunct.relations_);
+    if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct.expr_.get());
+        comparison != nullptr && comparison->comp_type_ == ComparisonType::Equal) {
+      const auto *left = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+      const auto *right = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+      if (left != nullptr && right != nullptr &&
+          column_relation_[left->GetColIdx()] != column_relation_[right->GetColIdx()]) {
+        conjunct.equi_columns_ = {left->GetColIdx(), right->GetColIdx()};
+      }
+    }
+    conjuncts_.push_back(std::move(conjunct));
+  }
+
+  auto Flat(const AbstractExpressionRef &expr, uint32_t left_offset, uint32_t right_offset, uint64_t *relations)
+      -> AbstractExpressionRef {
+    if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+      auto col_idx = (column->GetTupleIdx() == 0 ? left_offset : right_offset) + column->GetColIdx();
+      *relations |= uint64_t{1} << column_relation_[col_idx];
+      return std::make_shared<ColumnValueExpression>(0, col_idx, column->GetReturnType());
+    }
+    std::vector<AbstractExpressionRef> children;
+    for (const auto &child : expr->GetChildren()) {
+      children.emplace_back(Flat(child, left_offset, right_offset, relations));
+    }
+    return expr->CloneWithChildren(std::move(children));
+  }
+
+  auto LeafTable() const -> JoinTable {
+    JoinTable table;
+    for (size_t i = 0; i < leaves_.size(); i++) {
+      table[uint64_t{1} << i] = JoinEntry{leaves_[i].rows_, leaves_[i].base_rows_, 0, 0};
+    }
+    return table;
+  }
+
+  /** @return true if the conjunct is evaluated by the join of two sets of relations */
+  static auto Joins(const JoinConjunct &conjunct, uint64_t left, uint64_t right) -> bool {
+    return (conjunct.relations_ & left) != 0 && (conjunct.relations_ & right) != 0 &&
+           (conjunct.relations_ & ~(left | right)) == 0;
+  }
+
+  auto Connected(uint64_t left, uint64_t right) const -> bool {
+    return std::any_of(conjuncts_.begin(), conjuncts_.end(),
+                       [&](const auto &conjunct) { return Joins(conjunct, left, right); });
+  }
+
+  /** @return the estimated rows of the join of a set of relations */
+  auto Rows(uint64_t relations) const -> double {
+    double rows = 1;
+    for (size_t i = 0; i < leaves_.size(); i++) {
+      if ((relations >> i & 1) != 0) {
+        rows *= leaves_[i].rows_;
+      }
+    }
+    for (const auto &conjunct : conjuncts_) {
+      if (!IsSingle(conjunct.relations_) && conjunct.relations_ != 0 && (conjunct.relations_ & ~relations) == 0) {
+        rows *= conjunct.selectivity_;
+      }
+    }
+    return std::max(rows, 1.0);
+  }
+
+  /** @return the column of an equality between two sets of relations that is on the right */
+  auto RightColumn(const JoinConjunct &conjunct, uint64_t right) const -> uint32_t {
+    auto [a, b] = *conjunct.equi_columns_;
+    return (right >> column_relation_[a] & 1) != 0 ? a : b;
+  }
+
+  /** @return true if the join can look up the right relation by an index on its column of the equality */
+  auto IsIndexLookup(const JoinConjunct &conjunct, uint64_t right) const -> bool {
+    if (!IsSingle(right)) {
+      return false;
+    }
+    const auto &leaf = leaves_[Lowest(right)];
+    auto column = RightColumn(conjunct, right) - leaf.offset_;
+    return column < leaf.indexed_.size() && leaf.indexed_[column];
+  }
+
+  /** @return the equality that the join of two sets of relations looks up, preferring one an index can look up */
+  auto KeyConjunct(uint64_t left, uint64_t right) const -> const JoinConjunct * {
+    const JoinConjunct *key = nullptr;
+    for (const auto &conjunct : conjuncts_) {
+      if (!conjunct.equi_columns_.has_value() || !Joins(conjunct, left, right)) {
+        continue;
+      }
+      if (IsIndexLookup(conjunct, right)) {
+        return &conjunct;
+      }
+      key = key == nullptr ? &conjunct : key;
+    }
+    return key;
+  }
+
+  /**
+   * @return the cost of joining two sets of relations. The cost counts the rows read and compared: a hash join reads
+   * both inputs once, an index join looks up the right relation for every left row and a nested loop join reads the
+   * right input again for every block of left rows and compares every pair of rows.
+   */
+  auto Join(uint64_t left, uint64_t right, const JoinTable &table) const -> JoinEntry {
+    const auto &l = table.at(left);
+    const auto &r = table.at(right);
+    JoinEntry entry{Rows(left | right), 0, left, right};
+    if (const auto *key = KeyConjunct(left, right); key == nullptr) {
+      auto blocks = std::ceil(l.rows_ * ESTIMATED_ROW_BYTES / static_cast<double>(nested_loop_join_block_size));
+      entry.cost_ = l.cost_ + std::max(1.0, blocks) * r.cost_ + l.rows_ * r.rows_;
+    } else if (IsIndexLookup(*key, right)) {
+      entry.cost_ = l.cost_ + INDEX_LOOKUP_COST * l.rows_ + entry.rows_;
+    } else {
+      entry.cost_ = l.cost_ + r.cost_ + HASH_BUILD_COST * r.rows_ + l.rows_ + entry.rows_;
+    }
+    return entry;
+  }
+
+  /** Join the two inputs whose join has the fewest rows until one is left, preferring those a predicate connects */
+  void JoinGreedily(JoinTable *table) {
+    std::vector<uint64_t> inputs;
+    for (size_t i = 0; i < leaves_.size(); i++) {
+      inputs.push_back(uint64_t{1} << i);
+    }
+    while (inputs.size() > 1) {
+      std::optional<std::tuple<bool, JoinEntry, size_t, size_t>> best;
+      for (size_t i = 0; i < inputs.size(); i++) {
+        for (size_t j = 0; j < inputs.size(); j++) {
+          if (i == j) {
+            continue;
+          }
+          bool connected = Connected(inputs[i], inputs[j]);
+          auto entry = Join(inputs[i], inputs[j], *table);
+          if (best.has_value()) {
+            const auto &[best_connected, best_entry, best_i, best_j] = *best;
+            if (best_connected != connected ? best_connected
+                                            : std::make_pair(best_entry.rows_, best_entry.cost_) <=
+                                                  std::make_pair(entry.rows_, entry.cost_)) {
+              continue;
+            }
+          }
+          best = std::make_tuple(connected, entry, i, j);
+        }
+      }
+      const auto &[connected, entry, i, j] = *best;
+      (*table)[entry.left_ | entry.right_] = entry;
+      inputs[std::min(i, j)] = entry.left_ | entry.right_;
+      inputs.erase(inputs.begin() + static_cast<std::ptrdiff_t>(std::max(i, j)));
+    }
+  }
+
+  std::vector<JoinLeaf> leaves_;
+  std::vector<JoinConjunct> conjuncts_;
+  /** The relation of every column of the output of the written tree */
+  std::vector<size_t> column_relation_;
+  /** The inputs of every join of the written tree, each after the joins below it */
+  std::vector<std::pair<uint64_t, uint64_t>> written_joins_;
+};
+
+}  // namespace
+
+auto Optimizer::OptimizeJoinOrder(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  if (!IsJoinTree(*plan) || CountRelations(*plan) > MAX_RELATIONS) {
+    std::vector<AbstractPlanNodeRef> children;
+    for (const auto &child : plan->GetChildren()) {
+      children.emplace_back(OptimizeJoinOrder(child));
+    }
+    return plan->CloneWithChildren(std::move(children));
+  }
+
+  JoinGraph graph;
+  graph.Flatten(plan);
+  auto &leaves = graph.Leaves();
+  for (size_t i = 0; i < leaves.size(); i++) {
+    auto &leaf = leaves[i];
+    leaf.plan_ = OptimizeJoinOrder(leaf.plan_);
+    const auto &schema = leaf.plan_->OutputSchema();
+    // A filter pushed down to the input counts towards its selectivity.
+    auto local_conjuncts = graph.LocalConjuncts(i);
+    auto scan = leaf.plan_;
+    if (const auto *filter = dynamic_cast<const FilterPlanNode *>(scan.get()); filter != nullptr) {
+      local_conjuncts.push_back(filter->GetPredicate());
+      scan = filter->GetChildPlan();
+    }
+    std::shared_ptr<const TableStats> stats;
+    std::optional<size_t> cardinality;
+    if (const auto *seq_scan = dynamic_cast<const SeqScanPlanNode *>(scan.get()); seq_scan != nullptr) {
+      cardinality = EstimatedCardinality(seq_scan->table_name_);
+      stats = catalog_.GetTableStats(seq_scan->GetTableOid());
+    } else if (const auto *mock_scan = dynamic_cast<const MockScanPlanNode *>(scan.get()); mock_scan != nullptr) {
+      cardinality = EstimatedCardinality(mock_scan->GetTable());
+    } else if (const auto *values = dynamic_cast<const ValuesPlanNode *>(scan.get()); values != nullptr) {
+      cardinality = values->GetValues().size();
+    }
+    leaf.base_rows_ = cardinality.has_value() ? static_cast<double>(*cardinality) : leaf.base_rows_;
+    if (stats == nullptr || stats->columns_.size() != schema.GetColumnCount()) {
+      auto unknown = std::make_shared<TableStats>();
+      unknown->columns_.resize(schema.GetColumnCount());
+      stats = std::move(unknown);
+    }
+    auto local = And(local_conjuncts);
+    leaf.rows_ = std::max(1.0, leaf.base_rows_ * (local == nullptr ? 1 : EstimateSelectivity(*local, *stats, schema)));
+    leaf.distinct_.resize(schema.GetColumnCount());
+    leaf.indexed_.resize(schema.GetColumnCount());
+    const auto *seq_scan = dynamic_cast<const SeqScanPlanNode *>(leaf.plan_.get());
+    for (uint32_t col = 0; col < schema.GetColumnCount(); col++) {
+      if (stats->columns_[col].has_value()) {
+        leaf.distinct_[col] = static_cast<double>(stats->columns_[col]->distinct_);
+      }
+      leaf.indexed_[col] = seq_scan != nullptr && seq_scan->filter_predicate_ == nullptr && local == nullptr &&
+                           MatchIndex(seq_scan->table_name_, col).has_value();
+    }
+  }
+
+  // An equality of two columns keeps a row for every distinct value of the column with more of them.
+  for (auto &conjunct : graph.Conjuncts()) {
+    if (conjunct.equi_columns_.has_value()) {
+      double distinct = 1;
+      for (auto column : {conjunct.equi_columns_->first, conjunct.equi_columns_->second}) {
+        const auto &leaf = leaves[graph.ColumnRelation(column)];
+        auto known = leaf.distinct_[column - leaf.offset_];
+        distinct = std::max(distinct, known > 0 ? known : leaf.base_rows_);
+      }
+      conjunct.selectivity_ = 1 / distinct;
+    } else if (const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct.expr_.get());
+               comparison != nullptr && comparison->comp_type_ == ComparisonType::Equal) {
+      conjunct.selectivity_ = DEFAULT_EQUALITY_SELECTIVITY;
+    } else {
+      conjunct.selectivity_ = DEFAULT_RANGE_SELECTIVITY;
+    }
+  }
+
+  auto all = graph.AllRelations();
+  auto table = graph.WrittenJoinTable();
+  auto best = graph.BestJoinTable();
+  if (best.at(all).cost_ < REORDER_MIN_GAIN * table.at(all).cost_) {
+    table = std::move(best);
+  }
+  std::vector<uint32_t> columns;
+  auto joined = graph.Build(all, table, &columns);
+
+  // Predicates without columns are evaluated once above the joins, which return their columns in the written order.
+  std::vector<std::pair<uint32_t, uint32_t>> positions(graph.ColumnCount());
+  for (uint32_t i = 0; i < columns.size(); i++) {
+    positions[columns[i]] = {0, i};
+  }
+  std::vector<AbstractExpressionRef> constant;
+  for (const auto &conjunct : graph.Conjuncts()) {
+    if (conjunct.relations_ == 0) {
+      constant.push_back(conjunct.expr_);
+    }
+  }
+  if (!constant.empty()) {
+    joined = std::make_shared<FilterPlanNode>(joined->output_schema_, And(constant), joined);
+  }
+  bool reordered = false;
+  for (uint32_t i = 0; i < columns.size(); i++) {
+    reordered = reordered || columns[i] != i;
+  }
+  if (!reordered) {
+    return joined;
+  }
+  std::vector<AbstractExpressionRef> exprs;
+  for (uint32_t i = 0; i < graph.ColumnCount(); i++) {
+    exprs.push_back(std::make_shared<ColumnValueExpression>(0, positions[i].second,
+                                                            plan->OutputSchema().GetColumn(i).GetType()));
+  }
+  return std::make_shared<ProjectionPlanNode>(plan->output_schema_, std::move(exprs), std::move(joined));
+}
+
+}  // namespace bustub
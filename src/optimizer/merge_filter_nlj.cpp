@@ -60,7 +60,11 @@ auto Optimizer::OptimizeMergeFilterNLJ(const AbstractPlanNodeRef &plan) -> Abstr
       // Has exactly two children
       BUSTUB_ENSURE(child_plan->GetChildren().size() == 2, "NLJ should have exactly 2 children.");
 
-      if (IsPredicateTrue(nlj_plan.Predicate())) {
+      // A semi or anti join does not return the right columns the filter could read, and an anti join returns the
+      // left tuples that do not match its predicate.
+      bool is_semi_or_anti = nlj_plan.GetJoinType() == JoinType::SEMI || nlj_plan.GetJoinType() == JoinType::ANTI ||
+                             nlj_plan.GetJoinType() == JoinType::NULL_AWARE_ANTI;
+      if (!is_semi_or_anti && IsPredicateTrue(nlj_plan.Predicate())) {
         // Only rewrite when NLJ has always true predicate.
         return std::make_shared<NestedLoopJoinPlanNode>(
             filter_plan.output_schema_, nlj_plan.GetLeftPlan(), nlj_plan.GetRightPlan(),
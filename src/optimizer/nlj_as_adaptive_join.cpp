@@ -0,0 +1,67 @@
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/adaptive_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+auto Optimizer::OptimizeNLJAsAdaptiveJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeNLJAsAdaptiveJoin(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::NestedLoopJoin) {
+    return optimized_plan;
+  }
+  const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*optimized_plan);
+  BUSTUB_ENSURE(nlj_plan.children_.size() == 2, "NLJ should have exactly 2 children.");
+  if (nlj_plan.GetJoinType() != JoinType::INNER && nlj_plan.GetJoinType() != JoinType::LEFT) {
+    return optimized_plan;
+  }
+
+  // Match `<column> = <column>` with one column of each input, as OptimizeNLJAsHashJoin does.
+  const auto *expr = dynamic_cast<const ComparisonExpression *>(&nlj_plan.Predicate());
+  if (expr == nullptr || expr->comp_type_ != ComparisonType::Equal) {
+    return optimized_plan;
+  }
+  const auto *first = dynamic_cast<const ColumnValueExpression *>(expr->children_[0].get());
+  const auto *second = dynamic_cast<const ColumnValueExpression *>(expr->children_[1].get());
+  if (first == nullptr || second == nullptr || first->GetTupleIdx() == second->GetTupleIdx()) {
+    return optimized_plan;
+  }
+  const auto *left_expr = first->GetTupleIdx() == 0 ? first : second;
+  const auto *right_expr = first->GetTupleIdx() == 0 ? second : first;
+
+  // The join may look the right rows up by an index instead of scanning them if the scan reads every row.
+  std::optional<index_oid_t> index_oid;
+  std::string index_name;
+  if (nlj_plan.GetRightPlan()->GetType() == PlanType::SeqScan) {
+    const auto &right_seq_scan = dynamic_cast<const SeqScanPlanNode &>(*nlj_plan.GetRightPlan());
+    if (right_seq_scan.IsFullScan() && right_seq_scan.column_ids_.empty()) {
+      if (auto index = MatchIndex(right_seq_scan.table_name_, right_expr->GetColIdx()); index != std::nullopt) {
+        std::tie(index_oid, index_name) = *index;
+      }
+    }
+  }
+
+  return std::make_shared<AdaptiveJoinPlanNode>(
+      nlj_plan.output_schema_, nlj_plan.GetLeftPlan(), nlj_plan.GetRightPlan(),
+      std::make_shared<ColumnValueExpression>(0, left_expr->GetColIdx(), left_expr->GetReturnType()),
+      std::make_shared<ColumnValueExpression>(0, right_expr->GetColIdx(), right_expr->GetReturnType()),
+      nlj_plan.GetJoinType(), index_oid, std::move(index_name));
+}
+
+}  // namespace bustub
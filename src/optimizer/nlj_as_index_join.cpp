@@ -43,8 +43,11 @@ auto Optimizer::OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> Abstr
     const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*optimized_plan);
     // Has exactly two children
     BUSTUB_ENSURE(nlj_plan.children_.size() == 2, "NLJ should have exactly 2 children.");
+    // The index join executor only implements inner and left joins.
+    bool is_inner_or_left = nlj_plan.GetJoinType() == JoinType::INNER || nlj_plan.GetJoinType() == JoinType::LEFT;
     // Check if expr is equal condition where one is for the left table, and one is for the right table.
-    if (const auto *expr = dynamic_cast<const ComparisonExpression *>(&nlj_plan.Predicate()); expr != nullptr) {
+    if (const auto *expr = dynamic_cast<const ComparisonExpression *>(&nlj_plan.Predicate());
+        is_inner_or_left && expr != nullptr) {
       if (expr->comp_type_ == ComparisonType::Equal) {
         if (const auto *left_expr = dynamic_cast<const ColumnValueExpression *>(expr->children_[0].get());
             left_expr != nullptr) {
@@ -57,8 +60,9 @@ auto Optimizer::OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> Abstr
                 std::make_shared<ColumnValueExpression>(0, right_expr->GetColIdx(), right_expr->GetReturnType());
             // Now it's in form of <column_expr> = <column_expr>. Let's match an index for them.
 
-            // Ensure right child is table scan
-            if (nlj_plan.GetRightPlan()->GetType() == PlanType::SeqScan) {
+            // Ensure right child is table scan, which an index join replaces only if it reads every row
+            if (nlj_plan.GetRightPlan()->GetType() == PlanType::SeqScan &&
+                dynamic_cast<const SeqScanPlanNode &>(*nlj_plan.GetRightPlan()).IsFullScan()) {
               const auto &right_seq_scan = dynamic_cast<const SeqScanPlanNode &>(*nlj_plan.GetRightPlan());
               if (left_expr->GetTupleIdx() == 0 && right_expr->GetTupleIdx() == 1) {
                 if (auto index = MatchIndex(right_seq_scan.table_name_, right_expr->GetColIdx());
@@ -1,10 +1,61 @@
 #include "optimizer/optimizer.h"
+#include <algorithm>
+#include <memory>
 #include <optional>
 #include "common/util/string_util.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "execution/plans/adaptive_join_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/mock_scan_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/plans/values_plan.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return true if the predicate is an equality of a column of the left input and a column of the right input */
+auto IsEquiJoin(const AbstractExpressionRef &predicate) -> bool {
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(predicate.get());
+  if (comparison == nullptr || comparison->comp_type_ != ComparisonType::Equal) {
+    return false;
+  }
+  const auto *left = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+  const auto *right = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+  return left != nullptr && right != nullptr && left->GetTupleIdx() != right->GetTupleIdx();
+}
+
+/**
+ * @return the rows of a join. An equality keeps a row for every distinct key of the larger input, whose keys are
+ * assumed distinct, other predicates are guessed like a range. A left join returns every left row at least once, a
+ * semi join every left row at most once, and an anti join the left rows the semi join would not return.
+ */
+auto JoinRows(double left, double right, bool is_equi_join, JoinType join_type, double other_selectivity) -> double {
+  auto rows = left * right * (is_equi_join ? 1 / std::max({left, right, 1.0}) : other_selectivity);
+  switch (join_type) {
+    case JoinType::LEFT:
+      return std::max(rows, left);
+    case JoinType::SEMI:
+      return std::min(rows, left);
+    case JoinType::ANTI:
+    case JoinType::NULL_AWARE_ANTI:
+      return left - std::min(rows, left);
+    default:
+      return rows;
+  }
+}
+
+}  // namespace
+
 auto Optimizer::Optimize(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
   if (force_starter_rule_) {
     // Use starter rules when `force_starter_rule_` is set to true.
@@ -21,6 +72,11 @@ auto Optimizer::Optimize(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef
 }
 
 auto Optimizer::EstimatedCardinality(const std::string &table_name) -> std::optional<size_t> {
+  if (const auto *table_info = catalog_.GetTable(table_name); table_info != nullptr) {
+    if (auto stats = catalog_.GetTableStats(table_info->oid_); stats != nullptr) {
+      return std::make_optional<size_t>(stats->row_count_);
+    }
+  }
   if (StringUtil::EndsWith(table_name, "_1m")) {
     return std::make_optional(1000000);
   }
@@ -42,4 +98,102 @@ auto Optimizer::EstimatedCardinality(const std::string &table_name) -> std::opti
   return std::nullopt;
 }
 
+auto Optimizer::EstimateTableSelectivity(const AbstractExpressionRef &predicate, table_oid_t table_oid) -> double {
+  if (predicate == nullptr) {
+    return 1;
+  }
+  const auto &schema = catalog_.GetTable(table_oid)->schema_;
+  auto stats = catalog_.GetTableStats(table_oid);
+  if (stats == nullptr || stats->columns_.size() != schema.GetColumnCount()) {
+    auto unknown = std::make_shared<TableStats>();
+    unknown->columns_.resize(schema.GetColumnCount());
+    stats = std::move(unknown);
+  }
+  return EstimateSelectivity(*predicate, *stats, schema);
+}
+
+auto Optimizer::EstimateRows(const AbstractPlanNode &plan) -> std::optional<double> {
+  // Modifications return the number of rows they changed, aggregations without groups a single row.
+  if (plan.GetType() == PlanType::Insert || plan.GetType() == PlanType::Update || plan.GetType() == PlanType::Delete ||
+      (plan.GetType() == PlanType::Aggregation &&
+       dynamic_cast<const AggregationPlanNode &>(plan).GetGroupBys().empty())) {
+    return 1;
+  }
+  std::vector<double> children;
+  for (const auto &child : plan.GetChildren()) {
+    auto rows = EstimateRows(*child);
+    if (!rows.has_value()) {
+      return std::nullopt;
+    }
+    children.push_back(*rows);
+  }
+  switch (plan.GetType()) {
+    case PlanType::SeqScan: {
+      const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(plan);
+      auto rows = EstimatedCardinality(seq_scan.table_name_);
+      if (!rows.has_value()) {
+        return std::nullopt;
+      }
+      return static_cast<double>(*rows) * EstimateTableSelectivity(seq_scan.filter_predicate_, seq_scan.GetTableOid());
+    }
+    case PlanType::IndexScan: {
+      const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(plan);
+      const auto *index_info = catalog_.GetIndex(index_scan.GetIndexOid());
+      const auto *table_info = catalog_.GetTable(index_info->table_name_);
+      auto rows = EstimatedCardinality(index_info->table_name_);
+      if (!rows.has_value()) {
+        return std::nullopt;
+      }
+      // The filter of an index scan is the predicate its range was made from.
+      return static_cast<double>(*rows) * EstimateTableSelectivity(index_scan.filter_predicate_, table_info->oid_);
+    }
+    case PlanType::MockScan: {
+      auto rows = EstimatedCardinality(dynamic_cast<const MockScanPlanNode &>(plan).GetTable());
+      return rows.has_value() ? std::make_optional(static_cast<double>(*rows)) : std::nullopt;
+    }
+    case PlanType::Values:
+      return static_cast<double>(dynamic_cast<const ValuesPlanNode &>(plan).GetValues().size());
+    case PlanType::Filter: {
+      const auto &filter = dynamic_cast<const FilterPlanNode &>(plan);
+      const auto *seq_scan = dynamic_cast<const SeqScanPlanNode *>(filter.GetChildPlan().get());
+      if (seq_scan != nullptr && seq_scan->column_ids_.empty()) {
+        return children[0] * EstimateTableSelectivity(filter.GetPredicate(), seq_scan->GetTableOid());
+      }
+      auto unknown = TableStats();
+      unknown.columns_.resize(filter.GetChildPlan()->OutputSchema().GetColumnCount());
+      return children[0] * EstimateSelectivity(*filter.GetPredicate(), unknown, filter.GetChildPlan()->OutputSchema());
+    }
+    case PlanType::Projection:
+    case PlanType::Sort:
+      return children[0];
+    case PlanType::Limit:
+      return std::min(children[0], static_cast<double>(dynamic_cast<const LimitPlanNode &>(plan).GetLimit()));
+    case PlanType::TopN:
+      return std::min(children[0], static_cast<double>(dynamic_cast<const TopNPlanNode &>(plan).GetN()));
+    case PlanType::Aggregation:
+      // Without statistics of the groups, a group is guessed for every value an equality would select.
+      return std::max(1.0, children[0] * DEFAULT_EQUALITY_SELECTIVITY);
+    case PlanType::NestedLoopJoin: {
+      const auto &nlj = dynamic_cast<const NestedLoopJoinPlanNode &>(plan);
+      return JoinRows(children[0], children[1], IsEquiJoin(nlj.predicate_), nlj.GetJoinType(),
+                      nlj.predicate_ == nullptr || IsPredicateTrue(*nlj.predicate_) ? 1 : DEFAULT_RANGE_SELECTIVITY);
+    }
+    case PlanType::HashJoin:
+      return JoinRows(children[0], children[1], true, dynamic_cast<const HashJoinPlanNode &>(plan).GetJoinType(), 1);
+    case PlanType::AdaptiveJoin:
+      return JoinRows(children[0], children[1], true, dynamic_cast<const AdaptiveJoinPlanNode &>(plan).GetJoinType(),
+                      1);
+    case PlanType::NestedIndexJoin: {
+      const auto &index_join = dynamic_cast<const NestedIndexJoinPlanNode &>(plan);
+      auto right = EstimatedCardinality(catalog_.GetTable(index_join.GetInnerTableOid())->name_);
+      if (!right.has_value()) {
+        return std::nullopt;
+      }
+      return JoinRows(children[0], static_cast<double>(*right), true, index_join.GetJoinType(), 1);
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
 }  // namespace bustub
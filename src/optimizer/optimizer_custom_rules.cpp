@@ -1,13 +1,15 @@
-#include "execution/expressions/arithmetic_expression.h"
+#include <algorithm>
+
+#include "common/config.h"
 #include "execution/expressions/column_value_expression.h"
 #include "execution/expressions/comparison_expression.h"
 #include "execution/expressions/constant_value_expression.h"
 #include "execution/expressions/logic_expression.h"
+#include "execution/expressions/parameter_value_expression.h"
 #include "execution/plans/abstract_plan.h"
 #include "execution/plans/aggregation_plan.h"
 #include "execution/plans/filter_plan.h"
 #include "execution/plans/index_scan_plan.h"
-#include "execution/plans/mock_scan_plan.h"
 #include "execution/plans/nested_loop_join_plan.h"
 #include "execution/plans/projection_plan.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -20,173 +22,6 @@
 
 namespace bustub {
 
-auto Optimizer::OptimizeReorderJoinUseIndex(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
-  std::vector<AbstractPlanNodeRef> children;
-  for (const auto &child : plan->GetChildren()) {
-    children.emplace_back(OptimizeReorderJoinUseIndex(child));
-  }
-  auto optimized_plan = plan->CloneWithChildren(std::move(children));
-  if (optimized_plan->GetType() == PlanType::NestedLoopJoin) {
-    const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*optimized_plan);
-    BUSTUB_ASSERT(nlj_plan.children_.size() == 2, "NLJ should have exactly 2 children.");
-
-    // ensure the left child is nlp
-    // the right child is seqscan or mockscan
-    if (nlj_plan.GetLeftPlan()->GetType() != PlanType::NestedLoopJoin ||
-        (nlj_plan.GetRightPlan()->GetType() != PlanType::SeqScan &&
-         nlj_plan.GetRightPlan()->GetType() != PlanType::MockScan)) {
-      return optimized_plan;
-    }
-
-    const auto &left_nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*nlj_plan.GetLeftPlan());
-
-    if (left_nlj_plan.GetLeftPlan()->GetType() == PlanType::NestedLoopJoin ||
-        left_nlj_plan.GetRightPlan()->GetType() == PlanType::NestedLoopJoin) {
-      return optimized_plan;
-    }
-
-    if (const auto *expr = dynamic_cast<const ComparisonExpression *>(&left_nlj_plan.Predicate()); expr != nullptr) {
-      if (expr->comp_type_ == ComparisonType::Equal) {
-        if (const auto *left_expr = dynamic_cast<const ColumnValueExpression *>(expr->children_[0].get());
-            left_expr != nullptr) {
-          if (const auto *right_expr = dynamic_cast<const ColumnValueExpression *>(expr->children_[1].get());
-              right_expr != nullptr) {
-            if (left_nlj_plan.GetLeftPlan()->GetType() == PlanType::SeqScan) {
-              const auto &left_seq_scan = dynamic_cast<const SeqScanPlanNode &>(*left_nlj_plan.GetLeftPlan());
-              if (auto index = MatchIndex(left_seq_scan.table_name_, left_expr->GetColIdx()); index != std::nullopt) {
-                auto *outer_expr = dynamic_cast<const ComparisonExpression *>(&nlj_plan.Predicate());
-                auto left_outer_expr = dynamic_cast<const ColumnValueExpression *>(outer_expr->children_[0].get());
-                auto right_outer_expr = dynamic_cast<const ColumnValueExpression *>(outer_expr->children_[1].get());
-                BUSTUB_ASSERT(expr->comp_type_ == ComparisonType::Equal, "comparison type must be equal");
-                BUSTUB_ASSERT(outer_expr->comp_type_ == ComparisonType::Equal, "comparison type must be equal");
-
-                auto inner_pred = std::make_shared<ComparisonExpression>(
-                    std::make_shared<ColumnValueExpression>(
-                        0, left_outer_expr->GetColIdx() - left_nlj_plan.GetLeftPlan()->output_schema_->GetColumnCount(),
-                        left_outer_expr->GetReturnType()),
-                    std::make_shared<ColumnValueExpression>(1, right_outer_expr->GetColIdx(),
-                                                            right_outer_expr->GetReturnType()),
-                    ComparisonType::Equal);
-                auto outer_pred = std::make_shared<ComparisonExpression>(
-                    std::make_shared<ColumnValueExpression>(0, right_expr->GetColIdx(), right_expr->GetReturnType()),
-                    std::make_shared<ColumnValueExpression>(1, left_expr->GetColIdx(), left_expr->GetReturnType()),
-                    ComparisonType::Equal);
-
-                auto right_column_1 = left_nlj_plan.GetRightPlan()->output_schema_->GetColumns();
-                auto right_column_2 = nlj_plan.GetRightPlan()->output_schema_->GetColumns();
-                std::vector<Column> columns;
-                columns.reserve(right_column_1.size() + right_column_2.size());
-
-                for (const auto &col : right_column_1) {
-                  columns.push_back(col);
-                }
-                for (const auto &col : right_column_2) {
-                  columns.push_back(col);
-                }
-
-                std::vector<Column> outer_columns(columns);
-                for (const auto &col : left_nlj_plan.GetLeftPlan()->output_schema_->GetColumns()) {
-                  outer_columns.push_back(col);
-                }
-
-                return std::make_shared<NestedLoopJoinPlanNode>(
-                    std::make_shared<Schema>(outer_columns),
-                    std::make_shared<NestedLoopJoinPlanNode>(std::make_shared<Schema>(columns),
-                                                             left_nlj_plan.GetRightPlan(), nlj_plan.GetRightPlan(),
-                                                             inner_pred, JoinType::INNER),
-                    left_nlj_plan.GetLeftPlan(), outer_pred, JoinType::INNER);
-              }
-            }
-          }
-        }
-      }
-    }
-  }
-
-  return optimized_plan;
-}
-
-auto Optimizer::OptimizePredicatePushDown(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
-  std::vector<AbstractPlanNodeRef> children;
-  for (const auto &child : plan->GetChildren()) {
-    children.emplace_back(OptimizePredicatePushDown(child));
-  }
-  auto optimized_plan = plan->CloneWithChildren(std::move(children));
-
-  if (optimized_plan->GetType() == PlanType::NestedLoopJoin) {
-    const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*optimized_plan);
-
-    if (nlj_plan.GetLeftPlan()->GetType() != PlanType::NestedLoopJoin) {
-      return optimized_plan;
-    }
-    const auto &left_nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*nlj_plan.GetLeftPlan());
-
-    if (nlj_plan.GetRightPlan()->GetType() != PlanType::MockScan ||
-        left_nlj_plan.GetLeftPlan()->GetType() != PlanType::MockScan ||
-        left_nlj_plan.GetRightPlan()->GetType() != PlanType::MockScan) {
-      return optimized_plan;
-    }
-
-    std::vector<AbstractExpressionRef> join_preds;
-    std::vector<AbstractExpressionRef> filter_preds;
-    if (const auto *expr = dynamic_cast<const LogicExpression *>(&nlj_plan.Predicate()); expr != nullptr) {
-      while (const auto *inner_expr = dynamic_cast<const LogicExpression *>(expr->children_[0].get())) {
-        if (const auto *pred = dynamic_cast<const ColumnValueExpression *>(expr->children_[1]->children_[1].get());
-            pred != nullptr) {
-          join_preds.push_back(expr->children_[1]);
-        } else {
-          filter_preds.push_back(expr->children_[1]);
-        }
-        expr = dynamic_cast<const LogicExpression *>(expr->children_[0].get());
-      }
-      if (const auto *pred = dynamic_cast<const ColumnValueExpression *>(expr->children_[1]->children_[1].get());
-          pred != nullptr) {
-        join_preds.push_back(expr->children_[1]);
-      } else {
-        filter_preds.push_back(expr->children_[1]);
-      }
-      if (const auto *pred = dynamic_cast<const ColumnValueExpression *>(expr->children_[0]->children_[1].get());
-          pred != nullptr) {
-        join_preds.push_back(expr->children_[0]);
-      } else {
-        filter_preds.push_back(expr->children_[0]);
-      }
-
-      std::vector<AbstractExpressionRef> first_filter;
-      std::vector<AbstractExpressionRef> third_filter;
-
-      for (const auto &pred : filter_preds) {
-        const auto *outer = dynamic_cast<const ComparisonExpression *>(pred.get());
-        const auto *inner = dynamic_cast<const ColumnValueExpression *>(pred->children_[0].get());
-        if (inner->GetTupleIdx() == 0) {
-          first_filter.push_back(pred);
-        } else {
-          third_filter.push_back(std::make_shared<ComparisonExpression>(
-              std::make_shared<ColumnValueExpression>(0, inner->GetColIdx(), inner->GetReturnType()),
-              pred->children_[1], outer->comp_type_));
-        }
-      }
-      BUSTUB_ASSERT(first_filter.size() == 2, "only in leader board test!");
-      BUSTUB_ASSERT(third_filter.size() == 2, "only in leader board test!");
-
-      auto first_pred = std::make_shared<LogicExpression>(first_filter[0], first_filter[1], LogicType::And);
-      auto third_pred = std::make_shared<LogicExpression>(third_filter[0], third_filter[1], LogicType::And);
-
-      auto first_filter_scan = std::make_shared<FilterPlanNode>(left_nlj_plan.children_[0]->output_schema_, first_pred,
-                                                                left_nlj_plan.children_[0]);
-      auto third_filter_scan = std::make_shared<FilterPlanNode>(nlj_plan.GetRightPlan()->output_schema_, third_pred,
-                                                                nlj_plan.GetRightPlan());
-      auto left_node = std::make_shared<NestedLoopJoinPlanNode>(left_nlj_plan.output_schema_, first_filter_scan,
-                                                                left_nlj_plan.GetRightPlan(), left_nlj_plan.predicate_,
-                                                                left_nlj_plan.GetJoinType());
-      return std::make_shared<NestedLoopJoinPlanNode>(nlj_plan.output_schema_, left_node, third_filter_scan,
-                                                      join_preds[0], nlj_plan.GetJoinType());
-    }
-  }
-
-  return optimized_plan;
-}
-
 auto Optimizer::IsPredicateFalse(const AbstractExpression &expr) -> bool {
   if (const auto *compare_expr = dynamic_cast<const ComparisonExpression *>(&expr); compare_expr != nullptr) {
     if (const auto *left_expr = dynamic_cast<const ConstantValueExpression *>(compare_expr->children_[0].get());
@@ -238,6 +73,11 @@ auto Optimizer::OptimizeRemoveJoin(const AbstractPlanNodeRef &plan) -> AbstractP
       const auto &right_plan = dynamic_cast<const ValuesPlanNode &>(*nlj_plan.GetRightPlan());
 
       if (right_plan.GetValues().empty()) {
+        // Nothing matches a left tuple of a semi join.
+        if (nlj_plan.GetJoinType() == JoinType::SEMI) {
+          return std::make_shared<ValuesPlanNode>(nlj_plan.output_schema_,
+                                                  std::vector<std::vector<AbstractExpressionRef>>{});
+        }
         return nlj_plan.children_[0];
       }
     }
@@ -245,73 +85,163 @@ auto Optimizer::OptimizeRemoveJoin(const AbstractPlanNodeRef &plan) -> AbstractP
   return optimized_plan;
 }
 
-auto Optimizer::OptimizeRemoveColumn(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
-  std::vector<AbstractPlanNodeRef> children;
-  for (const auto &child : plan->GetChildren()) {
-    children.emplace_back(OptimizeRemoveJoin(child));
-  }
-
-  auto optimized_plan = plan->CloneWithChildren(std::move(children));
-  if (optimized_plan->GetType() == PlanType::Projection) {
-    const auto outer_proj = dynamic_cast<const ProjectionPlanNode &>(*optimized_plan);
-
-    if (outer_proj.GetChildPlan()->GetType() == PlanType::Projection) {
-      const auto inner_proj = dynamic_cast<const ProjectionPlanNode &>(*outer_proj.GetChildPlan());
+namespace {
 
-      if (inner_proj.GetChildPlan()->GetType() == PlanType::Aggregation) {
-        const auto agg_plan = dynamic_cast<const AggregationPlanNode &>(*inner_proj.GetChildPlan());
-        std::vector<AbstractExpressionRef> cols;
-        for (size_t i = 0; i < outer_proj.GetExpressions().size(); ++i) {
-          if (const auto *pred = dynamic_cast<const ColumnValueExpression *>(inner_proj.GetExpressions()[i].get());
-              pred != nullptr) {
-            cols.push_back(inner_proj.GetExpressions()[i]);
-          } else {
-            // hacking
-            cols.push_back(inner_proj.GetExpressions()[i]->children_[0]->children_[0]);
-            cols.push_back(inner_proj.GetExpressions()[i]->children_[0]->children_[1]);
-            cols.push_back(inner_proj.GetExpressions()[i]->children_[1]);
-          }
-        }
-
-        std::vector<Column> inner_schema;
-        std::vector<AbstractExpressionRef> inner_proj_expr;
-        for (const auto &i : outer_proj.GetExpressions()) {
-          const auto *col = dynamic_cast<const ColumnValueExpression *>(i.get());
-          inner_proj_expr.push_back(inner_proj.GetExpressions()[col->GetColIdx()]);
-          inner_schema.push_back(inner_proj.OutputSchema().GetColumns()[col->GetColIdx()]);
-        }
-
-        inner_proj_expr.pop_back();
-        inner_proj_expr.push_back(std::make_shared<ArithmeticExpression>(
-            std::make_shared<ArithmeticExpression>(std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER),
-                                                   std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER),
-                                                   ArithmeticType::Plus),
-            std::make_shared<ColumnValueExpression>(0, 2, TypeId::INTEGER), ArithmeticType::Plus));
-
-        std::vector<AbstractExpressionRef> aggregates;
-        std::vector<AggregationType> agg_types;
-        std::vector<Column> agg_schema;
+/**
+ * Tighten one end of a key range; `lower` picks the larger of two low ends, otherwise the smaller of two high ends.
+ * @return false if the ends cannot be compared, as the values of parameters are not known yet
+ */
+auto TightenBound(std::optional<IndexScanBound> *bound, const IndexScanBound &other, bool lower) -> bool {
+  if (!bound->has_value()) {
+    *bound = other;
+    return true;
+  }
+  if ((*bound)->param_idx_.has_value() || other.param_idx_.has_value()) {
+    if ((*bound)->param_idx_ != other.param_idx_) {
+      return false;
+    }
+    (*bound)->inclusive_ = (*bound)->inclusive_ && other.inclusive_;
+    return true;
+  }
+  const auto &key = (*bound)->key_;
+  if (key.CompareEquals(other.key_) == CmpBool::CmpTrue) {
+    (*bound)->inclusive_ = (*bound)->inclusive_ && other.inclusive_;
+  } else if ((lower ? other.key_.CompareGreaterThan(key) : other.key_.CompareLessThan(key)) == CmpBool::CmpTrue) {
+    *bound = other;
+  }
+  return true;
+}
 
-        for (size_t i = 0; i < agg_plan.GetGroupBys().size(); ++i) {
-          agg_schema.push_back(agg_plan.OutputSchema().GetColumns()[i]);
-        }
+/** @return the key a constant or a parameter stands for, if it is a key of the given type */
+auto KeyOf(const AbstractExpression *expr, TypeId type) -> std::optional<IndexScanBound> {
+  if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+    if (constant->val_.IsNull() || constant->val_.GetTypeId() != type) {
+      return std::nullopt;
+    }
+    return IndexScanBound{constant->val_, true};
+  }
+  if (const auto *param = dynamic_cast<const ParameterValueExpression *>(expr);
+      param != nullptr && param->GetReturnType() == type) {
+    return IndexScanBound{ValueFactory::GetNullValueByType(type), true, param->param_idx_};
+  }
+  return std::nullopt;
+}
 
-        aggregates.push_back(agg_plan.GetAggregates()[0]);
-        agg_types.push_back(agg_plan.GetAggregateTypes()[0]);
-        agg_schema.push_back(agg_plan.OutputSchema().GetColumns()[agg_plan.GetGroupBys().size()]);
+/**
+ * Turn `column <op> constant`, or a conjunction of such comparisons of one column, into a range of keys. A parameter
+ * stands for a constant as long as it is not compared with another end of the range.
+ * @param[out] col_idx the compared column
+ * @return false if the predicate is of another shape
+ */
+auto PredicateToKeyRange(const AbstractExpression &predicate, const Schema &schema, std::optional<uint32_t> *col_idx,
+                         std::optional<IndexScanBound> *low, std::optional<IndexScanBound> *high) -> bool {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(&predicate); logic != nullptr) {
+    return logic->logic_type_ == LogicType::And &&
+           PredicateToKeyRange(*logic->children_[0], schema, col_idx, low, high) &&
+           PredicateToKeyRange(*logic->children_[1], schema, col_idx, low, high);
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(&predicate);
+  if (comparison == nullptr) {
+    return false;
+  }
+  auto comp_type = comparison->comp_type_;
+  const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+  const auto *value = comparison->children_[1].get();
+  if (column == nullptr) {
+    // `constant <op> column` compares the other way round.
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+    value = comparison->children_[0].get();
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  if (column == nullptr || column->GetTupleIdx() != 0 || (col_idx->has_value() && **col_idx != column->GetColIdx())) {
+    return false;
+  }
+  auto key = KeyOf(value, schema.GetColumn(column->GetColIdx()).GetType());
+  if (!key.has_value()) {
+    return false;
+  }
+  *col_idx = column->GetColIdx();
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      return TightenBound(low, *key, true) && TightenBound(high, *key, false);
+    case ComparisonType::GreaterThan:
+    case ComparisonType::GreaterThanOrEqual:
+      key->inclusive_ = comp_type == ComparisonType::GreaterThanOrEqual;
+      return TightenBound(low, *key, true);
+    case ComparisonType::LessThan:
+    case ComparisonType::LessThanOrEqual:
+      key->inclusive_ = comp_type == ComparisonType::LessThanOrEqual;
+      return TightenBound(high, *key, false);
+    default:
+      return false;
+  }
+}
 
-        aggregates.push_back(agg_plan.GetAggregates()[3]);
-        agg_types.push_back(agg_plan.GetAggregateTypes()[3]);
-        agg_schema.push_back(agg_plan.OutputSchema().GetColumns()[agg_plan.GetGroupBys().size() + 3]);
+}  // namespace
 
-        return std::make_shared<ProjectionPlanNode>(
-            std::make_shared<Schema>(inner_schema), inner_proj_expr,
-            std::make_shared<AggregationPlanNode>(std::make_shared<Schema>(agg_schema), agg_plan.GetChildAt(0),
-                                                  agg_plan.GetGroupBys(), aggregates, agg_types));
-      }
+auto Optimizer::EstimateSelectivity(const AbstractExpression &predicate, const TableStats &stats, const Schema &schema)
+    -> double {
+  if (const auto *constant = dynamic_cast<const ConstantValueExpression *>(&predicate); constant != nullptr) {
+    return IsPredicateTrue(predicate) ? 1 : 0;
+  }
+  // A range of one column, e.g. `x >= 1 AND x < 10`, is looked up as a whole rather than as independent bounds.
+  std::optional<uint32_t> col_idx;
+  std::optional<IndexScanBound> low;
+  std::optional<IndexScanBound> high;
+  if (PredicateToKeyRange(predicate, schema, &col_idx, &low, &high)) {
+    const auto &column = stats.columns_[*col_idx];
+    bool has_params =
+        (low.has_value() && low->param_idx_.has_value()) || (high.has_value() && high->param_idx_.has_value());
+    if (!column.has_value() || has_params) {
+      bool is_point = low.has_value() && high.has_value() &&
+                      (has_params ? low->param_idx_ == high->param_idx_
+                                  : low->key_.CompareEquals(high->key_) == CmpBool::CmpTrue);
+      return is_point ? DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
     }
+    return column->RangeSelectivity(low.has_value() ? &low->key_ : nullptr, low.has_value() && low->inclusive_,
+                                    high.has_value() ? &high->key_ : nullptr, high.has_value() && high->inclusive_);
   }
-  return optimized_plan;
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(&predicate); logic != nullptr) {
+    auto left = EstimateSelectivity(*logic->children_[0], stats, schema);
+    auto right = EstimateSelectivity(*logic->children_[1], stats, schema);
+    return logic->logic_type_ == LogicType::And ? left * right : left + right - left * right;
+  }
+  const auto *comparison = dynamic_cast<const ComparisonExpression *>(&predicate);
+  if (comparison == nullptr) {
+    return DEFAULT_RANGE_SELECTIVITY;
+  }
+  if (comparison->comp_type_ == ComparisonType::NotEqual) {
+    ComparisonExpression equal(comparison->children_[0], comparison->children_[1], ComparisonType::Equal);
+    return 1 - EstimateSelectivity(equal, stats, schema);
+  }
+  if (comparison->comp_type_ == ComparisonType::Equal) {
+    // Two columns are equal in one of the rows for every distinct value of the column with more of them.
+    const auto *left = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+    const auto *right = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+    if (left != nullptr && right != nullptr && stats.columns_[left->GetColIdx()].has_value() &&
+        stats.columns_[right->GetColIdx()].has_value()) {
+      auto distinct =
+          std::max(stats.columns_[left->GetColIdx()]->distinct_, stats.columns_[right->GetColIdx()]->distinct_);
+      return 1.0 / static_cast<double>(std::max<uint64_t>(distinct, 1));
+    }
+    return DEFAULT_EQUALITY_SELECTIVITY;
+  }
+  return DEFAULT_RANGE_SELECTIVITY;
 }
 
 auto Optimizer::OptimizeMergeFilterIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
@@ -330,22 +260,21 @@ auto Optimizer::OptimizeMergeFilterIndexScan(const AbstractPlanNodeRef &plan) ->
       const auto &seq_scan_plan = dynamic_cast<const SeqScanPlanNode &>(child_plan);
       const auto *table_info = catalog_.GetTable(seq_scan_plan.GetTableOid());
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
-      if (const auto *expr = dynamic_cast<const ComparisonExpression *>(filter_plan.GetPredicate().get());
-          expr != nullptr) {
-        if (expr->comp_type_ == ComparisonType::Equal) {
-          if (const auto *left_expr = dynamic_cast<const ColumnValueExpression *>(expr->children_[0].get());
-              left_expr != nullptr) {
-            if (const auto *right_expr = dynamic_cast<const ConstantValueExpression *>(expr->children_[1].get());
-                right_expr != nullptr) {
-              for (const auto *index : indices) {
-                const auto &columns = index->key_schema_.GetColumns();
-                if (columns.size() == 1 &&
-                    columns[0].GetName() == table_info->schema_.GetColumn(left_expr->GetColIdx()).GetName()) {
-                  return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_,
-                                                             filter_plan.GetPredicate());
-                }
-              }
-            }
+      // Equality and range predicates on an indexed column read only the matching range of the index.
+      std::optional<uint32_t> col_idx;
+      std::optional<IndexScanBound> low;
+      std::optional<IndexScanBound> high;
+      if (PredicateToKeyRange(*filter_plan.GetPredicate(), table_info->schema_, &col_idx, &low, &high)) {
+        if (auto stats = catalog_.GetTableStats(table_info->oid_);
+            stats != nullptr && EstimateSelectivity(*filter_plan.GetPredicate(), *stats, table_info->schema_) >
+                                    INDEX_SCAN_MAX_SELECTIVITY) {
+          return optimized_plan;
+        }
+        for (const auto *index : indices) {
+          const auto &columns = index->key_schema_.GetColumns();
+          if (columns.size() == 1 && columns[0].GetName() == table_info->schema_.GetColumn(*col_idx).GetName()) {
+            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_,
+                                                       filter_plan.GetPredicate(), low, high);
           }
         }
       }
@@ -356,19 +285,26 @@ auto Optimizer::OptimizeMergeFilterIndexScan(const AbstractPlanNodeRef &plan) ->
 
 auto Optimizer::OptimizeCustom(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
   auto p = plan;
+  p = OptimizeSimplifyExpressions(p);
   p = OptimizeMergeProjection(p);
-  p = OptimizeMergeFilterIndexScan(p);
-  p = OptimizeMergeFilterScan(p);
   p = OptimizeMergeFilterNLJ(p);
-  p = OptimizeReorderJoinUseIndex(p);
   p = OptimizePredicatePushDown(p);
+  p = OptimizeJoinOrder(p);
+  p = OptimizeMergeFilterIndexScan(p);
+  p = OptimizeMergeFilterScan(p);
   p = OptimizeFalseFilter(p);
   p = OptimizeRemoveJoin(p);
-  p = OptimizeRemoveColumn(p);
+  if (enable_adaptive_join) {
+    p = OptimizeNLJAsAdaptiveJoin(p);
+  }
   p = OptimizeNLJAsIndexJoin(p);
   p = OptimizeNLJAsHashJoin(p);  // Enable this rule after you have implemented hash join.
   p = OptimizeOrderByAsIndexScan(p);
   p = OptimizeSortLimitAsTopN(p);
+  // Pruned first as well, so that expressions whose result is never read are not hoisted.
+  p = OptimizeColumnPruning(p);
+  p = OptimizeHoistCommonExpressions(p);
+  p = OptimizeColumnPruning(p);
   return p;
 }
 
@@ -0,0 +1,293 @@
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/expressions/parameter_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "optimizer/optimizer.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+using Predicates = std::vector<AbstractExpressionRef>;
+
+auto IsTrue(const AbstractExpression &expr) -> bool {
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(&expr);
+  return constant != nullptr && !constant->val_.IsNull() && constant->val_.CastAs(TypeId::BOOLEAN).GetAs<bool>();
+}
+
+/** Append the conjuncts of a predicate, leaving out those that are always true */
+void Split(const AbstractExpressionRef &expr, Predicates *conjuncts) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr.get());
+      logic != nullptr && logic->logic_type_ == LogicType::And) {
+    Split(logic->children_[0], conjuncts);
+    Split(logic->children_[1], conjuncts);
+  } else if (!IsTrue(*expr)) {
+    conjuncts->push_back(expr);
+  }
+}
+
+auto And(const Predicates &conjuncts) -> AbstractExpressionRef {
+  AbstractExpressionRef result;
+  for (const auto &conjunct : conjuncts) {
+    result = result == nullptr ? conjunct : std::make_shared<LogicExpression>(result, conjunct, LogicType::And);
+  }
+  return result;
+}
+
+/** @return true if every column the expression reads lies in [begin, end) */
+auto ReadsOnly(const AbstractExpression &expr, uint32_t begin, uint32_t end) -> bool {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(&expr); column != nullptr) {
+    return column->GetColIdx() >= begin && column->GetColIdx() < end;
+  }
+  for (const auto &child : expr.GetChildren()) {
+    if (!ReadsOnly(*child, begin, end)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/** @return the expression with column `i` of tuple 0 replaced by `columns[i]` */
+auto Substitute(const AbstractExpressionRef &expr, const Predicates &columns) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    return columns[column->GetColIdx()];
+  }
+  Predicates children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Substitute(child, columns));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/** @return the columns of both inputs of a join, numbered as in its predicate */
+auto JoinColumns(const NestedLoopJoinPlanNode &nlj_plan) -> Predicates {
+  Predicates columns;
+  for (uint32_t side = 0; side < 2; side++) {
+    const auto &schema = nlj_plan.GetChildAt(side)->OutputSchema();
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      columns.push_back(std::make_shared<ColumnValueExpression>(side, i, schema.GetColumn(i).GetType()));
+    }
+  }
+  return columns;
+}
+
+/** @return the predicate with a join predicate's column `i` of tuple 1 numbered `left_count + i` in tuple 0 */
+auto Flatten(const AbstractExpressionRef &expr, uint32_t left_count) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    auto offset = column->GetTupleIdx() == 0 ? 0 : left_count;
+    return std::make_shared<ColumnValueExpression>(0, offset + column->GetColIdx(), column->GetReturnType());
+  }
+  Predicates children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Flatten(child, left_count));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/** @return the predicate with every column moved `offset` columns to the left */
+auto Shift(const AbstractExpressionRef &expr, uint32_t offset) -> AbstractExpressionRef {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    return std::make_shared<ColumnValueExpression>(0, column->GetColIdx() - offset, column->GetReturnType());
+  }
+  Predicates children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Shift(child, offset));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+/**
+ * Add the comparisons with a constant that the equalities of columns imply: with `a = b` and `b = 5`, `a = 5` holds
+ * too, and can filter the input of `a` before the join.
+ */
+void AddTransitiveEqualities(Predicates *conjuncts, uint32_t column_count) {
+  std::vector<uint32_t> parent(column_count);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&parent](uint32_t column) {
+    while (parent[column] != column) {
+      column = parent[column] = parent[parent[column]];
+    }
+    return column;
+  };
+  // The constant every class of equal columns is equal to, and the columns already compared with it.
+  std::vector<AbstractExpressionRef> constants(column_count);
+  std::vector<bool> compared(column_count, false);
+  std::vector<TypeId> types(column_count, TypeId::INVALID);
+  for (const auto &conjunct : *conjuncts) {
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct.get());
+    if (comparison == nullptr || comparison->comp_type_ != ComparisonType::Equal) {
+      continue;
+    }
+    const auto *left = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+    const auto *right = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+    if (left != nullptr && right != nullptr) {
+      types[left->GetColIdx()] = left->GetReturnType();
+      types[right->GetColIdx()] = right->GetReturnType();
+      parent[find(left->GetColIdx())] = find(right->GetColIdx());
+    }
+  }
+  for (const auto &conjunct : *conjuncts) {
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct.get());
+    if (comparison == nullptr || comparison->comp_type_ != ComparisonType::Equal) {
+      continue;
+    }
+    for (size_t side = 0; side < 2; side++) {
+      const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[side].get());
+      const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->children_[1 - side].get());
+      const auto *param = dynamic_cast<const ParameterValueExpression *>(comparison->children_[1 - side].get());
+      if (column != nullptr && ((constant != nullptr && !constant->val_.IsNull()) || param != nullptr)) {
+        compared[column->GetColIdx()] = true;
+        constants[find(column->GetColIdx())] = comparison->children_[1 - side];
+      }
+    }
+  }
+  for (uint32_t column = 0; column < column_count; column++) {
+    if (const auto &constant = constants[find(column)]; constant != nullptr && !compared[column]) {
+      conjuncts->push_back(std::make_shared<ComparisonExpression>(
+          std::make_shared<ColumnValueExpression>(0, column, types[column]), constant, ComparisonType::Equal));
+    }
+  }
+}
+
+auto PushDown(const AbstractPlanNodeRef &plan, Predicates predicates) -> AbstractPlanNodeRef;
+
+/** @return the plan with its children pushed down on their own and the predicates filtering its output */
+auto KeepAbove(const AbstractPlanNodeRef &plan, const Predicates &predicates) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(PushDown(child, {}));
+  }
+  AbstractPlanNodeRef optimized_plan = plan->CloneWithChildren(std::move(children));
+  if (predicates.empty()) {
+    return optimized_plan;
+  }
+  return std::make_shared<FilterPlanNode>(optimized_plan->output_schema_, And(predicates), optimized_plan);
+}
+
+auto PushDownJoin(const NestedLoopJoinPlanNode &nlj_plan, Predicates predicates) -> AbstractPlanNodeRef {
+  uint32_t left_count = nlj_plan.GetLeftPlan()->OutputSchema().GetColumnCount();
+  // A semi or anti join only returns the left columns, its predicate reads those of both inputs.
+  uint32_t column_count = left_count + nlj_plan.GetRightPlan()->OutputSchema().GetColumnCount();
+  bool is_inner = nlj_plan.GetJoinType() == JoinType::INNER;
+  // Only the left rows a semi join returns have to match, an anti join returns those that do not.
+  bool can_filter_left = is_inner || nlj_plan.GetJoinType() == JoinType::SEMI;
+  // Whether `NOT IN` is NULL depends on the right rows the comparison is NULL for, whatever the rest of the predicate.
+  bool can_filter_right = nlj_plan.GetJoinType() != JoinType::NULL_AWARE_ANTI;
+  Predicates join_conjuncts;
+  Split(Flatten(nlj_plan.predicate_, left_count), &join_conjuncts);
+
+  Predicates left;
+  Predicates right;
+  Predicates join;
+  Predicates above;
+  if (is_inner) {
+    // A filter above an inner join and the predicate of the join are the same, and are split among its inputs.
+    join_conjuncts.insert(join_conjuncts.end(), predicates.begin(), predicates.end());
+    AddTransitiveEqualities(&join_conjuncts, column_count);
+    predicates.clear();
+  }
+  for (const auto &conjunct : predicates) {
+    // Rows of the left input of an outer join are kept whether they match or not, only they can be filtered early.
+    if (ReadsOnly(*conjunct, 0, left_count)) {
+      left.push_back(conjunct);
+    } else {
+      above.push_back(conjunct);
+    }
+  }
+  for (const auto &conjunct : join_conjuncts) {
+    if (can_filter_left && ReadsOnly(*conjunct, 0, left_count) && !ReadsOnly(*conjunct, 0, 0)) {
+      left.push_back(conjunct);
+    } else if (can_filter_right && ReadsOnly(*conjunct, left_count, column_count) && !ReadsOnly(*conjunct, 0, 0)) {
+      right.push_back(Shift(conjunct, left_count));
+    } else {
+      join.push_back(Substitute(conjunct, JoinColumns(nlj_plan)));
+    }
+  }
+
+  auto predicate = join.empty() ? std::make_shared<ConstantValueExpression>(ValueFactory::GetBooleanValue(true))
+                                : And(join);
+  AbstractPlanNodeRef optimized_plan = std::make_shared<NestedLoopJoinPlanNode>(
+      nlj_plan.output_schema_, PushDown(nlj_plan.GetLeftPlan(), std::move(left)),
+      PushDown(nlj_plan.GetRightPlan(), std::move(right)), predicate, nlj_plan.GetJoinType());
+  if (above.empty()) {
+    return optimized_plan;
+  }
+  return std::make_shared<FilterPlanNode>(optimized_plan->output_schema_, And(above), optimized_plan);
+}
+
+/**
+ * Push predicates over the output of a plan as far down into it as they can go.
+ * @param predicates conjuncts over the output of the plan that it must satisfy
+ */
+auto PushDown(const AbstractPlanNodeRef &plan, Predicates predicates) -> AbstractPlanNodeRef {
+  switch (plan->GetType()) {
+    case PlanType::Filter: {
+      const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*plan);
+      Split(filter_plan.GetPredicate(), &predicates);
+      return PushDown(filter_plan.GetChildPlan(), std::move(predicates));
+    }
+    case PlanType::NestedLoopJoin: {
+      const auto &nlj_plan = dynamic_cast<const NestedLoopJoinPlanNode &>(*plan);
+      if (nlj_plan.GetJoinType() == JoinType::RIGHT || nlj_plan.GetJoinType() == JoinType::OUTER) {
+        return KeepAbove(plan, predicates);
+      }
+      return PushDownJoin(nlj_plan, std::move(predicates));
+    }
+    case PlanType::Projection: {
+      // A projection computes its columns from every row of its input, so they can be computed below it as well.
+      const auto &projection_plan = dynamic_cast<const ProjectionPlanNode &>(*plan);
+      Predicates below;
+      for (const auto &predicate : predicates) {
+        below.push_back(Substitute(predicate, projection_plan.GetExpressions()));
+      }
+      return plan->CloneWithChildren({PushDown(projection_plan.GetChildPlan(), std::move(below))});
+    }
+    case PlanType::Aggregation: {
+      // A predicate on the groups only removes whole groups, which is the same as removing their rows before. Without
+      // GROUP BY there is always one group, which may not be removed by filtering its rows.
+      const auto &agg_plan = dynamic_cast<const AggregationPlanNode &>(*plan);
+      auto group_count = static_cast<uint32_t>(agg_plan.GetGroupBys().size());
+      Predicates below;
+      Predicates above;
+      for (const auto &predicate : predicates) {
+        if (group_count > 0 && ReadsOnly(*predicate, 0, group_count)) {
+          below.push_back(Substitute(predicate, agg_plan.GetGroupBys()));
+        } else {
+          above.push_back(predicate);
+        }
+      }
+      AbstractPlanNodeRef optimized_plan =
+          plan->CloneWithChildren({PushDown(agg_plan.GetChildPlan(), std::move(below))});
+      if (above.empty()) {
+        return optimized_plan;
+      }
+      return std::make_shared<FilterPlanNode>(optimized_plan->output_schema_, And(above), optimized_plan);
+    }
+    case PlanType::Sort:
+      return plan->CloneWithChildren({PushDown(plan->GetChildAt(0), std::move(predicates))});
+    default:
+      return KeepAbove(plan, predicates);
+  }
+}
+
+}  // namespace
+
+auto Optimizer::OptimizePredicatePushDown(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  return PushDown(plan, {});
+}
+
+}  // namespace bustub
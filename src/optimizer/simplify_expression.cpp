@@ -0,0 +1,195 @@
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/exception.h"
+#include "execution/expressions/arithmetic_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/adaptive_join_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "execution/plans/update_plan.h"
+#include "execution/plans/values_plan.h"
+#include "optimizer/optimizer.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto AsConstant(const AbstractExpressionRef &expr) -> const Value * {
+  const auto *constant = dynamic_cast<const ConstantValueExpression *>(expr.get());
+  return constant == nullptr ? nullptr : &constant->val_;
+}
+
+auto IsBoolean(const Value *value, bool expected) -> bool {
+  return value != nullptr && value->GetTypeId() == TypeId::BOOLEAN && !value->IsNull() &&
+         value->GetAs<bool>() == expected;
+}
+
+/** @return the simplified logic expression, whose children are simplified already */
+auto SimplifyLogic(const LogicExpression &logic, const AbstractExpressionRef &expr) -> AbstractExpressionRef {
+  const auto &left = logic.children_[0];
+  const auto &right = logic.children_[1];
+  // `x AND false` is false and `x OR true` is true even if x is NULL, `x AND true` and `x OR false` are x.
+  bool absorbing = logic.logic_type_ == LogicType::Or;
+  for (const auto &[side, other] : {std::make_pair(left, right), std::make_pair(right, left)}) {
+    const auto *value = AsConstant(side);
+    if (IsBoolean(value, absorbing)) {
+      return side;
+    }
+    if (IsBoolean(value, !absorbing)) {
+      return other;
+    }
+  }
+  if (left->ToString() == right->ToString()) {
+    return left;
+  }
+  return expr;
+}
+
+}  // namespace
+
+auto Optimizer::SimplifyExpression(const AbstractExpressionRef &expr) -> AbstractExpressionRef {
+  if (expr == nullptr || expr->GetChildren().empty()) {
+    return expr;
+  }
+  std::vector<AbstractExpressionRef> children;
+  bool is_constant = true;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(SimplifyExpression(child));
+    is_constant = is_constant && AsConstant(children.back()) != nullptr;
+  }
+  AbstractExpressionRef simplified = expr->CloneWithChildren(std::move(children));
+
+  bool is_foldable = dynamic_cast<const ArithmeticExpression *>(simplified.get()) != nullptr ||
+                     dynamic_cast<const ComparisonExpression *>(simplified.get()) != nullptr ||
+                     dynamic_cast<const LogicExpression *>(simplified.get()) != nullptr;
+  if (is_constant && is_foldable) {
+    try {
+      return std::make_shared<ConstantValueExpression>(simplified->Evaluate(nullptr, Schema(std::vector<Column>{})));
+    } catch (const Exception &) {
+      // e.g. comparing values of incompatible types, which fails when the plan is executed instead.
+      return simplified;
+    }
+  }
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(simplified.get()); logic != nullptr) {
+    return SimplifyLogic(*logic, simplified);
+  }
+  return simplified;
+}
+
+void Optimizer::RewriteExpressions(AbstractPlanNode *plan,
+                                   const std::function<AbstractExpressionRef(const AbstractExpressionRef &)> &rewrite) {
+  auto rewrite_all = [&rewrite](std::vector<AbstractExpressionRef> *exprs) {
+    for (auto &expr : *exprs) {
+      expr = rewrite(expr);
+    }
+  };
+  auto rewrite_order_bys = [&rewrite](std::vector<std::pair<OrderByType, AbstractExpressionRef>> *order_bys) {
+    for (auto &order_by : *order_bys) {
+      order_by.second = rewrite(order_by.second);
+    }
+  };
+  switch (plan->GetType()) {
+    case PlanType::SeqScan: {
+      auto &seq_scan = dynamic_cast<SeqScanPlanNode &>(*plan);
+      seq_scan.filter_predicate_ = rewrite(seq_scan.filter_predicate_);
+      break;
+    }
+    case PlanType::IndexScan: {
+      auto &index_scan = dynamic_cast<IndexScanPlanNode &>(*plan);
+      index_scan.filter_predicate_ = rewrite(index_scan.filter_predicate_);
+      break;
+    }
+    case PlanType::Filter: {
+      auto &filter = dynamic_cast<FilterPlanNode &>(*plan);
+      filter.predicate_ = rewrite(filter.predicate_);
+      break;
+    }
+    case PlanType::Projection:
+      rewrite_all(&dynamic_cast<ProjectionPlanNode &>(*plan).expressions_);
+      break;
+    case PlanType::Values:
+      for (auto &row : dynamic_cast<ValuesPlanNode &>(*plan).values_) {
+        rewrite_all(&row);
+      }
+      break;
+    case PlanType::Aggregation: {
+      auto &aggregation = dynamic_cast<AggregationPlanNode &>(*plan);
+      rewrite_all(&aggregation.group_bys_);
+      rewrite_all(&aggregation.aggregates_);
+      break;
+    }
+    case PlanType::NestedLoopJoin: {
+      auto &nlj = dynamic_cast<NestedLoopJoinPlanNode &>(*plan);
+      nlj.predicate_ = rewrite(nlj.predicate_);
+      break;
+    }
+    case PlanType::NestedIndexJoin: {
+      auto &index_join = dynamic_cast<NestedIndexJoinPlanNode &>(*plan);
+      index_join.key_predicate_ = rewrite(index_join.key_predicate_);
+      break;
+    }
+    case PlanType::HashJoin: {
+      auto &hash_join = dynamic_cast<HashJoinPlanNode &>(*plan);
+      hash_join.left_key_expression_ = rewrite(hash_join.left_key_expression_);
+      hash_join.right_key_expression_ = rewrite(hash_join.right_key_expression_);
+      break;
+    }
+    case PlanType::AdaptiveJoin: {
+      auto &adaptive_join = dynamic_cast<AdaptiveJoinPlanNode &>(*plan);
+      adaptive_join.left_key_expression_ = rewrite(adaptive_join.left_key_expression_);
+      adaptive_join.right_key_expression_ = rewrite(adaptive_join.right_key_expression_);
+      break;
+    }
+    case PlanType::Sort:
+      rewrite_order_bys(&dynamic_cast<SortPlanNode &>(*plan).order_bys_);
+      break;
+    case PlanType::TopN:
+      rewrite_order_bys(&dynamic_cast<TopNPlanNode &>(*plan).order_bys_);
+      break;
+    case PlanType::Update:
+      rewrite_all(&dynamic_cast<UpdatePlanNode &>(*plan).target_expressions_);
+      break;
+    default:
+      break;
+  }
+}
+
+auto Optimizer::OptimizeSimplifyExpressions(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeSimplifyExpressions(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+  RewriteExpressions(optimized_plan.get(), SimplifyExpression);
+
+  if (optimized_plan->GetType() == PlanType::Filter) {
+    const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+    if (const auto *value = AsConstant(filter_plan.GetPredicate());
+        value != nullptr && (value->IsNull() || value->GetTypeId() == TypeId::BOOLEAN)) {
+      if (IsBoolean(value, true)) {
+        return filter_plan.children_[0];
+      }
+      // A filter keeps no row for which its predicate is false or NULL.
+      return std::make_shared<ValuesPlanNode>(filter_plan.output_schema_,
+                                              std::vector<std::vector<AbstractExpressionRef>>{});
+    }
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
@@ -26,10 +26,6 @@ namespace bustub {
 
 auto Planner::PlanAggCall(const BoundAggCall &agg_call, const std::vector<AbstractPlanNodeRef> &children)
     -> std::tuple<AggregationType, std::vector<AbstractExpressionRef>> {
-  if (agg_call.is_distinct_) {
-    throw NotImplementedException("distinct agg is not implemented yet");
-  }
-
   std::vector<AbstractExpressionRef> exprs;
 
   {
@@ -41,7 +37,25 @@ auto Planner::PlanAggCall(const BoundAggCall &agg_call, const std::vector<Abstra
     }
   }
 
-  return GetAggCallFromFactory(agg_call.func_name_, std::move(exprs));
+  auto [agg_type, args] = GetAggCallFromFactory(agg_call.func_name_, std::move(exprs));
+  if (agg_call.is_distinct_) {
+    switch (agg_type) {
+      case AggregationType::CountAggregate:
+        agg_type = AggregationType::CountDistinctAggregate;
+        break;
+      case AggregationType::SumAggregate:
+        agg_type = AggregationType::SumDistinctAggregate;
+        break;
+      case AggregationType::MinAggregate:
+      case AggregationType::MaxAggregate:
+      case AggregationType::ApproxCountDistinctAggregate:
+        // Duplicates do not change the result.
+        break;
+      default:
+        throw NotImplementedException(fmt::format("{}(DISTINCT) is not supported", agg_call.func_name_));
+    }
+  }
+  return {agg_type, std::move(args)};
 }
 
 // TODO(chi): clang-tidy on macOS will suggest changing it to const reference. Looks like a bug.
@@ -0,0 +1,197 @@
+#include "planner/plan_cache.h"
+
+#include <cctype>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binder/binder.h"
+#include "binder/simplified_token.h"
+#include "common/exception.h"
+#include "common/util/string_util.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/parameter_value_expression.h"
+#include "execution/plans/index_scan_plan.h"
+#include "fmt/format.h"
+#include "optimizer/optimizer.h"
+#include "type/type.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the end of the integer constant starting at `start`, or nullopt if it is not an int */
+auto ScanInteger(const std::string &sql, size_t start, Value *value) -> std::optional<size_t> {
+  auto end = start;
+  while (end < sql.size() && std::isdigit(sql[end]) != 0) {
+    end++;
+  }
+  // Decimals, exponents and integers out of the range of INTEGER keep their meaning in the text.
+  if (end == start || end - start > 10 || (end < sql.size() && (std::isalnum(sql[end]) != 0 || sql[end] == '.'))) {
+    return std::nullopt;
+  }
+  auto number = std::stoll(sql.substr(start, end - start));
+  if (number > std::numeric_limits<int32_t>::max()) {
+    return std::nullopt;
+  }
+  *value = ValueFactory::GetIntegerValue(static_cast<int32_t>(number));
+  return end;
+}
+
+/** @return the end of the string constant starting at `start`, or nullopt if it is not a plain quoted string */
+auto ScanString(const std::string &sql, size_t start, Value *value) -> std::optional<size_t> {
+  if (sql[start] != '\'') {
+    return std::nullopt;
+  }
+  std::string str;
+  for (auto end = start + 1; end < sql.size(); end++) {
+    if (sql[end] != '\'') {
+      str.push_back(sql[end]);
+    } else if (end + 1 < sql.size() && sql[end + 1] == '\'') {
+      str.push_back('\'');
+      end++;
+    } else {
+      *value = ValueFactory::GetVarcharValue(str);
+      return end + 1;
+    }
+  }
+  return std::nullopt;
+}
+
+auto Bind(const AbstractExpressionRef &expr, const std::vector<Value> &params) -> AbstractExpressionRef {
+  if (expr == nullptr) {
+    return expr;
+  }
+  if (const auto *param = dynamic_cast<const ParameterValueExpression *>(expr.get()); param != nullptr) {
+    if (param->param_idx_ >= params.size()) {
+      throw Exception(fmt::format("no value for parameter ${}", param->param_idx_ + 1));
+    }
+    return std::make_shared<ConstantValueExpression>(params[param->param_idx_]);
+  }
+  if (expr->GetChildren().empty()) {
+    return expr;
+  }
+  std::vector<AbstractExpressionRef> children;
+  for (const auto &child : expr->GetChildren()) {
+    children.emplace_back(Bind(child, params));
+  }
+  return expr->CloneWithChildren(std::move(children));
+}
+
+void Bind(std::optional<IndexScanBound> *bound, const std::vector<Value> &params) {
+  if (bound->has_value() && (*bound)->param_idx_.has_value()) {
+    (*bound)->key_ = params.at(*(*bound)->param_idx_);
+    (*bound)->param_idx_ = std::nullopt;
+  }
+}
+
+}  // namespace
+
+auto PlanCache::Parameterize(const std::string &sql) -> std::optional<ParameterizedQuery> {
+  ParameterizedQuery result;
+  auto tokens = Binder::Tokenize(sql);
+  // Other statements, e.g. CREATE TABLE or EXPLAIN, are not planned with parameters.
+  if (tokens.empty() || tokens[0].type_ != SimplifiedTokenType::SIMPLIFIED_TOKEN_KEYWORD) {
+    return std::nullopt;
+  }
+  auto keyword = StringUtil::Lower(sql.substr(tokens[0].start_, 6));
+  if (keyword != "select" && keyword != "insert" && keyword != "update" && keyword != "delete") {
+    return std::nullopt;
+  }
+  size_t copied = 0;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    auto start = static_cast<size_t>(tokens[i].start_);
+    if (tokens[i].type_ == SimplifiedTokenType::SIMPLIFIED_TOKEN_OPERATOR && sql[start] == '$') {
+      return std::nullopt;
+    }
+    if (tokens[i].type_ != SimplifiedTokenType::SIMPLIFIED_TOKEN_NUMERIC_CONSTANT &&
+        tokens[i].type_ != SimplifiedTokenType::SIMPLIFIED_TOKEN_STRING_CONSTANT) {
+      continue;
+    }
+    if (i > 0) {
+      auto prev_start = static_cast<size_t>(tokens[i - 1].start_);
+      auto prev = StringUtil::Lower(sql.substr(prev_start, start - prev_start));
+      prev.erase(prev.find_last_not_of(" \t\r\n") + 1);
+      if (prev == "limit" || prev == "offset" || prev == "-") {
+        continue;
+      }
+    }
+    Value value;
+    auto is_numeric = tokens[i].type_ == SimplifiedTokenType::SIMPLIFIED_TOKEN_NUMERIC_CONSTANT;
+    auto end = is_numeric ? ScanInteger(sql, start, &value) : ScanString(sql, start, &value);
+    if (!end.has_value()) {
+      continue;
+    }
+    result.params_.push_back(value);
+    result.query_ += sql.substr(copied, start - copied);
+    result.query_ += fmt::format("${}", result.params_.size());
+    copied = *end;
+  }
+  result.query_ += sql.substr(copied);
+  return result;
+}
+
+auto PlanCache::Key(const std::string &query, const std::vector<Value> &params) -> std::string {
+  auto key = query;
+  for (const auto &param : params) {
+    key += '\n';
+    key += Type::TypeIdToString(param.GetTypeId());
+  }
+  return key;
+}
+
+auto PlanCache::BindParameters(const AbstractPlanNodeRef &plan, const std::vector<Value> &params)
+    -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(BindParameters(child, params));
+  }
+  auto bound = plan->CloneWithChildren(std::move(children));
+  // Constants computed from the parameters are folded once they are known, e.g. `x > $1 + $2`.
+  Optimizer::RewriteExpressions(bound.get(), [&params](const AbstractExpressionRef &expr) {
+    return Optimizer::SimplifyExpression(Bind(expr, params));
+  });
+  if (bound->GetType() == PlanType::IndexScan) {
+    auto &index_scan = dynamic_cast<IndexScanPlanNode &>(*bound);
+    Bind(&index_scan.low_, params);
+    Bind(&index_scan.high_, params);
+  }
+  return bound;
+}
+
+auto PlanCache::Get(const std::string &key, uint64_t catalog_version) -> std::shared_ptr<const CachedPlan> {
+  std::scoped_lock lock(latch_);
+  auto plan = plans_.find(key);
+  if (plan == plans_.end() || plan->second.first->catalog_version_ != catalog_version) {
+    misses_++;
+    return nullptr;
+  }
+  keys_.splice(keys_.begin(), keys_, plan->second.second);
+  hits_++;
+  return plan->second.first;
+}
+
+void PlanCache::Put(const std::string &key, std::shared_ptr<const CachedPlan> plan) {
+  std::scoped_lock lock(latch_);
+  if (auto cached = plans_.find(key); cached != plans_.end()) {
+    keys_.erase(cached->second.second);
+    plans_.erase(cached);
+  }
+  if (plans_.size() >= capacity_) {
+    plans_.erase(keys_.back());
+    keys_.pop_back();
+  }
+  keys_.push_front(key);
+  plans_.emplace(key, std::make_pair(std::move(plan), keys_.begin()));
+}
+
+void PlanCache::Clear() {
+  std::scoped_lock lock(latch_);
+  keys_.clear();
+  plans_.clear();
+}
+
+}  // namespace bustub
@@ -7,6 +7,7 @@
 #include "binder/expressions/bound_binary_op.h"
 #include "binder/expressions/bound_column_ref.h"
 #include "binder/expressions/bound_constant.h"
+#include "binder/expressions/bound_parameter.h"
 #include "binder/expressions/bound_unary_op.h"
 #include "binder/statement/select_statement.h"
 #include "common/exception.h"
@@ -14,6 +15,7 @@
 #include "common/util/string_util.h"
 #include "execution/expressions/column_value_expression.h"
 #include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/parameter_value_expression.h"
 #include "execution/plans/abstract_plan.h"
 #include "fmt/format.h"
 #include "planner/planner.h"
@@ -119,7 +121,8 @@ void Planner::AddAggCallToContext(BoundExpression &expr) {
       AddAggCallToContext(*binary_op_expr.rarg_);
       return;
     }
-    case ExpressionType::CONSTANT: {
+    case ExpressionType::CONSTANT:
+    case ExpressionType::PARAMETER: {
       return;
     }
     case ExpressionType::ALIAS: {
@@ -154,6 +157,11 @@ auto Planner::PlanExpression(const BoundExpression &expr, const std::vector<Abst
       const auto &constant_expr = dynamic_cast<const BoundConstant &>(expr);
       return std::make_tuple(UNNAMED_COLUMN, PlanConstant(constant_expr, children));
     }
+    case ExpressionType::PARAMETER: {
+      const auto &parameter_expr = dynamic_cast<const BoundParameter &>(expr);
+      return std::make_tuple(UNNAMED_COLUMN, std::make_shared<ParameterValueExpression>(parameter_expr.param_idx_,
+                                                                                         parameter_expr.type_id_));
+    }
     case ExpressionType::ALIAS: {
       const auto &alias_expr = dynamic_cast<const BoundAlias &>(expr);
       auto [_1, expr] = PlanExpression(*alias_expr.child_, children);
@@ -52,9 +52,7 @@ auto Planner::PlanSelect(const SelectStatement &statement) -> AbstractPlanNodeRe
   }
 
   if (!statement.where_->IsInvalid()) {
-    auto schema = plan->OutputSchema();
-    auto [_, expr] = PlanExpression(*statement.where_, {plan});
-    plan = std::make_shared<FilterPlanNode>(std::make_shared<Schema>(schema), std::move(expr), std::move(plan));
+    plan = PlanWhere(*statement.where_, std::move(plan), nullptr);
   }
 
   bool has_agg = false;
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "binder/bound_expression.h"
+#include "binder/bound_order_by.h"
+#include "binder/bound_table_ref.h"
+#include "binder/expressions/bound_agg_call.h"
+#include "binder/expressions/bound_alias.h"
+#include "binder/expressions/bound_binary_op.h"
+#include "binder/expressions/bound_column_ref.h"
+#include "binder/expressions/bound_subquery_expr.h"
+#include "binder/expressions/bound_unary_op.h"
+#include "binder/statement/select_statement.h"
+#include "binder/table_ref/bound_join_ref.h"
+#include "catalog/schema.h"
+#include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/nested_loop_join_plan.h"
+#include "execution/plans/values_plan.h"
+#include "planner/planner.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Append the conjuncts of a predicate */
+void SplitConjuncts(const BoundExpression &expr, std::vector<const BoundExpression *> *conjuncts) {
+  if (expr.type_ == ExpressionType::BINARY_OP) {
+    const auto &binary_op = dynamic_cast<const BoundBinaryOp &>(expr);
+    if (binary_op.op_name_ == "and") {
+      SplitConjuncts(*binary_op.larg_, conjuncts);
+      SplitConjuncts(*binary_op.rarg_, conjuncts);
+      return;
+    }
+  }
+  conjuncts->push_back(&expr);
+}
+
+/**
+ * @return the subquery a conjunct is, or nullptr if it is something else
+ * @param[out] negated whether it is `NOT EXISTS` or `NOT IN`
+ */
+auto AsSubquery(const BoundExpression &expr, bool *negated) -> const BoundSubqueryExpr * {
+  *negated = false;
+  if (expr.type_ == ExpressionType::UNARY_OP) {
+    const auto &unary_op = dynamic_cast<const BoundUnaryOp &>(expr);
+    if (unary_op.op_name_ != "not" || unary_op.arg_->type_ != ExpressionType::SUBQUERY) {
+      return nullptr;
+    }
+    *negated = true;
+    return &dynamic_cast<const BoundSubqueryExpr &>(*unary_op.arg_);
+  }
+  if (expr.type_ == ExpressionType::SUBQUERY) {
+    return &dynamic_cast<const BoundSubqueryExpr &>(expr);
+  }
+  return nullptr;
+}
+
+auto OuterDepth(const SelectStatement &select) -> size_t;
+
+/**
+ * @return how many queries out the furthest column an expression reads is, 0 if it only reads columns of its own query
+ * @param[out] has_subquery set if the expression contains a subquery
+ */
+auto OuterDepth(const BoundExpression &expr, bool *has_subquery) -> size_t {
+  switch (expr.type_) {
+    case ExpressionType::COLUMN_REF:
+      return dynamic_cast<const BoundColumnRef &>(expr).depth_;
+    case ExpressionType::BINARY_OP: {
+      const auto &binary_op = dynamic_cast<const BoundBinaryOp &>(expr);
+      return std::max(OuterDepth(*binary_op.larg_, has_subquery), OuterDepth(*binary_op.rarg_, has_subquery));
+    }
+    case ExpressionType::UNARY_OP:
+      return OuterDepth(*dynamic_cast<const BoundUnaryOp &>(expr).arg_, has_subquery);
+    case ExpressionType::ALIAS:
+      return OuterDepth(*dynamic_cast<const BoundAlias &>(expr).child_, has_subquery);
+    case ExpressionType::AGG_CALL: {
+      size_t depth = 0;
+      for (const auto &arg : dynamic_cast<const BoundAggCall &>(expr).args_) {
+        depth = std::max(depth, OuterDepth(*arg, has_subquery));
+      }
+      return depth;
+    }
+    case ExpressionType::SUBQUERY: {
+      const auto &subquery = dynamic_cast<const BoundSubqueryExpr &>(expr);
+      *has_subquery = true;
+      // The query around the subquery is one query out for it, and this query for the expression.
+      auto depth = OuterDepth(*subquery.subquery_);
+      depth = depth > 0 ? depth - 1 : 0;
+      if (subquery.test_expr_ != nullptr) {
+        depth = std::max(depth, OuterDepth(*subquery.test_expr_, has_subquery));
+      }
+      return depth;
+    }
+    default:
+      return 0;
+  }
+}
+
+/** @return how many queries out the furthest column a query reads is, 0 if it only reads columns of its own tables */
+auto OuterDepth(const SelectStatement &select) -> size_t {
+  bool has_subquery = false;
+  size_t depth = std::max(OuterDepth(*select.where_, &has_subquery), OuterDepth(*select.having_, &has_subquery));
+  for (const auto &item : select.select_list_) {
+    depth = std::max(depth, OuterDepth(*item, &has_subquery));
+  }
+  for (const auto &group_by : select.group_by_) {
+    depth = std::max(depth, OuterDepth(*group_by, &has_subquery));
+  }
+  for (const auto &order_by : select.sort_) {
+    depth = std::max(depth, OuterDepth(*order_by->expr_, &has_subquery));
+  }
+  return depth;
+}
+
+}  // namespace
+
+auto Planner::PlanWhere(const BoundExpression &where, AbstractPlanNodeRef plan,
+                        std::vector<const BoundExpression *> *correlated) -> AbstractPlanNodeRef {
+  std::vector<const BoundExpression *> conjuncts;
+  SplitConjuncts(where, &conjuncts);
+
+  std::vector<const BoundExpression *> filters;
+  std::vector<std::pair<const BoundSubqueryExpr *, bool>> subqueries;
+  for (const auto *conjunct : conjuncts) {
+    bool has_subquery = false;
+    auto depth = OuterDepth(*conjunct, &has_subquery);
+    bool negated = false;
+    if (depth > 0) {
+      if (correlated == nullptr || depth > 1 || has_subquery) {
+        throw NotImplementedException(
+            "a subquery can only read columns of the query right around it, in conjuncts of its WHERE clause");
+      }
+      correlated->push_back(conjunct);
+    } else if (const auto *subquery = AsSubquery(*conjunct, &negated); subquery != nullptr) {
+      subqueries.emplace_back(subquery, negated);
+    } else if (has_subquery) {
+      throw NotImplementedException("subqueries are only supported as conjuncts of WHERE, e.g. not under OR");
+    } else {
+      filters.push_back(conjunct);
+    }
+  }
+
+  if (!filters.empty()) {
+    AbstractExpressionRef predicate;
+    if (filters.size() == conjuncts.size()) {
+      predicate = std::get<1>(PlanExpression(where, {plan}));
+    } else {
+      for (const auto *filter : filters) {
+        auto [_, expr] = PlanExpression(*filter, {plan});
+        predicate = predicate == nullptr ? expr : GetBinaryExpressionFromFactory("and", predicate, expr);
+      }
+    }
+    auto schema = plan->OutputSchema();
+    plan = std::make_shared<FilterPlanNode>(std::make_shared<Schema>(schema), std::move(predicate), std::move(plan));
+  }
+  for (const auto &[subquery, negated] : subqueries) {
+    plan = PlanSubqueryExpr(*subquery, negated, std::move(plan));
+  }
+  return plan;
+}
+
+auto Planner::PlanSubqueryExpr(const BoundSubqueryExpr &expr, bool negated, AbstractPlanNodeRef left)
+    -> AbstractPlanNodeRef {
+  const auto &subquery = *expr.subquery_;
+  bool is_in = expr.subquery_type_ == SubqueryType::IN;
+  bool is_aggregated = !subquery.group_by_.empty() || !subquery.having_->IsInvalid() ||
+                       !subquery.limit_count_->IsInvalid() || !subquery.limit_offset_->IsInvalid();
+  for (const auto &item : subquery.select_list_) {
+    is_aggregated = is_aggregated || item->HasAggregation();
+  }
+
+  AbstractPlanNodeRef right;
+  // The value `IN` looks up, over the right tuple of the join.
+  AbstractExpressionRef item;
+  std::vector<const BoundExpression *> correlated;
+  if (is_aggregated) {
+    // Which rows an aggregation or a LIMIT returns depends on all rows of the subquery, not only on those of a row of
+    // the left plan, unless they are computed again for every left row.
+    if (OuterDepth(subquery) > 0) {
+      throw NotImplementedException("correlated subqueries with aggregation or LIMIT are not supported");
+    }
+    right = PlanSelect(subquery);
+    if (is_in) {
+      item = std::make_shared<ColumnValueExpression>(1, 0, right->OutputSchema().GetColumn(0).GetType());
+    }
+  } else {
+    // Only which rows of the FROM clause pass the WHERE clause matters, not their order or duplicates, nor the select
+    // list other than the value of `IN`.
+    auto ctx_guard = NewContext();
+    if (!subquery.ctes_.empty()) {
+      ctx_.cte_list_ = &subquery.ctes_;
+    }
+    if (subquery.table_->type_ == TableReferenceType::EMPTY) {
+      right = std::make_shared<ValuesPlanNode>(
+          std::make_shared<Schema>(std::vector<Column>{}),
+          std::vector<std::vector<AbstractExpressionRef>>{std::vector<AbstractExpressionRef>{}});
+    } else {
+      right = PlanTableRef(*subquery.table_);
+    }
+    if (!subquery.where_->IsInvalid()) {
+      right = PlanWhere(*subquery.where_, std::move(right), &correlated);
+    }
+    if (is_in) {
+      item = PlanCorrelatedExpression(*subquery.select_list_[0], left, right);
+    }
+  }
+  if (negated && is_in && !correlated.empty()) {
+    // Whether a NULL makes `NOT IN` NULL would depend on whether the row of the NULL passes the correlated conjuncts.
+    throw NotImplementedException("correlated NOT IN is not supported, use NOT EXISTS");
+  }
+
+  AbstractExpressionRef predicate;
+  if (is_in) {
+    auto [_, test] = PlanExpression(*expr.test_expr_, {left});
+    predicate = GetBinaryExpressionFromFactory("=", std::move(test), std::move(item));
+  }
+  for (const auto *conjunct : correlated) {
+    auto planned = PlanCorrelatedExpression(*conjunct, left, right);
+    predicate = predicate == nullptr ? planned : GetBinaryExpressionFromFactory("and", predicate, planned);
+  }
+  if (predicate == nullptr) {
+    predicate = std::make_shared<ConstantValueExpression>(ValueFactory::GetBooleanValue(true));
+  }
+
+  JoinType join_type = JoinType::SEMI;
+  if (negated) {
+    join_type = is_in ? JoinType::NULL_AWARE_ANTI : JoinType::ANTI;
+  }
+  auto schema = left->OutputSchema();
+  return std::make_shared<NestedLoopJoinPlanNode>(std::make_shared<Schema>(schema), std::move(left), std::move(right),
+                                                  std::move(predicate), join_type);
+}
+
+auto Planner::PlanCorrelatedExpression(const BoundExpression &expr, const AbstractPlanNodeRef &outer,
+                                       const AbstractPlanNodeRef &inner) -> AbstractExpressionRef {
+  switch (expr.type_) {
+    case ExpressionType::COLUMN_REF: {
+      const auto &column_ref = dynamic_cast<const BoundColumnRef &>(expr);
+      bool is_outer = column_ref.depth_ > 0;
+      auto [_, column] = PlanColumnRef(column_ref, {is_outer ? outer : inner});
+      return std::make_shared<ColumnValueExpression>(is_outer ? 0 : 1, column->GetColIdx(), column->GetReturnType());
+    }
+    case ExpressionType::BINARY_OP: {
+      const auto &binary_op = dynamic_cast<const BoundBinaryOp &>(expr);
+      return GetBinaryExpressionFromFactory(binary_op.op_name_,
+                                            PlanCorrelatedExpression(*binary_op.larg_, outer, inner),
+                                            PlanCorrelatedExpression(*binary_op.rarg_, outer, inner));
+    }
+    case ExpressionType::ALIAS:
+      return PlanCorrelatedExpression(*dynamic_cast<const BoundAlias &>(expr).child_, outer, inner);
+    default: {
+      // Constants and parameters read no columns.
+      auto [_, planned] = PlanExpression(expr, {});
+      return planned;
+    }
+  }
+}
+
+}  // namespace bustub
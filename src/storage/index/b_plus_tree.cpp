@@ -55,6 +55,51 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   return true;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::GetEntries(const KeyType *key, bool strict, size_t max_entries, std::vector<MappingType> *result) {
+  root_page_id_latch_.RLock();
+  if (IsEmpty()) {
+    root_page_id_latch_.RUnlock();
+    return;
+  }
+  if (key == nullptr) {
+    auto *page = FindLeaf(KeyType(), Operation::SEARCH, nullptr, true);
+    CopyEntries(page, 0, max_entries, result);
+    return;
+  }
+  auto *page = FindLeaf(*key, Operation::SEARCH);
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int index = leaf->KeyIndex(*key, comparator_);
+  if (strict && index < leaf->GetSize() && comparator_(leaf->KeyAt(index), *key) == 0) {
+    index++;
+  }
+  CopyEntries(page, index, max_entries, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CopyEntries(Page *page, int index, size_t max_entries, std::vector<MappingType> *result) {
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  while (result->size() < max_entries) {
+    if (index < leaf->GetSize()) {
+      result->push_back(leaf->GetItem(index++));
+      continue;
+    }
+    if (leaf->GetNextPageId() == INVALID_PAGE_ID) {
+      break;
+    }
+    // Latch coupling to the right, like the iterator.
+    auto *next_page = buffer_pool_manager_->FetchPage(leaf->GetNextPageId());
+    next_page->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = next_page;
+    leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    index = 0;
+  }
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
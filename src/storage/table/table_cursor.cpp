@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_cursor.cpp
+//
+// Identification: src/storage/table/table_cursor.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/table_cursor.h"
+
+#include "concurrency/transaction.h"
+#include "storage/table/table_heap.h"
+
+namespace bustub {
+
+TableCursor::TableCursor(TableHeap *table_heap, Transaction *snapshot)
+    : buffer_pool_manager_(table_heap->buffer_pool_manager_),
+      version_store_(table_heap->GetVersionStore()),
+      snapshot_(snapshot),
+      page_id_(table_heap->GetFirstPageId()) {}
+
+TableCursor::~TableCursor() { ReleasePage(); }
+
+auto TableCursor::Next(Tuple *tuple) -> bool {
+  while (page_id_ != INVALID_PAGE_ID) {
+    if (page_ == nullptr) {
+      page_ = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id_));
+      BUSTUB_ENSURE(page_ != nullptr, "BPM full");
+    }
+    if (!latched_) {
+      page_->RLatch();
+      latched_ = true;
+    }
+
+    if (snapshot_ != nullptr) {
+      if (NextVersion(tuple)) {
+        return true;
+      }
+    } else {
+      RID next_rid;
+      bool found = rid_.GetPageId() == page_id_ ? page_->GetNextTupleRid(rid_, &next_rid)
+                                                : page_->GetFirstTupleRid(&next_rid);
+      if (found) {
+        rid_ = next_rid;
+        BUSTUB_ENSURE(page_->GetTupleView(rid_, tuple), "read non-existing tuple");
+        return true;
+      }
+    }
+
+    page_id_t next_page_id = page_->GetNextPageId();
+    ReleasePage();
+    page_id_ = next_page_id;
+  }
+  return false;
+}
+
+auto TableCursor::NextVersion(Tuple *tuple) -> bool {
+  RID next_rid;
+  bool found = rid_.GetPageId() == page_id_ ? page_->GetNextTupleRid(rid_, &next_rid, true)
+                                            : page_->GetFirstTupleRid(&next_rid, true);
+  while (found) {
+    rid_ = next_rid;
+    bool is_deleted;
+    BUSTUB_ENSURE(page_->GetTupleView(rid_, tuple, &is_deleted), "read non-existing tuple");
+    // The store is read while the page is latched, so it has the record of every change the page shows.
+    auto visibility = version_store_->GetVisibleVersion(rid_, is_deleted, snapshot_->GetReadTs(),
+                                                        snapshot_->GetTransactionId(), tuple);
+    if (visibility != VersionVisibility::NONE) {
+      return true;
+    }
+    found = page_->GetNextTupleRid(rid_, &next_rid, true);
+  }
+  return false;
+}
+
+void TableCursor::Unlatch() {
+  if (latched_) {
+    page_->RUnlatch();
+    latched_ = false;
+  }
+}
+
+void TableCursor::ReleasePage() {
+  if (page_ == nullptr) {
+    return;
+  }
+  Unlatch();
+  buffer_pool_manager_->UnpinPage(page_id_, false);
+  page_ = nullptr;
+}
+
+}  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "common/logger.h"
 #include "fmt/format.h"
@@ -82,6 +84,7 @@ auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> b
       cur_page = new_page;
     }
   }
+  version_store_.Push(*rid, WType::INSERT, txn->GetTransactionId());
   // This line has caused most of us to double-take and "whoa double unlatch".
   // We are not, in fact, double unlatching. See the invariant above.
   cur_page->WUnlatch();
@@ -102,7 +105,9 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  if (page->MarkDelete(rid, txn, lock_manager_, log_manager_)) {
+    version_store_.Push(rid, WType::DELETE, txn->GetTransactionId());
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
   // Update the transaction's write set.
@@ -122,6 +127,10 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
   Tuple old_tuple;
   page->WLatch();
   bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  // A rollback restores the version the store already has.
+  if (is_updated && txn->GetState() != TransactionState::ABORTED) {
+    version_store_.Push(rid, WType::UPDATE, txn->GetTransactionId(), &old_tuple);
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
   // Update the transaction's write set.
@@ -156,6 +165,51 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
+void TableHeap::Rollback(std::vector<const TableWriteRecord *> records, Transaction *txn) {
+  // The sort is stable, so the records of a page are still undone newest first.
+  std::stable_sort(records.begin(), records.end(), [](const TableWriteRecord *a, const TableWriteRecord *b) {
+    return a->rid_.GetPageId() < b->rid_.GetPageId();
+  });
+  for (size_t begin = 0; begin < records.size();) {
+    page_id_t page_id = records[begin]->rid_.GetPageId();
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+    page->WLatch();
+    size_t end = begin;
+    for (; end < records.size() && records[end]->rid_.GetPageId() == page_id; end++) {
+      const auto *item = records[end];
+      if (item->wtype_ == WType::DELETE) {
+        page->RollbackDelete(item->rid_, txn, log_manager_);
+      } else if (item->wtype_ == WType::INSERT) {
+        page->ApplyDelete(item->rid_, txn, log_manager_);
+      } else if (item->wtype_ == WType::UPDATE) {
+        Tuple new_tuple;
+        page->UpdateTuple(item->tuple_, &new_tuple, item->rid_, txn, lock_manager_, log_manager_);
+      }
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    begin = end;
+  }
+}
+
+void TableHeap::ApplyDeletes(std::vector<RID> rids) {
+  std::sort(rids.begin(), rids.end(), [](const RID &a, const RID &b) { return a.Get() < b.Get(); });
+  for (size_t begin = 0; begin < rids.size();) {
+    page_id_t page_id = rids[begin].GetPageId();
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+    page->WLatch();
+    size_t end = begin;
+    for (; end < rids.size() && rids[end].GetPageId() == page_id; end++) {
+      page->ApplyDelete(rids[end], nullptr, log_manager_);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    begin = end;
+  }
+}
+
 auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock) -> bool {
   // Find the page which contains the tuple.
   auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
@@ -168,7 +222,26 @@ auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool ac
   if (acquire_read_lock) {
     page->RLatch();
   }
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
+  bool res;
+  if (txn != nullptr && txn->ReadsSnapshot()) {
+    Tuple view;
+    bool is_deleted;
+    res = page->GetTupleView(rid, &view, &is_deleted);
+    if (res) {
+      switch (version_store_.GetVisibleVersion(rid, is_deleted, txn->GetReadTs(), txn->GetTransactionId(), tuple)) {
+        case VersionVisibility::IN_PAGE:
+          *tuple = view;
+          break;
+        case VersionVisibility::OLDER:
+          break;
+        case VersionVisibility::NONE:
+          res = false;
+          break;
+      }
+    }
+  } else {
+    res = page->GetTuple(rid, tuple, txn, lock_manager_);
+  }
   if (acquire_read_lock) {
     page->RUnlatch();
   }
@@ -176,6 +249,44 @@ auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool ac
   return res;
 }
 
+auto TableHeap::HasWriteConflict(const RID &rid, Transaction *txn) -> bool {
+  return txn->ReadsSnapshot() && version_store_.HasWriteConflict(rid, txn->GetReadTs(), txn->GetTransactionId());
+}
+
+void TableHeap::CollectVersions(const std::vector<RID> &rids, timestamp_t watermark) {
+  // Only the caller whose collection dropped the chain removes the tuple, no one else can change a deleted tuple.
+  std::vector<RID> deleted;
+  for (const auto &rid : rids) {
+    if (version_store_.Collect(rid, watermark)) {
+      deleted.push_back(rid);
+    }
+  }
+  ApplyDeletes(std::move(deleted));
+}
+
+void TableHeap::CollectVersions(timestamp_t watermark) {
+  if (version_store_.Size() == 0) {
+    return;
+  }
+  std::vector<RID> deleted;
+  version_store_.CollectAll(watermark, &deleted);
+  ApplyDeletes(std::move(deleted));
+}
+
+auto TableHeap::GetPageCount() -> size_t {
+  size_t pages = 0;
+  for (auto page_id = first_page_id_; page_id != INVALID_PAGE_ID; pages++) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't find a page of the table.");
+    page->RLatch();
+    auto next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return pages;
+}
+
 auto TableHeap::Begin(Transaction *txn) -> TableIterator {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
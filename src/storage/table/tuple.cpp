@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/table/tuple.h"
@@ -61,37 +62,88 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
-  if (allocated_) {
-    delete[] data_;
+Tuple::Tuple(const Tuple &left, const Schema *left_schema, const Tuple &right, const Schema *right_schema)
+    : allocated_(true) {
+  // The output layout is | left fixed | right fixed | left varlen payload | right varlen payload |, which matches a
+  // schema made of the left columns followed by the right columns.
+  uint32_t left_fixed = left_schema->GetLength();
+  uint32_t right_fixed = right_schema->GetLength();
+  uint32_t left_payload = left.size_ - left_fixed;
+  uint32_t right_payload = right.size_ - right_fixed;
+
+  size_ = left.size_ + right.size_;
+  data_ = new char[size_];
+  memcpy(data_, left.data_, left_fixed);
+  memcpy(data_ + left_fixed, right.data_, right_fixed);
+  memcpy(data_ + left_fixed + right_fixed, left.data_ + left_fixed, left_payload);
+  memcpy(data_ + left_fixed + right_fixed + left_payload, right.data_ + right_fixed, right_payload);
+
+  // Varchar columns store the offset of their payload, which moved.
+  for (auto i : left_schema->GetUnlinedColumns()) {
+    *reinterpret_cast<uint32_t *>(data_ + left_schema->GetColumn(i).GetOffset()) += right_fixed;
   }
+  for (auto i : right_schema->GetUnlinedColumns()) {
+    *reinterpret_cast<uint32_t *>(data_ + left_fixed + right_schema->GetColumn(i).GetOffset()) +=
+        left_fixed + left_payload;
+  }
+}
+
+Tuple::Tuple(const Tuple &other) : allocated_(other.data_ != nullptr), rid_(other.rid_), size_(other.size_) {
   if (allocated_) {
-    // Deep copy.
+    // Deep copy. A view into a page is materialized as well, the copy must not depend on the page staying latched.
     data_ = new char[size_];
     memcpy(data_, other.data_, size_);
-  } else {
-    // Shallow copy.
-    data_ = other.data_;
   }
 }
 
 auto Tuple::operator=(const Tuple &other) -> Tuple & {
-  if (allocated_) {
-    delete[] data_;
+  if (this == &other) {
+    return *this;
   }
-  allocated_ = other.allocated_;
   rid_ = other.rid_;
+  if (other.data_ == nullptr) {
+    if (allocated_) {
+      delete[] data_;
+    }
+    allocated_ = false;
+    data_ = nullptr;
+    size_ = other.size_;
+    return *this;
+  }
+
+  // Deep copy, reusing our buffer if it has the right size (e.g. a scan copying every tuple into the same output).
+  if (!allocated_ || size_ != other.size_) {
+    if (allocated_) {
+      delete[] data_;
+    }
+    data_ = new char[other.size_];
+    allocated_ = true;
+  }
   size_ = other.size_;
+  memcpy(data_, other.data_, size_);
+  return *this;
+}
 
+Tuple::Tuple(Tuple &&other) noexcept { *this = std::move(other); }
+
+auto Tuple::operator=(Tuple &&other) noexcept -> Tuple & {
+  if (this == &other) {
+    return *this;
+  }
+  // A view into a page is materialized, as by the copy.
+  if (!other.allocated_) {
+    return *this = other;
+  }
   if (allocated_) {
-    // Deep copy.
-    data_ = new char[size_];
-    memcpy(data_, other.data_, size_);
-  } else {
-    // Shallow copy.
-    data_ = other.data_;
+    delete[] data_;
   }
-
+  allocated_ = true;
+  rid_ = other.rid_;
+  size_ = other.size_;
+  data_ = other.data_;
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
   return *this;
 }
 
@@ -105,7 +157,7 @@ auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> V
 }
 
 auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
-    -> Tuple {
+    const -> Tuple {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
   for (auto idx : key_attrs) {
@@ -114,6 +166,13 @@ auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const s
   return {values, &key_schema};
 }
 
+auto Tuple::ProjectColumns(const Schema &schema, const Schema &projected_schema,
+                           const std::vector<uint32_t> &column_ids) const -> Tuple {
+  Tuple projected = KeyFromTuple(schema, projected_schema, column_ids);
+  projected.rid_ = rid_;
+  return projected;
+}
+
 auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
   assert(schema);
   assert(data_);
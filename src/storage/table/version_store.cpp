@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// version_store.cpp
+//
+// Identification: src/storage/table/version_store.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/version_store.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void VersionStore::Push(const RID &rid, WType type, txn_id_t txn_id, const Tuple *old_tuple) {
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto [iter, inserted] = partition.chains_.try_emplace(rid);
+  if (inserted) {
+    CountChain(rid, 1);
+  }
+  auto &chain = iter->second;
+  chain.deleted_ = type == WType::DELETE;
+  if (!chain.undo_.empty() && chain.undo_.back().txn_id_ == txn_id && chain.undo_.back().commit_ts_ == INVALID_TS) {
+    return;
+  }
+  chain.undo_.push_back({type, txn_id, INVALID_TS, type == WType::UPDATE ? *old_tuple : Tuple{}});
+}
+
+void VersionStore::Commit(const RID &rid, txn_id_t txn_id, timestamp_t commit_ts) {
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end()) {
+    return;
+  }
+  // The changes of a writer are the newest ones, it holds the row lock until it commits.
+  auto &undo = iter->second.undo_;
+  for (auto record = undo.rbegin(); record != undo.rend() && record->txn_id_ == txn_id; ++record) {
+    record->commit_ts_ = commit_ts;
+  }
+  last_commit_ts_.store(std::max(last_commit_ts_.load(std::memory_order_relaxed), commit_ts),
+                        std::memory_order_release);
+}
+
+void VersionStore::Abort(const RID &rid, txn_id_t txn_id) {
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end()) {
+    return;
+  }
+  // An aborted insert frees its slot, so a new insert may already have pushed a record on top of it.
+  auto &undo = iter->second.undo_;
+  undo.erase(std::remove_if(undo.begin(), undo.end(),
+                            [txn_id](const UndoRecord &record) {
+                              return record.txn_id_ == txn_id && record.commit_ts_ == INVALID_TS;
+                            }),
+             undo.end());
+  // No change after a committed delete is possible, so the rolled back row is not deleted.
+  iter->second.deleted_ = false;
+  if (undo.empty()) {
+    partition.chains_.erase(iter);
+    CountChain(rid, -1);
+  }
+}
+
+auto VersionStore::GetVisibleVersion(const RID &rid, bool is_deleted, timestamp_t read_ts, txn_id_t txn_id,
+                                     Tuple *tuple) -> VersionVisibility {
+  auto visibility = is_deleted ? VersionVisibility::NONE : VersionVisibility::IN_PAGE;
+  if (!MayHaveChain(rid)) {
+    return visibility;
+  }
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end()) {
+    return visibility;
+  }
+  const auto &undo = iter->second.undo_;
+  const UndoRecord *older = nullptr;
+  for (auto record = undo.rbegin(); record != undo.rend(); ++record) {
+    if (record->txn_id_ == txn_id || (record->commit_ts_ != INVALID_TS && record->commit_ts_ <= read_ts)) {
+      break;
+    }
+    switch (record->type_) {
+      case WType::INSERT:
+        visibility = VersionVisibility::NONE;
+        break;
+      case WType::DELETE:
+        // A deleted tuple stays in the page until its chain is gone.
+        visibility = VersionVisibility::IN_PAGE;
+        break;
+      case WType::UPDATE:
+        visibility = VersionVisibility::OLDER;
+        older = &*record;
+        break;
+    }
+  }
+  if (visibility == VersionVisibility::OLDER) {
+    *tuple = older->old_tuple_;
+  }
+  return visibility;
+}
+
+auto VersionStore::HasWriteConflict(const RID &rid, timestamp_t read_ts, txn_id_t txn_id) -> bool {
+  if (!MayHaveChain(rid)) {
+    return false;
+  }
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end()) {
+    return false;
+  }
+  const auto &newest = iter->second.undo_.back();
+  return newest.txn_id_ != txn_id && (newest.commit_ts_ == INVALID_TS || newest.commit_ts_ > read_ts);
+}
+
+auto VersionStore::IsChangedSince(const RID &rid, timestamp_t read_ts) -> bool {
+  if (!MayHaveChain(rid)) {
+    return false;
+  }
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end()) {
+    return false;
+  }
+  // Records committed after the snapshot are kept as long as the snapshot is active.
+  const auto &undo = iter->second.undo_;
+  return std::any_of(undo.begin(), undo.end(), [read_ts](const UndoRecord &record) {
+    return record.commit_ts_ != INVALID_TS && record.commit_ts_ > read_ts;
+  });
+}
+
+auto VersionStore::Trim(VersionChain *chain, timestamp_t watermark) -> bool {
+  // Commit timestamps grow along a chain, so every record before the newest one committed at or before the
+  // watermark is read by no snapshot either.
+  auto &undo = chain->undo_;
+  for (size_t i = undo.size(); i > 0; i--) {
+    const auto &record = undo[i - 1];
+    if (record.commit_ts_ != INVALID_TS && record.commit_ts_ <= watermark) {
+      undo.erase(undo.begin(), undo.begin() + i);
+      break;
+    }
+  }
+  return undo.empty();
+}
+
+auto VersionStore::Collect(const RID &rid, timestamp_t watermark) -> bool {
+  auto &partition = GetPartition(rid);
+  std::scoped_lock<std::mutex> lock(partition.latch_);
+  auto iter = partition.chains_.find(rid);
+  if (iter == partition.chains_.end() || !Trim(&iter->second, watermark)) {
+    return false;
+  }
+  bool deleted = iter->second.deleted_;
+  partition.chains_.erase(iter);
+  CountChain(rid, -1);
+  return deleted;
+}
+
+void VersionStore::CollectAll(timestamp_t watermark, std::vector<RID> *deleted) {
+  for (auto &partition : partitions_) {
+    std::scoped_lock<std::mutex> lock(partition.latch_);
+    for (auto iter = partition.chains_.begin(); iter != partition.chains_.end();) {
+      if (!Trim(&iter->second, watermark)) {
+        ++iter;
+        continue;
+      }
+      if (iter->second.deleted_) {
+        deleted->push_back(iter->first);
+      }
+      CountChain(iter->first, -1);
+      iter = partition.chains_.erase(iter);
+    }
+  }
+}
+
+}  // namespace bustub
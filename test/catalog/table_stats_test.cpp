@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_stats_test.cpp
+//
+// Identification: test/catalog/table_stats_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "catalog/table_stats.h"
+#include "common/bustub_instance.h"
+#include "common/util/hyperloglog.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class TableStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (k int, v int);");
+    RunSql(bustub_.get(), "CREATE INDEX t_k ON t(k);");
+    // k is unique and spread evenly, v takes four values that are equally common.
+    std::string insert = "INSERT INTO t VALUES ";
+    for (int i = 0; i < ROWS; i++) {
+      insert += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i % 4);
+    }
+    RunSql(bustub_.get(), insert);
+  }
+
+  auto Stats() -> std::shared_ptr<const TableStats> {
+    return bustub_->catalog_->GetTableStats(bustub_->catalog_->GetTable("t")->oid_);
+  }
+
+  static constexpr int ROWS = 1000;
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(TableStatsTest, AnalyzeCollectsStats) {
+  EXPECT_EQ(Stats(), nullptr);
+  auto output = RunSql(bustub_.get(), "ANALYZE t");
+
+  auto stats = Stats();
+  ASSERT_NE(stats, nullptr);
+  EXPECT_EQ(output, fmt::format("Table t analyzed: {} rows, {} pages\t\n", ROWS, stats->page_count_));
+  EXPECT_EQ(stats->row_count_, ROWS);
+  EXPECT_GT(stats->page_count_, 1);
+  ASSERT_EQ(stats->columns_.size(), 2);
+
+  const auto &k = *stats->columns_[0];
+  EXPECT_EQ(k.distinct_, ROWS);
+  EXPECT_EQ(k.null_fraction_, 0);
+  EXPECT_TRUE(k.most_common_.empty());
+  EXPECT_EQ(k.histogram_bounds_.size(), TableStats::HISTOGRAM_BUCKETS + 1);
+  auto low = ValueFactory::GetIntegerValue(100);
+  auto high = ValueFactory::GetIntegerValue(200);
+  EXPECT_NEAR(k.RangeSelectivity(&low, true, &high, false), 0.1, 0.01);
+  EXPECT_NEAR(k.RangeSelectivity(nullptr, false, &high, false), 0.2, 0.01);
+  EXPECT_NEAR(k.EqualSelectivity(low), 1.0 / ROWS, 1e-6);
+  auto beyond = ValueFactory::GetIntegerValue(ROWS * 2);
+  EXPECT_NEAR(k.RangeSelectivity(&beyond, true, nullptr, false), 0, 1e-6);
+
+  const auto &v = *stats->columns_[1];
+  EXPECT_EQ(v.distinct_, 4);
+  ASSERT_EQ(v.most_common_.size(), 4);
+  EXPECT_TRUE(v.histogram_bounds_.empty());
+  auto one = ValueFactory::GetIntegerValue(1);
+  EXPECT_NEAR(v.EqualSelectivity(one), 0.25, 1e-6);
+  EXPECT_NEAR(v.RangeSelectivity(&one, false, nullptr, false), 0.5, 1e-6);
+}
+
+// NOLINTNEXTLINE
+TEST_F(TableStatsTest, AnalyzeColumnsKeepsOthers) {
+  RunSql(bustub_.get(), "ANALYZE t");
+  RunSql(bustub_.get(), "INSERT INTO t VALUES (1000, 7)");
+  RunSql(bustub_.get(), "ANALYZE t (v)");
+
+  auto stats = Stats();
+  EXPECT_EQ(stats->row_count_, ROWS + 1);
+  // k keeps the statistics of the first ANALYZE, v has a fifth value now.
+  EXPECT_EQ(stats->columns_[0]->distinct_, ROWS);
+  EXPECT_EQ(stats->columns_[1]->distinct_, 5);
+}
+
+// NOLINTNEXTLINE
+TEST_F(TableStatsTest, SelectivityPicksScan) {
+  // Without statistics, every range of an indexed column is read from the index.
+  EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN SELECT * FROM t WHERE k >= 10").find("IndexScan"), std::string::npos);
+
+  RunSql(bustub_.get(), "ANALYZE t");
+  EXPECT_EQ(RunSql(bustub_.get(), "EXPLAIN SELECT * FROM t WHERE k >= 10").find("IndexScan"), std::string::npos);
+  EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN SELECT * FROM t WHERE k >= 10 AND k < 20").find("IndexScan"),
+            std::string::npos);
+  EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN SELECT * FROM t WHERE k = 500").find("IndexScan"), std::string::npos);
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT count(*) FROM t WHERE k >= 10"), "990\t\n");
+}
+
+// NOLINTNEXTLINE
+TEST(HyperLogLogTest, EstimatesDistinctValues) {
+  for (int distinct : {10, 1000, 100000}) {
+    HyperLogLog sketch;
+    for (int round = 0; round < 2; round++) {
+      for (int i = 0; i < distinct; i++) {
+        sketch.Add(ValueFactory::GetIntegerValue(i));
+      }
+    }
+    EXPECT_NEAR(static_cast<double>(sketch.Estimate()), distinct, distinct * 0.05);
+  }
+}
+
+}  // namespace bustub
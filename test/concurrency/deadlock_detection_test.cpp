@@ -113,9 +113,6 @@ TEST(LockManagerDeadlockDetectionTest, BasicDeadlockDetectionTest) {
     txn_mgr.Abort(txn1);
   });
 
-  // Sleep for enough time to break cycle
-  std::this_thread::sleep_for(cycle_detection_interval * 2);
-
   t0.join();
   t1.join();
 
@@ -195,9 +192,6 @@ TEST(LockManagerDeadlockDetectionTest, BasicDeadlockDetectionTest1) {
     txn_mgr.Abort(txn2);
   });
 
-  // Sleep for enough time to break cycle
-  std::this_thread::sleep_for(cycle_detection_interval * 2);
-
   t0.join();
   t1.join();
   t2.join();
@@ -222,4 +216,73 @@ TEST(LockManagerDeadlockDetectionTest, CycleTest1) {
   lock_mgr.RemoveEdge(4, 2);
 }
 
+TEST(LockManagerDeadlockDetectionTest, WaitDieTest) {
+  deadlock_policy = DeadlockPolicy::WAIT_DIE;
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+
+  table_oid_t toid{0};
+  RID rid0{0, 0};
+  RID rid1{1, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+  EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+
+  // The older txn0 waits for the newer txn1.
+  std::thread t0([&] {
+    EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+    txn_mgr.Commit(txn0);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(TransactionState::GROWING, txn0->GetState());
+
+  // The newer txn1 dies instead of waiting for the older txn0, without blocking.
+  EXPECT_FALSE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+  EXPECT_EQ(TransactionState::ABORTED, txn1->GetState());
+  txn_mgr.Abort(txn1);
+
+  t0.join();
+  EXPECT_EQ(TransactionState::COMMITTED, txn0->GetState());
+  delete txn0;
+  delete txn1;
+  deadlock_policy = DeadlockPolicy::DETECTION;
+}
+
+TEST(LockManagerDeadlockDetectionTest, WoundWaitTest) {
+  deadlock_policy = DeadlockPolicy::WOUND_WAIT;
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+
+  table_oid_t toid{0};
+  RID rid0{0, 0};
+  RID rid1{1, 1};
+  auto *txn0 = txn_mgr.Begin();
+  auto *txn1 = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(txn0, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  EXPECT_TRUE(lock_mgr.LockTable(txn1, LockManager::LockMode::INTENTION_EXCLUSIVE, toid));
+  EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+  EXPECT_TRUE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+
+  // The newer txn1 waits for the older txn0.
+  std::thread t1([&] {
+    EXPECT_FALSE(lock_mgr.LockRow(txn1, LockManager::LockMode::EXCLUSIVE, toid, rid0));
+    EXPECT_EQ(TransactionState::ABORTED, txn1->GetState());
+    txn_mgr.Abort(txn1);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(TransactionState::GROWING, txn1->GetState());
+
+  // The older txn0 wounds the waiting txn1, which releases rid1 as it aborts.
+  EXPECT_TRUE(lock_mgr.LockRow(txn0, LockManager::LockMode::EXCLUSIVE, toid, rid1));
+  t1.join();
+  txn_mgr.Commit(txn0);
+  EXPECT_EQ(TransactionState::COMMITTED, txn0->GetState());
+  delete txn0;
+  delete txn1;
+  deadlock_policy = DeadlockPolicy::DETECTION;
+}
+
 }  // namespace bustub
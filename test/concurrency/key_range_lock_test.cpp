@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_range_lock_test.cpp
+//
+// Identification: test/concurrency/key_range_lock_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class KeyRangeLockTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    auto writer = NoopWriter();
+    bustub_->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+    bustub_->ExecuteSql("CREATE INDEX t_k ON t(k);", writer);
+    for (int k = 0; k < 100; k += 10) {
+      bustub_->ExecuteSql(fmt::format("INSERT INTO t VALUES ({}, {});", k, k), writer);
+    }
+  }
+
+  auto Begin() -> Transaction * { return bustub_->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ); }
+
+  void Commit(Transaction *txn) {
+    bustub_->txn_manager_->Commit(txn);
+    delete txn;
+  }
+
+  /** Run an insert in its own transaction on another thread, which sets `done` once it has committed */
+  auto InsertAsync(int key, std::atomic<bool> *done) -> std::thread {
+    return std::thread([this, key, done] {
+      auto *txn = Begin();
+      EXPECT_EQ(RunSqlRows(bustub_.get(), fmt::format("INSERT INTO t VALUES ({}, 0)", key), txn),
+                std::vector<std::string>{"1\t"});
+      Commit(txn);
+      *done = true;
+    });
+  }
+
+  /** Wait until `done` is set, or give up after a while */
+  static auto WaitFor(const std::atomic<bool> &done) -> bool {
+    for (int i = 0; i < 200 && !done; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return done;
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(KeyRangeLockTest, RangeScanBlocksPhantoms) {
+  auto *reader = Begin();
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT count(*) FROM t WHERE k >= 20 AND k <= 40", reader),
+            std::vector<std::string>{"3\t"});
+  // Only the keys of the range are locked, the table is not.
+  EXPECT_FALSE(reader->IsTableSharedLocked(bustub_->catalog_->GetTable("t")->oid_));
+
+  // An insert outside the range goes ahead.
+  std::atomic<bool> outside{false};
+  auto outside_thread = InsertAsync(75, &outside);
+  EXPECT_TRUE(WaitFor(outside));
+  outside_thread.join();
+
+  // An insert into the range waits for the reader, so the reader sees the same rows again.
+  std::atomic<bool> inside{false};
+  auto inside_thread = InsertAsync(35, &inside);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(inside);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT count(*) FROM t WHERE k >= 20 AND k <= 40", reader),
+            std::vector<std::string>{"3\t"});
+  Commit(reader);
+  EXPECT_TRUE(WaitFor(inside));
+  inside_thread.join();
+
+  auto *check = Begin();
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT count(*) FROM t WHERE k >= 20 AND k <= 40", check),
+            std::vector<std::string>{"4\t"});
+  Commit(check);
+}
+
+// NOLINTNEXTLINE
+TEST_F(KeyRangeLockTest, PointLookupLocksGap) {
+  auto *reader = Begin();
+  EXPECT_TRUE(RunSqlRows(bustub_.get(), "SELECT v FROM t WHERE k = 45", reader).empty());
+
+  // The missing key falls into the gap below 50, which the lookup locked; the gap below 20 is free.
+  std::atomic<bool> other_gap{false};
+  auto other_thread = InsertAsync(15, &other_gap);
+  EXPECT_TRUE(WaitFor(other_gap));
+  other_thread.join();
+
+  std::atomic<bool> same_gap{false};
+  auto same_thread = InsertAsync(45, &same_gap);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(same_gap);
+  Commit(reader);
+  EXPECT_TRUE(WaitFor(same_gap));
+  same_thread.join();
+}
+
+// NOLINTNEXTLINE
+TEST_F(KeyRangeLockTest, ScanPastLargestKeyLocksSupremum) {
+  auto *reader = Begin();
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT count(*) FROM t WHERE k > 85", reader), std::vector<std::string>{"1\t"});
+
+  std::atomic<bool> done{false};
+  auto thread = InsertAsync(1000, &done);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(done);
+  Commit(reader);
+  EXPECT_TRUE(WaitFor(done));
+  thread.join();
+}
+
+// NOLINTNEXTLINE
+TEST_F(KeyRangeLockTest, RangeScanReadsKeyOrder) {
+  auto *txn = Begin();
+  RunSqlRows(bustub_.get(), "INSERT INTO t VALUES (25, 0), (5, 0)", txn);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT k FROM t WHERE k < 30 AND k > 0", txn),
+            (std::vector<std::string>{"5\t", "10\t", "20\t", "25\t"}));
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT k FROM t WHERE 80 <= k", txn),
+            (std::vector<std::string>{"80\t", "90\t"}));
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT k FROM t WHERE k >= 30 AND k < 30", txn), std::vector<std::string>{});
+  Commit(txn);
+}
+
+}  // namespace bustub
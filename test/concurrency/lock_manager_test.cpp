@@ -4,8 +4,10 @@
 
 #include "concurrency/lock_manager.h"
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <random>
+#include <sstream>
 #include <thread>  // NOLINT
 
 #include "common/bustub_instance.h"
@@ -700,4 +702,271 @@ TEST(LockManagerTest, CompatibilityTest3) {
   delete txn2;
 }
 
+/** Rows spread over every lock table partition, locked and unlocked so often that their queues get recycled */
+TEST(LockManagerTest, RowQueueReuseTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+
+  const int num_threads = 8;
+  const int num_rows = 200;
+  const int txns_per_thread = 500;
+  std::vector<int> counters(num_rows, 0);
+
+  auto task = [&](int thread_id) {
+    std::default_random_engine gen(thread_id);
+    std::uniform_int_distribution<int> row_dist(0, num_rows - 1);
+    for (int i = 0; i < txns_per_thread; i++) {
+      int row = row_dist(gen);
+      RID rid{row / 10, static_cast<uint32_t>(row % 10)};
+      auto *txn = txn_mgr.Begin();
+      EXPECT_TRUE(lock_mgr.LockTable(txn, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+      EXPECT_TRUE(lock_mgr.LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, rid));
+      counters[row]++;
+      EXPECT_TRUE(lock_mgr.UnlockRow(txn, oid, rid));
+      EXPECT_TRUE(lock_mgr.UnlockTable(txn, oid));
+      txn_mgr.Commit(txn);
+      CheckTxnRowLockSize(txn, oid, 0, 0);
+      delete txn;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back(task, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  /** Every increment happened under an exclusive lock, so none was lost */
+  int total = 0;
+  for (int counter : counters) {
+    total += counter;
+  }
+  EXPECT_EQ(num_threads * txns_per_thread, total);
+}
+
+/** Row locks beyond the threshold are escalated to a table lock, unless another transaction holds a conflicting one */
+TEST(LockManagerTest, EscalationTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+  size_t saved_threshold = lock_escalation_threshold;
+  lock_escalation_threshold = 10;
+
+  auto *reader = txn_mgr.Begin();
+  auto *writer = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, RID{1, 0}));
+
+  /** The writer's IX conflicts with S, so the reader keeps its row locks */
+  EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, oid));
+  for (uint32_t slot = 0; slot < 10; slot++) {
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, oid, RID{0, slot}));
+  }
+  CheckTableLockSizes(reader, 0, 0, 1, 0, 0);
+  CheckTxnRowLockSize(reader, oid, 10, 0);
+  txn_mgr.Commit(writer);
+  CheckTableLockSizes(writer, 0, 0, 0, 0, 0);
+
+  /** Without the writer, the next round escalates to S, after which rows are covered by the table lock */
+  for (uint32_t slot = 10; slot < 20; slot++) {
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, oid, RID{0, slot}));
+  }
+  CheckTableLockSizes(reader, 1, 0, 0, 0, 0);
+  CheckTxnRowLockSize(reader, oid, 0, 0);
+  EXPECT_TRUE(LockManager::IsRowLockCovered(reader, LockManager::LockMode::SHARED, oid));
+  EXPECT_FALSE(LockManager::IsRowLockCovered(reader, LockManager::LockMode::EXCLUSIVE, oid));
+  CheckGrowing(reader);
+
+  /** A writer cannot get in while the reader holds S on the table */
+  auto *blocked = txn_mgr.Begin();
+  std::thread t0([&]() {
+    EXPECT_TRUE(lock_mgr.LockTable(blocked, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+    EXPECT_TRUE(lock_mgr.LockRow(blocked, LockManager::LockMode::EXCLUSIVE, oid, RID{0, 0}));
+    txn_mgr.Commit(blocked);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CheckGrowing(blocked);
+  CheckTableLockSizes(blocked, 0, 0, 0, 0, 0);
+  txn_mgr.Commit(reader);
+  t0.join();
+  CheckCommitted(blocked);
+
+  /** X rows escalate to X, and IS requests of later statements are covered by it */
+  auto *updater = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(updater, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  for (uint32_t slot = 0; slot < 10; slot++) {
+    EXPECT_TRUE(lock_mgr.LockRow(updater, LockManager::LockMode::EXCLUSIVE, oid, RID{0, slot}));
+  }
+  CheckTableLockSizes(updater, 0, 1, 0, 0, 0);
+  CheckTxnRowLockSize(updater, oid, 0, 0);
+  EXPECT_TRUE(lock_mgr.LockTable(updater, LockManager::LockMode::INTENTION_SHARED, oid));
+  CheckTableLockSizes(updater, 0, 1, 0, 0, 0);
+  txn_mgr.Commit(updater);
+  CheckTableLockSizes(updater, 0, 0, 0, 0, 0);
+
+  lock_escalation_threshold = saved_threshold;
+  delete reader;
+  delete writer;
+  delete blocked;
+  delete updater;
+}
+
+/** A batch of rows is locked like the rows one by one, and waits for the rows other transactions hold */
+TEST(LockManagerTest, LockRowsTest) {
+  LockManager lock_mgr{};
+  TransactionManager txn_mgr{&lock_mgr};
+  table_oid_t oid = 0;
+
+  /** Repeated rows are locked once */
+  auto *writer = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockRows(writer, LockManager::LockMode::EXCLUSIVE, oid, {{0, 2}, {0, 0}, {0, 1}, {0, 0}}));
+  CheckTxnRowLockSize(writer, oid, 0, 3);
+
+  /** An X lock stands for S, and S is upgraded to X in place if nobody else holds the row */
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::SHARED, oid, RID{1, 0}));
+  EXPECT_TRUE(lock_mgr.LockRows(writer, LockManager::LockMode::SHARED, oid, {{0, 0}, {1, 0}}));
+  CheckTxnRowLockSize(writer, oid, 1, 3);
+  EXPECT_TRUE(lock_mgr.LockRows(writer, LockManager::LockMode::EXCLUSIVE, oid, {{1, 0}}));
+  CheckTxnRowLockSize(writer, oid, 0, 4);
+
+  /** A reader of a held row waits for the writer, and locks the rest of its batch once it is granted */
+  auto *reader = txn_mgr.Begin();
+  std::thread t0([&]() {
+    EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, oid));
+    EXPECT_TRUE(lock_mgr.LockRows(reader, LockManager::LockMode::SHARED, oid, {{2, 0}, {0, 1}, {2, 1}}));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CheckGrowing(reader);
+  txn_mgr.Commit(writer);
+  t0.join();
+  CheckTxnRowLockSize(reader, oid, 3, 0);
+  txn_mgr.Commit(reader);
+  CheckTxnRowLockSize(reader, oid, 0, 0);
+
+  delete writer;
+  delete reader;
+}
+
+/** The lock metrics count grants, waits and contended rows, and the `\locks` command shows them */
+TEST(LockManagerTest, MetricsTest) {
+  auto bustub = std::make_unique<BustubInstance>();
+  auto &lock_mgr = *bustub->lock_manager_;
+  auto &txn_mgr = *bustub->txn_manager_;
+  auto &metrics = lock_mgr.GetMetrics();
+  metrics.Reset();
+  table_oid_t oid = 0;
+  RID rid{0, 0};
+
+  auto *writer = txn_mgr.Begin();
+  EXPECT_TRUE(lock_mgr.LockTable(writer, LockManager::LockMode::INTENTION_EXCLUSIVE, oid));
+  EXPECT_TRUE(lock_mgr.LockRow(writer, LockManager::LockMode::EXCLUSIVE, oid, rid));
+  auto *reader = txn_mgr.Begin();
+  std::thread t0([&]() {
+    EXPECT_TRUE(lock_mgr.LockTable(reader, LockManager::LockMode::INTENTION_SHARED, oid));
+    EXPECT_TRUE(lock_mgr.LockRow(reader, LockManager::LockMode::SHARED, oid, rid));
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  txn_mgr.Commit(writer);
+  t0.join();
+  txn_mgr.Commit(reader);
+  delete writer;
+  delete reader;
+
+  const auto &row_x = metrics.Mode(LockMetrics::Resource::ROW, static_cast<size_t>(LockManager::LockMode::EXCLUSIVE));
+  EXPECT_EQ(row_x.acquired_, 1);
+  EXPECT_EQ(row_x.waited_, 0);
+  EXPECT_EQ(row_x.hold_.Count(), 1);
+  EXPECT_GE(row_x.hold_.Percentile(1), 50 * 1000 * 1000);
+  const auto &row_s = metrics.Mode(LockMetrics::Resource::ROW, static_cast<size_t>(LockManager::LockMode::SHARED));
+  EXPECT_EQ(row_s.acquired_, 1);
+  EXPECT_EQ(row_s.waited_, 1);
+  EXPECT_GE(row_s.wait_.Percentile(1), 50 * 1000 * 1000);
+  EXPECT_EQ(metrics.Mode(LockMetrics::Resource::TABLE, static_cast<size_t>(LockManager::LockMode::INTENTION_SHARED))
+                .acquired_,
+            1);
+  EXPECT_EQ(metrics.waits_, 1);
+  EXPECT_EQ(metrics.committed_txns_, 2);
+  auto top_rows = metrics.TopRows(10);
+  ASSERT_EQ(top_rows.size(), 1);
+  EXPECT_EQ(top_rows[0].first, rid);
+  EXPECT_EQ(top_rows[0].second.waits_, 1);
+  auto top_tables = metrics.TopTables(10);
+  ASSERT_EQ(top_tables.size(), 1);
+  EXPECT_EQ(top_tables[0].first, oid);
+
+  std::stringstream ss;
+  auto stream_writer = SimpleStreamWriter(ss, true);
+  bustub->ExecuteSql("\\locks", stream_writer);
+  EXPECT_NE(ss.str().find("row\tS\t1\t1\t0\t0\t"), std::string::npos);
+  EXPECT_NE(ss.str().find("row 0:0\t1\t"), std::string::npos);
+  ss.str("");
+  bustub->ExecuteSql("\\locks json", stream_writer);
+  EXPECT_EQ(ss.str().rfind("{\"modes\":[{\"resource\":\"table\"", 0), 0);
+  EXPECT_NE(ss.str().find("\"top_rows\":[{\"page_id\":0,\"slot\":0,\"waits\":1,"), std::string::npos);
+  bustub->ExecuteSql("\\locks reset", stream_writer);
+  EXPECT_EQ(metrics.waits_, 0);
+  EXPECT_TRUE(metrics.TopRows(10).empty());
+}
+
+/** Scans and writes that read the whole table lock the table up front instead of each row */
+TEST(LockManagerTest, FullScanLocksTableTest) {
+  auto bustub = std::make_unique<BustubInstance>();
+  auto writer = NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+  bustub->ExecuteSql("INSERT INTO t VALUES (0, 0), (1, 1), (2, 2);", writer);
+  table_oid_t oid = bustub->catalog_->GetTable("t")->oid_;
+
+  auto *txn = bustub->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ);
+  EXPECT_TRUE(bustub->ExecuteSqlTxn("SELECT * FROM t WHERE k = 1", writer, txn));
+  CheckTableLockSizes(txn, 0, 0, 1, 0, 0);
+  // The filter is evaluated on locked rows, so every row the scan reads is locked.
+  CheckTxnRowLockSize(txn, oid, 3, 0);
+  EXPECT_TRUE(bustub->ExecuteSqlTxn("SELECT * FROM t", writer, txn));
+  CheckTableLockSizes(txn, 1, 0, 0, 0, 0);
+  EXPECT_TRUE(bustub->ExecuteSqlTxn("UPDATE t SET v = 5 WHERE k = 2", writer, txn));
+  CheckTableLockSizes(txn, 0, 0, 0, 0, 1);
+  CheckTxnRowLockSize(txn, oid, 2, 1);
+  EXPECT_TRUE(bustub->ExecuteSqlTxn("DELETE FROM t", writer, txn));
+  CheckTableLockSizes(txn, 0, 1, 0, 0, 0);
+  bustub->txn_manager_->Commit(txn);
+  CheckTableLockSizes(txn, 0, 0, 0, 0, 0);
+  delete txn;
+}
+
+/** A scan that has to lock rows reads and filters them only once it holds the locks, never a dirty image */
+TEST(LockManagerTest, ScanWaitsForAbortedWriterTest) {
+  auto bustub = std::make_unique<BustubInstance>();
+  auto writer = NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+  bustub->ExecuteSql("INSERT INTO t VALUES (0, 0), (1, 1), (2, 2);", writer);
+
+  // The writer X locks row 1 and holds the table in SIX mode, so the scan cannot take an S table lock.
+  auto *txn_writer = bustub->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ);
+  EXPECT_TRUE(bustub->ExecuteSqlTxn("UPDATE t SET v = 10 WHERE k = 1", writer, txn_writer));
+
+  std::atomic<bool> done{false};
+  std::stringstream ss;
+  std::thread reader([&] {
+    auto *txn = bustub->txn_manager_->Begin(nullptr, IsolationLevel::REPEATABLE_READ);
+    auto stream_writer = SimpleStreamWriter(ss, true);
+    EXPECT_TRUE(bustub->ExecuteSqlTxn("SELECT v FROM t WHERE v < 5", stream_writer, txn));
+    bustub->txn_manager_->Commit(txn);
+    delete txn;
+    done = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(done);
+  bustub->txn_manager_->Abort(txn_writer);
+  delete txn_writer;
+  reader.join();
+  // The filter sees the row as the writer left it after rolling back.
+  EXPECT_EQ(ss.str(), "0\t\n1\t\n2\t\n");
+}
+
 }  // namespace bustub
@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// optimistic_test.cpp
+//
+// Identification: test/concurrency/optimistic_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class OptimisticTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    auto writer = NoopWriter();
+    bustub_->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+    bustub_->ExecuteSql("CREATE INDEX t_k ON t(k);", writer);
+    bustub_->ExecuteSql("INSERT INTO t VALUES (0, 100), (1, 100), (2, 100), (3, 100);", writer);
+  }
+
+  auto Begin(IsolationLevel isolation_level) -> Transaction * {
+    return bustub_->txn_manager_->Begin(nullptr, isolation_level);
+  }
+
+  auto Commit(Transaction *txn) -> bool {
+    bool committed = bustub_->txn_manager_->Commit(txn);
+    delete txn;
+    return committed;
+  }
+
+  void Abort(Transaction *txn) {
+    bustub_->txn_manager_->Abort(txn);
+    delete txn;
+  }
+
+  auto Sum() -> std::vector<std::string> {
+    auto *txn = Begin(IsolationLevel::REPEATABLE_READ);
+    auto result = RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", txn);
+    Commit(txn);
+    return result;
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(OptimisticTest, DisjointWritersCommit) {
+  auto *first = Begin(IsolationLevel::OPTIMISTIC);
+  auto *second = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = v + 1 WHERE k = 0", first), std::vector<std::string>{"1\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = v + 1 WHERE k = 1", second), std::vector<std::string>{"1\t"});
+  // Neither sees the other's uncommitted write, nor waits for it.
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT v FROM t WHERE k = 1", first), std::vector<std::string>{"100\t"});
+  EXPECT_TRUE(Commit(first));
+  EXPECT_TRUE(Commit(second));
+  EXPECT_EQ(Sum(), std::vector<std::string>{"402\t4\t"});
+}
+
+// NOLINTNEXTLINE
+TEST_F(OptimisticTest, StaleReadFailsValidation) {
+  auto *txn = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT v FROM t WHERE k = 0", txn), std::vector<std::string>{"100\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = 0 WHERE k = 1", txn), std::vector<std::string>{"1\t"});
+
+  // The row read is changed by a commit after the snapshot, so the transaction must not commit on top of it.
+  auto *writer = Begin(IsolationLevel::REPEATABLE_READ);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = 50 WHERE k = 0", writer), std::vector<std::string>{"1\t"});
+  EXPECT_TRUE(Commit(writer));
+
+  EXPECT_FALSE(Commit(txn));
+  EXPECT_EQ(Sum(), std::vector<std::string>{"350\t4\t"});
+}
+
+// NOLINTNEXTLINE
+TEST_F(OptimisticTest, ScanFailsValidationOnInsert) {
+  auto *txn = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT count(*) FROM t WHERE k >= 0 AND k < 10", txn),
+            std::vector<std::string>{"4\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = 0 WHERE k = 3", txn), std::vector<std::string>{"1\t"});
+
+  // A new row in the scanned range is a change to what the scan read.
+  auto *writer = Begin(IsolationLevel::REPEATABLE_READ);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "INSERT INTO t VALUES (5, 1)", writer), std::vector<std::string>{"1\t"});
+  EXPECT_TRUE(Commit(writer));
+
+  EXPECT_FALSE(Commit(txn));
+  EXPECT_EQ(Sum(), std::vector<std::string>{"401\t5\t"});
+}
+
+// NOLINTNEXTLINE
+TEST_F(OptimisticTest, NeverWaitsForLocks) {
+  auto *locker = Begin(IsolationLevel::REPEATABLE_READ);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = 0 WHERE k = 2", locker), std::vector<std::string>{"1\t"});
+
+  // The row is locked, so the optimistic writer gives up at once instead of waiting.
+  auto *txn = Begin(IsolationLevel::OPTIMISTIC);
+  EXPECT_TRUE(RunSqlRows(bustub_.get(), "UPDATE t SET v = 1 WHERE k = 2", txn).empty());
+  EXPECT_EQ(txn->GetState(), TransactionState::ABORTED);
+  Abort(txn);
+  EXPECT_TRUE(Commit(locker));
+  EXPECT_EQ(Sum(), std::vector<std::string>{"300\t4\t"});
+}
+
+// NOLINTNEXTLINE
+TEST_F(OptimisticTest, ConcurrentTransfers) {
+  // Transfers validate the rows they read, so every committed state sums up to the same total.
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> committed{0};
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 2; i++) {
+    writers.emplace_back([this, i, &stop, &committed] {
+      for (int round = 0; !stop; round++) {
+        int from = (round + i) % 4;
+        int to = (round + i + 1) % 4;
+        auto *txn = Begin(IsolationLevel::OPTIMISTIC);
+        auto balance = RunSqlRows(bustub_.get(), fmt::format("SELECT v FROM t WHERE k = {}", from), txn);
+        bool ok = !balance.empty() &&
+                  !RunSqlRows(bustub_.get(),
+                              fmt::format("UPDATE t SET v = {} WHERE k = {}", std::stoi(balance[0]) - 1, from), txn)
+                       .empty() &&
+                  !RunSqlRows(bustub_.get(), fmt::format("UPDATE t SET v = v + 1 WHERE k = {}", to), txn).empty();
+        if (!ok) {
+          Abort(txn);
+        } else if (Commit(txn)) {
+          committed++;
+        }
+      }
+    });
+  }
+
+  // Keep reading until the writers have committed enough transfers, or until they stop making progress.
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  for (int i = 0; i < 200 || (committed < 100 && std::chrono::steady_clock::now() < deadline); i++) {
+    auto *reader = Begin(IsolationLevel::OPTIMISTIC);
+    EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader),
+              std::vector<std::string>{"400\t4\t"});
+    EXPECT_TRUE(Commit(reader));
+  }
+  stop = true;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_GE(committed, 100);
+  EXPECT_EQ(Sum(), std::vector<std::string>{"400\t4\t"});
+}
+
+}  // namespace bustub
@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// snapshot_isolation_test.cpp
+//
+// Identification: test/concurrency/snapshot_isolation_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class SnapshotIsolationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    auto writer = NoopWriter();
+    bustub_->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+    bustub_->ExecuteSql("INSERT INTO t VALUES (0, 100), (1, 100), (2, 100), (3, 100);", writer);
+  }
+
+  auto Begin(IsolationLevel isolation_level) -> Transaction * {
+    return bustub_->txn_manager_->Begin(nullptr, isolation_level);
+  }
+
+  void Commit(Transaction *txn) {
+    bustub_->txn_manager_->Commit(txn);
+    delete txn;
+  }
+
+  void Abort(Transaction *txn) {
+    bustub_->txn_manager_->Abort(txn);
+    delete txn;
+  }
+
+  auto VersionCount() -> size_t {
+    return bustub_->catalog_->GetTable("t")->table_->GetVersionStore()->Size();
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(SnapshotIsolationTest, ReadsSnapshot) {
+  auto *reader = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+
+  auto *updater = Begin(IsolationLevel::REPEATABLE_READ);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = 50 WHERE k = 0", updater), std::vector<std::string>{"1\t"});
+  // Uncommitted changes are invisible, and reading them does not wait for the writer's locks.
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+  Commit(updater);
+
+  auto *writer = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "DELETE FROM t WHERE k = 1", writer), std::vector<std::string>{"1\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "INSERT INTO t VALUES (4, 100)", writer), std::vector<std::string>{"1\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+  Commit(writer);
+
+  // Neither are changes committed after the snapshot was taken.
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT v FROM t WHERE k = 0", reader), std::vector<std::string>{"100\t"});
+  EXPECT_GT(VersionCount(), 0);
+
+  auto *later = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", later), std::vector<std::string>{"350\t4\t"});
+  Commit(later);
+  Commit(reader);
+
+  // Without any snapshot left, the garbage collector drops every version and removes the deleted tuple.
+  bustub_->txn_manager_->GarbageCollect();
+  EXPECT_EQ(VersionCount(), 0);
+  auto *check = Begin(IsolationLevel::REPEATABLE_READ);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", check), std::vector<std::string>{"350\t4\t"});
+  Commit(check);
+}
+
+// NOLINTNEXTLINE
+TEST_F(SnapshotIsolationTest, ReadsOwnWritesAndRollsBack) {
+  auto *txn = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  RunSqlRows(bustub_.get(), "UPDATE t SET v = 0 WHERE k = 2", txn);
+  RunSqlRows(bustub_.get(), "INSERT INTO t VALUES (5, 1)", txn);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", txn), std::vector<std::string>{"301\t5\t"});
+
+  auto *reader = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+  Abort(txn);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader), std::vector<std::string>{"400\t4\t"});
+  Commit(reader);
+  EXPECT_EQ(VersionCount(), 0);
+}
+
+// NOLINTNEXTLINE
+TEST_F(SnapshotIsolationTest, FirstUpdaterWins) {
+  auto *first = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  auto *second = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "UPDATE t SET v = v + 1 WHERE k = 3", first), std::vector<std::string>{"1\t"});
+  Commit(first);
+
+  // The row changed after the second snapshot was taken, so the second update must not overwrite it.
+  EXPECT_TRUE(RunSqlRows(bustub_.get(), "UPDATE t SET v = v + 1 WHERE k = 3", second).empty());
+  EXPECT_EQ(second->GetState(), TransactionState::ABORTED);
+  Abort(second);
+
+  auto *check = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+  EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT v FROM t WHERE k = 3", check), std::vector<std::string>{"101\t"});
+  Commit(check);
+}
+
+// NOLINTNEXTLINE
+TEST_F(SnapshotIsolationTest, ConcurrentTransfers) {
+  // Writers move amounts between rows, so every consistent snapshot sums up to the same total.
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> committed{0};
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 2; i++) {
+    writers.emplace_back([this, i, &stop, &committed] {
+      for (int round = 0; !stop; round++) {
+        int from = (round + i) % 4;
+        int to = (round + i + 1) % 4;
+        auto *txn = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+        bool ok = !RunSqlRows(bustub_.get(), fmt::format("UPDATE t SET v = v - 1 WHERE k = {}", from), txn).empty() &&
+                  !RunSqlRows(bustub_.get(), fmt::format("UPDATE t SET v = v + 1 WHERE k = {}", to), txn).empty();
+        if (ok) {
+          Commit(txn);
+          committed++;
+        } else {
+          Abort(txn);
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i < 200 || committed < 100; i++) {
+    auto *reader = Begin(IsolationLevel::SNAPSHOT_ISOLATION);
+    EXPECT_EQ(RunSqlRows(bustub_.get(), "SELECT sum(v), count(*) FROM t", reader),
+              std::vector<std::string>{"400\t4\t"});
+    Commit(reader);
+  }
+  stop = true;
+  for (auto &writer : writers) {
+    writer.join();
+  }
+}
+
+}  // namespace bustub
@@ -33,6 +33,7 @@
 #include "execution/plans/limit_plan.h"
 #include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "fmt/format.h"
 #include "gtest/gtest.h"
 #include "test_util.h"  // NOLINT
 #include "type/value_factory.h"
@@ -90,6 +91,42 @@ TEST_F(TransactionTest, SimpleInsertRollbackTest) {
   delete txn2;
 }
 
+// NOLINTNEXTLINE
+TEST_F(TransactionTest, BulkRollbackTest) {
+  // txn1: deletes, updates and inserts rows on many pages, and of the index on k
+  // txn1: abort
+  // txn2: reads the table and the index as they were before txn1
+
+  auto noop_writer = NoopWriter();
+  bustub_->ExecuteSql("CREATE TABLE t (k int, v int);", noop_writer);
+  bustub_->ExecuteSql("CREATE INDEX t_k ON t(k);", noop_writer);
+  std::string insert = "INSERT INTO t VALUES ";
+  for (int i = 0; i < 500; i++) {
+    insert += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i);
+  }
+  bustub_->ExecuteSql(insert, noop_writer);
+
+  auto *txn1 = bustub_->txn_manager_->Begin();
+  EXPECT_TRUE(bustub_->ExecuteSqlTxn("DELETE FROM t WHERE k < 250", noop_writer, txn1));
+  EXPECT_TRUE(bustub_->ExecuteSqlTxn("UPDATE t SET v = 0 WHERE k >= 0", noop_writer, txn1));
+  EXPECT_TRUE(bustub_->ExecuteSqlTxn("INSERT INTO t VALUES (1000, 1), (1001, 1)", noop_writer, txn1));
+  bustub_->txn_manager_->Abort(txn1);
+  delete txn1;
+
+  auto *txn2 = bustub_->txn_manager_->Begin();
+  auto query = [&](const std::string &sql) {
+    std::stringstream ss;
+    auto writer = SimpleStreamWriter(ss, true);
+    bustub_->ExecuteSqlTxn(sql, writer, txn2);
+    return ss.str();
+  };
+  EXPECT_EQ(query("SELECT count(*), sum(v) FROM t"), "500\t124750\t\n");
+  EXPECT_EQ(query("SELECT v FROM t WHERE k = 10"), "10\t\n");
+  EXPECT_EQ(query("SELECT v FROM t WHERE k = 1000"), "");
+  bustub_->txn_manager_->Commit(txn2);
+  delete txn2;
+}
+
 // NOLINTNEXTLINE
 TEST_F(TransactionTest, DirtyReadsTest) {
   bustub_->GenerateTestTable();
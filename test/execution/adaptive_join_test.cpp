@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// adaptive_join_test.cpp
+//
+// Identification: test/execution/adaptive_join_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class AdaptiveJoinTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    saved_enabled_ = enable_adaptive_join;
+    saved_buffer_rows_ = adaptive_join_buffer_rows;
+    saved_spill_threshold_ = hash_join_spill_threshold;
+    adaptive_join_buffer_rows = 64;
+
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE small (k int, v varchar(16));");
+    RunSql(bustub_.get(), "CREATE TABLE big (k int, g int, v varchar(16));");
+    RunSql(bustub_.get(), "CREATE TABLE other (g int, w int);");
+    RunSql(bustub_.get(), "CREATE INDEX big_k ON big(k);");
+    std::string small = "INSERT INTO small VALUES ";
+    for (int i = 0; i < 20; i++) {
+      small += fmt::format("{}({}, 's{}')", i == 0 ? "" : ", ", i * 61 % 1100, i);
+    }
+    RunSql(bustub_.get(), small);
+    std::string big = "INSERT INTO big VALUES ";
+    std::string other = "INSERT INTO other VALUES ";
+    for (int i = 0; i < 1000; i++) {
+      big += fmt::format("{}({}, {}, 'b{}')", i == 0 ? "" : ", ", i, i % 300, i);
+      other += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i % 400, i);
+    }
+    RunSql(bustub_.get(), big);
+    RunSql(bustub_.get(), other);
+  }
+
+  void TearDown() override {
+    enable_adaptive_join = saved_enabled_;
+    adaptive_join_buffer_rows = saved_buffer_rows_;
+    hash_join_spill_threshold = saved_spill_threshold_;
+  }
+
+  /** Check that the adaptive join returns the same rows as the joins planned at optimize time */
+  void CheckQuery(const std::string &query) {
+    enable_adaptive_join = false;
+    bustub_->plan_cache_.Clear();
+    auto expected = SortedRows(bustub_.get(), query);
+    enable_adaptive_join = true;
+    bustub_->plan_cache_.Clear();
+    EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN (o) " + query).find("AdaptiveJoin"), std::string::npos) << query;
+    auto actual = SortedRows(bustub_.get(), query);
+    ASSERT_FALSE(expected.empty()) << query;
+    ASSERT_EQ(expected.size(), actual.size()) << query;
+    EXPECT_EQ(expected, actual) << query;
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+
+ private:
+  bool saved_enabled_;
+  size_t saved_buffer_rows_;
+  size_t saved_spill_threshold_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(AdaptiveJoinTest, IndexNestedLoop) {
+  // The left input fits in the buffer and the right one is a full scan of a table with an index on the key.
+  CheckQuery("SELECT small.k, small.v, big.v FROM small INNER JOIN big ON small.k = big.k");
+  CheckQuery("SELECT small.k, small.v, big.g FROM small LEFT OUTER JOIN big ON small.k = big.k");
+}
+
+// NOLINTNEXTLINE
+TEST_F(AdaptiveJoinTest, InMemoryHash) {
+  // The right input fits in the buffer.
+  CheckQuery("SELECT big.k, small.v FROM big INNER JOIN small ON big.k = small.k");
+  CheckQuery("SELECT big.k, small.v FROM big LEFT OUTER JOIN small ON big.k = small.k");
+  // Only the left input fits in the buffer, the hash table is built on it instead.
+  CheckQuery("SELECT small.v, big.k FROM small INNER JOIN big ON small.k = big.g");
+  CheckQuery("SELECT small.v, big.k FROM small LEFT OUTER JOIN big ON small.k = big.g");
+  // Neither input fits in the buffer, but the right one fits in memory.
+  CheckQuery("SELECT big.k, other.w FROM big INNER JOIN other ON big.g = other.g");
+}
+
+// NOLINTNEXTLINE
+TEST_F(AdaptiveJoinTest, Spill) {
+  hash_join_spill_threshold = 1024;
+  CheckQuery("SELECT big.k, other.w FROM big INNER JOIN other ON big.g = other.g");
+  CheckQuery("SELECT big.k, big.v, other.w FROM big LEFT OUTER JOIN other ON big.k = other.w");
+  CheckQuery("SELECT other.w, big.v FROM other LEFT OUTER JOIN big ON other.w = big.g");
+}
+
+}  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// column_pruning_test.cpp
+//
+// Identification: test/execution/column_pruning_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks the columns the plans keep, test/sql/column-pruning.slt checks the rows they return */
+class ColumnPruningTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE a (x int, y int, s varchar(16));");
+    RunSql(bustub_.get(), "CREATE TABLE b (x int, z int, t varchar(16));");
+    RunSql(bustub_.get(), "INSERT INTO a VALUES (1, 10, 'one'), (2, 20, 'two'), (3, 30, 'three');");
+    RunSql(bustub_.get(), "INSERT INTO b VALUES (2, 7, 'seven'), (3, 8, 'eight');");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(ColumnPruningTest, ScansOnlyReadColumns) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT b.t FROM a, b WHERE a.x = b.x AND a.y > 10");
+  // The filter of a reads y, the join reads x of both tables and only t of b is returned.
+  EXPECT_NE(plan.find("SeqScan { table=a, filter=(#0.1>10), columns=[0] }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("SeqScan { table=b, columns=[0, 2] }"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ColumnPruningTest, DropsUnreadAggregates) {
+  auto plan = RunSql(bustub_.get(),
+                     "EXPLAIN (o) SELECT x, m FROM (SELECT x, min(y) AS m, max(s), count(*) FROM a GROUP BY x) "
+                     "WHERE m > 10");
+  EXPECT_NE(plan.find("Agg { types=[min], aggregates=[#0.1], group_by=[#0.0] }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("columns=[0, 1]"), std::string::npos) << plan;
+
+  // A count of the rows still scans a column.
+  plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT count(*) FROM a");
+  EXPECT_NE(plan.find("SeqScan { table=a, columns=[0] }"), std::string::npos) << plan;
+}
+
+}  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_expression_test.cpp
+//
+// Identification: test/execution/compiled_expression_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/compiled_expression.h"
+#include "execution/expressions/arithmetic_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+static auto Col(uint32_t tuple_idx, uint32_t col_idx, TypeId type) -> AbstractExpressionRef {
+  return std::make_shared<ColumnValueExpression>(tuple_idx, col_idx, type);
+}
+
+static auto Const(const Value &val) -> AbstractExpressionRef { return std::make_shared<ConstantValueExpression>(val); }
+
+static auto Cmp(AbstractExpressionRef left, AbstractExpressionRef right, ComparisonType type) -> AbstractExpressionRef {
+  return std::make_shared<ComparisonExpression>(std::move(left), std::move(right), type);
+}
+
+static auto Logic(AbstractExpressionRef left, AbstractExpressionRef right, LogicType type) -> AbstractExpressionRef {
+  return std::make_shared<LogicExpression>(std::move(left), std::move(right), type);
+}
+
+/** Check that the compiled program returns exactly what the tree returns, NULLs included */
+static void ExpectSameAsTree(const AbstractExpressionRef &expr, const Schema &schema, const std::vector<Tuple> &tuples,
+                             bool compiled) {
+  CompiledExpression program(expr.get(), schema);
+  EXPECT_EQ(compiled, program.IsCompiled()) << expr->ToString();
+  for (const auto &tuple : tuples) {
+    auto expected = expr->Evaluate(&tuple, schema);
+    auto actual = program.Evaluate(&tuple);
+    ASSERT_EQ(expected.GetTypeId(), actual.GetTypeId()) << expr->ToString();
+    ASSERT_EQ(expected.IsNull(), actual.IsNull()) << expr->ToString() << " " << tuple.ToString(&schema);
+    if (!expected.IsNull()) {
+      ASSERT_EQ(expected.CompareEquals(actual), CmpBool::CmpTrue) << expr->ToString() << " " << tuple.ToString(&schema);
+    }
+    if (expr->GetReturnType() == TypeId::BOOLEAN) {
+      ASSERT_EQ(!expected.IsNull() && expected.GetAs<bool>(), program.EvaluatePredicate(&tuple))
+          << expr->ToString() << " " << tuple.ToString(&schema);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(CompiledExpressionTest, SingleTuple) {
+  Schema schema(std::vector{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::BIGINT}, Column{"s", TypeId::VARCHAR, 8},
+                            Column{"c", TypeId::SMALLINT}});
+  std::vector<Tuple> tuples;
+  for (int32_t i = -5; i < 30; i++) {
+    Value a = i % 7 == 0 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(i);
+    Value b = i % 5 == 0 ? ValueFactory::GetNullValueByType(TypeId::BIGINT) : ValueFactory::GetBigIntValue(i * 3LL);
+    Value s = ValueFactory::GetVarcharValue(i % 2 == 0 ? "even" : "odd");
+    Value c = ValueFactory::GetSmallIntValue(static_cast<int16_t>(i % 4));
+    tuples.emplace_back(std::vector{a, b, s, c}, &schema);
+  }
+
+  auto a = Col(0, 0, TypeId::INTEGER);
+  auto b = Col(0, 1, TypeId::BIGINT);
+  auto s = Col(0, 2, TypeId::VARCHAR);
+  auto c = Col(0, 3, TypeId::SMALLINT);
+  auto ten = Const(ValueFactory::GetIntegerValue(10));
+  auto null_int = Const(ValueFactory::GetNullValueByType(TypeId::INTEGER));
+
+  ExpectSameAsTree(a, schema, tuples, true);
+  ExpectSameAsTree(Cmp(a, ten, ComparisonType::LessThan), schema, tuples, true);
+  ExpectSameAsTree(Cmp(b, Const(ValueFactory::GetBigIntValue(30)), ComparisonType::GreaterThanOrEqual), schema, tuples,
+                   true);
+  ExpectSameAsTree(Cmp(c, Const(ValueFactory::GetSmallIntValue(2)), ComparisonType::NotEqual), schema, tuples, true);
+  ExpectSameAsTree(std::make_shared<ArithmeticExpression>(a, ten, ArithmeticType::Minus), schema, tuples, true);
+  ExpectSameAsTree(Cmp(a, null_int, ComparisonType::Equal), schema, tuples, true);
+
+  // Three-valued logic over NULL operands.
+  auto a_lt_10 = Cmp(a, ten, ComparisonType::LessThan);
+  auto b_gt_20 = Cmp(b, Const(ValueFactory::GetBigIntValue(20)), ComparisonType::GreaterThan);
+  ExpectSameAsTree(Logic(a_lt_10, b_gt_20, LogicType::And), schema, tuples, true);
+  ExpectSameAsTree(Logic(a_lt_10, b_gt_20, LogicType::Or), schema, tuples, true);
+  ExpectSameAsTree(Logic(Logic(a_lt_10, b_gt_20, LogicType::And), Cmp(a, Const(ValueFactory::GetIntegerValue(7)),
+                                                                      ComparisonType::Equal),
+                         LogicType::Or),
+                   schema, tuples, true);
+
+  // A VARCHAR comparison is evaluated through the tree inside an otherwise compiled program.
+  auto s_eq_even = Cmp(s, Const(ValueFactory::GetVarcharValue("even")), ComparisonType::Equal);
+  ExpectSameAsTree(s_eq_even, schema, tuples, true);
+  ExpectSameAsTree(Logic(s_eq_even, a_lt_10, LogicType::And), schema, tuples, true);
+
+  // A VARCHAR root cannot be compiled at all.
+  ExpectSameAsTree(s, schema, tuples, false);
+}
+
+// NOLINTNEXTLINE
+TEST(CompiledExpressionTest, Join) {
+  Schema left_schema(std::vector{Column{"a", TypeId::INTEGER}, Column{"s", TypeId::VARCHAR, 8}});
+  Schema right_schema(std::vector{Column{"s", TypeId::VARCHAR, 8}, Column{"b", TypeId::INTEGER}});
+  std::vector<Tuple> left_tuples;
+  std::vector<Tuple> right_tuples;
+  for (int32_t i = 0; i < 10; i++) {
+    Value v = i == 3 ? ValueFactory::GetNullValueByType(TypeId::INTEGER) : ValueFactory::GetIntegerValue(i);
+    left_tuples.emplace_back(std::vector{v, ValueFactory::GetVarcharValue(std::to_string(i % 3))}, &left_schema);
+    right_tuples.emplace_back(std::vector{ValueFactory::GetVarcharValue(std::to_string(i % 2)), v}, &right_schema);
+  }
+
+  auto equi = Cmp(Col(0, 0, TypeId::INTEGER), Col(1, 1, TypeId::INTEGER), ComparisonType::Equal);
+  auto pred = Logic(equi, Cmp(Col(0, 1, TypeId::VARCHAR), Col(1, 0, TypeId::VARCHAR), ComparisonType::NotEqual),
+                    LogicType::Or);
+  for (const auto &expr : {equi, pred}) {
+    CompiledExpression program(expr.get(), left_schema, right_schema);
+    EXPECT_TRUE(program.IsCompiled());
+    for (const auto &left : left_tuples) {
+      for (const auto &right : right_tuples) {
+        auto expected = expr->EvaluateJoin(&left, left_schema, &right, right_schema);
+        auto actual = program.EvaluateJoin(&left, &right);
+        ASSERT_EQ(expected.IsNull(), actual.IsNull());
+        if (!expected.IsNull()) {
+          ASSERT_EQ(expected.GetAs<bool>(), actual.GetAs<bool>());
+        }
+        ASSERT_EQ(!expected.IsNull() && expected.GetAs<bool>(), program.EvaluateJoinPredicate(&left, &right));
+      }
+    }
+  }
+}
+
+}  // namespace bustub
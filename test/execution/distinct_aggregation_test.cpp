@@ -0,0 +1,65 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// distinct_aggregation_test.cpp
+//
+// Identification: test/execution/distinct_aggregation_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "common/util/string_util.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks the plans of distinct aggregates, test/sql/distinct-aggregation.slt checks their rows */
+class DistinctAggregationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (g int, v int);");
+    RunSql(bustub_.get(),
+           "INSERT INTO t VALUES (1, 10), (1, 10), (1, 20), (1, NULL), (2, 30), (2, 30), (2, 30), (3, NULL);");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(DistinctAggregationTest, DistinctAggregates) {
+  EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN (o) SELECT count(DISTINCT v) FROM t;").find("types=[count_distinct]"),
+            std::string::npos);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DistinctAggregationTest, ApproxCountDistinct) {
+  RunSql(bustub_.get(), "CREATE TABLE big (g int, v int);");
+  std::string insert = "INSERT INTO big VALUES ";
+  for (int i = 0; i < 6000; i++) {
+    insert += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i % 2, i % 3000);
+  }
+  RunSql(bustub_.get(), insert);
+  EXPECT_NE(RunSql(bustub_.get(), "EXPLAIN (o) SELECT approx_count_distinct(v) FROM big;")
+                .find("types=[approx_count_distinct]"),
+            std::string::npos);
+
+  // Group 0 sees the 1500 even values of v, group 1 the 1500 odd ones.
+  auto rows = SortedRows(bustub_.get(), "SELECT g, approx_count_distinct(v), count(DISTINCT v) FROM big GROUP BY g;");
+  ASSERT_EQ(rows.size(), 2);
+  for (const auto &row : rows) {
+    auto cells = StringUtil::Split(row, '\t');
+    EXPECT_EQ(cells[2], "1500");
+    EXPECT_NEAR(std::stoi(cells[1]), 1500, 1500 * 0.05);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// explain_analyze_test.cpp
+//
+// Identification: test/execution/explain_analyze_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class ExplainAnalyzeTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    saved_adaptive_join_ = enable_adaptive_join;
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (k int, v int);");
+    RunSql(bustub_.get(), "CREATE TABLE u (k int, w int);");
+    RunSql(bustub_.get(), "CREATE INDEX u_k ON u(k);");
+    std::string t = "INSERT INTO t VALUES ";
+    std::string u = "INSERT INTO u VALUES ";
+    for (int i = 0; i < 100; i++) {
+      t += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i % 10, i);
+      u += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i);
+    }
+    RunSql(bustub_.get(), t);
+    RunSql(bustub_.get(), u);
+  }
+
+  void TearDown() override { enable_adaptive_join = saved_adaptive_join_; }
+
+  /** @return the line of the EXPLAIN ANALYZE output that starts with the given plan node */
+  static auto Line(const std::string &output, const std::string &node) -> std::string {
+    auto analyze = output.find("=== ANALYZE ===");
+    EXPECT_NE(analyze, std::string::npos);
+    auto begin = output.find(node, analyze);
+    EXPECT_NE(begin, std::string::npos) << node;
+    if (begin == std::string::npos) {
+      return "";
+    }
+    return output.substr(begin, output.find('\n', begin) - begin);
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+  bool saved_adaptive_join_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(ExplainAnalyzeTest, RowsAndEstimates) {
+  auto output = RunSql(bustub_.get(), "EXPLAIN ANALYZE SELECT v FROM t WHERE k = 3;");
+  EXPECT_NE(output.find("Execution time: "), std::string::npos);
+  auto scan = Line(output, "SeqScan");
+  EXPECT_NE(scan.find("actual rows=10,"), std::string::npos) << scan;
+  EXPECT_NE(scan.find("loops=1,"), std::string::npos) << scan;
+  EXPECT_EQ(scan.find("pages fetched=0 "), std::string::npos) << scan;
+
+  // Once the table has statistics, the estimate of the scan is a number.
+  RunSql(bustub_.get(), "ANALYZE t;");
+  bustub_->plan_cache_.Clear();
+  output = RunSql(bustub_.get(), "EXPLAIN ANALYZE SELECT v FROM t WHERE k = 3;");
+  scan = Line(output, "SeqScan");
+  EXPECT_EQ(scan.find("estimated rows=?"), std::string::npos) << scan;
+  EXPECT_NE(scan.find("estimated rows="), std::string::npos) << scan;
+
+  auto agg = Line(RunSql(bustub_.get(), "EXPLAIN ANALYZE SELECT count(*) FROM u;"), "Agg");
+  EXPECT_NE(agg.find("estimated rows=1, actual rows=1,"), std::string::npos) << agg;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExplainAnalyzeTest, AdaptiveJoinDecisions) {
+  enable_adaptive_join = true;
+  bustub_->plan_cache_.Clear();
+  auto output = RunSql(bustub_.get(), "EXPLAIN ANALYZE SELECT t.v, u.w FROM t INNER JOIN u ON t.k = u.k;");
+  auto join = Line(output, "AdaptiveJoin");
+  EXPECT_NE(join.find("actual rows=100,"), std::string::npos) << join;
+  EXPECT_NE(output.find("note: "), std::string::npos) << output;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExplainAnalyzeTest, ExecutesStatement) {
+  RunSql(bustub_.get(), "EXPLAIN ANALYZE INSERT INTO t VALUES (42, 42);");
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT v FROM t WHERE k = 42;"), "42\t\n");
+}
+
+}  // namespace bustub
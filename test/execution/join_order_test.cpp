@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// join_order_test.cpp
+//
+// Identification: test/execution/join_order_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks the plans of reordered joins, test/sql/join-order.slt checks their rows */
+class JoinOrderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    // big has a row per key, small a row for ten of the keys, and tiny two rows for one of them.
+    RunSql(bustub_.get(), "CREATE TABLE big (k int, v int);");
+    RunSql(bustub_.get(), "CREATE TABLE small (k int, w int);");
+    RunSql(bustub_.get(), "CREATE TABLE tiny (k int, z int);");
+    RunSql(bustub_.get(), "CREATE INDEX big_k ON big(k);");
+    std::string big = "INSERT INTO big VALUES ";
+    for (int i = 0; i < 1000; i++) {
+      big += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i % 7);
+    }
+    RunSql(bustub_.get(), big);
+    std::string small = "INSERT INTO small VALUES ";
+    for (int i = 0; i < 10; i++) {
+      small += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i * 10, i);
+    }
+    RunSql(bustub_.get(), small);
+    RunSql(bustub_.get(), "INSERT INTO tiny VALUES (20, 1), (20, 2);");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(JoinOrderTest, JoinsSmallInputsFirst) {
+  RunSql(bustub_.get(), "ANALYZE");
+  auto plan = RunSql(bustub_.get(),
+                     "EXPLAIN (o) SELECT big.k, big.v, small.w, tiny.z FROM big INNER JOIN small ON big.k = small.k "
+                     "INNER JOIN tiny ON small.k = tiny.k");
+  // small and tiny are joined first and big is looked up by its index for the few rows left.
+  EXPECT_NE(plan.find("NestedIndexJoin"), std::string::npos) << plan;
+  EXPECT_LT(plan.find("table=small"), plan.find("table=tiny")) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(JoinOrderTest, PushesDownPredicates) {
+  auto plan = RunSql(bustub_.get(),
+                     "EXPLAIN (o) SELECT * FROM small, tiny, big WHERE big.k = small.k AND tiny.k = small.k "
+                     "AND small.w < 5 AND big.v = 6");
+  // The predicates on one table filter its scan, and no join is a cross product.
+  EXPECT_NE(plan.find("filter=(#0.1<5)"), std::string::npos) << plan;
+  EXPECT_EQ(plan.find("NestedLoopJoin { type=Inner, predicate=true }"), std::string::npos) << plan;
+}
+
+}  // namespace bustub
@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// nested_loop_join_test.cpp
+//
+// Identification: test/execution/nested_loop_join_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** The join must return the same rows whether the outer side fits into one block or needs one block per tuple */
+static void CheckQuery(BustubInstance *bustub, const std::string &query, size_t expected_rows) {
+  size_t saved_block_size = nested_loop_join_block_size;
+  nested_loop_join_block_size = 1 << 30;
+  auto expected = SortedRows(bustub, query);
+  nested_loop_join_block_size = 1;
+  auto actual = SortedRows(bustub, query);
+  nested_loop_join_block_size = 64;
+  auto small_blocks = SortedRows(bustub, query);
+  nested_loop_join_block_size = saved_block_size;
+
+  EXPECT_EQ(expected_rows, expected.size()) << query;
+  EXPECT_EQ(expected, actual) << query;
+  EXPECT_EQ(expected, small_blocks) << query;
+}
+
+TEST(NestedLoopJoinTest, BlockSizes) {
+  auto bustub = std::make_unique<BustubInstance>();
+  bustub->GenerateMockTable();
+  // colA in [0, 100), colE is even in [0, 100) or NULL
+  CheckQuery(bustub.get(), "SELECT * FROM __mock_table_1 INNER JOIN __mock_table_3 ON colA < colE", 2450);
+  CheckQuery(bustub.get(), "SELECT * FROM __mock_table_1 LEFT JOIN __mock_table_3 ON colA > colE + 90", 25 + 91);
+  CheckQuery(bustub.get(), "SELECT colC, colF FROM __mock_table_2 LEFT JOIN __mock_table_3 ON colE > 200", 100);
+  CheckQuery(bustub.get(), "SELECT * FROM __mock_table_2 INNER JOIN __mock_table_3 ON colE > 200", 0);
+}
+
+}  // namespace bustub
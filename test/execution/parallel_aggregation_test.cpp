@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_aggregation_test.cpp
+//
+// Identification: test/execution/parallel_aggregation_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "binder/binder.h"
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "concurrency/transaction_manager.h"
+#include "execution/executor_context.h"
+#include "execution/executor_factory.h"
+#include "execution/executors/aggregation_executor.h"
+#include "gtest/gtest.h"
+#include "optimizer/optimizer.h"
+#include "planner/planner.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class ParallelAggregationTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    saved_enabled_ = enable_parallel_aggregation;
+    saved_parallelism_ = aggregation_parallelism;
+    saved_spill_threshold_ = aggregation_spill_threshold;
+    aggregation_parallelism = GetParam();
+  }
+
+  void TearDown() override {
+    enable_parallel_aggregation = saved_enabled_;
+    aggregation_parallelism = saved_parallelism_;
+    aggregation_spill_threshold = saved_spill_threshold_;
+  }
+
+  /** Check that the two-phase aggregation returns the same rows as the simple hash table */
+  void CheckQuery(BustubInstance *bustub, const std::string &query) {
+    enable_parallel_aggregation = false;
+    auto expected = SortedRows(bustub, query);
+    enable_parallel_aggregation = true;
+    auto actual = SortedRows(bustub, query);
+    ASSERT_EQ(expected.size(), actual.size()) << query;
+    EXPECT_EQ(expected, actual) << query;
+  }
+
+ private:
+  bool saved_enabled_;
+  size_t saved_parallelism_;
+  size_t saved_spill_threshold_;
+};
+
+TEST_P(ParallelAggregationTest, InMemory) {
+  auto bustub = std::make_unique<BustubInstance>();
+  bustub->GenerateMockTable();
+  CheckQuery(bustub.get(),
+             "SELECT v1, count(*), count(v2), sum(v2), min(v3), max(v4) FROM __mock_agg_input_big GROUP BY v1");
+  CheckQuery(bustub.get(), "SELECT v6, v1, count(*), sum(v3) FROM __mock_agg_input_big GROUP BY v6, v1");
+  CheckQuery(bustub.get(), "SELECT colF, count(colE), min(colE), sum(colE) FROM __mock_table_3 GROUP BY colF");
+  CheckQuery(bustub.get(), "SELECT count(*), min(x), max(y) FROM __mock_t2_100k");
+  CheckQuery(bustub.get(), "SELECT count(*), min(x) FROM __mock_t2_100k WHERE x < 0");
+  CheckQuery(bustub.get(), "SELECT x, count(*) FROM __mock_t2_100k WHERE x < 0 GROUP BY x");
+}
+
+TEST_P(ParallelAggregationTest, Spill) {
+  auto bustub = std::make_unique<BustubInstance>();
+  bustub->GenerateMockTable();
+  // Every partition buffer goes to disk almost immediately.
+  aggregation_spill_threshold = 4096;
+  CheckQuery(bustub.get(), "SELECT x, count(*), sum(y), max(y) FROM __mock_t2_100k GROUP BY x");
+  CheckQuery(bustub.get(), "SELECT x, y, count(*), min(y) FROM __mock_t2_100k GROUP BY x, y");
+  CheckQuery(bustub.get(), "SELECT v6, count(*), sum(v2) FROM __mock_agg_input_big GROUP BY v6");
+
+  // Run the aggregation of the first query on its own and check that it went to disk.
+  bustub::Binder binder(*bustub->catalog_);
+  binder.ParseAndSave("SELECT x, count(*), sum(y), max(y) FROM __mock_t2_100k GROUP BY x");
+  auto statement = binder.BindStatement(binder.statement_nodes_[0]);
+  bustub::Planner planner(*bustub->catalog_);
+  planner.PlanQuery(*statement);
+  bustub::Optimizer optimizer(*bustub->catalog_, false);
+  auto plan = optimizer.Optimize(planner.plan_);
+  while (plan->GetType() != PlanType::Aggregation) {
+    ASSERT_EQ(plan->GetChildren().size(), 1) << plan->ToString();
+    plan = plan->GetChildAt(0);
+  }
+
+  auto txn = bustub->txn_manager_->Begin();
+  auto exec_ctx = std::make_unique<ExecutorContext>(txn, bustub->catalog_, bustub->buffer_pool_manager_,
+                                                    bustub->txn_manager_, bustub->lock_manager_);
+  auto executor = ExecutorFactory::CreateExecutor(exec_ctx.get(), plan);
+  executor->Init();
+  const auto *aggregation = dynamic_cast<const AggregationExecutor *>(executor.get());
+  ASSERT_NE(aggregation, nullptr);
+  EXPECT_GT(aggregation->GetSpilledPageCount(), 0);
+  bustub->txn_manager_->Commit(txn);
+  delete txn;
+}
+
+INSTANTIATE_TEST_SUITE_P(Parallelism, ParallelAggregationTest, ::testing::Values(1, 4));
+
+}  // namespace bustub
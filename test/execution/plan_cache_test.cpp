@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// plan_cache_test.cpp
+//
+// Identification: test/execution/plan_cache_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "common/exception.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+#include "planner/plan_cache.h"
+
+namespace bustub {
+
+class PlanCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (k int, v varchar(16));");
+    std::string rows = "INSERT INTO t VALUES ";
+    for (int i = 0; i < 100; i++) {
+      rows += fmt::format("{}({}, 'v{}')", i == 0 ? "" : ", ", i, i % 10);
+    }
+    RunSql(bustub_.get(), rows);
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST(PlanCacheParameterizeTest, ReplacesConstants) {
+  auto query = PlanCache::Parameterize("SELECT k, 'it''s' FROM t WHERE k > 10 AND v = 'a' AND k < -3 LIMIT 5;");
+  ASSERT_TRUE(query.has_value());
+  EXPECT_EQ(query->query_, "SELECT k, $1 FROM t WHERE k > $2 AND v = $3 AND k < -3 LIMIT 5;");
+  ASSERT_EQ(query->params_.size(), 3);
+  EXPECT_EQ(query->params_[0].ToString(), "it's");
+  EXPECT_EQ(query->params_[1].ToString(), "10");
+  EXPECT_EQ(query->params_[2].ToString(), "a");
+
+  // Decimals stay in the text, and statements with parameters of their own or without a plan are not parameterized.
+  EXPECT_EQ(PlanCache::Parameterize("SELECT 1.5 FROM t")->query_, "SELECT 1.5 FROM t");
+  EXPECT_FALSE(PlanCache::Parameterize("SELECT * FROM t WHERE k = $1").has_value());
+  EXPECT_FALSE(PlanCache::Parameterize("CREATE TABLE u (v varchar(10))").has_value());
+}
+
+// NOLINTNEXTLINE
+TEST_F(PlanCacheTest, ReusesPlansAcrossConstants) {
+  const auto hits = bustub_->plan_cache_.GetHits();
+  EXPECT_EQ(SortedRows(bustub_.get(), "SELECT k FROM t WHERE k > 95"),
+            (std::vector<std::string>{"96\t", "97\t", "98\t", "99\t"}));
+  EXPECT_EQ(SortedRows(bustub_.get(), "SELECT k FROM t WHERE k > 97"), (std::vector<std::string>{"98\t", "99\t"}));
+  EXPECT_EQ(SortedRows(bustub_.get(), "SELECT k, v FROM t WHERE v = 'v3' AND k < 30"),
+            (std::vector<std::string>{"13\tv3\t", "23\tv3\t", "3\tv3\t"}));
+  EXPECT_EQ(SortedRows(bustub_.get(), "SELECT k, v FROM t WHERE v = 'v4' AND k < 20"),
+            (std::vector<std::string>{"14\tv4\t", "4\tv4\t"}));
+  EXPECT_EQ(bustub_->plan_cache_.GetHits(), hits + 2);
+}
+
+// NOLINTNEXTLINE
+TEST_F(PlanCacheTest, InvalidatesPlansOnCatalogChanges) {
+  const std::string query = "EXPLAIN (o) SELECT k FROM t WHERE k = 42";
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t WHERE k = 42"), "42\t\n");
+  RunSql(bustub_.get(), "CREATE INDEX t_k ON t(k);");
+  // The plan cached before the index was created is not reused, the point lookup now goes through the index.
+  const auto misses = bustub_->plan_cache_.GetMisses();
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t WHERE k = 43"), "43\t\n");
+  EXPECT_EQ(bustub_->plan_cache_.GetMisses(), misses + 1);
+  EXPECT_NE(RunSql(bustub_.get(), query).find("IndexScan"), std::string::npos);
+
+  RunSql(bustub_.get(), "ANALYZE t");
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t WHERE k = 44"), "44\t\n");
+  EXPECT_EQ(bustub_->plan_cache_.GetMisses(), misses + 2);
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t WHERE k = 45"), "45\t\n");
+  EXPECT_EQ(bustub_->plan_cache_.GetMisses(), misses + 2);
+}
+
+// NOLINTNEXTLINE
+TEST_F(PlanCacheTest, ExecutesPreparedStatements) {
+  RunSql(bustub_.get(), "CREATE INDEX t_k ON t(k);");
+  RunSql(bustub_.get(), "PREPARE point(int) AS SELECT k, v FROM t WHERE k = $1;");
+  EXPECT_EQ(RunSql(bustub_.get(), "EXECUTE point(7);"), "7\tv7\t\n");
+  EXPECT_EQ(RunSql(bustub_.get(), "EXECUTE point(61);"), "61\tv1\t\n");
+
+  RunSql(bustub_.get(), "PREPARE range AS SELECT k FROM t WHERE k >= $1 AND k < $2 AND v = $3;");
+  EXPECT_EQ(SortedRows(bustub_.get(), "EXECUTE range(10, 40, 'v5');"),
+            (std::vector<std::string>{"15\t", "25\t", "35\t"}));
+
+  RunSql(bustub_.get(), "PREPARE bump(int) AS UPDATE t SET v = 'bumped' WHERE k = $1;");
+  RunSql(bustub_.get(), "EXECUTE bump(8);");
+  EXPECT_EQ(RunSql(bustub_.get(), "EXECUTE point(8);"), "8\tbumped\t\n");
+
+  RunSql(bustub_.get(), "DEALLOCATE point;");
+  EXPECT_THROW(RunSql(bustub_.get(), "EXECUTE point(8);"), Exception);
+  EXPECT_THROW(RunSql(bustub_.get(), "EXECUTE bump(1, 2);"), Exception);
+  EXPECT_THROW(RunSql(bustub_.get(), "PREPARE bad(int) AS SELECT * FROM missing WHERE k = $1;"), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(PlanCacheTest, FallsBackForUncacheableStatements) {
+  // Multiple statements are executed one by one, each through the plan cache.
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t WHERE k = 1; SELECT k FROM t WHERE k = 2;"), "1\t\n2\t\n");
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t ORDER BY k DESC LIMIT 2"), "99\t\n98\t\n");
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT k FROM t ORDER BY k DESC LIMIT 1"), "99\t\n");
+}
+
+}  // namespace bustub
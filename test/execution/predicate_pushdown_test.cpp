@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// predicate_pushdown_test.cpp
+//
+// Identification: test/execution/predicate_pushdown_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks where the predicates end up, test/sql/predicate-pushdown.slt checks the rows they filter */
+class PredicatePushDownTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE a (x int, y int);");
+    RunSql(bustub_.get(), "CREATE TABLE b (x int, z int);");
+    RunSql(bustub_.get(), "INSERT INTO a VALUES (1, 1), (2, 2), (3, 3);");
+    RunSql(bustub_.get(), "INSERT INTO b VALUES (2, 7), (3, 8);");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(PredicatePushDownTest, DerivesTransitiveEqualities) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT * FROM a, b WHERE a.x = b.x AND b.x = 2");
+  EXPECT_NE(plan.find("SeqScan { table=a, filter=(#0.0=2) }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("SeqScan { table=b, filter=(#0.0=2) }"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(PredicatePushDownTest, MovesThroughProjectionAndAggregation) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT * FROM (SELECT x, y + 1 AS w FROM a) t WHERE t.w > 2");
+  EXPECT_NE(plan.find("SeqScan { table=a, filter=((#0.1+1)>2) }"), std::string::npos) << plan;
+
+  // Only the predicate on the group moves below the aggregation.
+  plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT x, count(*) FROM a GROUP BY x HAVING x > 1 AND count(*) > 0");
+  EXPECT_NE(plan.find("SeqScan { table=a, filter=(#0.0>1), columns=[0] }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("Filter { predicate=(#0.1>0) }"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(PredicatePushDownTest, KeepsOuterJoinRows) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT * FROM a LEFT JOIN b ON a.x = b.x AND b.z > 7 WHERE a.y > 1");
+  // The filter of the WHERE clause reads only the left input, the predicate of the join only the right one.
+  EXPECT_NE(plan.find("SeqScan { table=a, filter=(#0.1>1) }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("SeqScan { table=b, filter=(#0.1>7) }"), std::string::npos) << plan;
+}
+
+}  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// seq_scan_test.cpp
+//
+// Identification: test/execution/seq_scan_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(SeqScanTest, ZeroCopyMatchesCopy) {
+  bool saved = enable_zero_copy_scan;
+  auto bustub = std::make_unique<BustubInstance>();
+  SortedRows(bustub.get(), "CREATE TABLE t(k int, v int, s varchar(32));");
+  // Enough rows to span a few dozen pages.
+  for (int batch = 0; batch < 20; batch++) {
+    std::string query = "INSERT INTO t VALUES ";
+    for (int i = 0; i < 200; i++) {
+      int k = batch * 200 + i;
+      query += fmt::format("{}({}, {}, 'tuple-{}')", i == 0 ? "" : ", ", k, k % 7, k);
+    }
+    SortedRows(bustub.get(), query);
+  }
+  SortedRows(bustub.get(), "DELETE FROM t WHERE v = 3;");
+
+  std::vector<std::string> queries{
+      "SELECT * FROM t",
+      "SELECT k, s FROM t WHERE k < 100 OR v = 5",
+      "SELECT s FROM t WHERE s = 'tuple-1234'",
+      "SELECT * FROM t ORDER BY s DESC LIMIT 10",
+      "SELECT a.k, b.s FROM t a, t b WHERE a.k = b.k AND a.v = 1",
+      "SELECT a.k, b.k FROM t a INNER JOIN t b ON a.k + 1 = b.k WHERE a.k < 50 AND b.k < 50",
+      "SELECT v, count(*), min(s), max(k) FROM t GROUP BY v",
+  };
+  for (const auto &query : queries) {
+    enable_zero_copy_scan = false;
+    auto expected = SortedRows(bustub.get(), query);
+    enable_zero_copy_scan = true;
+    auto actual = SortedRows(bustub.get(), query);
+    ASSERT_FALSE(expected.empty()) << query;
+    EXPECT_EQ(expected, actual) << query;
+  }
+
+  // Writers driven by a zero-copy scan of the same table.
+  enable_zero_copy_scan = true;
+  SortedRows(bustub.get(), "UPDATE t SET s = 'updated' WHERE v = 1;");
+  SortedRows(bustub.get(), "DELETE FROM t WHERE k >= 2000;");
+  SortedRows(bustub.get(), "INSERT INTO t SELECT k + 10000, v, s FROM t WHERE k < 10;");
+  EXPECT_EQ(SortedRows(bustub.get(), "SELECT count(*) FROM t WHERE s = 'updated'"),
+            std::vector<std::string>{"288\t"});
+  EXPECT_EQ(SortedRows(bustub.get(), "SELECT count(*), max(k) FROM t"), std::vector<std::string>{"1723\t10009\t"});
+
+  enable_zero_copy_scan = saved;
+}
+
+}  // namespace bustub
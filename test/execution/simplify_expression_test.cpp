@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// simplify_expression_test.cpp
+//
+// Identification: test/execution/simplify_expression_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks the simplified plans, test/sql/simplify-expression.slt checks their rows */
+class SimplifyExpressionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (a int, b int, c int);");
+    RunSql(bustub_.get(), "INSERT INTO t VALUES (1, 2, 3), (1, 5, 6), (4, 5, 6), (7, 8, 9);");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(SimplifyExpressionTest, FoldsConstants) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a FROM t WHERE a > 1 + 2");
+  EXPECT_NE(plan.find("filter=(#0.0>3)"), std::string::npos) << plan;
+  // The cached plan is made with parameters for the constants, which are folded once they are bound.
+  RunSql(bustub_.get(), "SELECT a FROM t WHERE a > 1 + 2");
+  auto hits = bustub_->plan_cache_.GetHits();
+  EXPECT_EQ(RunSql(bustub_.get(), "SELECT a FROM t WHERE a > 2 + 3"), "7\t\n");
+  EXPECT_EQ(bustub_->plan_cache_.GetHits(), hits + 1);
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimplifyExpressionTest, SimplifiesBooleanLogic) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a FROM t WHERE a > 3 AND 1 = 1");
+  EXPECT_NE(plan.find("filter=(#0.0>3)"), std::string::npos) << plan;
+  plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a FROM t WHERE a > 3 OR 1 = 1");
+  EXPECT_EQ(plan.find("filter="), std::string::npos) << plan;
+  plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a FROM t WHERE a > 3 AND 1 = 2");
+  EXPECT_EQ(plan.find("SeqScan"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimplifyExpressionTest, HoistsCommonExpressions) {
+  // `a + b` is computed once by a projection below the one of the select list.
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a + b, a + b - c FROM t");
+  EXPECT_NE(plan.find("Projection { exprs=[#0.1, (#0.1-#0.0)] }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("Projection { exprs=[#0.2, (#0.0+#0.1)] }"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimplifyExpressionTest, HoistsAboveFilters) {
+  // The predicate stays in the scan, `a + b` is only hoisted above it.
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT a + b, a + b - c FROM t WHERE a + b > 6");
+  EXPECT_NE(plan.find("Projection { exprs=[#0.2, (#0.0+#0.1)] }"), std::string::npos) << plan;
+  EXPECT_NE(plan.find("SeqScan { table=t, filter=((#0.0+#0.1)>6) }"), std::string::npos) << plan;
+  EXPECT_EQ(plan.find("Filter"), std::string::npos) << plan;
+  // `a + max(b)` is only read by the select list, so the groups HAVING drops never compute it.
+  plan = RunSql(bustub_.get(),
+                "EXPLAIN (o) SELECT a + max(b), a + max(b) - min(c) FROM t GROUP BY a HAVING min(c) > 3");
+  auto hoisted = plan.find("Projection { exprs=[#0.1, (#0.0+#0.2)] }");
+  auto filter = plan.find("Filter { predicate=(#0.1>3) }");
+  ASSERT_NE(hoisted, std::string::npos) << plan;
+  ASSERT_NE(filter, std::string::npos) << plan;
+  EXPECT_LT(hoisted, filter) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimplifyExpressionTest, SharesAggregatesWithHaving) {
+  // The aggregates of HAVING are computed once with those of the select list, and so is their sum.
+  auto plan =
+      RunSql(bustub_.get(), "EXPLAIN (o) SELECT a, max(b) + min(c) FROM t GROUP BY a HAVING max(b) + min(c) > 8");
+  EXPECT_NE(plan.find("Agg { types=[max, min], aggregates=[#0.1, #0.2], group_by=[#0.0] }"), std::string::npos)
+      << plan;
+  EXPECT_NE(plan.find("Filter { predicate=(#0.1>8) }"), std::string::npos) << plan;
+}
+
+}  // namespace bustub
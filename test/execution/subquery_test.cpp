@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// subquery_test.cpp
+//
+// Identification: test/execution/subquery_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+
+#include "common/bustub_instance.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+/** Checks the joins subqueries are planned as, test/sql/semi-anti-join.slt checks their rows */
+class SubqueryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    bustub_ = std::make_unique<BustubInstance>();
+    RunSql(bustub_.get(), "CREATE TABLE t (k int, v int);");
+    RunSql(bustub_.get(), "INSERT INTO t VALUES (1, 10), (2, 20), (3, 30), (NULL, 40);");
+    RunSql(bustub_.get(), "CREATE TABLE u (k int, w int);");
+    RunSql(bustub_.get(), "INSERT INTO u VALUES (1, 100), (3, 300), (3, 301);");
+  }
+
+  std::unique_ptr<BustubInstance> bustub_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(SubqueryTest, SemiJoin) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT v FROM t WHERE k IN (SELECT k FROM u);");
+  EXPECT_NE(plan.find("HashJoin { type=Semi"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(SubqueryTest, AntiJoin) {
+  auto plan = RunSql(bustub_.get(), "EXPLAIN (o) SELECT v FROM t WHERE NOT EXISTS (SELECT * FROM u WHERE u.k = t.k);");
+  EXPECT_NE(plan.find("HashJoin { type=Anti"), std::string::npos) << plan;
+}
+
+// NOLINTNEXTLINE
+TEST_F(SubqueryTest, HashJoinAgainstNestedLoop) {
+  RunSql(bustub_.get(), "CREATE TABLE a (k int, v int);");
+  RunSql(bustub_.get(), "CREATE TABLE b (k int);");
+  std::string a = "INSERT INTO a VALUES ";
+  std::string b = "INSERT INTO b VALUES ";
+  for (int i = 0; i < 2000; i++) {
+    a += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i * 7);
+    b += fmt::format("{}({})", i == 0 ? "" : ", ", i * 3 % 2500);
+  }
+  RunSql(bustub_.get(), a);
+  RunSql(bustub_.get(), b);
+
+  // The equality is evaluated with a hash join, the same predicate as a range with a nested loop join.
+  for (const auto *not_ : {"", "NOT "}) {
+    auto hash_query = fmt::format("SELECT v FROM a WHERE {}EXISTS (SELECT * FROM b WHERE b.k = a.k);", not_);
+    auto nlj_query =
+        fmt::format("SELECT v FROM a WHERE {}EXISTS (SELECT * FROM b WHERE b.k >= a.k AND b.k <= a.k);", not_);
+    ASSERT_NE(RunSql(bustub_.get(), "EXPLAIN (o) " + hash_query).find("HashJoin"), std::string::npos);
+    ASSERT_NE(RunSql(bustub_.get(), "EXPLAIN (o) " + nlj_query).find("NestedLoopJoin"), std::string::npos);
+
+    auto hash_rows = SortedRows(bustub_.get(), hash_query);
+    EXPECT_EQ(hash_rows.size(), not_[0] == '\0' ? 1666 : 334);
+    EXPECT_EQ(hash_rows, SortedRows(bustub_.get(), nlj_query));
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// topn_test.cpp
+//
+// Identification: test/execution/topn_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "gtest/gtest.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+class TopNTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    saved_parallelism_ = topn_parallelism;
+    topn_parallelism = GetParam();
+  }
+
+  void TearDown() override { topn_parallelism = saved_parallelism_; }
+
+  /** Check that ORDER BY ... LIMIT n returns the first n rows of the full ORDER BY */
+  static void CheckQuery(BustubInstance *bustub, const std::string &order_by, size_t n) {
+    auto expected = RunSqlRows(bustub, order_by);
+    expected.resize(std::min(expected.size(), n));
+    auto actual = RunSqlRows(bustub, fmt::format("{} LIMIT {}", order_by, n));
+    EXPECT_EQ(expected, actual) << order_by << " LIMIT " << n;
+  }
+
+ private:
+  size_t saved_parallelism_;
+};
+
+TEST_P(TopNTest, MatchesSort) {
+  auto bustub = std::make_unique<BustubInstance>();
+  bustub->GenerateMockTable();
+  // Keys are unique, so the order is fully determined.
+  CheckQuery(bustub.get(), "SELECT x, y FROM __mock_t2_100k ORDER BY x DESC, y", 10);
+  CheckQuery(bustub.get(), "SELECT x, y FROM __mock_t2_100k ORDER BY y, x DESC", 1500);
+  CheckQuery(bustub.get(), "SELECT colA, colB FROM __mock_table_1 ORDER BY colB DESC, colA", 1000);
+  CheckQuery(bustub.get(), "SELECT colA FROM __mock_table_1 ORDER BY colA", 0);
+  // VARCHAR keys sharing an 8-byte prefix are ordered by the full value.
+  CheckQuery(bustub.get(), "SELECT colC, colD FROM __mock_table_2 ORDER BY colD DESC, colC", 5);
+  CheckQuery(bustub.get(), "SELECT v6, v1 FROM __mock_agg_input_big ORDER BY v6, v1 DESC", 25);
+}
+
+TEST_P(TopNTest, Nulls) {
+  auto bustub = std::make_unique<BustubInstance>();
+  bustub->GenerateMockTable();
+  // colE is NULL for every odd row; NULLs come first under ASC and last under DESC.
+  auto asc = RunSqlRows(bustub.get(), "SELECT colE FROM __mock_table_3 ORDER BY colE LIMIT 3");
+  EXPECT_EQ(asc, (std::vector<std::string>{"integer_null\t", "integer_null\t", "integer_null\t"}));
+  auto desc = RunSqlRows(bustub.get(), "SELECT colE FROM __mock_table_3 ORDER BY colE DESC LIMIT 3");
+  ASSERT_EQ(desc.size(), 3);
+  EXPECT_NE(desc.back(), "integer_null\t");
+  // A sort puts NULLs in the same place, so a top-N over NULL keys returns the first rows of the full sort.
+  CheckQuery(bustub.get(), "SELECT colE, colF FROM __mock_table_3 ORDER BY colE, colF", 60);
+  CheckQuery(bustub.get(), "SELECT colE, colF FROM __mock_table_3 ORDER BY colE DESC, colF DESC", 60);
+}
+
+INSTANTIATE_TEST_SUITE_P(Parallelism, TopNTest, ::testing::Values(1, 4));
+
+}  // namespace bustub
@@ -17,10 +17,12 @@
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/util/string_util.h"
@@ -92,4 +94,38 @@ auto ParseCreateStatement(const std::string &sql_base) -> std::unique_ptr<Schema
   return std::make_unique<Schema>(v);
 }
 
+/**
+ * Execute SQL on a BusTub instance, in the given transaction or else in a transaction of its own.
+ * @param[out] ok whether the SQL succeeded, if not null
+ * @return the output without header, a line per row with a tab after every cell, e.g. the plan of an EXPLAIN
+ */
+inline auto RunSql(BustubInstance *bustub, const std::string &sql, Transaction *txn = nullptr, bool *ok = nullptr)
+    -> std::string {
+  std::stringstream ss;
+  auto writer = SimpleStreamWriter(ss, true);
+  auto success = txn == nullptr ? bustub->ExecuteSql(sql, writer) : bustub->ExecuteSqlTxn(sql, writer, txn);
+  if (ok != nullptr) {
+    *ok = success;
+  }
+  return ss.str();
+}
+
+/** @return the rows of the output of the SQL in order, or no rows if it failed */
+inline auto RunSqlRows(BustubInstance *bustub, const std::string &sql, Transaction *txn = nullptr)
+    -> std::vector<std::string> {
+  bool ok;
+  auto output = RunSql(bustub, sql, txn, &ok);
+  if (!ok) {
+    return {};
+  }
+  return StringUtil::Split(output, '\n');
+}
+
+/** @return the rows of the output of the SQL, sorted so that the order of an unordered result does not matter */
+inline auto SortedRows(BustubInstance *bustub, const std::string &sql) -> std::vector<std::string> {
+  auto rows = StringUtil::Split(RunSql(bustub, sql), '\n');
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
 }  // namespace bustub
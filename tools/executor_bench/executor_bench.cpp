@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "catalog/catalog.h"
+#include "common/config.h"
+#include "execution/compiled_expression.h"
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/executors/aggregation_executor.h"
+#include "execution/executors/limit_executor.h"
+#include "execution/executors/seq_scan_executor.h"
+#include "execution/executors/sort_executor.h"
+#include "execution/executors/topn_executor.h"
+#include "execution/expressions/arithmetic_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/limit_plan.h"
+#include "execution/plans/mock_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/**
+ * GeneratorExecutor produces `rows` tuples of (cursor % groups, cursor % 100) without touching any table, so that the
+ * benchmark measures the operator on top of it.
+ */
+class GeneratorExecutor : public AbstractExecutor {
+ public:
+  GeneratorExecutor(ExecutorContext *exec_ctx, const AbstractPlanNode *plan, size_t rows, size_t groups)
+      : AbstractExecutor(exec_ctx), plan_(plan), rows_(rows), groups_(groups) {}
+
+  void Init() override { cursor_ = 0; }
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override {
+    if (cursor_ == rows_) {
+      return false;
+    }
+    std::vector<Value> values{ValueFactory::GetIntegerValue(static_cast<int32_t>(cursor_ % groups_)),
+                              ValueFactory::GetIntegerValue(static_cast<int32_t>(cursor_ % 100))};
+    *tuple = Tuple{values, &GetOutputSchema()};
+    *rid = RID{};
+    cursor_++;
+    return true;
+  }
+
+  auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
+
+ private:
+  const AbstractPlanNode *plan_;
+  size_t rows_;
+  size_t groups_;
+  size_t cursor_{0};
+};
+
+}  // namespace bustub
+
+auto ClockMs() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/** SELECT k, count(*), sum(v), min(v), max(v) FROM generator GROUP BY k */
+void BenchGroupBy(size_t rows, size_t groups, bool parallel) {
+  using bustub::AggregationType;
+  using bustub::Column;
+  using bustub::ColumnValueExpression;
+  using bustub::Schema;
+  using bustub::TypeId;
+
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(bustub::BUFFER_POOL_SIZE, disk_manager.get());
+  bustub::ExecutorContext exec_ctx(nullptr, nullptr, bpm.get(), nullptr, nullptr);
+
+  auto input_schema = std::make_shared<Schema>(std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}});
+  auto output_schema = std::make_shared<Schema>(
+      std::vector{Column{"k", TypeId::INTEGER}, Column{"cnt", TypeId::INTEGER}, Column{"sum", TypeId::INTEGER},
+                  Column{"min", TypeId::INTEGER}, Column{"max", TypeId::INTEGER}});
+  auto child_plan = std::make_shared<bustub::MockScanPlanNode>(input_schema, "__generator");
+  auto k = std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER);
+  auto v = std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER);
+  auto plan = std::make_shared<bustub::AggregationPlanNode>(
+      output_schema, child_plan, std::vector<bustub::AbstractExpressionRef>{k},
+      std::vector<bustub::AbstractExpressionRef>{k, v, v, v},
+      std::vector{AggregationType::CountStarAggregate, AggregationType::SumAggregate, AggregationType::MinAggregate,
+                  AggregationType::MaxAggregate});
+
+  auto child = std::make_unique<bustub::GeneratorExecutor>(&exec_ctx, child_plan.get(), rows, groups);
+  bustub::AggregationExecutor executor(&exec_ctx, plan.get(), std::move(child));
+
+  bustub::enable_parallel_aggregation = parallel;
+  auto start = ClockMs();
+  executor.Init();
+  bustub::Tuple tuple;
+  bustub::RID rid;
+  size_t output = 0;
+  while (executor.Next(&tuple, &rid)) {
+    output++;
+  }
+  auto elapsed = ClockMs() - start;
+
+  fmt::print("group_by: mode={:<8} rows={:<9} groups={:<9} output={:<9} time={}ms rows_per_sec={:.0f}\n",
+             parallel ? "parallel" : "simple", rows, groups, output, elapsed,
+             rows / static_cast<double>(std::max<uint64_t>(elapsed, 1)) * 1000);
+}
+
+/** @return the peak resident memory of the process in KB */
+auto PeakMemoryKb() -> uint64_t {
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * SELECT count(DISTINCT k) FROM generator, counted exactly and with APPROX_COUNT_DISTINCT. The approximate count runs
+ * first, as the peak memory of the process only grows.
+ */
+void BenchDistinct(size_t rows, size_t distinct) {
+  using bustub::AggregationType;
+  using bustub::Column;
+  using bustub::ColumnValueExpression;
+  using bustub::Schema;
+  using bustub::TypeId;
+
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(bustub::BUFFER_POOL_SIZE, disk_manager.get());
+  bustub::ExecutorContext exec_ctx(nullptr, nullptr, bpm.get(), nullptr, nullptr);
+
+  auto input_schema = std::make_shared<Schema>(std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}});
+  auto output_schema = std::make_shared<Schema>(std::vector{Column{"cnt", TypeId::INTEGER}});
+  auto child_plan = std::make_shared<bustub::MockScanPlanNode>(input_schema, "__generator");
+  auto k = std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER);
+
+  for (auto agg_type : {AggregationType::ApproxCountDistinctAggregate, AggregationType::CountDistinctAggregate}) {
+    auto plan = std::make_shared<bustub::AggregationPlanNode>(output_schema, child_plan,
+                                                              std::vector<bustub::AbstractExpressionRef>{},
+                                                              std::vector<bustub::AbstractExpressionRef>{k},
+                                                              std::vector{agg_type});
+    auto child = std::make_unique<bustub::GeneratorExecutor>(&exec_ctx, child_plan.get(), rows, distinct);
+    bustub::AggregationExecutor executor(&exec_ctx, plan.get(), std::move(child));
+
+    auto memory_before = PeakMemoryKb();
+    auto start = ClockMs();
+    executor.Init();
+    bustub::Tuple tuple;
+    bustub::RID rid;
+    int32_t count = 0;
+    while (executor.Next(&tuple, &rid)) {
+      count = tuple.GetValue(output_schema.get(), 0).GetAs<int32_t>();
+    }
+    auto elapsed = ClockMs() - start;
+    auto memory = PeakMemoryKb() - memory_before;
+
+    fmt::print("distinct: mode={:<8} rows={:<9} distinct={:<9} count={:<9} time={}ms peak_memory_growth={}KB\n",
+               agg_type == AggregationType::CountDistinctAggregate ? "exact" : "approx", rows, distinct, count,
+               elapsed, memory);
+  }
+}
+
+/** SELECT * FROM generator ORDER BY v DESC, k DESC LIMIT 10, as sort + limit and as top-N */
+void BenchTopN(size_t rows, size_t threads) {
+  using bustub::Column;
+  using bustub::ColumnValueExpression;
+  using bustub::OrderByType;
+  using bustub::Schema;
+  using bustub::TypeId;
+
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(bustub::BUFFER_POOL_SIZE, disk_manager.get());
+  bustub::ExecutorContext exec_ctx(nullptr, nullptr, bpm.get(), nullptr, nullptr);
+
+  auto schema = std::make_shared<Schema>(std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER}});
+  auto child_plan = std::make_shared<bustub::MockScanPlanNode>(schema, "__generator");
+  std::vector<std::pair<OrderByType, bustub::AbstractExpressionRef>> order_bys{
+      {OrderByType::DESC, std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER)},
+      {OrderByType::DESC, std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER)}};
+  const size_t limit = 10;
+
+  for (const char *mode : {"sort", "topn", "parallel"}) {
+    if (std::string(mode) == "parallel" && threads <= 1) {
+      continue;
+    }
+    bustub::topn_parallelism = std::string(mode) == "parallel" ? threads : 1;
+    auto child = std::make_unique<bustub::GeneratorExecutor>(&exec_ctx, child_plan.get(), rows, rows);
+    std::unique_ptr<bustub::AbstractExecutor> executor;
+    auto sort_plan = std::make_shared<bustub::SortPlanNode>(schema, child_plan, order_bys);
+    auto limit_plan = std::make_shared<bustub::LimitPlanNode>(schema, sort_plan, limit);
+    auto topn_plan = std::make_shared<bustub::TopNPlanNode>(schema, child_plan, order_bys, limit);
+    if (std::string(mode) == "sort") {
+      auto sort = std::make_unique<bustub::SortExecutor>(&exec_ctx, sort_plan.get(), std::move(child));
+      executor = std::make_unique<bustub::LimitExecutor>(&exec_ctx, limit_plan.get(), std::move(sort));
+    } else {
+      executor = std::make_unique<bustub::TopNExecutor>(&exec_ctx, topn_plan.get(), std::move(child));
+    }
+
+    auto start = ClockMs();
+    executor->Init();
+    bustub::Tuple tuple;
+    bustub::RID rid;
+    size_t output = 0;
+    while (executor->Next(&tuple, &rid)) {
+      output++;
+    }
+    auto elapsed = ClockMs() - start;
+
+    fmt::print("topn: mode={:<8} rows={:<9} output={:<9} time={}ms rows_per_sec={:.0f}\n", mode, rows, output, elapsed,
+               rows / static_cast<double>(std::max<uint64_t>(elapsed, 1)) * 1000);
+  }
+}
+
+/** SELECT * FROM t WHERE k < table_rows * selectivity, repeated until `rows` tuples were scanned */
+void BenchSeqScan(size_t rows) {
+  using bustub::Column;
+  using bustub::TypeId;
+  using bustub::ValueFactory;
+
+  // TableHeap::InsertTuple walks the page list from the start, so keep the table small and scan it several times.
+  size_t table_rows = std::min<size_t>(rows, 50000);
+  size_t passes = std::max<size_t>(rows / table_rows, 1);
+
+  // Keep the whole table in memory, so that the benchmark measures the scan rather than the buffer pool.
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManagerInstance>(table_rows / 50 + 16, disk_manager.get());
+  bustub::Catalog catalog(bpm.get(), nullptr, nullptr);
+  bustub::Transaction txn(0, bustub::IsolationLevel::READ_UNCOMMITTED);
+  bustub::ExecutorContext exec_ctx(&txn, &catalog, bpm.get(), nullptr, nullptr);
+
+  bustub::Schema schema(std::vector{Column{"k", TypeId::INTEGER}, Column{"v", TypeId::INTEGER},
+                                    Column{"s", TypeId::VARCHAR, 32}});
+  auto table_info = catalog.CreateTable(&txn, "t", schema);
+  for (size_t i = 0; i < table_rows; i++) {
+    bustub::Tuple tuple{{ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                         ValueFactory::GetIntegerValue(static_cast<int32_t>(i % 100)),
+                         ValueFactory::GetVarcharValue(fmt::format("tuple-{}", i))},
+                        &schema};
+    bustub::RID rid;
+    table_info->table_->InsertTuple(tuple, &rid, &txn);
+  }
+  txn.GetWriteSet()->clear();
+
+  auto output_schema = std::make_shared<bustub::Schema>(schema);
+  for (double selectivity : {0.01, 1.0}) {
+    auto k = std::make_shared<bustub::ColumnValueExpression>(0, 0, TypeId::INTEGER);
+    auto bound = std::make_shared<bustub::ConstantValueExpression>(
+        ValueFactory::GetIntegerValue(static_cast<int32_t>(table_rows * selectivity)));
+    auto predicate = std::make_shared<bustub::ComparisonExpression>(k, bound, bustub::ComparisonType::LessThan);
+    bustub::SeqScanPlanNode plan(output_schema, table_info->oid_, "t", predicate);
+
+    for (bool zero_copy : {false, true}) {
+      bustub::enable_zero_copy_scan = zero_copy;
+      bustub::SeqScanExecutor executor(&exec_ctx, &plan);
+      auto start = ClockMs();
+      size_t output = 0;
+      for (size_t pass = 0; pass < passes; pass++) {
+        executor.Init();
+        bustub::Tuple tuple;
+        bustub::RID rid;
+        while (executor.Next(&tuple, &rid)) {
+          output++;
+        }
+      }
+      auto elapsed = ClockMs() - start;
+
+      fmt::print("seq_scan: mode={:<9} rows={:<9} output={:<9} time={}ms rows_per_sec={:.0f}\n",
+                 zero_copy ? "zero-copy" : "copy", table_rows * passes, output, elapsed,
+                 table_rows * passes / static_cast<double>(std::max<uint64_t>(elapsed, 1)) * 1000);
+    }
+  }
+}
+
+/** WHERE (k < 500 AND v + 1 > 10) OR k = 7, evaluated as a tree and as a compiled program */
+void BenchPredicate(size_t rows) {
+  using bustub::AbstractExpressionRef;
+  using bustub::ColumnValueExpression;
+  using bustub::ConstantValueExpression;
+  using bustub::TypeId;
+  using bustub::ValueFactory;
+
+  bustub::Schema schema(std::vector{bustub::Column{"k", TypeId::INTEGER}, bustub::Column{"v", TypeId::INTEGER}});
+  AbstractExpressionRef k = std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER);
+  AbstractExpressionRef v = std::make_shared<ColumnValueExpression>(0, 1, TypeId::INTEGER);
+  auto constant = [](int32_t val) -> AbstractExpressionRef {
+    return std::make_shared<ConstantValueExpression>(ValueFactory::GetIntegerValue(val));
+  };
+  auto cmp = [](AbstractExpressionRef left, AbstractExpressionRef right, bustub::ComparisonType type) {
+    return std::make_shared<bustub::ComparisonExpression>(std::move(left), std::move(right), type);
+  };
+  auto v_plus_1 = std::make_shared<bustub::ArithmeticExpression>(v, constant(1), bustub::ArithmeticType::Plus);
+  auto conj = std::make_shared<bustub::LogicExpression>(cmp(k, constant(500), bustub::ComparisonType::LessThan),
+                                                        cmp(v_plus_1, constant(10), bustub::ComparisonType::GreaterThan),
+                                                        bustub::LogicType::And);
+  auto predicate = std::make_shared<bustub::LogicExpression>(
+      conj, cmp(k, constant(7), bustub::ComparisonType::Equal), bustub::LogicType::Or);
+
+  // A small working set of tuples, so that the benchmark measures evaluation rather than memory traffic.
+  std::vector<bustub::Tuple> tuples;
+  for (int32_t i = 0; i < 1024; i++) {
+    tuples.emplace_back(std::vector{ValueFactory::GetIntegerValue(i), ValueFactory::GetIntegerValue(i % 100)},
+                        &schema);
+  }
+
+  bustub::CompiledExpression compiled(predicate.get(), schema);
+  for (bool use_compiled : {false, true}) {
+    auto start = ClockMs();
+    size_t matched = 0;
+    for (size_t i = 0; i < rows; i++) {
+      const auto &tuple = tuples[i % tuples.size()];
+      bool result;
+      if (use_compiled) {
+        result = compiled.EvaluatePredicate(&tuple);
+      } else {
+        auto value = predicate->Evaluate(&tuple, schema);
+        result = !value.IsNull() && value.GetAs<bool>();
+      }
+      matched += static_cast<size_t>(result);
+    }
+    auto elapsed = ClockMs() - start;
+
+    fmt::print("predicate: mode={:<8} rows={:<9} matched={:<9} time={}ms predicates_per_sec={:.0f}\n",
+               use_compiled ? "compiled" : "tree", rows, matched, elapsed,
+               rows / static_cast<double>(std::max<uint64_t>(elapsed, 1)) * 1000);
+  }
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-executor-bench");
+  program.add_argument("--rows").help("number of input rows of every benchmark");
+  program.add_argument("--threads").help("worker threads of the parallel operators");
+  program.add_argument("--spill-threshold").help("bytes of aggregate state a worker buffers before spilling");
+  program.add_argument("--skip-simple")
+      .help("only run the parallel operators")
+      .default_value(false)
+      .implicit_value(true);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  size_t rows = 10000000;
+  if (program.present("--rows")) {
+    rows = std::stoul(program.get("--rows"));
+  }
+  if (program.present("--threads")) {
+    bustub::aggregation_parallelism = std::stoul(program.get("--threads"));
+    bustub::topn_parallelism = bustub::aggregation_parallelism.load();
+  }
+  if (program.present("--spill-threshold")) {
+    bustub::aggregation_spill_threshold = std::stoul(program.get("--spill-threshold"));
+  }
+  bool skip_simple = program.get<bool>("--skip-simple");
+
+  std::cerr << "x: " << rows << " rows, " << bustub::aggregation_parallelism << " threads" << std::endl;
+
+  // First, as it reports how much the peak memory of the process grows.
+  BenchDistinct(rows, std::max<size_t>(rows / 4, 1));
+
+  for (size_t groups : {1000UL, 1000000UL, 10000000UL}) {
+    groups = std::min(groups, rows);
+    if (!skip_simple) {
+      BenchGroupBy(rows, groups, false);
+    }
+    BenchGroupBy(rows, groups, true);
+  }
+
+  BenchPredicate(rows);
+  BenchSeqScan(rows);
+  BenchTopN(rows, bustub::topn_parallelism);
+
+  return 0;
+}
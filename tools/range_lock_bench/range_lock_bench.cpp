@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/bustub_instance.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+
+auto ClockMs() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/** Keys of the initial rows are multiples of this, inserters fill the gaps between them */
+static const int KEY_STRIDE = 10;
+
+struct RangeLockMetrics {
+  std::atomic<uint64_t> committed_scans_{0};
+  std::atomic<uint64_t> aborted_scans_{0};
+  std::atomic<uint64_t> committed_inserts_{0};
+  std::atomic<uint64_t> aborted_inserts_{0};
+};
+
+/**
+ * Scanners count the rows of short key ranges under REPEATABLE_READ while inserters add rows at random keys. With
+ * key-range locks a scan only blocks the inserts into the range it read; with `table_lock` every scan first locks the
+ * whole table in S mode, which blocks all inserts the way phantom protection worked before.
+ */
+void BenchRangeScans(int rows, size_t scanners, size_t inserters, int range, uint64_t duration_ms, bool table_lock) {
+  auto bustub = std::make_unique<bustub::BustubInstance>();
+  auto noop_writer = bustub::NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (k int, v int);", noop_writer);
+  bustub->ExecuteSql("CREATE INDEX t_k ON t(k);", noop_writer);
+  {
+    std::string query = "INSERT INTO t VALUES ";
+    for (int i = 0; i < rows; i++) {
+      query += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i * KEY_STRIDE, i);
+    }
+    auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+    bustub->ExecuteSqlTxn(query, noop_writer, txn);
+    bustub->txn_manager_->Commit(txn);
+    delete txn;
+  }
+  auto oid = bustub->catalog_->GetTable("t")->oid_;
+
+  RangeLockMetrics metrics;
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+
+  for (size_t thread_id = 0; thread_id < scanners; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::default_random_engine gen(thread_id);
+      std::uniform_int_distribution<int> low_dist(0, rows * KEY_STRIDE - range);
+      while (!stop) {
+        std::stringstream ss;
+        auto writer = bustub::SimpleStreamWriter(ss, true);
+        auto low = low_dist(gen);
+        auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        bool success = true;
+        try {
+          success = !table_lock || bustub->lock_manager_->LockTable(txn, bustub::LockManager::LockMode::SHARED, oid);
+        } catch (bustub::TransactionAbortException &e) {
+          success = false;
+        }
+        success = success && bustub->ExecuteSqlTxn(
+                                 fmt::format("SELECT count(*) FROM t WHERE k >= {} AND k < {}", low, low + range),
+                                 writer, txn);
+        if (success) {
+          bustub->txn_manager_->Commit(txn);
+          metrics.committed_scans_++;
+        } else {
+          bustub->txn_manager_->Abort(txn);
+          metrics.aborted_scans_++;
+        }
+        delete txn;
+      }
+    });
+  }
+
+  for (size_t thread_id = 0; thread_id < inserters; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      // Inserters share the gaps between the initial keys: each gap has room for KEY_STRIDE - 1 keys, and every
+      // inserter owns one of them in every `rounds`-th gap, so that no two inserts collide on a key.
+      const size_t slots = KEY_STRIDE - 1;
+      const size_t rounds = (inserters + slots - 1) / slots;
+      std::vector<int> gaps(rows);
+      for (int i = 0; i < rows; i++) {
+        gaps[i] = i;
+      }
+      std::shuffle(gaps.begin(), gaps.end(), std::default_random_engine(scanners + thread_id));
+      int offset = static_cast<int>(thread_id % slots) + 1;
+      for (size_t i = thread_id / slots; i < gaps.size() && !stop; i += rounds) {
+        auto writer = bustub::NoopWriter();
+        auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        if (bustub->ExecuteSqlTxn(fmt::format("INSERT INTO t VALUES ({}, 0)", gaps[i] * KEY_STRIDE + offset), writer,
+                                  txn)) {
+          bustub->txn_manager_->Commit(txn);
+          metrics.committed_inserts_++;
+        } else {
+          bustub->txn_manager_->Abort(txn);
+          metrics.aborted_inserts_++;
+        }
+        delete txn;
+      }
+    });
+  }
+
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = static_cast<double>(std::max<uint64_t>(ClockMs() - start, 1));
+
+  fmt::print(
+      "range_scan: mode={:<10} range={:<6} scans={:<8} scan_aborts={:<6} inserts={:<8} insert_aborts={:<6} "
+      "scans_per_sec={:.0f} inserts_per_sec={:.0f}\n",
+      table_lock ? "table_lock" : "key_lock", range, metrics.committed_scans_.load(), metrics.aborted_scans_.load(),
+      metrics.committed_inserts_.load(), metrics.aborted_inserts_.load(),
+      metrics.committed_scans_ / elapsed * 1000, metrics.committed_inserts_ / elapsed * 1000);
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-range-lock-bench");
+  program.add_argument("--rows").help("number of rows in the table before the benchmark");
+  program.add_argument("--scanners").help("number of range scan threads");
+  program.add_argument("--inserters").help("number of insert threads");
+  program.add_argument("--range").help("width of the key range every scan reads");
+  program.add_argument("--duration").help("run every mode for n milliseconds");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  int rows = 10000;
+  size_t scanners = 2;
+  size_t inserters = 2;
+  int range = 100;
+  uint64_t duration_ms = 5000;
+  if (program.present("--rows")) {
+    rows = std::stoi(program.get("--rows"));
+  }
+  if (program.present("--scanners")) {
+    scanners = std::stoul(program.get("--scanners"));
+  }
+  if (program.present("--inserters")) {
+    inserters = std::stoul(program.get("--inserters"));
+  }
+  if (program.present("--range")) {
+    range = std::min(std::stoi(program.get("--range")), rows * KEY_STRIDE);
+  }
+  if (program.present("--duration")) {
+    duration_ms = std::stoul(program.get("--duration"));
+  }
+
+  std::cerr << "x: " << rows << " rows, " << scanners << " scan threads, " << inserters << " insert threads"
+            << std::endl;
+
+  for (bool table_lock : {true, false}) {
+    BenchRangeScans(rows, scanners, inserters, range, duration_ms, table_lock);
+  }
+
+  return 0;
+}
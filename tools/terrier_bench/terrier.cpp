@@ -13,6 +13,7 @@
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
+#include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "concurrency/transaction_manager.h"
 #include "fmt/core.h"
@@ -53,6 +54,10 @@ struct TerrierTotalMetrics {
     committed_update_txn_cnt_ += committed_cnt;
   }
 
+  static auto AbortRate(uint64_t aborted_cnt, uint64_t committed_cnt) -> double {
+    return aborted_cnt == 0 ? 0 : aborted_cnt * 100.0 / (aborted_cnt + committed_cnt);
+  }
+
   void Report() {
     auto now = ClockMs();
     auto elsped = now - start_time_;
@@ -63,6 +68,8 @@ struct TerrierTotalMetrics {
     fmt::print("update: {}\n", update_txn_per_sec);
     fmt::print("count: {}\n", count_txn_per_sec);
     fmt::print(">>> END\n");
+    fmt::print("update abort rate: {:.2f}%\n", AbortRate(aborted_update_txn_cnt_, committed_update_txn_cnt_));
+    fmt::print("count abort rate: {:.2f}%\n", AbortRate(aborted_count_txn_cnt_, committed_count_txn_cnt_));
   }
 };
 
@@ -120,6 +127,10 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--duration").help("run terrier bench for n milliseconds");
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
+  program.add_argument("--threads").help("number of update threads and count threads in terrier bench");
+  program.add_argument("--snapshot").help("run count queries under snapshot isolation in terrier bench");
+  program.add_argument("--occ").help("run update and delete transactions optimistically in terrier bench");
+  program.add_argument("--lock-metrics").help("print the lock metrics of the benchmark as JSON in terrier bench");
 
   try {
     program.parse_args(argc, argv);
@@ -172,6 +183,19 @@ auto main(int argc, char **argv) -> int {
     std::cerr << "x: use insert + delete" << std::endl;
   }
 
+  auto count_isolation = bustub::IsolationLevel::REPEATABLE_READ;
+  if (program.present("--snapshot") && ParseBool(program.get("--snapshot"))) {
+    count_isolation = bustub::IsolationLevel::SNAPSHOT_ISOLATION;
+    std::cerr << "x: count with snapshot isolation" << std::endl;
+  }
+
+  // Inserts stay under 2PL: a delete that committed must get its NFT back, so the insert has to wait, not abort.
+  auto update_isolation = bustub::IsolationLevel::REPEATABLE_READ;
+  if (program.present("--occ") && ParseBool(program.get("--occ"))) {
+    update_isolation = bustub::IsolationLevel::OPTIMISTIC;
+    std::cerr << "x: update with optimistic concurrency control" << std::endl;
+  }
+
   uint64_t duration_ms = 30000;
 
   if (program.present("--duration")) {
@@ -180,6 +204,15 @@ auto main(int argc, char **argv) -> int {
 
   std::cerr << "x: benchmark for " << duration_ms << "ms" << std::endl;
 
+  size_t terrier_threads = BUSTUB_TERRIER_THREAD;
+
+  if (program.present("--threads")) {
+    terrier_threads = std::stoi(program.get("--threads"));
+  }
+
+  std::cerr << "x: " << terrier_threads << " update threads and " << terrier_threads << " count threads"
+            << std::endl;
+
   // initialize data
   std::cerr << "x: initialize data" << std::endl;
   std::string query = "INSERT INTO nft VALUES ";
@@ -205,6 +238,8 @@ auto main(int argc, char **argv) -> int {
     }
   }
 
+  // Only the benchmark itself shows up in the lock metrics.
+  bustub->lock_manager_->GetMetrics().Reset();
   std::cerr << "x: benchmark start" << std::endl;
 
   std::vector<std::thread> threads;
@@ -212,9 +247,10 @@ auto main(int argc, char **argv) -> int {
 
   total_metrics.Begin();
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, enable_update, duration_ms, &total_metrics] {
-      const size_t nft_range_size = BUSTUB_NFT_NUM / BUSTUB_TERRIER_THREAD;
+  for (size_t thread_id = 0; thread_id < terrier_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, terrier_threads, &bustub, enable_update, update_isolation, duration_ms,
+                                      &total_metrics] {
+      const size_t nft_range_size = BUSTUB_NFT_NUM / terrier_threads;
       const size_t nft_range_begin = thread_id * nft_range_size;
       const size_t nft_range_end = (thread_id + 1) * nft_range_size;
       std::random_device r;
@@ -233,7 +269,7 @@ auto main(int argc, char **argv) -> int {
         bool txn_success = true;
 
         if (enable_update) {
-          auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+          auto txn = bustub->txn_manager_->Begin(nullptr, update_isolation);
           std::string query = fmt::format("UPDATE nft SET terrier = {} WHERE id = {}", terrier_id, nft_id);
           if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
             txn_success = false;
@@ -244,16 +280,17 @@ auto main(int argc, char **argv) -> int {
             exit(1);
           }
 
-          if (txn_success) {
-            bustub->txn_manager_->Commit(txn);
+          if (!txn_success) {
+            bustub->txn_manager_->Abort(txn);
+            metrics.TxnAborted();
+          } else if (bustub->txn_manager_->Commit(txn)) {
             metrics.TxnCommitted();
           } else {
-            bustub->txn_manager_->Abort(txn);
             metrics.TxnAborted();
           }
           delete txn;
         } else {
-          auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+          auto txn = bustub->txn_manager_->Begin(nullptr, update_isolation);
 
           std::string query = fmt::format("DELETE FROM nft WHERE id = {}", nft_id);
           if (!bustub->ExecuteSqlTxn(query, writer, txn)) {
@@ -269,8 +306,10 @@ auto main(int argc, char **argv) -> int {
             bustub->txn_manager_->Abort(txn);
             metrics.TxnAborted();
             delete txn;
+          } else if (!bustub->txn_manager_->Commit(txn)) {
+            metrics.TxnAborted();
+            delete txn;
           } else {
-            bustub->txn_manager_->Commit(txn);
             delete txn;
 
             txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
@@ -303,8 +342,8 @@ auto main(int argc, char **argv) -> int {
     }));
   }
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, &total_metrics] {
+  for (size_t thread_id = 0; thread_id < terrier_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &bustub, duration_ms, count_isolation, &total_metrics] {
       std::random_device r;
       std::default_random_engine gen(r());
       std::uniform_int_distribution<int> terrier_uniform_dist(0, BUSTUB_TERRIER_CNT - 1);
@@ -317,7 +356,7 @@ auto main(int argc, char **argv) -> int {
         auto writer = bustub::SimpleStreamWriter(ss, true);
         auto terrier_id = terrier_uniform_dist(gen);
 
-        auto txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        auto txn = bustub->txn_manager_->Begin(nullptr, count_isolation);
         bool txn_success = true;
 
         std::string query = fmt::format("SELECT count(*) FROM nft WHERE terrier = {}", terrier_id);
@@ -359,6 +398,9 @@ auto main(int argc, char **argv) -> int {
   }
 
   total_metrics.Report();
+  if (program.present("--lock-metrics") && ParseBool(program.get("--lock-metrics"))) {
+    fmt::print("lock metrics: {}\n", bustub->lock_manager_->GetMetrics().ToJson());
+  }
 
   return 0;
 }
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+
+auto ClockMs() -> uint64_t {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * Every thread begins and commits `txns` transactions back to back, which is what the tiny transactions of the
+ * terrier bench spend on top of their queries. A transaction optionally takes an IS lock on a table and S locks on
+ * `rows` rows of its own, so that threads never wait for each other and only the per-transaction work is measured.
+ */
+void BenchBeginCommit(size_t threads, size_t txns, size_t rows) {
+  bustub::LockManager lock_manager;
+  bustub::TransactionManager txn_manager(&lock_manager);
+  const bustub::table_oid_t oid = 0;
+
+  std::vector<std::thread> workers;
+  auto start = ClockMs();
+  for (size_t thread_id = 0; thread_id < threads; thread_id++) {
+    workers.emplace_back([&, thread_id] {
+      for (size_t i = 0; i < txns; i++) {
+        auto *txn = txn_manager.Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+        if (rows > 0) {
+          lock_manager.LockTable(txn, bustub::LockManager::LockMode::INTENTION_SHARED, oid);
+          for (size_t row = 0; row < rows; row++) {
+            bustub::RID rid(static_cast<bustub::page_id_t>(thread_id), static_cast<uint32_t>(row));
+            lock_manager.LockRow(txn, bustub::LockManager::LockMode::SHARED, oid, rid);
+          }
+        }
+        txn_manager.Commit(txn);
+        delete txn;
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  auto elapsed = ClockMs() - start;
+
+  fmt::print("begin_commit: threads={:<3} rows={:<3} txns={:<9} time={}ms txns_per_sec={:.0f}\n", threads, rows,
+             threads * txns, elapsed, threads * txns / static_cast<double>(std::max<uint64_t>(elapsed, 1)) * 1000);
+}
+
+/**
+ * Runs every statement that locks many rows once, each in its own REPEATABLE_READ transaction, and counts the lock
+ * table latches the thread takes per locked row. With `batched` off, LockManager::LockRows() locks the rows one by one
+ * as LockRow() calls from the executors used to. Escalation is disabled so that every row is locked. An insert locks
+ * each new row with LockRow() as soon as it is written, so its count is the same in both modes.
+ */
+void BenchRowLockBatches(int rows, bool batched) {
+  auto bustub = std::make_unique<bustub::BustubInstance>();
+  auto writer = bustub::NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+  bustub::lock_escalation_threshold = 0;
+  bustub::enable_batched_row_locks = batched;
+
+  std::string insert = "INSERT INTO t VALUES ";
+  for (int i = 0; i < rows; i++) {
+    insert += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i);
+  }
+  for (const auto &[name, query] : std::vector<std::pair<std::string, std::string>>{
+           {"insert", insert},
+           {"select", "SELECT count(*) FROM t WHERE v >= 0"},
+           {"update", "UPDATE t SET v = v + 1 WHERE v >= 0"},
+           {"delete", "DELETE FROM t WHERE v >= 0"}}) {
+    auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+    auto latches = bustub::LockManager::RowLatchCount();
+    auto start = ClockMs();
+    bustub->ExecuteSqlTxn(query, writer, txn);
+    auto elapsed = ClockMs() - start;
+    latches = bustub::LockManager::RowLatchCount() - latches;
+    bustub->txn_manager_->Commit(txn);
+    delete txn;
+    fmt::print("row_locks: mode={:<8} query={:<7} rows={:<8} latches_per_row={:.2f} time={}ms\n",
+               batched ? "batched" : "per_row", name, rows, latches / static_cast<double>(rows), elapsed);
+  }
+  bustub::enable_batched_row_locks = true;
+  bustub::lock_escalation_threshold = 1000;
+}
+
+/**
+ * Deletes and re-inserts `rows` rows of an indexed table in one transaction and times its abort, then does the same
+ * again and times its commit, which is the write set work of large bulk transactions.
+ */
+void BenchBulkWriteSet(int rows) {
+  auto bustub = std::make_unique<bustub::BustubInstance>();
+  auto writer = bustub::NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (k int, v int);", writer);
+  bustub->ExecuteSql("CREATE INDEX t_k ON t(k);", writer);
+  std::string insert = "INSERT INTO t VALUES ";
+  for (int i = 0; i < rows; i++) {
+    insert += fmt::format("{}({}, {})", i == 0 ? "" : ", ", i, i);
+  }
+  bustub->ExecuteSql(insert, writer);
+
+  for (bool commit : {false, true}) {
+    auto *txn = bustub->txn_manager_->Begin(nullptr, bustub::IsolationLevel::REPEATABLE_READ);
+    bustub->ExecuteSqlTxn("DELETE FROM t WHERE v >= 0", writer, txn);
+    bustub->ExecuteSqlTxn(insert, writer, txn);
+    auto start = ClockMs();
+    if (commit) {
+      bustub->txn_manager_->Commit(txn);
+    } else {
+      bustub->txn_manager_->Abort(txn);
+    }
+    auto elapsed = ClockMs() - start;
+    delete txn;
+    fmt::print("write_set: end={:<7} rows={:<8} time={}ms\n", commit ? "commit" : "abort", rows, elapsed);
+  }
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-txn-bench");
+  program.add_argument("--txns").help("number of transactions every thread runs");
+  program.add_argument("--threads").help("maximum number of threads, doubled from 1");
+  program.add_argument("--rows").help("number of rows every statement of the row lock benchmark locks");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  size_t txns = 200000;
+  size_t max_threads = std::max(1U, std::thread::hardware_concurrency());
+  int statement_rows = 10000;
+  if (program.present("--txns")) {
+    txns = std::stoul(program.get("--txns"));
+  }
+  if (program.present("--threads")) {
+    max_threads = std::stoul(program.get("--threads"));
+  }
+  if (program.present("--rows")) {
+    statement_rows = std::stoi(program.get("--rows"));
+  }
+
+  std::cerr << "x: " << txns << " transactions per thread, up to " << max_threads << " threads" << std::endl;
+
+  for (size_t rows : {0, 4}) {
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+      BenchBeginCommit(threads, txns, rows);
+    }
+  }
+  for (bool batched : {false, true}) {
+    BenchRowLockBatches(statement_rows, batched);
+  }
+  BenchBulkWriteSet(statement_rows);
+
+  return 0;
+}